@@ -0,0 +1,173 @@
+/*
+ * ncbench.c
+ *
+ * This file contains a benchmark of normalizedCut. It partitions a graph
+ * a few times and reports the time and the memory that were spent, so
+ * that the 32-bit and the 64-bit idxtype builds of Graclus (ncbench and
+ * ncbench64) can be compared on the same graph. It also compares the
+ * METIS and the spectral initial partitioning of the coarsest graph, and
+ * the multilevel kernel k-means with the label propagation engine.
+ *
+ */
+
+#include <Graclus.h>
+#include <sys/resource.h>
+
+
+/*************************************************************************
+* This function returns the peak resident set size of the process in MB
+**************************************************************************/
+static double PeakRSS(void)
+{
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+
+  return usage.ru_maxrss/1024.0;  /* ru_maxrss is in KB on Linux */
+}
+
+
+/*************************************************************************
+* The following data structure holds the results of the runs of one
+* initial partitioning scheme or engine
+**************************************************************************/
+struct benchdef {
+  double readtime, parttime, mintime, inittime, refinetime;
+  int kkmiters;
+  float ncut, balance;
+  MLStatsType stats;
+};
+
+typedef struct benchdef BenchType;
+
+
+/*************************************************************************
+* This function runs normalizedCut nruns times with the options and
+* averages the results into bench
+**************************************************************************/
+static void RunBench(char *filename, int nparts, int nruns, int *options, BenchType *bench)
+{
+  int i;
+  Graclus ncData;
+
+  memset(bench, 0, sizeof(BenchType));
+  bench->mintime = -1.0;
+  for (i=0; i<nruns; i++) {
+    ncData = normalizedCut(filename, nparts, options);
+
+    bench->readtime += ncData.readTime/nruns;
+    bench->parttime += ncData.stats.totaltime/nruns;
+    bench->inittime += ncData.stats.initparttime/nruns;
+    bench->refinetime += ncData.stats.refinetime/nruns;
+    if (bench->mintime < 0 || ncData.stats.totaltime < bench->mintime)
+      bench->mintime = ncData.stats.totaltime;
+    bench->kkmiters = ncData.stats.totalkkmiters;
+    bench->ncut = ncData.ncut;
+    bench->balance = ncData.balance;
+    bench->stats = ncData.stats;
+
+    GraclusFree(&ncData);
+  }
+}
+
+
+/*************************************************************************
+* Let the game begin
+**************************************************************************/
+int main(int argc, char *argv[])
+{
+  int i, nparts, nruns, ninits, initparts[3], engines[3], ctypes[3];
+  int options[GRACLUS_NOPTIONS];
+  char *initnames[3], *mode;
+  BenchType bench[3];
+  GraclusPool *pool;
+
+  if (argc < 3) {
+    printf("Usage: %s <GraphFile> <Nparts> [Nruns] [Nthreads] [metis|spectral|both|lp|match|all]\n", argv[0]);
+    exit(0);
+  }
+
+  nparts = atoi(argv[2]);
+  nruns = (argc > 3 ? amax(atoi(argv[3]), 1) : 3);
+
+  GraclusSetDefaultOptions(options);
+  if (argc > 4)
+    options[OPTION_NTHREADS] = atoi(argv[4]);
+
+  /* lp compares the label propagation engine with the default kernel k-means, 
+     match the parallel handshake matching with the serial one */
+  mode = (argc > 5 ? argv[5] : "metis");
+  ninits = 0;
+  if (strcmp(mode, "spectral") != 0) {
+    initparts[ninits] = INITPART_METIS;
+    engines[ninits] = ENGINE_MLKKM;
+    ctypes[ninits] = MATCH_SHEMN;
+    initnames[ninits++] = "metis initial partitioning";
+  }
+  if (strcmp(mode, "spectral") == 0 || strcmp(mode, "both") == 0 || strcmp(mode, "all") == 0) {
+    initparts[ninits] = INITPART_SPECTRAL;
+    engines[ninits] = ENGINE_MLKKM;
+    ctypes[ninits] = MATCH_SHEMN;
+    initnames[ninits++] = "spectral initial partitioning";
+  }
+  if (strcmp(mode, "lp") == 0 || strcmp(mode, "all") == 0) {
+    initparts[ninits] = INITPART_METIS;
+    engines[ninits] = ENGINE_LABELPROP;
+    ctypes[ninits] = MATCH_SHEMN;
+    initnames[ninits++] = "label propagation";
+  }
+  if (strcmp(mode, "match") == 0) {
+    initparts[ninits] = INITPART_METIS;
+    engines[ninits] = ENGINE_MLKKM;
+    ctypes[ninits] = MATCH_PSHEMN;
+    initnames[ninits++] = "parallel matching";
+  }
+
+  pool = GraclusPoolCreate();
+  GraclusUsePool(pool);
+
+  for (i=0; i<ninits; i++) {
+    options[OPTION_INITPART] = initparts[i];
+    options[OPTION_ENGINE] = engines[i];
+    options[OPTION_CTYPE] = ctypes[i];
+    RunBench(argv[1], nparts, nruns, options, bench+i);
+  }
+
+  GraclusUsePool(NULL);
+
+  printf("idxtype:            %d bits\n", (int)(8*sizeof(idxtype)));
+  printf("graph:              %d vertices, %" PRIDX " edges, %d levels\n", bench[0].stats.nvtxs[0], bench[0].stats.nedges[0], bench[0].stats.nlevels);
+  printf("clusters:           %d\n", nparts);
+  printf("read time:          %.3f s (average of %d runs)\n", bench[0].readtime, nruns);
+  for (i=0; i<ninits; i++) {
+    if (engines[i] == ENGINE_LABELPROP) {
+      printf("%s:\n", initnames[i]);
+      printf("  ncut:             %.4f, balance %.3f\n", bench[i].ncut, bench[i].balance);
+      printf("  partition time:   %.3f s (average), %.3f s (best)\n", bench[i].parttime, bench[i].mintime);
+      printf("    cluster:        %.3f s\n", bench[i].stats.coarsentime);
+      printf("    pack:           %.3f s (average)\n", bench[i].inittime);
+      printf("    refine:         %.3f s (average), %d rounds\n", bench[i].refinetime, bench[i].kkmiters);
+      continue;
+    }
+    printf("%s:\n", initnames[i]);
+    printf("  ncut:             %.4f, balance %.3f\n", bench[i].ncut, bench[i].balance);
+    printf("  partition time:   %.3f s (average), %.3f s (best)\n", bench[i].parttime, bench[i].mintime);
+    printf("    coarsen:        %.3f s\n", bench[i].stats.coarsentime);
+    printf("    initial:        %.3f s (average)\n", bench[i].inittime);
+    printf("    refine:         %.3f s (average), %d kernel k-means iterations\n", bench[i].refinetime, bench[i].kkmiters);
+  }
+  if (ninits > 1 && initparts[1] == INITPART_SPECTRAL && bench[0].refinetime > 0)
+    printf("refine time spectral/metis: %.3f\n", bench[1].refinetime/bench[0].refinetime);
+  if (engines[ninits-1] == ENGINE_LABELPROP && ninits > 1 && bench[ninits-1].parttime > 0)
+    printf("label propagation: %.2fx faster, ncut %+.1f%%\n", bench[0].parttime/bench[ninits-1].parttime,
+           100.0*(bench[ninits-1].ncut-bench[0].ncut)/amax(bench[0].ncut, 1e-6));
+  if (ninits > 1 && ctypes[ninits-1] == MATCH_PSHEMN)
+    printf("coarsen time parallel/serial: %.3f, ncut %+.1f%%\n", bench[ninits-1].stats.coarsentime/amax(bench[0].stats.coarsentime, 1e-6),
+           100.0*(bench[ninits-1].ncut-bench[0].ncut)/amax(bench[0].ncut, 1e-6));
+  printf("workspace peak:     %.1f MB\n", GraclusPoolPeakSize(pool)/(1024.0*1024.0));
+  printf("peak RSS:           %.1f MB\n", PeakRSS());
+
+  GraclusPoolDestroy(pool);
+
+  return 0;
+}
@@ -7,52 +7,192 @@
 
 
 int boundary_points = 0;
-int spectral_initialization = 0;
 int cutType = 0; //cut type, default is normalized cut
 int memory_saving = 0; // forbid using local search or empty cluster removing
 
 /*************************************************************************
-* multi-level weighted kernel k-means main function
+* This function creates a memory pool for normalizedCut
 **************************************************************************/
-Graclus normalizedCut(char* filename, int nparts)
+GraclusPool *GraclusPoolCreate(void)
 {
-  Graclus ncData;
-  int options[11];
-  idxtype *part;  // cluster result stored in array part
-  float rubvec[MAXNCON], lbvec[MAXNCON];
-  GraphType graph;
-  int numflag = 0, wgtflag = 0, edgecut, chain_length = 0;
-  int no_args = 1, levels = 0;
+  return PoolCreate();
+}
 
+/*************************************************************************
+* This function frees a memory pool. The results of normalizedCut that 
+* were computed in the pool must have been freed by GraclusFree.
+**************************************************************************/
+void GraclusPoolDestroy(GraclusPool *pool)
+{
+  PoolDestroy(pool);
+}
 
-  no_args = 0;
-  
-  if (nparts < 2) 
-  {
-    printf("The number of partitions should be greater than 1!\n");
-    exit(0);
-  }
+/*************************************************************************
+* This function makes the following normalizedCut calls of the calling
+* thread take their memory from pool, or from the system if pool is NULL.
+* The pool keeps the freed memory, so repeated calls on graphs of similar
+* size do not go back to the system allocator.
+**************************************************************************/
+void GraclusUsePool(GraclusPool *pool)
+{
+  PoolActivate(pool);
+}
 
-  ReadGraph(&graph, filename, &wgtflag);
-  if (graph.nvtxs <= 0) 
+/*************************************************************************
+* This function returns the largest # of bytes of pool that were in use
+**************************************************************************/
+size_t GraclusPoolPeakSize(GraclusPool *pool)
+{
+  return PoolPeakSize(pool);
+}
+
+/*************************************************************************
+* This function fills options with the default parameters of normalizedCut.
+* options[0] is set, so the remaining entries are used by MLKKM.
+**************************************************************************/
+void GraclusSetDefaultOptions(int *options)
+{
+  int i;
+
+  for (i = 0; i < GRACLUS_NOPTIONS; i++)
+    options[i] = 0;
+
+  options[0] = 1;
+  options[OPTION_CTYPE] = KMETIS_CTYPE;
+  options[OPTION_ITYPE] = KMETIS_ITYPE;
+  options[OPTION_RTYPE] = KMETIS_RTYPE;
+  options[OPTION_DBGLVL] = KMETIS_DBGLVL;
+  options[OPTION_NTHREADS] = 1;
+  options[OPTION_NRESTARTS] = 1;
+  options[OPTION_SEED] = -1;
+  options[OPTION_INITPART] = INITPART_METIS;
+  options[OPTION_MAXPWGT] = 0;
+  options[OPTION_ENGINE] = ENGINE_MLKKM;
+}
+
+/*************************************************************************
+* The partitioning engines of normalizedCut, indexed by the ENGINE_* 
+* constants. They take the arguments of MLKKM_PartGraphKway.
+**************************************************************************/
+typedef void (*PartGraphFuncType)(int *, idxtype *, idxtype *, idxtype *, idxtype *, int *, int *, 
+                                  int *, int *, int *, int *, idxtype *, int, MLStatsType *);
+
+static PartGraphFuncType engines[] = {
+  MLKKM_PartGraphKway,      /* ENGINE_MLKKM */
+  LP_PartGraphKway          /* ENGINE_LABELPROP */
+};
+
+/*************************************************************************
+* The following data structure holds the state shared by the threads that
+* run the restarts of normalizedCut
+**************************************************************************/
+typedef struct restartdef
+{
+  GraphType *graph;
+  int wgtflag, nparts, levels;
+  int *options;
+  int nrestarts, ithreads;  /* # of restarts, # of threads inside a restart */
+  idxtype **parts;
+  float *ncuts;
+  double *times;
+  MLStatsType *stats;
+} RestartType;
+
+/*************************************************************************
+* This function returns the seed of restart r. Restart 0 uses the seed of
+* the options, so that a single run is not affected by the restarts.
+**************************************************************************/
+static int RestartSeed(int seed, int r)
+{
+  if (r == 0)
+    return seed;
+  return (seed == -1 ? 0 : seed) + 7919*r;
+}
+
+/*************************************************************************
+* This function runs the restarts tid, tid+nthreads, ... of normalizedCut
+**************************************************************************/
+static void RunRestarts(void *ptr, int tid, int nthreads)
+{
+  RestartType *rs = (RestartType *)ptr;
+  GraphType *graph = rs->graph;
+  int r, i, edgecut, numflag = 0, chain_length = 0, wgtflag;
+  int options[GRACLUS_NOPTIONS];
+  double tstart;
+  PartGraphFuncType partgraph;
+
+  partgraph = engines[rs->options[OPTION_ENGINE] == ENGINE_LABELPROP ? ENGINE_LABELPROP : ENGINE_MLKKM];
+  for (r = tid; r < rs->nrestarts; r += nthreads)
   {
-    puts("Empty graph. Nothing to do.\n");
-    exit(0);
+    for (i = 0; i < GRACLUS_NOPTIONS; i++)
+      options[i] = rs->options[i];
+    options[OPTION_NTHREADS] = rs->ithreads;
+    options[OPTION_NRESTARTS] = 1;
+    options[OPTION_SEED] = RestartSeed(rs->options[OPTION_SEED], r);
+    wgtflag = rs->wgtflag;
+
+    tstart = WallSeconds();
+    partgraph(&graph->nvtxs, graph->xadj, graph->adjncy, graph->vwgt, graph->adjwgt, 
+              &wgtflag, &numflag, &rs->nparts, &chain_length, options, &edgecut, 
+              rs->parts[r], rs->levels, rs->stats+r);
+    rs->times[r] = WallSeconds() - tstart;
+    rs->ncuts[r] = ComputeNCut(graph, rs->parts[r], rs->nparts);
   }
+}
+
+/*************************************************************************
+* This function partitions graph into nparts clusters for normalizedCut
+* and normalizedCutGraph, and frees the arrays of graph
+**************************************************************************/
+static Graclus PartitionGraph(GraphType *graphp, int wgtflag, int nparts, int *options, double readTime)
+{
+  Graclus ncData;
+  GraphType graph = *graphp;
+  idxtype *part;  // cluster result stored in array part
+  float rubvec[MAXNCON], lbvec[MAXNCON];
+  RestartType rs;
+  int nthreads, nrestarts, best, r;
+  int levels = 0;
+
+  nrestarts = amax(options[OPTION_NRESTARTS], 1);
+  ncData.readTime = readTime;
 
 	levels = amax((graph.nvtxs)/(40*log2_metis(nparts)), 20*(nparts));
   
   // if(graph.ncon > 1)
   //   printf("  Balancing Constraints: %d\n", graph.ncon);
 
-  part = idxmalloc(graph.nvtxs, "main: part");
-  options[0] = 0;
+  ncData.nrestarts = nrestarts;
+  ncData.bestRestart = 0;
+  ncData.restartNCut = sset(nrestarts, 0.0, fmalloc(nrestarts, "main: restartNCut"));
+  ncData.restartTime = (double *)GKmalloc(sizeof(double)*nrestarts, "main: restartTime");
+
+  rs.parts = (idxtype **)GKmalloc(sizeof(idxtype *)*nrestarts, "main: parts");
+  rs.stats = (MLStatsType *)GKmalloc(sizeof(MLStatsType)*nrestarts, "main: stats");
+  memset(rs.stats, 0, sizeof(MLStatsType)*nrestarts);
+  for (r = 0; r < nrestarts; r++)
+  {
+    rs.parts[r] = idxmalloc(graph.nvtxs, "main: part");
+    ncData.restartTime[r] = 0.0;
+  }
 
   // printf("#Clusters: %d\n", nparts);
   if (graph.ncon == 1) 
   {
-    MLKKM_PartGraphKway(&graph.nvtxs, graph.xadj, graph.adjncy, graph.vwgt, graph.adjwgt, 
-			  &wgtflag, &numflag, &nparts, &chain_length, options, &edgecut, part, levels);
+    /* The threads are shared between the restarts and the parallel coarsening */
+    nthreads = (options[OPTION_NTHREADS] > 0 ? options[OPTION_NTHREADS] : GetNumProcessors());
+
+    rs.graph = &graph;
+    rs.wgtflag = wgtflag;
+    rs.nparts = nparts;
+    rs.levels = levels;
+    rs.options = options;
+    rs.nrestarts = nrestarts;
+    rs.ithreads = amax(nthreads/amin(nthreads, nrestarts), 1);
+    rs.ncuts = ncData.restartNCut;
+    rs.times = ncData.restartTime;
+
+    RunThreads(amin(nthreads, nrestarts), RunRestarts, (void *)&rs);
   }
   else 
   {
@@ -61,14 +201,31 @@ Graclus normalizedCut(char* filename, int nparts)
       rubvec[i] = HORIZONTAL_IMBALANCE;
   }
 
+  for (best = 0, r = 1; r < nrestarts; r++)
+  {
+    if (ncData.restartNCut[r] < ncData.restartNCut[best])
+      best = r;
+  }
+  part = rs.parts[best];
+  for (r = 0; r < nrestarts; r++)
+  {
+    if (r != best)
+      GKdealloc(rs.parts[r]);
+  }
+  GKdealloc(rs.parts);
+  ncData.stats = rs.stats[best];
+  GKdealloc(rs.stats);
+
   ComputePartitionBalance(&graph, nparts, part, lbvec);
-  ComputeNCut(&graph, part, nparts);
+  ncData.ncut = ncData.restartNCut[best];
+  ncData.balance = lbvec[0];
   
   //for(int i = 0; i < graph.nvtxs; i++) printf("%d\n", part[i]);
   //int clusterNum = graph.nvtxs;
 
   ncData.part = part;
   ncData.clusterNum = graph.nvtxs;
+  ncData.bestRestart = best;
 
   //GKfree((void **) &graph.xadj, (void **) &graph.adjncy, (void **) &graph.vwgt, (void **) &graph.adjwgt, (void **) &part, LTERM);
   GKfree((void **) &graph.xadj, (void **) &graph.adjncy, (void **) &graph.vwgt, (void **) &graph.adjwgt, LTERM);  
@@ -76,6 +233,171 @@ Graclus normalizedCut(char* filename, int nparts)
   return ncData;
 }
 
+/*************************************************************************
+* This function returns the result of a call that could not partition the
+* graph: part is NULL and clusterNum is 0. GraclusFree accepts it.
+**************************************************************************/
+static Graclus EmptyResult(void)
+{
+  Graclus ncData;
+
+  memset(&ncData, 0, sizeof(Graclus));
+  return ncData;
+}
+
+/*************************************************************************
+* multi-level weighted kernel k-means main function
+* options may be NULL, in which case the default parameters are used.
+* options[OPTION_ENGINE] selects the partitioning engine.
+* options[OPTION_NRESTARTS] independent partitionings are computed 
+* concurrently and the one with the lowest normalized cut is returned.
+* If nparts < 2 or the graph is empty, part of the result is NULL.
+**************************************************************************/
+Graclus normalizedCut(char* filename, int nparts, int *options)
+{
+  int defaults[GRACLUS_NOPTIONS];
+  GraphType graph;
+  int wgtflag = 0;
+  double tstart;
+
+  if (nparts < 2) 
+  {
+    printf("The number of partitions should be greater than 1!\n");
+    return EmptyResult();
+  }
+
+  if (options == NULL)
+  {
+    GraclusSetDefaultOptions(defaults);
+    options = defaults;
+  }
+
+  tstart = WallSeconds();
+  ReadGraph(&graph, filename, &wgtflag, options[OPTION_NTHREADS]);
+  if (graph.nvtxs <= 0) 
+  {
+    puts("Empty graph. Nothing to do.\n");
+    return EmptyResult();
+  }
+
+  return PartitionGraph(&graph, wgtflag, nparts, options, WallSeconds() - tstart);
+}
+
+/*************************************************************************
+* This function is normalizedCut on a graph in memory instead of a file.
+* xadj, adjncy, vwgt and adjwgt are in the CSR format of the graphs of 
+* METIS, with the vertices numbered from 0 and every edge stored in the 
+* lists of both of its vertices. vwgt and adjwgt may be NULL for unit 
+* weights. The arrays are copied, they are not changed. If nparts < 2 or
+* nvtxs <= 0, part of the result is NULL.
+**************************************************************************/
+Graclus normalizedCutGraph(int nvtxs, idxtype *xadj, idxtype *adjncy, idxtype *vwgt, idxtype *adjwgt, 
+                           int nparts, int *options)
+{
+  int defaults[GRACLUS_NOPTIONS];
+  GraphType graph;
+  int wgtflag = 0;
+  double tstart;
+
+  if (nparts < 2) 
+  {
+    printf("The number of partitions should be greater than 1!\n");
+    return EmptyResult();
+  }
+  if (nvtxs <= 0) 
+  {
+    puts("Empty graph. Nothing to do.\n");
+    return EmptyResult();
+  }
+
+  if (options == NULL)
+  {
+    GraclusSetDefaultOptions(defaults);
+    options = defaults;
+  }
+
+  tstart = WallSeconds();
+  InitGraph(&graph);
+  graph.nvtxs = nvtxs;
+  graph.nedges = xadj[nvtxs];
+  graph.ncon = 1;
+  graph.xadj = idxcopy(nvtxs+1, xadj, idxmalloc(nvtxs+1, "normalizedCutGraph: xadj"));
+  graph.adjncy = idxcopy(graph.nedges, adjncy, idxmalloc(graph.nedges, "normalizedCutGraph: adjncy"));
+  graph.vwgt = NULL;
+  graph.adjwgt = NULL;
+  if (adjwgt != NULL) 
+  {
+    graph.adjwgt = idxcopy(graph.nedges, adjwgt, idxmalloc(graph.nedges, "normalizedCutGraph: adjwgt"));
+    wgtflag += 1;
+  }
+  if (vwgt != NULL) 
+  {
+    graph.vwgt = idxcopy(nvtxs, vwgt, idxmalloc(nvtxs, "normalizedCutGraph: vwgt"));
+    wgtflag += 2;
+  }
+
+  return PartitionGraph(&graph, wgtflag, nparts, options, WallSeconds() - tstart);
+}
+
+/*************************************************************************
+* This function refines the partitioning part of the graph in filename by
+* weighted kernel k-means, without coarsening the graph. part is not 
+* changed, the refined partitioning is returned in the result. options may
+* be NULL, in which case the default parameters are used. If the graph is
+* empty, part of the result is NULL.
+**************************************************************************/
+Graclus refineNormalizedCut(char* filename, int nparts, idxtype *part, int *options)
+{
+  Graclus ncData;
+  int defaults[GRACLUS_NOPTIONS];
+  float lbvec[MAXNCON];
+  GraphType graph;
+  int wgtflag = 0, chain_length = 0;
+  double tstart;
+
+  if (options == NULL)
+  {
+    GraclusSetDefaultOptions(defaults);
+    options = defaults;
+  }
+
+  tstart = WallSeconds();
+  ReadGraph(&graph, filename, &wgtflag, options[OPTION_NTHREADS]);
+  ncData.readTime = WallSeconds() - tstart;
+  if (graph.nvtxs <= 0) 
+  {
+    puts("Empty graph. Nothing to do.\n");
+    return EmptyResult();
+  }
+
+  ncData.part = idxcopy(graph.nvtxs, part, idxmalloc(graph.nvtxs, "refineNormalizedCut: part"));
+  MLKKM_RefineKway(&graph.nvtxs, graph.xadj, graph.adjncy, graph.vwgt, graph.adjwgt, &wgtflag, 
+                   &nparts, &chain_length, options, ncData.part, &ncData.stats);
+
+  ncData.nrestarts = 1;
+  ncData.bestRestart = 0;
+  ncData.restartNCut = fmalloc(1, "refineNormalizedCut: restartNCut");
+  ncData.restartTime = (double *)GKmalloc(sizeof(double), "refineNormalizedCut: restartTime");
+  ncData.restartNCut[0] = ncData.ncut = ComputeNCut(&graph, ncData.part, nparts);
+  ncData.restartTime[0] = ncData.stats.totaltime;
+  ComputePartitionBalance(&graph, nparts, ncData.part, lbvec);
+  ncData.balance = lbvec[0];
+  ncData.clusterNum = graph.nvtxs;
+
+  GKfree((void **) &graph.xadj, (void **) &graph.adjncy, (void **) &graph.vwgt, (void **) &graph.adjwgt, LTERM);  
+
+  return ncData;
+}
+
+/*************************************************************************
+* This function frees the memory of the result of normalizedCut or
+* refineNormalizedCut
+**************************************************************************/
+void GraclusFree(Graclus *ncData)
+{
+  GKfree((void **) &ncData->part, (void **) &ncData->restartNCut, (void **) &ncData->restartTime, LTERM);
+}
+
 /*************************************************************************
 * multi-level weighted kernel k-means main function
 **************************************************************************/
@@ -12,7 +12,29 @@ typedef struct graclus
 {
   idxtype* part;
   int clusterNum;
+  int nrestarts;        /* number of restarts that were run */
+  int bestRestart;      /* restart whose partitioning is returned in part */
+  float *restartNCut;   /* normalized cut of every restart */
+  double *restartTime;  /* wall clock seconds of every restart */
+  float ncut;           /* normalized cut of part */
+  float balance;        /* largest cluster size over the average cluster size */
+  double readTime;      /* wall clock seconds of reading the graph */
+  MLStatsType stats;    /* levels, kernel k-means iterations and phase timings of bestRestart */
 }Graclus;
-Graclus normalizedCut(char* filename, int nparts);
+
+/* Memory pool that keeps the workspace of normalizedCut between calls */
+typedef struct pooldef GraclusPool;
+
+GraclusPool *GraclusPoolCreate(void);
+void GraclusPoolDestroy(GraclusPool *pool);
+void GraclusUsePool(GraclusPool *pool);
+size_t GraclusPoolPeakSize(GraclusPool *pool);
+
+void GraclusSetDefaultOptions(int *options);
+Graclus normalizedCut(char* filename, int nparts, int *options);
+Graclus normalizedCutGraph(int nvtxs, idxtype *xadj, idxtype *adjncy, idxtype *vwgt, idxtype *adjwgt, 
+                           int nparts, int *options);
+Graclus refineNormalizedCut(char* filename, int nparts, idxtype *part, int *options);
+void GraclusFree(Graclus *ncData);
 
 #endif
\ No newline at end of file
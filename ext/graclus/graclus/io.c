@@ -13,6 +13,10 @@
  */
 
 #include <metis.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 /************************************************************************
  * This function reads in a clustering file and return #clusters
@@ -39,14 +43,14 @@ int readClustering(char *filename, int *part, int nvtex){
 void WriteCoarsestGraph(GraphType *graph, char *filename, int *wgtflag)
 {
   FILE *fpout;
-  int i, j, k, nvtxs;
-  idxtype *xadj, *adjncy, *adjwgt;
+  int i, k, nvtxs;
+  idxtype j, *xadj, *adjncy, *adjwgt;
 
   if ((fpout = fopen(filename, "w")) == NULL) {
     printf("Failed to open file %s\n", filename);
     exit(0);
   }
-  fprintf(fpout, "%d %d 1\n", graph->nvtxs, graph->nedges);
+  fprintf(fpout, "%d %" PRIDX " 1\n", graph->nvtxs, graph->nedges);
   xadj = graph->xadj;
   adjncy = graph->adjncy;
   adjwgt = graph->adjwgt;
@@ -54,7 +58,7 @@ void WriteCoarsestGraph(GraphType *graph, char *filename, int *wgtflag)
 
   for (i=0; i<nvtxs; i++){
     for (j=xadj[i]; j<xadj[i+1]; j++)
-      fprintf(fpout, "%d %d ", adjncy[j]+1, adjwgt[j]); //index starts from 1 
+      fprintf(fpout, "%" PRIDX " %" PRIDX " ", adjncy[j]+1, adjwgt[j]); //index starts from 1 
     fprintf(fpout, "\n");
   }
   
@@ -80,42 +84,265 @@ void ReadCoarsestInit(GraphType *graph, char *filename, int *wgtflag)
   where = graph->where;
 
   for (i=0; i<nvtxs; i++)
-    fscanf(fpin, "%d", &where[i]);
+    fscanf(fpin, "%" PRIDX, &where[i]);
   fclose(fpin);
 
 }
 
 /*************************************************************************
-* This function reads the spd matrix
+* The following data structure describes a chunk of whole lines of the
+* graph file that is parsed by one thread
+**************************************************************************/
+struct readchunkdef {
+  char *start, *end;		/* The bytes [start, end) of the chunk */
+  idxtype nlines;		/* The # of vertex lines of the chunk */
+  idxtype nedges;		/* The # of adjacency entries of these lines */
+  idxtype fvtx, fedge;		/* The first vertex and edge of the chunk */
+  idxtype errvtx;		/* The vertex of the first malformed line, or -1 */
+};
+
+typedef struct readchunkdef ReadChunkType;
+
+
+/*************************************************************************
+* The following data structure holds the state that the threads of
+* ReadGraph share
+**************************************************************************/
+struct readgraphdef {
+  GraphType *graph;
+  ReadChunkType *chunks;
+  int nchunks, readew, readvw, ncon;
+};
+
+typedef struct readgraphdef ReadGraphType;
+
+#define IsBlank(c)	((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+#define IsDigit(c)	((c) >= '0' && (c) <= '9')
+
+
+/*************************************************************************
+* This function returns the start of the line that follows the one that
+* ptr points into
 **************************************************************************/
-void ReadGraph(GraphType *graph, char *filename, int *wgtflag)
+static char *NextLine(char *ptr, char *end)
 {
-  int i, j, k, l, fmt, readew, readvw, ncon, edge, ewgt;
-  idxtype *xadj, *adjncy, *vwgt, *adjwgt;
-  char *line, *oldstr, *newstr;
-  FILE *fpin;
+  char *eol;
 
-  InitGraph(graph);
+  eol = (char *)memchr(ptr, '\n', end-ptr);
 
-  line = (char *)malloc(sizeof(char)*(MAXLINE+1));
+  return (eol == NULL ? end : eol+1);
+}
 
-  if ((fpin = fopen(filename, "r")) == NULL) {
+
+/*************************************************************************
+* This function parses the next integer of the line [ptr, eol). It returns
+* the position that follows the integer, or NULL if the line has no more
+* tokens. *ok is cleared if the token is not an integer.
+**************************************************************************/
+static char *ParseIdx(char *ptr, char *eol, idxtype *val, int *ok)
+{
+  int neg;
+  idxtype x;
+
+  while (ptr < eol && IsBlank(*ptr))
+    ptr++;
+  if (ptr == eol)
+    return NULL;
+
+  neg = (*ptr == '-');
+  if (neg || *ptr == '+')
+    ptr++;
+
+  if (ptr == eol || !IsDigit(*ptr)) {
+    *ok = 0;
+    return NULL;
+  }
+
+  for (x=0; ptr < eol && IsDigit(*ptr); ptr++)
+    x = 10*x + (*ptr - '0');
+
+  if (ptr < eol && !IsBlank(*ptr)) {
+    *ok = 0;
+    return NULL;
+  }
+
+  *val = (neg ? -x : x);
+  return ptr;
+}
+
+
+/*************************************************************************
+* This function counts the vertex lines of a chunk, up to maxlines of them
+* if maxlines >= 0, and the adjacency entries that these lines hold
+**************************************************************************/
+static void CountChunk(ReadChunkType *chunk, idxtype maxlines, int readew, int readvw, int ncon)
+{
+  idxtype ntokens;
+  char *ptr, *eol;
+
+  chunk->nlines = chunk->nedges = 0;
+  for (ptr=chunk->start; ptr<chunk->end; ptr=eol) {
+    if (maxlines >= 0 && chunk->nlines == maxlines)
+      break;
+
+    eol = NextLine(ptr, chunk->end);
+    if (*ptr == '%')
+      continue;
+
+    for (ntokens=0; ; ntokens++) {
+      while (ptr < eol && IsBlank(*ptr))
+        ptr++;
+      if (ptr == eol)
+        break;
+      while (ptr < eol && !IsBlank(*ptr))
+        ptr++;
+    }
+
+    /* Malformed lines are counted as they are and reported by ParseChunk */
+    if (readvw)
+      ntokens = amax(ntokens-ncon, 0);
+
+    chunk->nlines++;
+    chunk->nedges += (readew ? ntokens/2 : ntokens);
+  }
+}
+
+
+/*************************************************************************
+* This function parses the vertex lines of a chunk into the arrays of the
+* graph, starting at vertex chunk->fvtx and at edge chunk->fedge
+**************************************************************************/
+static void ParseChunk(ReadGraphType *rg, ReadChunkType *chunk)
+{
+  int l, ok;
+  idxtype v, k, lastv, edge, ewgt, nvtxs, *xadj, *adjncy, *vwgt, *adjwgt;
+  char *ptr, *eol;
+
+  nvtxs = rg->graph->nvtxs;
+  xadj = rg->graph->xadj;
+  adjncy = rg->graph->adjncy;
+  vwgt = rg->graph->vwgt;
+  adjwgt = rg->graph->adjwgt;
+
+  chunk->errvtx = -1;
+  lastv = chunk->fvtx + chunk->nlines;
+
+  for (v=chunk->fvtx, k=chunk->fedge, ptr=chunk->start; v<lastv; ptr=eol) {
+    eol = NextLine(ptr, chunk->end);
+    if (*ptr == '%')
+      continue;
+
+    ok = 1;
+    if (rg->readvw) {
+      for (l=0; l<rg->ncon && ok; l++) {
+        if ((ptr = ParseIdx(ptr, eol, vwgt+v*rg->ncon+l, &ok)) == NULL)
+          ok = 0;
+      }
+    }
+
+    while (ok && (ptr = ParseIdx(ptr, eol, &edge, &ok)) != NULL) {
+      if (edge < 1 || edge > nvtxs) {
+        ok = 0;
+        break;
+      }
+
+      if (rg->readew) {
+        if ((ptr = ParseIdx(ptr, eol, &ewgt, &ok)) == NULL) {
+          ok = 0;
+          break;
+        }
+        adjwgt[k] = ewgt;
+      }
+      adjncy[k++] = edge-1;
+    }
+
+    if (!ok) {
+      chunk->errvtx = v;
+      return;
+    }
+
+    xadj[++v] = k;
+  }
+}
+
+
+/*************************************************************************
+* These functions are the thread bodies of the two passes of ReadGraph
+**************************************************************************/
+static void CountChunks(void *arg, int tid, int nthreads)
+{
+  int c;
+  ReadGraphType *rg = (ReadGraphType *)arg;
+
+  for (c=tid; c<rg->nchunks; c+=nthreads)
+    CountChunk(rg->chunks+c, -1, rg->readew, rg->readvw, rg->ncon);
+}
+
+static void ParseChunks(void *arg, int tid, int nthreads)
+{
+  int c;
+  ReadGraphType *rg = (ReadGraphType *)arg;
+
+  for (c=tid; c<rg->nchunks; c+=nthreads)
+    ParseChunk(rg, rg->chunks+c);
+}
+
+
+/*************************************************************************
+* This function reads the spd matrix. The file is mapped into memory and
+* its lines are split into one chunk per thread. A first pass counts the
+* vertices and the edges of every chunk, so that the chunks know where
+* their part of xadj and adjncy starts, and a second pass parses them.
+* nthreads <= 0 uses all the processors.
+**************************************************************************/
+void ReadGraph(GraphType *graph, char *filename, int *wgtflag, int nthreads)
+{
+  int c, fd, fmt, readew, readvw, ncon, nchunks;
+  idxtype v, k;
+  size_t size, len;
+  char *map, *end, *body, *ptr, header[256];
+  struct stat st;
+  ReadGraphType rg;
+  ReadChunkType *chunks;
+
+  InitGraph(graph);
+
+  if ((fd = open(filename, O_RDONLY)) == -1) {
     printf("Failed to open file %s\n", filename);
     exit(0);
   }
 
-  do {
-    fgets(line, MAXLINE, fpin);
-  } while (line[0] == '%' && !feof(fpin));
+  if (fstat(fd, &st) == -1)
+    errexit("ReadGraph: Failed to stat file %s\n", filename);
+  size = (size_t)st.st_size;
 
-  if (feof(fpin)) {
+  if (size == 0) {
     graph->nvtxs = 0;
-    free(line);
+    close(fd);
     return;
   }
 
+  if ((map = (char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+    errexit("ReadGraph: Failed to map file %s\n", filename);
+  close(fd);
+  madvise(map, size, MADV_SEQUENTIAL);
+  end = map+size;
+
+  for (ptr=map; ptr<end && *ptr=='%'; ptr=NextLine(ptr, end));
+
+  if (ptr == end) {
+    graph->nvtxs = 0;
+    munmap(map, size);
+    return;
+  }
+
+  body = NextLine(ptr, end);
+  len = amin((size_t)(body-ptr), sizeof(header)-1);
+  memcpy(header, ptr, len);
+  header[len] = '\0';
+
   fmt = ncon = 0;
-  sscanf(line, "%d %d %d %d", &(graph->nvtxs), &(graph->nedges), &fmt, &ncon);
+  sscanf(header, "%d %" PRIDX " %d %d", &(graph->nvtxs), &(graph->nedges), &fmt, &ncon);
 
   readew = (fmt%10 > 0);
   readvw = ((fmt/10)%10 > 0);
@@ -147,57 +374,73 @@ void ReadGraph(GraphType *graph, char *filename, int *wgtflag)
   /*if (graph->nvtxs > MAXIDX) 
     errexit("\nThe matrix is too big: %d [%d %d]\n", graph->nvtxs, MAXIDX, sizeof(idxtype));
   */
-  xadj = graph->xadj = idxsmalloc(graph->nvtxs+1, 0, "ReadGraph: xadj");
-  adjncy = graph->adjncy = idxmalloc(graph->nedges, "ReadGraph: adjncy");
-
-  vwgt = graph->vwgt = (readvw ? idxmalloc(ncon*graph->nvtxs, "ReadGraph: vwgt") : NULL);
-  adjwgt = graph->adjwgt = (readew ? idxmalloc(graph->nedges, "ReadGraph: adjwgt") : NULL);
 
+  /* Split the lines of the file into one chunk per thread */
+  if (nthreads <= 0)
+    nthreads = GetNumProcessors();
+  nchunks = (int)amax(amin((size_t)nthreads, (size_t)(end-body)/PARALLEL_MINREAD), 1);
 
-  /* Start reading the graph file */
-  for (xadj[0]=0, k=0, i=0; i<graph->nvtxs; i++) {
-    do {
-      fgets(line, MAXLINE, fpin);
-    } while (line[0] == '%' && !feof(fpin));
-    oldstr = line;
-    newstr = NULL;
-
-    if (strlen(line) == MAXLINE) 
-      errexit("\nBuffer for fgets not big enough!\n");
+  chunks = (ReadChunkType *)GKmalloc(sizeof(ReadChunkType)*nchunks, "ReadGraph: chunks");
+  for (c=0; c<nchunks; c++) {
+    ptr = body + (size_t)(end-body)/nchunks*c;
+    chunks[c].start = (c == 0 || ptr[-1] == '\n' ? ptr : NextLine(ptr, end));
+  }
+  for (c=0; c<nchunks; c++)
+    chunks[c].end = (c+1 < nchunks ? chunks[c+1].start : end);
+
+  rg.graph = graph;
+  rg.chunks = chunks;
+  rg.nchunks = nchunks;
+  rg.readew = readew;
+  rg.readvw = readvw;
+  rg.ncon = ncon;
+
+  RunThreads(nchunks, CountChunks, (void *)&rg);
+
+  /* Find the first vertex and edge of every chunk. The lines that follow
+     the last vertex are ignored. The malformed lines are reported before
+     the # of edges is checked against the header. */
+  for (v=0, k=0, c=0; c<nchunks; c++) {
+    if (chunks[c].nlines > graph->nvtxs-v)
+      CountChunk(chunks+c, graph->nvtxs-v, readew, readvw, ncon);
+
+    chunks[c].fvtx = v;
+    chunks[c].fedge = k;
+    v += chunks[c].nlines;
+    k += chunks[c].nedges;
+  }
 
-    if (readvw) {
-      for (l=0; l<ncon; l++) {
-        vwgt[i*ncon+l] = (int)strtol(oldstr, &newstr, 10);
-        oldstr = newstr;
-      }
-    }
+  if (v < graph->nvtxs) {
+    printf("------------------------------------------------------------------------------\n");
+    printf("***  I detected an error in your input file  ***\n\n");
+    printf("In the first line of the file, you specified that the graph contained\n%d vertices. However, I only found %" PRIDX " vertex lines in the file.\n", graph->nvtxs, v);
+    printf("------------------------------------------------------------------------------\n");
+    exit(0);
+  }
 
-    for (;;) {
-      edge = (idxtype)strtol(oldstr, &newstr, 10) -1;
-      oldstr = newstr;
+  graph->xadj = idxsmalloc(graph->nvtxs+1, 0, "ReadGraph: xadj");
+  graph->adjncy = idxmalloc(k, "ReadGraph: adjncy");
 
-      if (readew) {
-        ewgt = (idxtype)strtol(oldstr, &newstr, 10);
-        oldstr = newstr;
-      }
+  graph->vwgt = (readvw ? idxmalloc(ncon*graph->nvtxs, "ReadGraph: vwgt") : NULL);
+  graph->adjwgt = (readew ? idxmalloc(k, "ReadGraph: adjwgt") : NULL);
 
-      if (edge < 0)
-        break;
+  RunThreads(nchunks, ParseChunks, (void *)&rg);
 
-      adjncy[k] = edge;
-      if (readew) 
-        adjwgt[k] = ewgt;
-      k++;
-    } 
-    xadj[i+1] = k;
+  for (c=0; c<nchunks; c++) {
+    if (chunks[c].errvtx != -1) {
+      printf("------------------------------------------------------------------------------\n");
+      printf("***  I detected an error in your input file  ***\n\n");
+      printf("The line of vertex %" PRIDX " holds a token that is not an integer, a neighbor\n", chunks[c].errvtx+1);
+      printf("that is not in [1, %d], or an edge without a weight.\n", graph->nvtxs);
+      printf("------------------------------------------------------------------------------\n");
+      exit(0);
+    }
   }
 
-  fclose(fpin);
-
   if (k != graph->nedges) {
     printf("------------------------------------------------------------------------------\n");
     printf("***  I detected an error in your input file  ***\n\n");
-    printf("In the first line of the file, you specified that the graph contained\n%d edges. However, I only found %d edges in the file.\n", graph->nedges/2, k/2);
+    printf("In the first line of the file, you specified that the graph contained\n%" PRIDX " edges. However, I only found %" PRIDX " edges in the file.\n", graph->nedges/2, k/2);
     if (2*k == graph->nedges) {
       printf("\n *> I detected that you specified twice the number of edges that you have in\n");
       printf("    the file. Remember that the number of edges specified in the first line\n");
@@ -208,7 +451,8 @@ void ReadGraph(GraphType *graph, char *filename, int *wgtflag)
     exit(0);
   }
 
-  free(line);
+  GKdealloc(chunks);
+  munmap(map, size);
 
 }
 
@@ -230,7 +474,7 @@ void WritePartition(char *fname, idxtype *part, int n, int nparts)
     errexit("Problems in opening the partition file: %s", filename);
 
   for (i=0; i<n; i++)
-    fprintf(fpout,"%d\n",part[i]);
+    fprintf(fpout,"%" PRIDX "\n",part[i]);
 
   fclose(fpout);
 
@@ -252,7 +496,7 @@ void WriteMeshPartition(char *fname, int nparts, int ne, idxtype *epart, int nn,
     errexit("Problems in opening the partition file: %s", filename);
 
   for (i=0; i<ne; i++)
-    fprintf(fpout,"%d\n", epart[i]);
+    fprintf(fpout,"%" PRIDX "\n", epart[i]);
 
   fclose(fpout);
 
@@ -262,7 +506,7 @@ void WriteMeshPartition(char *fname, int nparts, int ne, idxtype *epart, int nn,
     errexit("Problems in opening the partition file: %s", filename);
 
   for (i=0; i<nn; i++)
-    fprintf(fpout,"%d\n", npart[i]);
+    fprintf(fpout,"%" PRIDX "\n", npart[i]);
 
   fclose(fpout);
 
@@ -286,7 +530,7 @@ void WritePermutation(char *fname, idxtype *iperm, int n)
     errexit("Problems in opening the permutation file: %s", filename);
 
   for (i=0; i<n; i++)
-    fprintf(fpout,"%d\n", iperm[i]);
+    fprintf(fpout,"%" PRIDX "\n", iperm[i]);
 
   fclose(fpout);
 
@@ -320,7 +564,7 @@ int CheckGraph(GraphType *graph)
         for (l=xadj[k]; l<xadj[k+1]; l++) {
           if (adjncy[l] == i) {
             if (adjwgt != NULL && adjwgt[l] != adjwgt[j]) {
-              printf("Edges (%d %d) and (%d %d) do not have the same weight! %d %d\n", i,k,k,i, adjwgt[l], adjwgt[adjncy[j]]);
+              printf("Edges (%d %d) and (%d %d) do not have the same weight! %" PRIDX " %" PRIDX "\n", i,k,k,i, adjwgt[l], adjwgt[adjncy[j]]);
               err++;
             }
             break;
@@ -377,7 +621,7 @@ idxtype *ReadMesh(char *filename, int *ne, int *nn, int *etype)
   elmnts = idxmalloc(esize*(*ne), "ReadMesh: elmnts");
 
   for (j=esize*(*ne), i=0; i<j; i++) {
-    fscanf(fpin, "%d", elmnts+i);
+    fscanf(fpin, "%" PRIDX, elmnts+i);
     elmnts[i]--;
   }
 
@@ -402,12 +646,12 @@ void WriteGraph(char *filename, int nvtxs, idxtype *xadj, idxtype *adjncy)
     exit(0);
   }
 
-  fprintf(fpout, "%d %d", nvtxs, xadj[nvtxs]/2);
+  fprintf(fpout, "%d %" PRIDX, nvtxs, xadj[nvtxs]/2);
 
   for (i=0; i<nvtxs; i++) {
     fprintf(fpout, "\n");
     for (j=xadj[i]; j<xadj[i+1]; j++)
-      fprintf(fpout, " %d", adjncy[j]+1);
+      fprintf(fpout, " %" PRIDX, adjncy[j]+1);
   }
 
   fclose(fpout);
@@ -438,7 +682,7 @@ void WriteMocGraph(GraphType *graph)
     exit(0);
   }
 
-  fprintf(fpout, "%d %d 10 1 %d", nvtxs, xadj[nvtxs]/2, ncon);
+  fprintf(fpout, "%d %" PRIDX " 10 1 %d", nvtxs, xadj[nvtxs]/2, ncon);
 
   for (i=0; i<nvtxs; i++) {
     fprintf(fpout, "\n");
@@ -446,7 +690,7 @@ void WriteMocGraph(GraphType *graph)
       fprintf(fpout, "%d ", (int)((float)10e6*nvwgt[i*ncon+j]));
 
     for (j=xadj[i]; j<xadj[i+1]; j++)
-      fprintf(fpout, " %d", adjncy[j]+1);
+      fprintf(fpout, " %" PRIDX, adjncy[j]+1);
   }
 
   fclose(fpout);
@@ -74,7 +74,7 @@ void Bnd2WayBalance(CtrlType *ctrl, GraphType *graph, int *tpwgts)
   to = (from+1)%2;
 
   IFSET(ctrl->dbglvl, DBG_REFINE, 
-     printf("Partitions: [%6d %6d] T[%6d %6d], Nv-Nb[%6d %6d]. ICut: %6d [B]\n",
+     printf("Partitions: [%6" PRIDX " %6" PRIDX "] T[%6d %6d], Nv-Nb[%6d %6d]. ICut: %6d [B]\n",
              pwgts[0], pwgts[1], tpwgts[0], tpwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
 
   tmp = graph->adjwgtsum[idxamax(nvtxs, graph->adjwgtsum)];
@@ -112,7 +112,7 @@ void Bnd2WayBalance(CtrlType *ctrl, GraphType *graph, int *tpwgts)
     moved[higain] = nswaps;
 
     IFSET(ctrl->dbglvl, DBG_MOVEINFO, 
-      printf("Moved %6d from %d. [%3d %3d] %5d [%4d %4d]\n", higain, from, ed[higain]-id[higain], vwgt[higain], mincut, pwgts[0], pwgts[1]));
+      printf("Moved %6d from %d. [%3" PRIDX " %3" PRIDX "] %5d [%4" PRIDX " %4" PRIDX "]\n", higain, from, ed[higain]-id[higain], vwgt[higain], mincut, pwgts[0], pwgts[1]));
 
     /**************************************************************
     * Update the id[i]/ed[i] values of the affected nodes
@@ -151,7 +151,7 @@ void Bnd2WayBalance(CtrlType *ctrl, GraphType *graph, int *tpwgts)
   }
 
   IFSET(ctrl->dbglvl, DBG_REFINE, 
-    printf("\tMinimum cut: %6d, PWGTS: [%6d %6d], NBND: %6d\n", mincut, pwgts[0], pwgts[1], nbnd));
+    printf("\tMinimum cut: %6d, PWGTS: [%6" PRIDX " %6" PRIDX "], NBND: %6d\n", mincut, pwgts[0], pwgts[1], nbnd));
 
   graph->mincut = mincut;
   graph->nbnd = nbnd;
@@ -200,7 +200,7 @@ void General2WayBalance(CtrlType *ctrl, GraphType *graph, int *tpwgts)
   to = (from+1)%2;
 
   IFSET(ctrl->dbglvl, DBG_REFINE, 
-     printf("Partitions: [%6d %6d] T[%6d %6d], Nv-Nb[%6d %6d]. ICut: %6d [B]\n",
+     printf("Partitions: [%6" PRIDX " %6" PRIDX "] T[%6d %6d], Nv-Nb[%6d %6d]. ICut: %6d [B]\n",
              pwgts[0], pwgts[1], tpwgts[0], tpwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
 
   tmp = graph->adjwgtsum[idxamax(nvtxs, graph->adjwgtsum)];
@@ -235,7 +235,7 @@ void General2WayBalance(CtrlType *ctrl, GraphType *graph, int *tpwgts)
     moved[higain] = nswaps;
 
     IFSET(ctrl->dbglvl, DBG_MOVEINFO, 
-      printf("Moved %6d from %d. [%3d %3d] %5d [%4d %4d]\n", higain, from, ed[higain]-id[higain], vwgt[higain], mincut, pwgts[0], pwgts[1]));
+      printf("Moved %6d from %d. [%3" PRIDX " %3" PRIDX "] %5d [%4" PRIDX " %4" PRIDX "]\n", higain, from, ed[higain]-id[higain], vwgt[higain], mincut, pwgts[0], pwgts[1]));
 
     /**************************************************************
     * Update the id[i]/ed[i] values of the affected nodes
@@ -266,7 +266,7 @@ void General2WayBalance(CtrlType *ctrl, GraphType *graph, int *tpwgts)
   }
 
   IFSET(ctrl->dbglvl, DBG_REFINE, 
-    printf("\tMinimum cut: %6d, PWGTS: [%6d %6d], NBND: %6d\n", mincut, pwgts[0], pwgts[1], nbnd));
+    printf("\tMinimum cut: %6d, PWGTS: [%6" PRIDX " %6" PRIDX "], NBND: %6d\n", mincut, pwgts[0], pwgts[1], nbnd));
 
   graph->mincut = mincut;
   graph->nbnd = nbnd;
@@ -38,6 +38,6 @@ void BucketSortKeysInc(int n, int max, idxtype *keys, idxtype *tperm, idxtype *p
     perm[counts[keys[i]]++] = i;
   }
 
-  free(counts);
+  GKdealloc(counts);
 }
 
@@ -21,7 +21,8 @@
 **************************************************************************/
 void CreateCoarseGraph(CtrlType *ctrl, GraphType *graph, int cnvtxs, idxtype *match, idxtype *perm)
 {
-  int i, j, jj, k, kk, l, m, istart, iend, nvtxs, nedges, ncon, cnedges, v, u, mask, dovsize;
+  int i, jj, k, kk, l, m, nvtxs, nedges, ncon, v, u, mask, dovsize;
+  idxtype j, istart, iend, cnedges;
   idxtype *xadj, *vwgt, *vsize, *adjncy, *adjwgt, *adjwgtsum, *auxadj;
   idxtype *cmap, *htable;
   idxtype *cxadj, *cvwgt, *cvsize, *cadjncy, *cadjwgt, *cadjwgtsum;
@@ -63,8 +64,8 @@ void CreateCoarseGraph(CtrlType *ctrl, GraphType *graph, int cnvtxs, idxtype *ma
   iend = xadj[nvtxs];
   auxadj = ctrl->wspace.auxcore; 
   memcpy(auxadj, adjncy, iend*sizeof(idxtype)); 
-  for (i=0; i<iend; i++)
-    auxadj[i] = cmap[auxadj[i]];
+  for (j=0; j<iend; j++)
+    auxadj[j] = cmap[auxadj[j]];
 
   htable = idxset(mask+1, -1, idxwspacemalloc(ctrl, mask+1)); 
 
@@ -194,7 +195,8 @@ void CreateCoarseGraph(CtrlType *ctrl, GraphType *graph, int cnvtxs, idxtype *ma
 **************************************************************************/
 void CreateCoarseGraphNoMask(CtrlType *ctrl, GraphType *graph, int cnvtxs, idxtype *match, idxtype *perm)
 {
-  int i, j, k, m, istart, iend, nvtxs, nedges, ncon, cnedges, v, u, dovsize;
+  int i, k, m, nvtxs, nedges, ncon, v, u, dovsize;
+  idxtype j, istart, iend, cnedges;
   idxtype *xadj, *vwgt, *vsize, *adjncy, *adjwgt, *adjwgtsum, *auxadj;
   idxtype *cmap, *htable;
   idxtype *cxadj, *cvwgt, *cvsize, *cadjncy, *cadjwgt, *cadjwgtsum;
@@ -233,8 +235,8 @@ void CreateCoarseGraphNoMask(CtrlType *ctrl, GraphType *graph, int cnvtxs, idxty
   iend = xadj[nvtxs];
   auxadj = ctrl->wspace.auxcore; 
   memcpy(auxadj, adjncy, iend*sizeof(idxtype)); 
-  for (i=0; i<iend; i++)
-    auxadj[i] = cmap[auxadj[i]];
+  for (j=0; j<iend; j++)
+    auxadj[j] = cmap[auxadj[j]];
 
   cxadj[0] = cnvtxs = cnedges = 0;
   for (i=0; i<nvtxs; i++) {
@@ -360,8 +362,8 @@ void CreateCoarseGraph_NVW(CtrlType *ctrl, GraphType *graph, int cnvtxs, idxtype
   iend = xadj[nvtxs];
   auxadj = ctrl->wspace.auxcore; 
   memcpy(auxadj, adjncy, iend*sizeof(idxtype)); 
-  for (i=0; i<iend; i++)
-    auxadj[i] = cmap[auxadj[i]];
+  for (j=0; j<iend; j++)
+    auxadj[j] = cmap[auxadj[j]];
 
   mask = HTLENGTH;
   htable = idxset(mask+1, -1, idxwspacemalloc(ctrl, mask+1)); 
@@ -548,7 +550,7 @@ void ReAdjustMemory(GraphType *graph, GraphType *cgraph, int dovsize)
 
     if (graph->ncon == 1) {
       if (dovsize) {
-        cgraph->gdata = (idxtype*) realloc(cgraph->gdata, (5*cgraph->nvtxs+1 + 2*cgraph->nedges)*sizeof(idxtype));
+        cgraph->gdata = (idxtype*) GKrealloc(cgraph->gdata, (5*cgraph->nvtxs+1 + 2*cgraph->nedges)*sizeof(idxtype), "ReAdjustMemory: gdata");
 
         /* Do this, in case everything was copied into new space */
         cgraph->xadj 		= cgraph->gdata;
@@ -560,7 +562,7 @@ void ReAdjustMemory(GraphType *graph, GraphType *cgraph, int dovsize)
         cgraph->adjwgt 		= cgraph->gdata + 5*cgraph->nvtxs+1 + cgraph->nedges;
       }
       else {
-        cgraph->gdata = (idxtype*) realloc(cgraph->gdata, (4*cgraph->nvtxs+1 + 2*cgraph->nedges)*sizeof(idxtype));
+        cgraph->gdata = (idxtype*) GKrealloc(cgraph->gdata, (4*cgraph->nvtxs+1 + 2*cgraph->nedges)*sizeof(idxtype), "ReAdjustMemory: gdata");
 
         /* Do this, in case everything was copied into new space */
         cgraph->xadj 	= cgraph->gdata;
@@ -573,7 +575,7 @@ void ReAdjustMemory(GraphType *graph, GraphType *cgraph, int dovsize)
     }
     else {
       if (dovsize) {
-        cgraph->gdata = (idxtype*) realloc(cgraph->gdata, (4*cgraph->nvtxs+1 + 2*cgraph->nedges)*sizeof(idxtype));
+        cgraph->gdata = (idxtype*) GKrealloc(cgraph->gdata, (4*cgraph->nvtxs+1 + 2*cgraph->nedges)*sizeof(idxtype), "ReAdjustMemory: gdata");
 
         /* Do this, in case everything was copied into new space */
         cgraph->xadj 		= cgraph->gdata;
@@ -584,7 +586,7 @@ void ReAdjustMemory(GraphType *graph, GraphType *cgraph, int dovsize)
         cgraph->adjwgt 		= cgraph->gdata + 4*cgraph->nvtxs+1 + cgraph->nedges;
       }
       else {
-        cgraph->gdata = (idxtype*) realloc(cgraph->gdata, (3*cgraph->nvtxs+1 + 2*cgraph->nedges)*sizeof(idxtype));
+        cgraph->gdata = (idxtype*) GKrealloc(cgraph->gdata, (3*cgraph->nvtxs+1 + 2*cgraph->nedges)*sizeof(idxtype), "ReAdjustMemory: gdata");
 
         /* Do this, in case everything was copied into new space */
         cgraph->xadj 		= cgraph->gdata;
@@ -597,3 +599,195 @@ void ReAdjustMemory(GraphType *graph, GraphType *cgraph, int dovsize)
   }
 
 }
+
+
+/*************************************************************************
+* The following data structure holds the state that is shared by the 
+* threads of CreateCoarseGraphParallel
+**************************************************************************/
+struct pcontractdef {
+  GraphType *graph, *cgraph;
+  idxtype *match, *cperm;
+  idxtype **htables;		/* Per thread open addressing hash tables */
+  int *hmasks;
+  idxtype *tnedges;		/* Per thread # of coarse edges */
+};
+
+typedef struct pcontractdef PContractType;
+
+#define PHASH(k, mask) ((int)(((unsigned int)(k)*2654435761U)&(mask)))
+
+
+/*************************************************************************
+* This function merges the adjacency lists of the fine vertices v and u
+* that form the coarse vertex c. The distinct coarse neighbors are written
+* to cadjncy/cadjwgt (unless cadjncy is NULL) and their number is returned.
+* htable holds 3 words (stamp, key, position) per slot; a slot belongs to 
+* the current coarse vertex only if its stamp equals c.
+**************************************************************************/
+static int ContractCoarseVertex(GraphType *graph, int c, int v, int u, idxtype *htable, int hmask, 
+                                idxtype *cadjncy, idxtype *cadjwgt, int *selfwgt)
+{
+  int k, h, l, w, nedges;
+  idxtype j, *xadj, *adjncy, *adjwgt, *cmap;
+
+  xadj = graph->xadj;
+  adjncy = graph->adjncy;
+  adjwgt = graph->adjwgt;
+  cmap = graph->cmap;
+
+  nedges = 0;
+  *selfwgt = 0;
+
+  for (l=0; l<2; l++) {
+    w = (l == 0 ? v : u);
+    if (l == 1 && u == v)
+      break;
+
+    for (j=xadj[w]; j<xadj[w+1]; j++) {
+      k = cmap[adjncy[j]];
+      if (k == c) {  /* This edge is contracted away */
+        *selfwgt += adjwgt[j];
+        continue;
+      }
+
+      for (h=PHASH(k, hmask); htable[3*h] == c && htable[3*h+1] != k; h=(h+1)&hmask);
+
+      if (htable[3*h] != c) {
+        htable[3*h] = c;
+        htable[3*h+1] = k;
+        htable[3*h+2] = nedges;
+        if (cadjncy != NULL) {
+          cadjncy[nedges] = k;
+          cadjwgt[nedges] = adjwgt[j];
+        }
+        nedges++;
+      }
+      else if (cadjncy != NULL) {
+        cadjwgt[htable[3*h+2]] += adjwgt[j];
+      }
+    }
+  }
+
+  return nedges;
+}
+
+
+/*************************************************************************
+* This function counts the edges of the coarse vertices owned by thread tid
+**************************************************************************/
+static void PContractCount(void *ptr, int tid, int nthreads)
+{
+  int c, v, u, cstart, cend, maxdeg, hsize, selfwgt;
+  idxtype *xadj, *match, *cperm;
+  PContractType *pc = (PContractType *)ptr;
+
+  xadj = pc->graph->xadj;
+  match = pc->match;
+  cperm = pc->cperm;
+
+  ThreadRange(pc->cgraph->nvtxs, tid, nthreads, &cstart, &cend);
+
+  /* Size the hash table so that it is at most half full */
+  for (maxdeg=1, c=cstart; c<cend; c++) {
+    v = cperm[c];
+    u = match[v];
+    maxdeg = amax(maxdeg, (xadj[v+1]-xadj[v]) + (u != v ? xadj[u+1]-xadj[u] : 0));
+  }
+  for (hsize=1; hsize<2*maxdeg; hsize<<=1);
+
+  pc->hmasks[tid] = hsize-1;
+  pc->htables[tid] = idxsmalloc(3*hsize, -1, "PContractCount: htable");
+
+  pc->tnedges[tid] = 0;
+  for (c=cstart; c<cend; c++) {
+    v = cperm[c];
+    pc->tnedges[tid] += ContractCoarseVertex(pc->graph, c, v, match[v], pc->htables[tid], 
+                                             pc->hmasks[tid], NULL, NULL, &selfwgt);
+  }
+}
+
+
+/*************************************************************************
+* This function fills in the coarse vertices owned by thread tid
+**************************************************************************/
+static void PContractFill(void *ptr, int tid, int nthreads)
+{
+  int i, c, v, u, cstart, cend, selfwgt;
+  idxtype nedges, *vwgt, *adjwgtsum, *match, *cperm, *htable;
+  idxtype *cxadj, *cvwgt, *cadjncy, *cadjwgt, *cadjwgtsum;
+  PContractType *pc = (PContractType *)ptr;
+
+  vwgt = pc->graph->vwgt;
+  adjwgtsum = pc->graph->adjwgtsum;
+  match = pc->match;
+  cperm = pc->cperm;
+
+  cxadj = pc->cgraph->xadj;
+  cvwgt = pc->cgraph->vwgt;
+  cadjncy = pc->cgraph->adjncy;
+  cadjwgt = pc->cgraph->adjwgt;
+  cadjwgtsum = pc->cgraph->adjwgtsum;
+
+  ThreadRange(pc->cgraph->nvtxs, tid, nthreads, &cstart, &cend);
+
+  /* The coarse edges of this thread start after those of the preceding threads */
+  for (nedges=0, i=0; i<tid; i++)
+    nedges += pc->tnedges[i];
+
+  htable = idxset(3*(pc->hmasks[tid]+1), -1, pc->htables[tid]);
+
+  for (c=cstart; c<cend; c++) {
+    v = cperm[c];
+    u = match[v];
+
+    cvwgt[c] = vwgt[v] + (u != v ? vwgt[u] : 0);
+
+    nedges += ContractCoarseVertex(pc->graph, c, v, u, htable, pc->hmasks[tid], 
+                                   cadjncy+nedges, cadjwgt+nedges, &selfwgt);
+    cxadj[c+1] = nedges;
+
+    cadjwgtsum[c] = adjwgtsum[v] + (u != v ? adjwgtsum[u] : 0) - selfwgt;
+  }
+
+  GKdealloc(pc->htables[tid]);
+}
+
+
+/*************************************************************************
+* This function creates the coarser graph using nthreads threads. 
+* cperm[c] is the lower numbered fine vertex of coarse vertex c, and 
+* graph->cmap must already map the fine vertices to the coarse ones.
+**************************************************************************/
+void CreateCoarseGraphParallel(CtrlType *ctrl, GraphType *graph, int cnvtxs, idxtype *match, idxtype *cperm)
+{
+  int nthreads;
+  GraphType *cgraph;
+  PContractType pc;
+
+  IFSET(ctrl->dbglvl, DBG_TIME, starttimer(ctrl->ContractTmr));
+
+  cgraph = SetUpCoarseGraph(graph, cnvtxs, 0);
+  cgraph->xadj[0] = 0;
+
+  nthreads = ThreadCount(ctrl, cnvtxs);
+
+  pc.graph = graph;
+  pc.cgraph = cgraph;
+  pc.match = match;
+  pc.cperm = cperm;
+  pc.htables = (idxtype **)GKmalloc(sizeof(idxtype *)*nthreads, "CreateCoarseGraphParallel: htables");
+  pc.hmasks = imalloc(nthreads, "CreateCoarseGraphParallel: hmasks");
+  pc.tnedges = idxmalloc(nthreads, "CreateCoarseGraphParallel: tnedges");
+
+  RunThreads(nthreads, PContractCount, (void *)&pc);
+  RunThreads(nthreads, PContractFill, (void *)&pc);
+
+  cgraph->nedges = cgraph->xadj[cnvtxs];
+
+  GKfree((void **) &pc.htables, (void **) &pc.hmasks, (void **) &pc.tnedges, LTERM);
+
+  ReAdjustMemory(graph, cgraph, 0);
+
+  IFSET(ctrl->dbglvl, DBG_TIME, stoptimer(ctrl->ContractTmr));
+}
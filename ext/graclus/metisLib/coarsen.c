@@ -35,7 +35,7 @@ GraphType *Coarsen2Way(CtrlType *ctrl, GraphType *graph)
     clevel = 0;
   
   do {
-    IFSET(ctrl->dbglvl, DBG_COARSEN, printf("%6d %7d [%d] [%d %d]\n",
+    IFSET(ctrl->dbglvl, DBG_COARSEN, printf("%6d %7" PRIDX " [%d] [%d %d]\n",
           cgraph->nvtxs, cgraph->nedges, ctrl->CoarsenTo, ctrl->maxvwgt, 
           (cgraph->vwgt ? idxsum(cgraph->nvtxs, cgraph->vwgt) : cgraph->nvtxs)));
 
@@ -62,6 +62,9 @@ GraphType *Coarsen2Way(CtrlType *ctrl, GraphType *graph)
           //else
             Match_SHEMN(ctrl, cgraph);
           break;
+        case MATCH_PSHEMN:
+          Match_PSHEMN(ctrl, cgraph);
+          break;
         case MATCH_SHEM:
           if (clevel < 1)
             Match_RM(ctrl, cgraph);
@@ -85,7 +88,7 @@ GraphType *Coarsen2Way(CtrlType *ctrl, GraphType *graph)
   } while (cgraph->nvtxs > ctrl->CoarsenTo && cgraph->nvtxs < COARSEN_FRACTION2*cgraph->finer->nvtxs && cgraph->nedges > cgraph->nvtxs/2); 
 
 
-  IFSET(ctrl->dbglvl, DBG_COARSEN, printf("%6d %7d [%d] [%d %d]\n",
+  IFSET(ctrl->dbglvl, DBG_COARSEN, printf("%6d %7" PRIDX " [%d] [%d %d]\n",
         cgraph->nvtxs, cgraph->nedges, ctrl->CoarsenTo, ctrl->maxvwgt, 
         (cgraph->vwgt ? idxsum(cgraph->nvtxs, cgraph->vwgt) : cgraph->nvtxs)));
 
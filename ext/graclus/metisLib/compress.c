@@ -242,7 +242,7 @@ void PruneGraph(CtrlType *ctrl, GraphType *graph, int nvtxs, idxtype *xadj, idxt
       graph->label[i] = i;
   }
 
-  free(perm);
+  GKdealloc(perm);
 
 }
 
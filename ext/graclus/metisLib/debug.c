@@ -56,8 +56,8 @@ float ComputeRAsso(GraphType *graph, idxtype *where, int npart)
     if (clusterSize[i] >0)
       result +=  rasso[i] *1.0/ clusterSize[i];
   }
-  free(rasso);
-  free(clusterSize);
+  GKdealloc(rasso);
+  GKdealloc(clusterSize);
   return result;
 }
 
@@ -66,13 +66,14 @@ float ComputeRAsso(GraphType *graph, idxtype *where, int npart)
 **************************************************************************/
 float ComputeNCut(GraphType *graph, idxtype *where, int npart)
 {
-  int i, j, cm, nvtxs;
-  idxtype *ncut, *degree, *xadj, *adjncy;
+  int i, cm, nvtxs;
+  idxtype j, *xadj, *adjncy;
+  acctype *ncut, *degree;
   float result;
   idxtype * adjwgt;
 
-  ncut = idxsmalloc(npart, 0, "ComputeNCut: ncut");
-  degree = idxsmalloc(npart, 0, "ComputeNCut: degree");
+  ncut = accsmalloc(npart, 0, "ComputeNCut: ncut");
+  degree = accsmalloc(npart, 0, "ComputeNCut: degree");
   nvtxs = graph->nvtxs;
   xadj = graph->xadj;
   adjncy = graph->adjncy;
@@ -107,8 +108,8 @@ float ComputeNCut(GraphType *graph, idxtype *where, int npart)
       result +=  ncut[i] *1.0/ degree[i];
   }
   //printf("Empty clusters: %d\n", empty);
-  free(ncut);
-  free(degree);
+  GKdealloc(ncut);
+  GKdealloc(degree);
   return result+empty;
 }
 
@@ -297,14 +298,14 @@ int CheckNodePartitionParams(GraphType *graph)
           edegrees[other] += vwgt[adjncy[j]];
       }
       if (edegrees[0] != graph->nrinfo[i].edegrees[0] || edegrees[1] != graph->nrinfo[i].edegrees[1]) {
-        printf("Something wrong with edegrees: %d %d %d %d %d\n", i, edegrees[0], edegrees[1], graph->nrinfo[i].edegrees[0], graph->nrinfo[i].edegrees[1]);
+        printf("Something wrong with edegrees: %d %" PRIDX " %" PRIDX " %" PRIDX " %" PRIDX "\n", i, edegrees[0], edegrees[1], graph->nrinfo[i].edegrees[0], graph->nrinfo[i].edegrees[1]);
         return 0;
       }
     }
   }
 
   if (pwgts[0] != graph->pwgts[0] || pwgts[1] != graph->pwgts[1] || pwgts[2] != graph->pwgts[2])
-    printf("Something wrong with part-weights: %d %d %d %d %d %d\n", pwgts[0], pwgts[1], pwgts[2], graph->pwgts[0], graph->pwgts[1], graph->pwgts[2]);
+    printf("Something wrong with part-weights: %" PRIDX " %" PRIDX " %" PRIDX " %" PRIDX " %" PRIDX " %" PRIDX "\n", pwgts[0], pwgts[1], pwgts[2], graph->pwgts[0], graph->pwgts[1], graph->pwgts[2]);
 
   return 1;
 }
@@ -50,6 +50,15 @@
 #define OPTION_OFLAGS		5
 #define OPTION_PFACTOR		6
 #define OPTION_NSEPS		7
+#define OPTION_NTHREADS		8
+#define OPTION_NRESTARTS	9
+#define OPTION_SEED		10
+#define OPTION_INITPART		11
+#define OPTION_MAXPWGT		12
+#define OPTION_ENGINE		13
+
+/* Size of the options arrays, indexed by the OPTION_* constants */
+#define GRACLUS_NOPTIONS	16
 
 #define OFLAG_COMPRESS		1	/* Try to compress the graph */
 #define OFLAG_CCMP		2	/* Find and order connected components */
@@ -123,6 +132,7 @@
 #define MATCH_SBHEM_INFNORM	8
 #define MATCH_HEMN              9
 #define MATCH_SHEMN             10
+#define MATCH_PSHEMN            11	/* Parallel handshake version of MATCH_SHEMN */
 
 /* Initial partitioning schemes for PMETIS and ONMETIS */
 #define IPART_GGPKL		1
@@ -144,6 +154,14 @@
 #define RTYPE_SEP2SIDED		1
 #define RTYPE_SEP1SIDED		2
 
+/* Initial partitioning schemes of the coarsest graph for MLKKM */
+#define INITPART_METIS		0	/* Recursive bisection by METIS */
+#define INITPART_SPECTRAL	1	/* k-means on the leading eigenvectors of the normalized adjacency matrix */
+
+/* Partitioning engines of normalizedCut */
+#define ENGINE_MLKKM		0	/* Multilevel weighted kernel k-means */
+#define ENGINE_LABELPROP	1	/* Size-constrained label propagation */
+
 /* Initial Partitioning Schemes for McKMETIS */
 #define IPART_McPMETIS		1   	/* Simple McPMETIS */
 #define IPART_McHPMETIS		2	/* horizontally relaxed McPMETIS */
@@ -170,6 +188,26 @@
 
 #define HORIZONTAL_IMBALANCE		1.05
 
+#define PARALLEL_MINCHUNK	4096	/* Minimum # of items per thread in the parallel routines */
+#define PARALLEL_MINBISECT	512	/* Minimum # of vertices of both sides of a bisection that run concurrently */
+#define PARALLEL_MINREAD	(1<<20)	/* Minimum # of bytes of a graph file per reading thread */
+#define NHANDSHAKE_PASSES	8	/* Number of proposal rounds of the parallel matching */
+#define NPOOLCLASSES		48	/* Number of size classes of the memory pool */
+#define MAXSTATLEVELS		64	/* Number of levels whose statistics are kept */
+#define SPECTRAL_MAXDIM		32	/* Maximum # of eigenvectors of the spectral initial partitioning */
+#define SPECTRAL_MAXITER	100	/* Maximum # of LOBPCG iterations */
+#define SPECTRAL_TOL		1e-2	/* Residual norm at which an eigenvector is converged */
+#define SPECTRAL_KMEANSITER	20	/* Maximum # of k-means iterations on the eigenvectors */
+#define SIZEBOUND_NPASSES	8	/* Maximum # of passes of the cluster size rebalancing */
+#define SPECTRAL_KMEANSBLOCK	1024	/* # of vertices whose distances to the centers are computed at once */
+#define LP_NITER		3	/* Maximum # of label propagation rounds of the clustering */
+#define LP_NREFINE		10	/* Maximum # of label propagation rounds of the refinement */
+#define LP_MINMOVES		0.001	/* Fraction of moved vertices below which the rounds stop */
+#define LP_CHUNK		256	/* # of vertices that a thread takes at a time */
+#define LP_COARSENTO		4	/* The coarsening stops at LP_COARSENTO vertices per part */
+#define LP_SHRINKFRACTION	0.95	/* Node reduction below which the coarsening gives up */
+#define LP_UBFACTOR		1.03	/* Part size over the average part size without a bound */
+
 /* Debug Levels */
 #define DBG_TIME	1		/* Perform timing analysis */
 #define DBG_OUTPUT	2
@@ -49,7 +49,7 @@ void FM_2WayEdgeRefine(CtrlType *ctrl, GraphType *graph, int *tpwgts, int npasse
   PQueueInit(ctrl, &parts[1], nvtxs, tmp);
 
   IFSET(ctrl->dbglvl, DBG_REFINE, 
-     printf("Partitions: [%6d %6d] T[%6d %6d], Nv-Nb[%6d %6d]. ICut: %6d\n",
+     printf("Partitions: [%6" PRIDX " %6" PRIDX "] T[%6d %6d], Nv-Nb[%6d %6d]. ICut: %6d\n",
              pwgts[0], pwgts[1], tpwgts[0], tpwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
 
   origdiff = abs(tpwgts[0]-pwgts[0]);
@@ -103,7 +103,7 @@ void FM_2WayEdgeRefine(CtrlType *ctrl, GraphType *graph, int *tpwgts, int npasse
       swaps[nswaps] = higain;
 
       IFSET(ctrl->dbglvl, DBG_MOVEINFO, 
-        printf("Moved %6d from %d. [%3d %3d] %5d [%4d %4d]\n", higain, from, ed[higain]-id[higain], vwgt[higain], newcut, pwgts[0], pwgts[1]));
+        printf("Moved %6d from %d. [%3" PRIDX " %3" PRIDX "] %5d [%4" PRIDX " %4" PRIDX "]\n", higain, from, ed[higain]-id[higain], vwgt[higain], newcut, pwgts[0], pwgts[1]));
 
       /**************************************************************
       * Update the id[i]/ed[i] values of the affected nodes
@@ -173,7 +173,7 @@ void FM_2WayEdgeRefine(CtrlType *ctrl, GraphType *graph, int *tpwgts, int npasse
     }
 
     IFSET(ctrl->dbglvl, DBG_REFINE, 
-      printf("\tMinimum cut: %6d at %5d, PWGTS: [%6d %6d], NBND: %6d\n", mincut, mincutorder, pwgts[0], pwgts[1], nbnd));
+      printf("\tMinimum cut: %6d at %5d, PWGTS: [%6" PRIDX " %6" PRIDX "], NBND: %6d\n", mincut, mincutorder, pwgts[0], pwgts[1], nbnd));
 
     graph->mincut = mincut;
     graph->nbnd = nbnd;
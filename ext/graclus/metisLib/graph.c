@@ -21,7 +21,8 @@
 void SetUpGraph(GraphType *graph, int OpType, int nvtxs, int ncon,
        idxtype *xadj, idxtype *adjncy, idxtype *vwgt, idxtype *adjwgt, int wgtflag)
 {
-  int i, j, k, sum, gsize;
+  int i, k;
+  idxtype j, sum, gsize;
   float *nvwgt;
   idxtype tvwgt[MAXNCON];
 
@@ -300,7 +301,7 @@ void VolSetUpGraph(GraphType *graph, int OpType, int nvtxs, int ncon, idxtype *x
         nvwgt[i*ncon+j] = (1.0*vwgt[i*ncon+j])/(1.0*tvwgt[j]);
     }
     if ((wgtflag&2) == 0) 
-      free(vwgt);
+      GKdealloc(vwgt);
 
 
     /* Create the vsize vector if it is not supplied */
@@ -433,7 +434,7 @@ int IsConnectedSubdomain(CtrlType *ctrl, GraphType *graph, int pid, int report)
       wgt = 0;
       for (j=cptr[i]; j<cptr[i+1]; j++)
         wgt += graph->vwgt[queue[j]];
-      printf("[%5d %5d] ", cptr[i+1]-cptr[i], wgt);
+      printf("[%5" PRIDX " %5d] ", cptr[i+1]-cptr[i], wgt);
       /*
       if (cptr[i+1]-cptr[i] == 1)
         printf("[%d %d] ", queue[cptr[i]], xadj[queue[cptr[i]]+1]-xadj[queue[cptr[i]]]);
@@ -536,7 +537,7 @@ int IsConnected2(GraphType *graph, int report)
     printf("%d connected components:\t", ncmps);
     for (i=0; i<ncmps; i++) {
       if (cptr[i+1]-cptr[i] > 200)
-        printf("[%5d] ", cptr[i+1]-cptr[i]);
+        printf("[%5" PRIDX "] ", cptr[i+1]-cptr[i]);
     }
     printf("\n");
   }
@@ -621,7 +622,7 @@ int FindComponents(CtrlType *ctrl, GraphType *graph, idxtype *cptr, idxtype *cin
   //  fprintf(fp, "%d\n", queue[i]);
   //fclose(fp);
 
-  free(touched);
+  GKdealloc(touched);
 
   return ncmps;
 }
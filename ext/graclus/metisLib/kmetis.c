@@ -33,7 +33,7 @@ void METIS_PartGraphKway(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxtype *vw
   METIS_WPartGraphKway(nvtxs, xadj, adjncy, vwgt, adjwgt, wgtflag, numflag, nparts, 
                        tpwgts, options, edgecut, part);
 
-  free(tpwgts);
+  GKdealloc(tpwgts);
 }
 
 
@@ -107,6 +107,7 @@ int MlevelKWayPartitioning(CtrlType *ctrl, GraphType *graph, int nparts, idxtype
   options[OPTION_ITYPE] = IPART_GGPKL;
   options[OPTION_RTYPE] = RTYPE_FM;
   options[OPTION_DBGLVL] = 0;
+  options[OPTION_NTHREADS] = 1;
 
   METIS_WPartGraphRecursive(&cgraph->nvtxs, cgraph->xadj, cgraph->adjncy, cgraph->vwgt, 
                             cgraph->adjwgt, &wgtflag, &numflag, &nparts, tpwgts, options, 
@@ -33,7 +33,7 @@ void METIS_PartGraphVKway(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxtype *v
   METIS_WPartGraphVKway(nvtxs, xadj, adjncy, vwgt, vsize, wgtflag, numflag, nparts, 
                        tpwgts, options, volume, part);
 
-  free(tpwgts);
+  GKdealloc(tpwgts);
 }
 
 
@@ -108,6 +108,7 @@ int MlevelVolKWayPartitioning(CtrlType *ctrl, GraphType *graph, int nparts, idxt
   options[OPTION_ITYPE] = IPART_GGPKL;
   options[OPTION_RTYPE] = RTYPE_FM;
   options[OPTION_DBGLVL] = 0;
+  options[OPTION_NTHREADS] = 1;
 
   METIS_WPartGraphRecursive(&cgraph->nvtxs, cgraph->xadj, cgraph->adjncy, cgraph->vwgt, 
                             cgraph->adjwgt, &wgtflag, &numflag, &nparts, tpwgts, options, 
@@ -52,7 +52,7 @@ void Random_KWayEdgeRefine(CtrlType *ctrl, GraphType *graph, int nparts, float *
   perm = idxwspacemalloc(ctrl, nvtxs);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-     printf("Partitions: [%6d %6d]-[%6d %6d], Balance: %5.3f, Nv-Nb[%6d %6d]. Cut: %6d\n",
+     printf("Partitions: [%6" PRIDX " %6" PRIDX "]-[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nv-Nb[%6d %6d]. Cut: %6d\n",
              pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)], minwgt[0], maxwgt[0], 
              1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nvtxs, graph->nbnd,
              graph->mincut));
@@ -117,7 +117,7 @@ void Random_KWayEdgeRefine(CtrlType *ctrl, GraphType *graph, int nparts, float *
         *======================================================================*/
         graph->mincut -= myedegrees[k].ed-myrinfo->id;
 
-        IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4d. Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
+        IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4" PRIDX ". Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
 
         /* Update where, weight, and ID/ED information of the vertex you moved */
         where[i] = to;
@@ -197,7 +197,7 @@ void Random_KWayEdgeRefine(CtrlType *ctrl, GraphType *graph, int nparts, float *
     graph->nbnd = nbnd;
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-       printf("\t[%6d %6d], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d, Vol: %6d\n",
+       printf("\t[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d, Vol: %6d\n",
                pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)],
                1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nbnd, nmoves, graph->mincut, ComputeVolume(graph, where)));
 
@@ -259,7 +259,7 @@ void Greedy_KWayEdgeRefine(CtrlType *ctrl, GraphType *graph, int nparts, float *
   PQueueInit(ctrl, &queue, nvtxs, graph->adjwgtsum[idxamax(nvtxs, graph->adjwgtsum)]);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-     printf("Partitions: [%6d %6d]-[%6d %6d], Balance: %5.3f, Nv-Nb[%6d %6d]. Cut: %6d\n",
+     printf("Partitions: [%6" PRIDX " %6" PRIDX "]-[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nv-Nb[%6d %6d]. Cut: %6d\n",
              pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)], minwgt[0], maxwgt[0], 
              1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nvtxs, graph->nbnd,
              graph->mincut));
@@ -330,7 +330,7 @@ void Greedy_KWayEdgeRefine(CtrlType *ctrl, GraphType *graph, int nparts, float *
       *======================================================================*/
       graph->mincut -= myedegrees[k].ed-myrinfo->id;
 
-      IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4d. Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
+      IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4" PRIDX ". Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
 
       /* Update where, weight, and ID/ED information of the vertex you moved */
       where[i] = to;
@@ -427,7 +427,7 @@ void Greedy_KWayEdgeRefine(CtrlType *ctrl, GraphType *graph, int nparts, float *
     graph->nbnd = nbnd;
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-       printf("\t[%6d %6d], Balance: %5.3f, Nb: %6d. Cut: %6d\n",
+       printf("\t[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nb: %6d. Cut: %6d\n",
                pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)],
                1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nbnd, graph->mincut));
 
@@ -489,7 +489,7 @@ void Greedy_KWayEdgeBalance(CtrlType *ctrl, GraphType *graph, int nparts, float
   PQueueInit(ctrl, &queue, nvtxs, graph->adjwgtsum[idxamax(nvtxs, graph->adjwgtsum)]);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-     printf("Partitions: [%6d %6d]-[%6d %6d], Balance: %5.3f, Nv-Nb[%6d %6d]. Cut: %6d [B]\n",
+     printf("Partitions: [%6" PRIDX " %6" PRIDX "]-[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nv-Nb[%6d %6d]. Cut: %6d [B]\n",
              pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)], minwgt[0], maxwgt[0], 
              1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nvtxs, graph->nbnd,
              graph->mincut));
@@ -558,7 +558,7 @@ void Greedy_KWayEdgeBalance(CtrlType *ctrl, GraphType *graph, int nparts, float
       *======================================================================*/
       graph->mincut -= myedegrees[k].ed-myrinfo->id;
 
-      IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4d. Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
+      IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4" PRIDX ". Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
 
       /* Update where, weight, and ID/ED information of the vertex you moved */
       where[i] = to;
@@ -655,7 +655,7 @@ void Greedy_KWayEdgeBalance(CtrlType *ctrl, GraphType *graph, int nparts, float
     graph->nbnd = nbnd;
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-       printf("\t[%6d %6d], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d\n",
+       printf("\t[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d\n",
                pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)],
                1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nbnd, nmoves, graph->mincut));
   }
@@ -129,7 +129,7 @@ void AllocateKWayPartitionMemory(CtrlType *ctrl, GraphType *graph, int nparts)
 
 /*
   if (ctrl->wspace.edegrees != NULL)
-    free(ctrl->wspace.edegrees);
+    GKdealloc(ctrl->wspace.edegrees);
   ctrl->wspace.edegrees = (EDegreeType *)GKmalloc(graph->nedges*sizeof(EDegreeType), "AllocateKWayPartitionMemory: edegrees");
 */
 }
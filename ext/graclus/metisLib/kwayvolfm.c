@@ -57,7 +57,7 @@ void Random_KWayVolRefine(CtrlType *ctrl, GraphType *graph, int nparts, float *t
   perm = idxwspacemalloc(ctrl, nvtxs);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-     printf("VolPart: [%5d %5d]-[%5d %5d], Balance: %3.2f, Nv-Nb[%5d %5d]. Cut: %5d, Vol: %5d\n",
+     printf("VolPart: [%5" PRIDX " %5" PRIDX "]-[%5" PRIDX " %5" PRIDX "], Balance: %3.2f, Nv-Nb[%5d %5d]. Cut: %5d, Vol: %5d\n",
              pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)], minwgt[0], maxwgt[0], 
              1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nvtxs, graph->nbnd,
              graph->mincut, graph->minvol));
@@ -127,7 +127,7 @@ void Random_KWayVolRefine(CtrlType *ctrl, GraphType *graph, int nparts, float *t
         graph->minvol -= (xgain+myedegrees[k].gv);
         where[i] = to;
 
-        IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d from %3d to %3d. Gain: [%4d %4d]. Cut: %6d, Vol: %6d\n", 
+        IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d from %3d to %3d. Gain: [%4" PRIDX " %4" PRIDX "]. Cut: %6d, Vol: %6d\n", 
               i, from, to, xgain+myedegrees[k].gv, myedegrees[k].ed-myrinfo->id, graph->mincut, graph->minvol));
 
         KWayVolUpdate(ctrl, graph, i, from, to, marker, phtable, updind);
@@ -139,7 +139,7 @@ void Random_KWayVolRefine(CtrlType *ctrl, GraphType *graph, int nparts, float *t
     }
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-       printf("\t[%6d %6d], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d, Vol: %6d\n",
+       printf("\t[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d, Vol: %6d\n",
                pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)],
                1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nbnd, nmoves, graph->mincut, 
                graph->minvol));
@@ -207,7 +207,7 @@ void Random_KWayVolRefineMConn(CtrlType *ctrl, GraphType *graph, int nparts, flo
   perm = idxwspacemalloc(ctrl, nvtxs);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-     printf("VolPart: [%5d %5d]-[%5d %5d], Balance: %3.2f, Nv-Nb[%5d %5d]. Cut: %5d, Vol: %5d\n",
+     printf("VolPart: [%5" PRIDX " %5" PRIDX "]-[%5" PRIDX " %5" PRIDX "], Balance: %3.2f, Nv-Nb[%5d %5d]. Cut: %5d, Vol: %5d\n",
              pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)], minwgt[0], maxwgt[0], 
              1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nvtxs, graph->nbnd,
              graph->mincut, graph->minvol));
@@ -311,7 +311,7 @@ void Random_KWayVolRefineMConn(CtrlType *ctrl, GraphType *graph, int nparts, flo
         graph->minvol -= (xgain+myedegrees[k].gv);
         where[i] = to;
 
-        IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d from %3d to %3d. Gain: [%4d %4d]. Cut: %6d, Vol: %6d\n", 
+        IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d from %3d to %3d. Gain: [%4" PRIDX " %4" PRIDX "]. Cut: %6d, Vol: %6d\n", 
               i, from, to, xgain+myedegrees[k].gv, myedegrees[k].ed-myrinfo->id, graph->mincut, graph->minvol));
 
         /* Update pmat to reflect the move of 'i' */
@@ -350,14 +350,14 @@ void Random_KWayVolRefineMConn(CtrlType *ctrl, GraphType *graph, int nparts, flo
             if (pmat[me*nparts+to] == 0) {
               ndoms[me]++;
               if (ndoms[me] > maxndoms) {
-                printf("You just increased the maxndoms: %d %d\n", ndoms[me], maxndoms);
+                printf("You just increased the maxndoms: %" PRIDX " %d\n", ndoms[me], maxndoms);
                 maxndoms = ndoms[me];
               }
             }
             if (pmat[to*nparts+me] == 0) {
               ndoms[to]++;
               if (ndoms[to] > maxndoms) {
-                printf("You just increased the maxndoms: %d %d\n", ndoms[to], maxndoms);
+                printf("You just increased the maxndoms: %" PRIDX " %d\n", ndoms[to], maxndoms);
                 maxndoms = ndoms[to];
               }
             }
@@ -375,7 +375,7 @@ void Random_KWayVolRefineMConn(CtrlType *ctrl, GraphType *graph, int nparts, flo
     }
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-       printf("\t[%6d %6d], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d, Vol: %6d\n",
+       printf("\t[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d, Vol: %6d\n",
                pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)],
                1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nbnd, nmoves, graph->mincut, 
                graph->minvol));
@@ -444,7 +444,7 @@ void Greedy_KWayVolBalance(CtrlType *ctrl, GraphType *graph, int nparts, float *
   PQueueInit(ctrl, &queue, nvtxs, graph->adjwgtsum[idxamax(nvtxs, graph->adjwgtsum)]);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-     printf("VolPart: [%5d %5d]-[%5d %5d], Balance: %3.2f, Nv-Nb[%5d %5d]. Cut: %5d, Vol: %5d [B]\n",
+     printf("VolPart: [%5" PRIDX " %5" PRIDX "]-[%5" PRIDX " %5" PRIDX "], Balance: %3.2f, Nv-Nb[%5d %5d]. Cut: %5d, Vol: %5d [B]\n",
              pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)], minwgt[0], maxwgt[0], 
              1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nvtxs, graph->nbnd,
              graph->mincut, graph->minvol));
@@ -519,7 +519,7 @@ void Greedy_KWayVolBalance(CtrlType *ctrl, GraphType *graph, int nparts, float *
       graph->minvol -= (xgain+myedegrees[k].gv);
       where[i] = to;
 
-      IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d from %3d to %3d. Gain: [%4d %4d]. Cut: %6d, Vol: %6d\n", 
+      IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d from %3d to %3d. Gain: [%4" PRIDX " %4" PRIDX "]. Cut: %6d, Vol: %6d\n", 
             i, from, to, xgain+myedegrees[k].gv, myedegrees[k].ed-myrinfo->id, graph->mincut, graph->minvol));
 
       KWayVolUpdate(ctrl, graph, i, from, to, marker, phtable, updind);
@@ -530,7 +530,7 @@ void Greedy_KWayVolBalance(CtrlType *ctrl, GraphType *graph, int nparts, float *
     }
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-       printf("\t[%6d %6d], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d, Vol: %6d\n",
+       printf("\t[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d, Vol: %6d\n",
                pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)],
                1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nbnd, nmoves, graph->mincut, 
                graph->minvol));
@@ -604,7 +604,7 @@ void Greedy_KWayVolBalanceMConn(CtrlType *ctrl, GraphType *graph, int nparts, fl
   PQueueInit(ctrl, &queue, nvtxs, graph->adjwgtsum[idxamax(nvtxs, graph->adjwgtsum)]);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-     printf("VolPart: [%5d %5d]-[%5d %5d], Balance: %3.2f, Nv-Nb[%5d %5d]. Cut: %5d, Vol: %5d [B]\n",
+     printf("VolPart: [%5" PRIDX " %5" PRIDX "]-[%5" PRIDX " %5" PRIDX "], Balance: %3.2f, Nv-Nb[%5d %5d]. Cut: %5d, Vol: %5d [B]\n",
              pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)], minwgt[0], maxwgt[0], 
              1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nvtxs, graph->nbnd,
              graph->mincut, graph->minvol));
@@ -711,7 +711,7 @@ void Greedy_KWayVolBalanceMConn(CtrlType *ctrl, GraphType *graph, int nparts, fl
       graph->minvol -= (xgain+myedegrees[k].gv);
       where[i] = to;
 
-      IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d from %3d to %3d. Gain: [%4d %4d]. Cut: %6d, Vol: %6d\n", 
+      IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d from %3d to %3d. Gain: [%4" PRIDX " %4" PRIDX "]. Cut: %6d, Vol: %6d\n", 
             i, from, to, xgain+myedegrees[k].gv, myedegrees[k].ed-myrinfo->id, graph->mincut, graph->minvol));
 
       /* Update pmat to reflect the move of 'i' */
@@ -750,14 +750,14 @@ void Greedy_KWayVolBalanceMConn(CtrlType *ctrl, GraphType *graph, int nparts, fl
           if (pmat[me*nparts+to] == 0) {
             ndoms[me]++;
             if (ndoms[me] > maxndoms) {
-              printf("You just increased the maxndoms: %d %d\n", ndoms[me], maxndoms);
+              printf("You just increased the maxndoms: %" PRIDX " %d\n", ndoms[me], maxndoms);
               maxndoms = ndoms[me];
             }
           }
           if (pmat[to*nparts+me] == 0) {
             ndoms[to]++;
             if (ndoms[to] > maxndoms) {
-              printf("You just increased the maxndoms: %d %d\n", ndoms[to], maxndoms);
+              printf("You just increased the maxndoms: %" PRIDX " %d\n", ndoms[to], maxndoms);
               maxndoms = ndoms[to];
             }
           }
@@ -774,7 +774,7 @@ void Greedy_KWayVolBalanceMConn(CtrlType *ctrl, GraphType *graph, int nparts, fl
     }
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-       printf("\t[%6d %6d], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d, Vol: %6d\n",
+       printf("\t[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d, Vol: %6d\n",
                pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)],
                1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nbnd, nmoves, graph->mincut, 
                graph->minvol));
@@ -1204,7 +1204,7 @@ int ComputeVolume(GraphType *graph, idxtype *where)
     }
   }
 
-  free(marker);
+  GKdealloc(marker);
 
   return totalv;
 }
@@ -1326,7 +1326,7 @@ void CheckVolKWayPartitionParams(CtrlType *ctrl, GraphType *graph, int nparts)
       for (kk=0; kk<tmprinfo.ndegrees; kk++) {
         if (tmpdegrees[kk].pid == pid) {
           if (tmpdegrees[kk].gv != myedegrees[k].gv)
-            printf("[%d %d %d %d]\n", i, pid, myedegrees[k].gv, tmpdegrees[kk].gv);
+            printf("[%d %d %" PRIDX " %" PRIDX "]\n", i, pid, myedegrees[k].gv, tmpdegrees[kk].gv);
           break;
         }
       }
@@ -1334,7 +1334,7 @@ void CheckVolKWayPartitionParams(CtrlType *ctrl, GraphType *graph, int nparts)
 
   }
 
-  free(tmpdegrees);
+  GKdealloc(tmpdegrees);
 
 }
 
@@ -1745,7 +1745,7 @@ void EliminateVolComponents(CtrlType *ctrl, GraphType *graph, int nparts, float
       }
     }
 
-    free(cand);
+    GKdealloc(cand);
   }
 
   if (recompute) {
@@ -20,8 +20,8 @@
 #define RandomInRange(u) ((rand()>>3)%(u))
 #define RandomInRangeFast(u) ((rand()>>3)%(u))
 #else
-#define RandomInRange(u) ((int)(drand48()*((double)(u))))
-#define RandomInRangeFast(u) ((rand()>>3)%(u))
+#define RandomInRange(u) ((int)(GKdrand()*((double)(u))))
+#define RandomInRangeFast(u) ((GKrand()>>3)%(u))
 #endif
 
 
@@ -70,6 +70,8 @@
 #define ismalloc(n, val, msg) (iset((n), (val), malloc(sizeof(int)*(n))))
 #define idxsmalloc(n, val, msg) (idxset((n), (val), malloc(sizeof(idxtype)*(n))))
 #define GKmalloc(a, b) (malloc((a)))
+#define GKdealloc(a) (free((a)))
+#define GKrealloc(a, b, c) (realloc((a), (b)))
 #endif
 
 #ifdef DMALLOC
@@ -93,7 +95,19 @@
      for (i=1; i<n; i++) a[i] += a[i-1]; \
      for (i=n; i>0; i--) a[i] = a[i-1]; \
      a[0] = 0; \
-   } while(0) 
+   } while(0)
+
+
+/*************************************************************************
+* These macros access the integers that the threads of the asynchronous
+* label propagation share. The accesses are relaxed, they only keep the
+* individual reads and writes whole.
+**************************************************************************/
+#define AtomicLoad(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define AtomicStore(p, val) __atomic_store_n((p), (val), __ATOMIC_RELAXED)
+#define AtomicFetchAdd(p, val) __atomic_fetch_add((p), (val), __ATOMIC_RELAXED)
+#define AtomicCAS(p, expected, desired) \
+   __atomic_compare_exchange_n((p), (expected), (desired), 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
 
 
 /*************************************************************************
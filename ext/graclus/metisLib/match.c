@@ -20,8 +20,8 @@
 **************************************************************************/
 void Match_SHEMN(CtrlType *ctrl, GraphType *graph)
 {
-  int i, ii, j, k, nvtxs, cnvtxs, maxidx, avgdegree;
-  idxtype *xadj, *vwgt, *adjncy, *adjwgt, *adjwgtsum;
+  int i, ii, k, nvtxs, cnvtxs, maxidx, avgdegree;
+  idxtype j, *xadj, *vwgt, *adjncy, *adjwgt, *adjwgtsum;
   idxtype *match, *cmap, *degrees, *perm, *tperm;
   float rtemp1, rtemp2, maxwgt;
 
@@ -110,6 +110,270 @@ void Match_SHEMN(CtrlType *ctrl, GraphType *graph)
 }
 
 
+/*************************************************************************
+* The following data structure holds the state that is shared by the 
+* threads of Match_PSHEMN
+**************************************************************************/
+struct pmatchdef {
+  CtrlType *ctrl;
+  GraphType *graph;
+  idxtype *match, *cand, *cperm;
+  int *tcounts;			/* Per thread counters */
+};
+
+typedef struct pmatchdef PMatchType;
+
+
+/*************************************************************************
+* This function lets every unmatched vertex of thread tid propose to its
+* heaviest eligible unmatched neighbor. The edge weight is the one used 
+* by SHEMN; ties are broken by a symmetric hash of the endpoints so that 
+* both endpoints order their edges in the same way.
+**************************************************************************/
+static void PMatchPropose(void *ptr, int tid, int nthreads)
+{
+  int i, k, istart, iend, maxidx, nislands;
+  unsigned int key, maxkey;
+  idxtype j, *xadj, *vwgt, *adjncy, *adjwgt, *adjwgtsum, *match, *cand;
+  float rtemp1, rtemp2, maxwgt;
+  PMatchType *pm = (PMatchType *)ptr;
+
+  xadj = pm->graph->xadj;
+  vwgt = pm->graph->vwgt;
+  adjncy = pm->graph->adjncy;
+  adjwgt = pm->graph->adjwgt;
+  adjwgtsum = pm->graph->adjwgtsum;
+  match = pm->match;
+  cand = pm->cand;
+
+  ThreadRange(pm->graph->nvtxs, tid, nthreads, &istart, &iend);
+
+  nislands = 0;
+  for (i=istart; i<iend; i++) {
+    cand[i] = UNMATCHED;
+    if (match[i] != UNMATCHED)
+      continue;
+
+    if (xadj[i] == xadj[i+1]) {
+      nislands++;
+      continue;
+    }
+
+    maxidx = UNMATCHED;
+    maxwgt = 0;
+    maxkey = 0;
+    rtemp1 = 1.0/adjwgtsum[i];
+    for (j=xadj[i]; j<xadj[i+1]; j++) {
+      k = adjncy[j];
+      if (k == i || match[k] != UNMATCHED || vwgt[i]+vwgt[k] > pm->ctrl->maxvwgt)
+        continue;
+
+      rtemp2 = adjwgt[j]*(rtemp1 + (float)(1.0/adjwgtsum[k]));
+      key = ((unsigned int)amin(i, k)*2654435761U)^(unsigned int)amax(i, k);
+      if (maxwgt < rtemp2 || (maxwgt == rtemp2 && maxkey < key)) {
+        maxwgt = rtemp2;
+        maxkey = key;
+        maxidx = k;
+      }
+    }
+    cand[i] = maxidx;
+  }
+
+  pm->tcounts[tid] = nislands;
+}
+
+
+/*************************************************************************
+* This function matches the vertices of thread tid whose proposal was 
+* returned. Every thread writes only the mates of its own vertices.
+**************************************************************************/
+static void PMatchAccept(void *ptr, int tid, int nthreads)
+{
+  int i, istart, iend, nmatched;
+  idxtype *match, *cand;
+  PMatchType *pm = (PMatchType *)ptr;
+
+  match = pm->match;
+  cand = pm->cand;
+
+  ThreadRange(pm->graph->nvtxs, tid, nthreads, &istart, &iend);
+
+  nmatched = 0;
+  for (i=istart; i<iend; i++) {
+    if (match[i] == UNMATCHED && cand[i] != UNMATCHED && cand[cand[i]] == i) {
+      match[i] = cand[i];
+      nmatched++;
+    }
+  }
+
+  pm->tcounts[tid] = nmatched;
+}
+
+
+/*************************************************************************
+* This function counts the coarse vertices of thread tid. The lower 
+* numbered vertex of every matched pair represents the coarse vertex.
+**************************************************************************/
+static void PMatchCount(void *ptr, int tid, int nthreads)
+{
+  int i, istart, iend, ncoarse;
+  idxtype *match;
+  PMatchType *pm = (PMatchType *)ptr;
+
+  match = pm->match;
+
+  ThreadRange(pm->graph->nvtxs, tid, nthreads, &istart, &iend);
+
+  ncoarse = 0;
+  for (i=istart; i<iend; i++) {
+    if (match[i] == UNMATCHED)
+      match[i] = i;
+    if (match[i] >= i)
+      ncoarse++;
+  }
+
+  pm->tcounts[tid] = ncoarse;
+}
+
+
+/*************************************************************************
+* This function numbers the coarse vertices of thread tid, given that
+* tcounts holds the exclusive prefix sum of the per thread counts
+**************************************************************************/
+static void PMatchNumber(void *ptr, int tid, int nthreads)
+{
+  int i, istart, iend, cnvtxs;
+  idxtype *match, *cmap, *cperm;
+  PMatchType *pm = (PMatchType *)ptr;
+
+  match = pm->match;
+  cmap = pm->graph->cmap;
+  cperm = pm->cperm;
+
+  ThreadRange(pm->graph->nvtxs, tid, nthreads, &istart, &iend);
+
+  cnvtxs = pm->tcounts[tid];
+  for (i=istart; i<iend; i++) {
+    if (match[i] >= i) {
+      cperm[cnvtxs] = i;
+      cmap[i] = cnvtxs++;
+    }
+  }
+}
+
+
+/*************************************************************************
+* This function copies the coarse vertex number to the higher numbered
+* vertex of every matched pair of thread tid
+**************************************************************************/
+static void PMatchFollow(void *ptr, int tid, int nthreads)
+{
+  int i, istart, iend;
+  idxtype *match, *cmap;
+  PMatchType *pm = (PMatchType *)ptr;
+
+  match = pm->match;
+  cmap = pm->graph->cmap;
+
+  ThreadRange(pm->graph->nvtxs, tid, nthreads, &istart, &iend);
+
+  for (i=istart; i<iend; i++) {
+    if (match[i] < i)
+      cmap[i] = cmap[match[i]];
+  }
+}
+
+
+/*************************************************************************
+* This function finds a matching using a parallel version of the SHEMN 
+* heuristic. Unmatched vertices repeatedly propose to their heaviest 
+* unmatched neighbor and mutual proposals (handshakes) are matched, which
+* yields a locally dominant heavy-edge matching. The coarse vertices are
+* numbered by a prefix sum and the graph is contracted in parallel.
+**************************************************************************/
+void Match_PSHEMN(CtrlType *ctrl, GraphType *graph)
+{
+  int i, k, pass, nvtxs, cnvtxs, nthreads, nmatched, nislands, sum;
+  idxtype *xadj, *match, *cand, *cperm;
+  PMatchType pm;
+
+  nvtxs = graph->nvtxs;
+  nthreads = ThreadCount(ctrl, nvtxs);
+
+  /* Small graphs are coarsened faster by the serial code */
+  if (nthreads == 1 || graph->ncon != 1 || ctrl->optype == OP_KVMETIS) {
+    Match_SHEMN(ctrl, graph);
+    return;
+  }
+
+  IFSET(ctrl->dbglvl, DBG_TIME, starttimer(ctrl->MatchTmr));
+
+  xadj = graph->xadj;
+
+  match = idxset(nvtxs, UNMATCHED, idxwspacemalloc(ctrl, nvtxs));
+  cand = idxwspacemalloc(ctrl, nvtxs);
+  cperm = idxwspacemalloc(ctrl, nvtxs);
+
+  pm.ctrl = ctrl;
+  pm.graph = graph;
+  pm.match = match;
+  pm.cand = cand;
+  pm.cperm = cperm;
+  pm.tcounts = imalloc(nthreads, "Match_PSHEMN: tcounts");
+
+  nislands = 0;
+  for (pass=0; pass<NHANDSHAKE_PASSES; pass++) {
+    RunThreads(nthreads, PMatchPropose, (void *)&pm);
+    nislands = isum(nthreads, pm.tcounts);
+
+    RunThreads(nthreads, PMatchAccept, (void *)&pm);
+    nmatched = isum(nthreads, pm.tcounts);
+    if (nmatched == 0)
+      break;
+  }
+
+  /* Take care any islands. Islands are matched with non-islands due to coarsening */
+  if (nislands > 0) {
+    for (k=nvtxs-1, i=0; i<nvtxs; i++) {
+      if (match[i] != UNMATCHED || xadj[i] < xadj[i+1])
+        continue;
+
+      for (; k>=0; k--) {
+        if (match[k] == UNMATCHED && xadj[k] < xadj[k+1])
+          break;
+      }
+      if (k < 0)
+        break;
+
+      match[i] = k;
+      match[k] = i;
+    }
+  }
+
+  /* Number the coarse vertices */
+  RunThreads(nthreads, PMatchCount, (void *)&pm);
+  for (sum=0, i=0; i<nthreads; i++) {
+    k = pm.tcounts[i];
+    pm.tcounts[i] = sum;
+    sum += k;
+  }
+  cnvtxs = sum;
+
+  RunThreads(nthreads, PMatchNumber, (void *)&pm);
+  RunThreads(nthreads, PMatchFollow, (void *)&pm);
+
+  IFSET(ctrl->dbglvl, DBG_TIME, stoptimer(ctrl->MatchTmr));
+
+  GKdealloc(pm.tcounts);
+
+  CreateCoarseGraphParallel(ctrl, graph, cnvtxs, match, cperm);
+
+  idxwspacefree(ctrl, nvtxs);
+  idxwspacefree(ctrl, nvtxs);
+  idxwspacefree(ctrl, nvtxs);
+}
+
+
 /*************************************************************************
 * This function finds a matching using the HEM heuristic
 **************************************************************************/
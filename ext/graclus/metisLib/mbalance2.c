@@ -151,7 +151,7 @@ void MocGeneral2WayBalance2(CtrlType *ctrl, GraphType *graph, float *tpwgts, flo
     swaps[nswaps] = higain;
 
     if (ctrl->dbglvl&DBG_MOVEINFO) {
-      printf("Moved %6d from %d(%d). Gain: %5d, Cut: %5d, NPwgts: ", higain, from, cnum, ed[higain]-id[higain], newcut);
+      printf("Moved %6d from %d(%d). Gain: %5" PRIDX ", Cut: %5d, NPwgts: ", higain, from, cnum, ed[higain]-id[higain], newcut);
       for (i=0; i<ncon; i++) 
         printf("(%.3f, %.3f) ", npwgts[i], npwgts[ncon+i]);
 
@@ -28,7 +28,7 @@ GraphType *MCCoarsen2Way(CtrlType *ctrl, GraphType *graph)
   clevel = 0;
   do {
     if (ctrl->dbglvl&DBG_COARSEN) {
-      printf("%6d %7d %10d [%d] [%6.4f", cgraph->nvtxs, cgraph->nedges, 
+      printf("%6d %7" PRIDX " %10d [%d] [%6.4f", cgraph->nvtxs, cgraph->nedges, 
               idxsum(cgraph->nvtxs, cgraph->adjwgtsum), ctrl->CoarsenTo, ctrl->nmaxvwgt);
       for (i=0; i<graph->ncon; i++)
         printf(" %5.3f", ssum_strd(cgraph->nvtxs, cgraph->nvwgt+i, cgraph->ncon));
@@ -76,7 +76,7 @@ GraphType *MCCoarsen2Way(CtrlType *ctrl, GraphType *graph)
   } while (cgraph->nvtxs > ctrl->CoarsenTo && cgraph->nvtxs < COARSEN_FRACTION2*cgraph->finer->nvtxs && cgraph->nedges > cgraph->nvtxs/2); 
 
   if (ctrl->dbglvl&DBG_COARSEN) {
-    printf("%6d %7d %10d [%d] [%6.4f", cgraph->nvtxs, cgraph->nedges, 
+    printf("%6d %7" PRIDX " %10d [%d] [%6.4f", cgraph->nvtxs, cgraph->nedges, 
             idxsum(cgraph->nvtxs, cgraph->adjwgtsum), ctrl->CoarsenTo, ctrl->nmaxvwgt);
     for (i=0; i<graph->ncon; i++)
       printf(" %5.3f", ssum_strd(cgraph->nvtxs, cgraph->nvwgt+i, cgraph->ncon));
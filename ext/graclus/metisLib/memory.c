@@ -203,6 +203,6 @@ void FreeGraph(GraphType *graph)
 {
 
   GKfree((void**) &graph->gdata, (void**) &graph->nvwgt, (void**) &graph->rdata, (void**) &graph->npwgts, LTERM);
-  free(graph);
+  GKdealloc(graph);
 }
 
@@ -154,9 +154,9 @@ void GENDUALMETIS(int nelmnts, int nvtxs, int etype, idxtype *elmnts, idxtype *d
      dxadj[i] = dxadj[i-1];
    dxadj[0] = 0;
 
-   free(mark);
-   free(nptr);
-   free(nind);
+   GKdealloc(mark);
+   GKdealloc(nptr);
+   GKdealloc(nind);
 
 }
 
@@ -205,9 +205,9 @@ void TRINODALMETIS(int nelmnts, int nvtxs, idxtype *elmnts, idxtype *dxadj, idxt
      dxadj[i+1] = nedges;
    }
 
-   free(mark);
-   free(nptr);
-   free(nind);
+   GKdealloc(mark);
+   GKdealloc(nptr);
+   GKdealloc(nind);
 
 }
 
@@ -254,9 +254,9 @@ void TETNODALMETIS(int nelmnts, int nvtxs, idxtype *elmnts, idxtype *dxadj, idxt
      dxadj[i+1] = nedges;
    }
 
-   free(mark);
-   free(nptr);
-   free(nind);
+   GKdealloc(mark);
+   GKdealloc(nptr);
+   GKdealloc(nind);
 
 }
 
@@ -327,9 +327,9 @@ void HEXNODALMETIS(int nelmnts, int nvtxs, idxtype *elmnts, idxtype *dxadj, idxt
      dxadj[i+1] = nedges;
    }
 
-   free(mark);
-   free(nptr);
-   free(nind);
+   GKdealloc(mark);
+   GKdealloc(nptr);
+   GKdealloc(nind);
 
 }
 
@@ -391,8 +391,8 @@ void QUADNODALMETIS(int nelmnts, int nvtxs, idxtype *elmnts, idxtype *dxadj, idx
      dxadj[i+1] = nedges;
    }
 
-   free(mark);
-   free(nptr);
-   free(nind);
+   GKdealloc(mark);
+   GKdealloc(nptr);
+   GKdealloc(nind);
 
 }
@@ -24,6 +24,7 @@
 #include <math.h>
 #include <stdarg.h>
 #include <time.h>
+#include <pthread.h>
 
 #ifdef DMALLOC
 #include <dmalloc.h>
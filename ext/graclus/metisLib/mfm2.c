@@ -141,7 +141,7 @@ void MocFM_2WayEdgeRefine2(CtrlType *ctrl, GraphType *graph, float *tpwgts, floa
       swaps[nswaps] = higain;
 
       if (ctrl->dbglvl&DBG_MOVEINFO) {
-        printf("Moved %6d from %d(%d). Gain: %5d, Cut: %5d, NPwgts: ", higain, from, cnum, ed[higain]-id[higain], newcut);
+        printf("Moved %6d from %d(%d). Gain: %5" PRIDX ", Cut: %5d, NPwgts: ", higain, from, cnum, ed[higain]-id[higain], newcut);
         for (l=0; l<ncon; l++) 
           printf("(%.3f, %.3f) ", npwgts[l], npwgts[ncon+l]);
 
@@ -96,7 +96,7 @@ void MinCover(idxtype *xadj, idxtype *adjncy, int asize, int bsize, idxtype *cov
             }
             else { /* This column node is matched */
               if (flag[mate[col]]) 
-                printf("\nSomething wrong, flag[%d] is 1",mate[col]);
+                printf("\nSomething wrong, flag[%" PRIDX "] is 1",mate[col]);
               queue[rptr++] = mate[col];
               level[mate[col]] = level[row] + 1;
             }
@@ -200,7 +200,7 @@ void MinCover_Decompose(idxtype *xadj, idxtype *adjncy, int asize, int bsize, id
   }
 
   *csize = k;
-  free(where);
+  GKdealloc(where);
 
 }
 
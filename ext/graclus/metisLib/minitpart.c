@@ -39,7 +39,7 @@ void MocInit2WayPartition(CtrlType *ctrl, GraphType *graph, float *tpwgts, float
       errexit("Unknown initial partition type: %d\n", ctrl->IType);
   }
 
-  IFSET(ctrl->dbglvl, DBG_IPART, printf("Initial Cut: %d [%d]\n", graph->mincut, graph->where[0]));
+  IFSET(ctrl->dbglvl, DBG_IPART, printf("Initial Cut: %d [%" PRIDX "]\n", graph->mincut, graph->where[0]));
   IFSET(ctrl->dbglvl, DBG_TIME, stoptimer(ctrl->InitPartTmr));
   ctrl->dbglvl = dbglvl;
 
@@ -258,7 +258,7 @@ void MocInit2WayBalance(CtrlType *ctrl, GraphType *graph, float *tpwgts)
     where[higain] = to;
 
     if (ctrl->dbglvl&DBG_MOVEINFO) {
-      printf("Moved %6d from %d(%d). [%5d] %5d, NPwgts: ", higain, from, cnum, ed[higain]-id[higain], mincut);
+      printf("Moved %6d from %d(%d). [%5" PRIDX "] %5d, NPwgts: ", higain, from, cnum, ed[higain]-id[higain], mincut);
       for (l=0; l<ncon; l++) 
         printf("(%.3f, %.3f) ", npwgts[l], npwgts[ncon+l]);
       printf(", LB: %.3f\n", Compute2WayHLoadImbalance(ncon, npwgts, tpwgts));
@@ -249,7 +249,7 @@ void MocInit2WayBalance2(CtrlType *ctrl, GraphType *graph, float *tpwgts, float
     moved[higain] = nswaps;
 
     if (ctrl->dbglvl&DBG_MOVEINFO) {
-      printf("Moved %6d from %d(%d). [%5d] %5d, NPwgts: ", higain, from, cnum, ed[higain]-id[higain], mincut);
+      printf("Moved %6d from %d(%d). [%5" PRIDX "] %5d, NPwgts: ", higain, from, cnum, ed[higain]-id[higain], mincut);
       for (l=0; l<ncon; l++) 
         printf("(%.3f, %.3f) ", npwgts[l], npwgts[ncon+l]);
       printf(", LB: %.3f\n", ComputeLoadImbalance(ncon, 2, npwgts, tpwgts));
@@ -150,7 +150,7 @@ void MCRandom_KWayEdgeRefineHorizontal(CtrlType *ctrl, GraphType *graph, int npa
         *======================================================================*/
         graph->mincut -= myedegrees[k].ed-myrinfo->id;
 
-        IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4d. Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
+        IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4" PRIDX ". Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
 
         /* Update where, weight, and ID/ED information of the vertex you moved */
         saxpy(ncon, 1.0, nvwgt, 1, npwgts+to*ncon, 1);
@@ -380,7 +380,7 @@ void MCGreedy_KWayEdgeBalanceHorizontal(CtrlType *ctrl, GraphType *graph, int np
       *======================================================================*/
       graph->mincut -= myedegrees[k].ed-myrinfo->id;
 
-      IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4d. Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
+      IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4" PRIDX ". Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
 
       /* Update where, weight, and ID/ED information of the vertex you moved */
       saxpy(ncon, 1.0, nvwgt, 1, npwgts+to*ncon, 1);
@@ -285,7 +285,7 @@ void MlevelNestedDissection(CtrlType *ctrl, GraphType *graph, idxtype *order, fl
     case OP_ONMETIS:
       MlevelNodeBisectionMultiple(ctrl, graph, tpwgts2, ubfactor);
 
-      IFSET(ctrl->dbglvl, DBG_SEPINFO, printf("Nvtxs: %6d, [%6d %6d %6d]\n", graph->nvtxs, graph->pwgts[0], graph->pwgts[1], graph->pwgts[2]));
+      IFSET(ctrl->dbglvl, DBG_SEPINFO, printf("Nvtxs: %6d, [%6" PRIDX " %6" PRIDX " %6" PRIDX "]\n", graph->nvtxs, graph->pwgts[0], graph->pwgts[1], graph->pwgts[2]));
 
       break;
   }
@@ -335,7 +335,7 @@ void MlevelNestedDissectionCC(CtrlType *ctrl, GraphType *graph, idxtype *order,
   tpwgts2[1] = tvwgt-tpwgts2[0];
 
   MlevelNodeBisectionMultiple(ctrl, graph, tpwgts2, ubfactor);
-  IFSET(ctrl->dbglvl, DBG_SEPINFO, printf("Nvtxs: %6d, [%6d %6d %6d]\n", graph->nvtxs, graph->pwgts[0], graph->pwgts[1], graph->pwgts[2]));
+  IFSET(ctrl->dbglvl, DBG_SEPINFO, printf("Nvtxs: %6d, [%6" PRIDX " %6" PRIDX " %6" PRIDX "]\n", graph->nvtxs, graph->pwgts[0], graph->pwgts[1], graph->pwgts[2]));
 
   /* Order the nodes in the separator */
   nbnd = graph->nbnd;
@@ -374,7 +374,7 @@ void MlevelNestedDissectionCC(CtrlType *ctrl, GraphType *graph, idxtype *order,
     rnvtxs += sgraphs[i].nvtxs;
   }
 
-  free(sgraphs);
+  GKdealloc(sgraphs);
 }
 
 
@@ -419,7 +419,7 @@ void MlevelNodeBisectionMultiple(CtrlType *ctrl, GraphType *graph, int *tpwgts,
 
     Allocate2WayNodePartitionMemory(ctrl, graph);
     idxcopy(nvtxs, bestwhere, graph->where);
-    free(bestwhere);
+    GKdealloc(bestwhere);
 
     Compute2WayNodePartitionParams(ctrl, graph);
   }
@@ -453,7 +453,7 @@ void MlevelNodeBisectionMultiple(CtrlType *ctrl, GraphType *graph, int *tpwgts,
 
     Allocate2WayNodePartitionMemory(ctrl, cgraph);
     idxcopy(cnvtxs, bestwhere, cgraph->where);
-    free(bestwhere);
+    GKdealloc(bestwhere);
 
     Compute2WayNodePartitionParams(ctrl, cgraph);
 
@@ -638,14 +638,14 @@ void MMDOrder(CtrlType *ctrl, GraphType *graph, idxtype *order, int lastvtx)
   list = qsize + nvtxs + 5;
   marker = list + nvtxs + 5;
 
-  genmmd(nvtxs, xadj, adjncy, iperm, perm, 1, head, qsize, list, marker, MAXIDX, &nofsub);
+  genmmd(nvtxs, xadj, adjncy, iperm, perm, 1, head, qsize, list, marker, (int)amin(MAXIDX, 1<<30), &nofsub);
 
   label = graph->label;
   firstvtx = lastvtx-nvtxs;
   for (i=0; i<nvtxs; i++)
     order[label[i]] = firstvtx+iperm[i]-1;
 
-  free(perm);
+  GKdealloc(perm);
 
   /* Relabel the vertices so that it starts from 0 */
   for (i=0; i<nvtxs+1; i++)
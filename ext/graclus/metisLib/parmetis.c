@@ -33,7 +33,7 @@ void METIS_PartGraphKway2(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxtype *v
   METIS_WPartGraphKway2(nvtxs, xadj, adjncy, vwgt, adjwgt, wgtflag, numflag, nparts, 
                        tpwgts, options, edgecut, part);
 
-  free(tpwgts);
+  GKdealloc(tpwgts);
 }
 
 
@@ -218,7 +218,7 @@ void MlevelNestedDissectionP(CtrlType *ctrl, GraphType *graph, idxtype *order, i
 
   MlevelNodeBisectionMultiple(ctrl, graph, tpwgts2, ubfactor);
 
-  IFSET(ctrl->dbglvl, DBG_SEPINFO, printf("Nvtxs: %6d, [%6d %6d %6d]\n", graph->nvtxs, graph->pwgts[0], graph->pwgts[1], graph->pwgts[2]));
+  IFSET(ctrl->dbglvl, DBG_SEPINFO, printf("Nvtxs: %6d, [%6" PRIDX " %6" PRIDX " %6" PRIDX "]\n", graph->nvtxs, graph->pwgts[0], graph->pwgts[1], graph->pwgts[2]));
 
   if (cpos < npes-1) {
     sizes[2*npes-2-cpos] = graph->pwgts[2];
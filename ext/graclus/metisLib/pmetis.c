@@ -16,6 +16,24 @@
 #include <metis.h>
 
 
+/*************************************************************************
+* The following data structure describes one side of a recursive
+* bisection. The two sides are independent and may run concurrently.
+**************************************************************************/
+struct bisectiondef {
+  CtrlType *ctrl;
+  GraphType *graph;
+  int nparts, fpart;
+  idxtype *part;
+  float *tpwgts, ubfactor;
+  int nthreads;			/* The # of threads this side may use */
+  int seed;			/* The seed of its random number generator */
+  int cut;
+};
+
+typedef struct bisectiondef BisectionType;
+
+
 /*************************************************************************
 * This function is the entry point for PMETIS
 **************************************************************************/
@@ -33,7 +51,7 @@ void METIS_PartGraphRecursive(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxtyp
   METIS_WPartGraphRecursive(nvtxs, xadj, adjncy, vwgt, adjwgt, wgtflag, numflag, nparts, 
                             tpwgts, options, edgecut, part);
 
-  free(tpwgts);
+  GKdealloc(tpwgts);
 }
 
 
@@ -61,12 +79,14 @@ void METIS_WPartGraphRecursive(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxty
     ctrl.IType = PMETIS_ITYPE;
     ctrl.RType = PMETIS_RTYPE;
     ctrl.dbglvl = PMETIS_DBGLVL;
+    ctrl.nthreads = 1;
   }
   else {
     ctrl.CType = options[OPTION_CTYPE];
     ctrl.IType = options[OPTION_ITYPE];
     ctrl.RType = options[OPTION_RTYPE];
     ctrl.dbglvl = options[OPTION_DBGLVL];
+    ctrl.nthreads = options[OPTION_NTHREADS];
   }
   ctrl.optype = OP_PMETIS;
   ctrl.CoarsenTo = 20;
@@ -76,7 +96,10 @@ void METIS_WPartGraphRecursive(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxty
   for (i=0; i<*nparts; i++) 
     mytpwgts[i] = tpwgts[i];
 
-  InitRandom(-1);
+  /* Callers that pass their own options keep their random stream, so that
+     every restart of MLKKM gets a different initial partitioning */
+  if (options[0] == 0)
+    InitRandom(-1);
 
   AllocateWorkSpace(&ctrl, &graph, *nparts);
 
@@ -89,7 +112,7 @@ void METIS_WPartGraphRecursive(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxty
   IFSET(ctrl.dbglvl, DBG_TIME, PrintTimers(&ctrl));
 
   FreeWorkSpace(&ctrl, &graph);
-  free(mytpwgts);
+  GKdealloc(mytpwgts);
 
   if (*numflag == 1)
     Change2FNumbering(*nvtxs, xadj, adjncy, part);
@@ -149,8 +172,7 @@ int MlevelRecursiveBisection(CtrlType *ctrl, GraphType *graph, int nparts, idxty
 
   /* Do the recursive call */
   if (nparts > 3) {
-    cut += MlevelRecursiveBisection(ctrl, &lgraph, nparts/2, part, tpwgts, ubfactor, fpart);
-    cut += MlevelRecursiveBisection(ctrl, &rgraph, nparts-nparts/2, part, tpwgts+nparts/2, ubfactor, fpart+nparts/2);
+    cut += MlevelRecursiveBisectionSides(ctrl, &lgraph, &rgraph, nparts, part, tpwgts, ubfactor, fpart);
   }
   else if (nparts == 3) {
     cut += MlevelRecursiveBisection(ctrl, &rgraph, nparts-nparts/2, part, tpwgts+nparts/2, ubfactor, fpart+nparts/2);
@@ -162,6 +184,91 @@ int MlevelRecursiveBisection(CtrlType *ctrl, GraphType *graph, int nparts, idxty
 }
 
 
+/*************************************************************************
+* This function runs the sides tid, tid+nthreads, ... of a bisection. The
+* calling thread works with ctrl, every other thread with its own copy of
+* ctrl and its own workspace.
+**************************************************************************/
+static void BisectSides(void *ptr, int tid, int nthreads)
+{
+  int i, oldnthreads;
+  CtrlType myctrl, *ctrl;
+  BisectionType *bs, *sides = (BisectionType *)ptr;
+
+  for (i=tid; i<2; i+=nthreads) {
+    bs = sides+i;
+
+    if (tid == 0) {
+      ctrl = bs->ctrl;
+    }
+    else {
+      myctrl = *bs->ctrl;
+      AllocateWorkSpace(&myctrl, bs->graph, bs->nparts);
+      ctrl = &myctrl;
+    }
+
+    oldnthreads = ctrl->nthreads;
+    ctrl->nthreads = bs->nthreads;
+    InitRandom(bs->seed);
+
+    bs->cut = MlevelRecursiveBisection(ctrl, bs->graph, bs->nparts, bs->part, bs->tpwgts, bs->ubfactor, bs->fpart);
+
+    ctrl->nthreads = oldnthreads;
+    if (tid != 0)
+      FreeWorkSpace(&myctrl, bs->graph);
+  }
+}
+
+
+/*************************************************************************
+* This function partitions the two sides of a bisection into nparts/2 and 
+* nparts-nparts/2 parts. The sides run concurrently when ctrl allows more
+* than one thread and both of them are large enough. Every side draws its
+* random numbers from its own stream, so the result does not depend on
+* the # of threads.
+**************************************************************************/
+int MlevelRecursiveBisectionSides(CtrlType *ctrl, GraphType *lgraph, GraphType *rgraph, int nparts, idxtype *part, float *tpwgts, float ubfactor, int fpart)
+{
+  int nthreads, tthreads, seed;
+  BisectionType sides[2];
+
+  sides[0].graph = lgraph;
+  sides[0].nparts = nparts/2;
+  sides[0].fpart = fpart;
+  sides[0].tpwgts = tpwgts;
+
+  sides[1].graph = rgraph;
+  sides[1].nparts = nparts-nparts/2;
+  sides[1].fpart = fpart+nparts/2;
+  sides[1].tpwgts = tpwgts+nparts/2;
+
+  sides[0].ctrl = sides[1].ctrl = ctrl;
+  sides[0].part = sides[1].part = part;
+  sides[0].ubfactor = sides[1].ubfactor = ubfactor;
+  sides[0].seed = GKrand();
+  sides[1].seed = GKrand();
+  seed = GKrand();
+
+  tthreads = (ctrl->nthreads > 0 ? ctrl->nthreads : GetNumProcessors());
+  if (tthreads > 1 && amin(lgraph->nvtxs, rgraph->nvtxs) >= PARALLEL_MINBISECT) {
+    nthreads = 2;
+    sides[0].nthreads = tthreads/2;
+    sides[1].nthreads = tthreads-tthreads/2;
+  }
+  else {
+    nthreads = 1;
+    sides[0].nthreads = sides[1].nthreads = ctrl->nthreads;
+  }
+
+  RunThreads(nthreads, BisectSides, (void *)sides);
+
+  /* Continue with a stream that does not depend on which side ran here */
+  InitRandom(seed);
+
+  return sides[0].cut + sides[1].cut;
+}
+
+
 /*************************************************************************
 * This function performs multilevel bisection
 **************************************************************************/
@@ -0,0 +1,262 @@
+/*
+ * pool.c
+ *
+ * This file contains the memory pool that GKmalloc draws from. A pool
+ * keeps the blocks that are freed in free lists of power-of-two size
+ * classes, so that repeated partitionings of similar graphs reuse the
+ * same memory instead of going back to the system allocator.
+ *
+ */
+
+#include <metis.h>
+
+/* The blocks are handed back to the system by the real free */
+#undef free
+
+#define POOLMAGIC	0x6b6d706fUL	/* Marks the blocks of GKmalloc */
+#define MINPOOLCLASS	6			/* Smallest block is 2^6 bytes */
+#define BLOCKHDRSIZE	((sizeof(BlockType)+15)/16*16)
+
+#define BlockHeader(ptr) ((BlockType *)((char *)(ptr) - BLOCKHDRSIZE))
+#define BlockData(blk) ((void *)((char *)(blk) + BLOCKHDRSIZE))
+
+/*************************************************************************
+* The pool that GKmalloc uses in the calling thread, or NULL
+**************************************************************************/
+#ifdef __VC__
+static __declspec(thread) PoolType *curpool = NULL;
+#else
+static __thread PoolType *curpool = NULL;
+#endif
+
+
+/*************************************************************************
+* This function returns the size class of a block of nbytes
+**************************************************************************/
+static int PoolClass(size_t nbytes)
+{
+  int sclass;
+
+  for (sclass=MINPOOLCLASS; ((size_t)1<<sclass) < nbytes; sclass++);
+
+  return sclass;
+}
+
+
+/*************************************************************************
+* This function creates an empty pool
+**************************************************************************/
+PoolType *PoolCreate(void)
+{
+  PoolType *pool;
+
+  pool = (PoolType *)malloc(sizeof(PoolType));
+  if (pool == NULL)
+    errexit("***Memory allocation failed for PoolCreate: pool");
+
+  memset(pool->freelists, 0, sizeof(pool->freelists));
+  pool->poolsize = pool->cursize = pool->peaksize = 0;
+  pool->nsysallocs = 0;
+  pthread_mutex_init(&pool->lock, NULL);
+
+  return pool;
+}
+
+
+/*************************************************************************
+* This function returns the memory of the pool to the system. All the
+* blocks of the pool must have been freed.
+**************************************************************************/
+void PoolDestroy(PoolType *pool)
+{
+  int i;
+  BlockType *blk, *next;
+
+  if (pool == NULL)
+    return;
+
+  if (curpool == pool)
+    curpool = NULL;
+
+  for (i=0; i<NPOOLCLASSES; i++) {
+    for (blk=pool->freelists[i]; blk!=NULL; blk=next) {
+      next = blk->next;
+      free(blk);
+    }
+  }
+
+  pthread_mutex_destroy(&pool->lock);
+  free(pool);
+}
+
+
+/*************************************************************************
+* This function makes GKmalloc of the calling thread use pool, or the
+* system allocator if pool is NULL. It returns the previous pool.
+**************************************************************************/
+PoolType *PoolActivate(PoolType *pool)
+{
+  PoolType *oldpool;
+
+  oldpool = curpool;
+  curpool = pool;
+
+  return oldpool;
+}
+
+
+/*************************************************************************
+* This function returns the pool of the calling thread
+**************************************************************************/
+PoolType *PoolCurrent(void)
+{
+  return curpool;
+}
+
+
+/*************************************************************************
+* This function returns the largest # of bytes of the pool that were in
+* use at the same time
+**************************************************************************/
+size_t PoolPeakSize(PoolType *pool)
+{
+  return pool->peaksize;
+}
+
+
+/*************************************************************************
+* This function allocates a block of at least nbytes from the pool of the
+* calling thread or, if there is none, from the system
+**************************************************************************/
+static BlockType *BlockMalloc(size_t nbytes)
+{
+  int sclass;
+  BlockType *blk;
+  PoolType *pool = curpool;
+
+  if (pool == NULL) {
+    blk = (BlockType *)malloc(BLOCKHDRSIZE + nbytes);
+    if (blk != NULL) {
+      blk->pool = NULL;
+      blk->sclass = -1;
+    }
+  }
+  else {
+    sclass = PoolClass(BLOCKHDRSIZE + nbytes);
+    if (sclass >= NPOOLCLASSES)
+      return NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    blk = pool->freelists[sclass];
+    if (blk != NULL) {
+      pool->freelists[sclass] = blk->next;
+    }
+    else {
+      blk = (BlockType *)malloc((size_t)1<<sclass);
+      if (blk != NULL) {
+        pool->nsysallocs++;
+        pool->poolsize += (size_t)1<<sclass;
+        blk->pool = pool;
+        blk->sclass = sclass;
+      }
+    }
+    if (blk != NULL) {
+      pool->cursize += (size_t)1<<sclass;
+      pool->peaksize = amax(pool->peaksize, pool->cursize);
+    }
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+  if (blk != NULL) {
+    blk->magic = POOLMAGIC;
+    blk->next = NULL;
+  }
+
+  return blk;
+}
+
+
+/*************************************************************************
+* This function is my wrapper around malloc. The blocks carry a header
+* that tells GKdealloc where they came from.
+**************************************************************************/
+#ifndef DMALLOC
+void *GKmalloc(size_t nbytes, char *msg)
+{
+  BlockType *blk;
+
+  if (nbytes == 0)
+    return NULL;
+
+  blk = BlockMalloc(nbytes);
+  if (blk == NULL)
+    errexit("***Memory allocation failed for %s. Requested size: %lu bytes", msg, (unsigned long)nbytes);
+
+  return BlockData(blk);
+}
+
+
+/*************************************************************************
+* This function frees a block of GKmalloc. Blocks of a pool go to its free
+* lists, the others to the system. It must only be given GKmalloc memory,
+* as it reads the header in front of the block; anything else is freed by
+* the system free.
+**************************************************************************/
+void GKdealloc(void *ptr)
+{
+  BlockType *blk;
+  PoolType *pool;
+
+  if (ptr == NULL)
+    return;
+
+  blk = BlockHeader(ptr);
+  ASSERT(blk->magic == POOLMAGIC);
+
+  if ((pool = blk->pool) == NULL) {
+    blk->magic = 0;
+    free(blk);
+    return;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->cursize -= (size_t)1<<blk->sclass;
+  blk->next = pool->freelists[blk->sclass];
+  pool->freelists[blk->sclass] = blk;
+  pthread_mutex_unlock(&pool->lock);
+}
+
+
+/*************************************************************************
+* This function is my wrapper around realloc for the blocks of GKmalloc
+**************************************************************************/
+void *GKrealloc(void *ptr, size_t nbytes, char *msg)
+{
+  BlockType *blk;
+  void *newptr;
+  size_t oldbytes;
+
+  if (ptr == NULL)
+    return GKmalloc(nbytes, msg);
+
+  blk = BlockHeader(ptr);
+  ASSERT(blk->magic == POOLMAGIC);
+  if (blk->pool == NULL) {
+    blk = (BlockType *)realloc(blk, BLOCKHDRSIZE + nbytes);
+    if (blk == NULL)
+      errexit("***Memory allocation failed for %s. Requested size: %lu bytes", msg, (unsigned long)nbytes);
+    return BlockData(blk);
+  }
+
+  /* A pool block is kept if the new size fits in its class */
+  oldbytes = ((size_t)1<<blk->sclass) - BLOCKHDRSIZE;
+  if (nbytes <= oldbytes)
+    return ptr;
+
+  newptr = GKmalloc(nbytes, msg);
+  memcpy(newptr, ptr, oldbytes);
+  GKdealloc(ptr);
+
+  return newptr;
+}
+#endif
@@ -26,6 +26,7 @@ void CreateCoarseGraphNoMask(CtrlType *, GraphType *, int, idxtype *, idxtype *)
 void CreateCoarseGraph_NVW(CtrlType *, GraphType *, int, idxtype *, idxtype *);
 GraphType *SetUpCoarseGraph(GraphType *, int, int);
 void ReAdjustMemory(GraphType *, GraphType *, int);
+void CreateCoarseGraphParallel(CtrlType *, GraphType *, int, idxtype *, idxtype *);
 
 /* coarsen.c */
 GraphType *Coarsen2Way(CtrlType *, GraphType *);
@@ -147,24 +148,31 @@ void GrowBisectionNode(CtrlType *, GraphType *, float);
 void RandomBisection(CtrlType *, GraphType *, int *, float);
 
 /* mlkkm.c */
-/*void spectralInit(CtrlType *, GraphType *, int *);*/
-void spectralInit(GraphType *, int, int *, int *);
-void MLKKM_PartGraphKway(int *, idxtype *, idxtype *, idxtype *, idxtype *, int *, int *, int *, int *, int *, int *, idxtype *, int); 
-void MLKKM_WPartGraphKway(int *, idxtype *, idxtype *, idxtype *, idxtype *, int *, int *, int *, int *, float *, int *, int *, idxtype *, int); 
+void MLKKM_PartGraphKway(int *, idxtype *, idxtype *, idxtype *, idxtype *, int *, int *, int *, int *, int *, int *, idxtype *, int, MLStatsType *); 
+void MLKKM_WPartGraphKway(int *, idxtype *, idxtype *, idxtype *, idxtype *, int *, int *, int *, int *, float *, int *, int *, idxtype *, int, MLStatsType *); 
 int MLKKMPartitioning(CtrlType *, GraphType *, int, int, idxtype *, float *, float);
+void MLKKM_RefineKway(int *, idxtype *, idxtype *, idxtype *, idxtype *, int *, int *, int *, int *, idxtype *, MLStatsType *);
+
+/* labelprop.c */
+int LabelPropagation(CtrlType *, GraphType *, int, idxtype, idxtype *);
+void LP_PartGraphKway(int *, idxtype *, idxtype *, idxtype *, idxtype *, int *, int *, int *, int *, int *, int *, idxtype *, int, MLStatsType *); 
+
+/* spectral.cpp */
+int SpectralInit(CtrlType *, GraphType *, int, idxtype *);
 
 /* weighted kernel k-means */
 void Compute_Weights(CtrlType *ctrl, GraphType *graph, idxtype *w);
 void transform_matrix(CtrlType *ctrl, GraphType *graph, idxtype *w, float *adjwgt);
 void transform_matrix_half(CtrlType *ctrl, GraphType *graph, idxtype *w, float *adjwgt);
-void pingpong(CtrlType *, GraphType *, int , int , float *, float, int );
-void Weighted_kernel_k_means(CtrlType *, GraphType *, int , idxtype *, float *, float );
+int pingpong(CtrlType *, GraphType *, int , int , float *, float, int );
+int Weighted_kernel_k_means(CtrlType *, GraphType *, int , idxtype *, float *, float );
 void remove_empty_clusters_l1(CtrlType *ctrl, GraphType *graph, int nparts, idxtype *w, float *tpwgts, float ubfactor);
 void remove_empty_clusters_l2(CtrlType *ctrl, GraphType *graph, int nparts, idxtype *w, float *tpwgts, float ubfactor);
+int EnforceSizeBound(CtrlType *, GraphType *, int, idxtype *);
 /*void Weighted_kernel_k_means(CtrlType *, GraphType *, int , idxtype *, float *, float *, float ); */
 void MLKKMRefine(CtrlType *, GraphType *, GraphType *, int, int, float *, float);
-float onePoint_move(GraphType *graph, int nparts, idxtype *sum, idxtype *squared_sum, idxtype *w, idxtype *self_sim, int **linearTerm, int ii);
-void move1Point2EmptyCluster(GraphType *graph, int nparts, idxtype *sum, idxtype *squared_sum, idxtype *w, idxtype *self_sim, int **linearTerm, int k);
+float onePoint_move(GraphType *graph, int nparts, acctype *sum, acctype *squared_sum, idxtype *w, idxtype *self_sim, int **linearTerm, int ii);
+void move1Point2EmptyCluster(GraphType *graph, int nparts, acctype *sum, acctype *squared_sum, idxtype *w, idxtype *self_sim, int **linearTerm, int k);
 int local_search(CtrlType *, GraphType *, int, int, idxtype *, float *, float);
 /*int local_search(CtrlType *, GraphType *, int, int, idxtype *, float *, float *, float); */
 /* kmetis.c */
@@ -220,6 +228,7 @@ void Match_RM_NVW(CtrlType *, GraphType *);
 void Match_HEM(CtrlType *, GraphType *);
 void Match_SHEM(CtrlType *, GraphType *);
 void Match_SHEMN(CtrlType *, GraphType *);
+void Match_PSHEMN(CtrlType *, GraphType *);
 
 /* mbalance.c */
 void MocBalance2Way(CtrlType *, GraphType *, float *, float);
@@ -384,6 +393,7 @@ void METIS_EdgeComputeSeparator(int *, idxtype *, idxtype *, idxtype *, idxtype
 void METIS_PartGraphRecursive(int *, idxtype *, idxtype *, idxtype *, idxtype *, int *, int *, int *, int *, int *, idxtype *); 
 void METIS_WPartGraphRecursive(int *, idxtype *, idxtype *, idxtype *, idxtype *, int *, int *, int *, float *, int *, int *, idxtype *); 
 int MlevelRecursiveBisection(CtrlType *, GraphType *, int, idxtype *, float *, float, int);
+int MlevelRecursiveBisectionSides(CtrlType *, GraphType *, GraphType *, int, idxtype *, float *, float, int);
 void MlevelEdgeBisection(CtrlType *, GraphType *, int *, float);
 void SplitGraphPart(CtrlType *, GraphType *, GraphType *, GraphType *);
 void SetUpSplitGraph(GraphType *, GraphType *, int, int);
@@ -442,10 +452,28 @@ void MoveGroupMConn(CtrlType *, GraphType *, idxtype *, idxtype *, int, int, int
 void EliminateComponents(CtrlType *, GraphType *, int, float *, float);
 void MoveGroup(CtrlType *, GraphType *, int, int, int, idxtype *, idxtype *);
 
+/* pool.c */
+PoolType *PoolCreate(void);
+void PoolDestroy(PoolType *);
+PoolType *PoolActivate(PoolType *);
+PoolType *PoolCurrent(void);
+size_t PoolPeakSize(PoolType *);
+#ifndef DMALLOC
+void GKdealloc(void *);
+void *GKrealloc(void *, size_t, char *);
+#endif
+
+/* thread.c */
+int GetNumProcessors(void);
+void RunThreads(int, ThreadFuncType, void *);
+void ThreadRange(int, int, int, int *, int *);
+int ThreadCount(CtrlType *, int);
+
 /* timing.c */
 void InitTimers(CtrlType *);
 void PrintTimers(CtrlType *);
 double seconds(void);
+double WallSeconds(void);
 
 /* util.c */
 void print_help(char *program_name);
@@ -458,15 +486,16 @@ Chains *chainmalloc(int n, char *msg);
 float **f2malloc(int n, int m, char *msg);
 int **i2malloc(int, int, char *);
 int *imalloc(int, char *);
-idxtype *idxmalloc(int, char *);
-float *fmalloc(int, char *);
+idxtype *idxmalloc(idxtype, char *);
+float *fmalloc(idxtype, char *);
 int *ismalloc(int, int, char *);
-idxtype *idxsmalloc(int, idxtype, char *);
-void *GKmalloc(int, char *);
+idxtype *idxsmalloc(idxtype, idxtype, char *);
+acctype *accsmalloc(int, acctype, char *);
+void *GKmalloc(size_t, char *);
 #endif
 void GKfree(void **,...); 
 int *iset(int n, int val, int *x);
-idxtype *idxset(int n, idxtype val, idxtype *x);
+idxtype *idxset(idxtype n, idxtype val, idxtype *x);
 float *sset(int n, float val, float *x);
 int iamax(int, int *);
 int idxamax(int, idxtype *);
@@ -492,6 +521,8 @@ double drand48();
 void srand48(long);
 int ispow2(int);
 void InitRandom(int);
+int GKrand(void);
+double GKdrand(void);
 int log2_metis(int);
 
 
@@ -511,7 +542,7 @@ int log2_metis(int);
 void ReadCoarsestInit(GraphType *graph, char *filename, int *wgtflag);
 void WriteCoarsestGraph(GraphType *graph, char *filename, int *wgtflag);
 void CreateGraph_Matlab(GraphType *graph, double* idata, double* jdata, double* edgeval, int vtx, int edges, int *wgtflag);
-void ReadGraph(GraphType *, char *, int *);
+void ReadGraph(GraphType *, char *, int *, int);
 void WritePartition(char *, idxtype *, int, int);
 void WriteMeshPartition(char *, int, int, idxtype *, int, idxtype *);
 void WritePermutation(char *, idxtype *, int);
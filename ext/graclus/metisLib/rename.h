@@ -28,6 +28,7 @@
 #define CreateCoarseGraph_NVW 		__CreateCoarseGraph_NVW
 #define SetUpCoarseGraph		__SetUpCoarseGraph
 #define ReAdjustMemory			__ReAdjustMemory
+#define CreateCoarseGraphParallel	__CreateCoarseGraphParallel
 
 
 /* coarsen.c */
@@ -140,6 +141,7 @@
 #define Match_RM_NVW			__Match_RM_NVW
 #define Match_HEM			__Match_HEM
 #define Match_SHEM			__Match_SHEM
+#define Match_PSHEMN			__Match_PSHEMN
 
 
 /* mbalance.c */
@@ -306,6 +308,7 @@
 
 /* pmetis.c */
 #define MlevelRecursiveBisection	__MlevelRecursiveBisection
+#define MlevelRecursiveBisectionSides	__MlevelRecursiveBisectionSides
 #define MlevelEdgeBisection		__MlevelEdgeBisection
 #define SplitGraphPart			__SplitGraphPart
 #define SetUpSplitGraph			__SetUpSplitGraph
@@ -369,10 +372,30 @@
 #define MoveGroup			__MoveGroup
 
 
+/* pool.c */
+#define PoolCreate			__PoolCreate
+#define PoolDestroy			__PoolDestroy
+#define PoolActivate			__PoolActivate
+#define PoolCurrent			__PoolCurrent
+#define PoolPeakSize			__PoolPeakSize
+#ifndef DMALLOC
+#define GKdealloc			__GKdealloc
+#define GKrealloc			__GKrealloc
+#endif
+
+
+/* thread.c */
+#define GetNumProcessors		__GetNumProcessors
+#define RunThreads			__RunThreads
+#define ThreadRange			__ThreadRange
+#define ThreadCount			__ThreadCount
+
+
 /* timing.c */
 #define InitTimers			__InitTimers
 #define PrintTimers			__PrintTimers
 #define seconds				__seconds
+#define WallSeconds			__WallSeconds
 
 
 /* util.c */
@@ -384,6 +407,7 @@
 #define fmalloc				__fmalloc
 #define ismalloc			__ismalloc
 #define idxsmalloc			__idxsmalloc
+#define accsmalloc			__accsmalloc
 #define GKmalloc			__GKmalloc
 #endif
 #define iset				__iset
@@ -410,6 +434,8 @@
 #define RandomPermute			__RandomPermute
 #define ispow2				__ispow2
 #define InitRandom			__InitRandom
+#define GKrand				__GKrand
+#define GKdrand				__GKdrand
 #define log2_metis			__log2_metis
 
 
@@ -136,7 +136,7 @@ void ConstructMinCoverSeparator0(CtrlType *ctrl, GraphType *graph, float ubfacto
     MinCover(bxadj, badjncy, bnvtxs[0], bnvtxs[1], cover, &csize);
 
     IFSET(ctrl->dbglvl, DBG_SEPINFO,
-      printf("Nvtxs: %6d, [%5d %5d], Cut: %6d, SS: [%6d %6d], Cover: %6d\n", nvtxs, graph->pwgts[0], graph->pwgts[1], graph->mincut, bnvtxs[0], bnvtxs[1]-bnvtxs[0], csize));
+      printf("Nvtxs: %6d, [%5" PRIDX " %5" PRIDX "], Cut: %6d, SS: [%6d %6d], Cover: %6d\n", nvtxs, graph->pwgts[0], graph->pwgts[1], graph->mincut, bnvtxs[0], bnvtxs[1]-bnvtxs[0], csize));
 
     for (i=0; i<csize; i++) {
       j = ivmap[cover[i]];
@@ -156,7 +156,7 @@ void ConstructMinCoverSeparator0(CtrlType *ctrl, GraphType *graph, float ubfacto
   }
   else {
     IFSET(ctrl->dbglvl, DBG_SEPINFO,
-      printf("Nvtxs: %6d, [%5d %5d], Cut: %6d, SS: [%6d %6d], Cover: %6d\n", nvtxs, graph->pwgts[0], graph->pwgts[1], graph->mincut, 0, 0, 0));
+      printf("Nvtxs: %6d, [%5" PRIDX " %5" PRIDX "], Cut: %6d, SS: [%6d %6d], Cover: %6d\n", nvtxs, graph->pwgts[0], graph->pwgts[1], graph->mincut, 0, 0, 0));
   }
 
   idxwspacefree(ctrl, nvtxs);
@@ -251,7 +251,7 @@ void ConstructMinCoverSeparator(CtrlType *ctrl, GraphType *graph, float ubfactor
     MinCover(bxadj, badjncy, bnvtxs[0], bnvtxs[1], cover, &csize);
 
     IFSET(ctrl->dbglvl, DBG_SEPINFO,
-      printf("Nvtxs: %6d, [%5d %5d], Cut: %6d, SS: [%6d %6d], Cover: %6d\n", nvtxs, graph->pwgts[0], graph->pwgts[1], graph->mincut, bnvtxs[0], bnvtxs[1]-bnvtxs[0], csize));
+      printf("Nvtxs: %6d, [%5" PRIDX " %5" PRIDX "], Cut: %6d, SS: [%6d %6d], Cover: %6d\n", nvtxs, graph->pwgts[0], graph->pwgts[1], graph->mincut, bnvtxs[0], bnvtxs[1]-bnvtxs[0], csize));
 
     for (i=0; i<csize; i++) {
       j = ivmap[cover[i]];
@@ -262,7 +262,7 @@ void ConstructMinCoverSeparator(CtrlType *ctrl, GraphType *graph, float ubfactor
   }
   else {
     IFSET(ctrl->dbglvl, DBG_SEPINFO,
-      printf("Nvtxs: %6d, [%5d %5d], Cut: %6d, SS: [%6d %6d], Cover: %6d\n", nvtxs, graph->pwgts[0], graph->pwgts[1], graph->mincut, 0, 0, 0));
+      printf("Nvtxs: %6d, [%5" PRIDX " %5" PRIDX "], Cut: %6d, SS: [%6d %6d], Cover: %6d\n", nvtxs, graph->pwgts[0], graph->pwgts[1], graph->mincut, 0, 0, 0));
   }
 
   /* Prepare to refine the vertex separator */
@@ -53,7 +53,7 @@ void FM_2WayNodeRefine(CtrlType *ctrl, GraphType *graph, float ubfactor, int npa
   perm = idxwspacemalloc(ctrl, nvtxs);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-    printf("Partitions: [%6d %6d] Nv-Nb[%6d %6d]. ISep: %6d\n", pwgts[0], pwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
+    printf("Partitions: [%6" PRIDX " %6" PRIDX "] Nv-Nb[%6d %6d]. ISep: %6d\n", pwgts[0], pwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
 
   badmaxpwgt = (int)(ubfactor*(pwgts[0]+pwgts[1]+pwgts[2])/2);
 
@@ -183,7 +183,7 @@ void FM_2WayNodeRefine(CtrlType *ctrl, GraphType *graph, float ubfactor, int npa
       mptr[nswaps+1] = nmind;
 
       IFSET(ctrl->dbglvl, DBG_MOVEINFO,
-            printf("Moved %6d to %3d, Gain: %5d [%5d] [%4d %4d] \t[%5d %5d %5d]\n", higain, to, g[to], g[other], vwgt[u[to]], vwgt[u[other]], pwgts[0], pwgts[1], pwgts[2]));
+            printf("Moved %6d to %3d, Gain: %5d [%5d] [%4" PRIDX " %4" PRIDX "] \t[%5" PRIDX " %5" PRIDX " %5" PRIDX "]\n", higain, to, g[to], g[other], vwgt[u[to]], vwgt[u[other]], pwgts[0], pwgts[1], pwgts[2]));
 
     }
 
@@ -230,7 +230,7 @@ void FM_2WayNodeRefine(CtrlType *ctrl, GraphType *graph, float ubfactor, int npa
     ASSERT(mincut == pwgts[2]);
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-      printf("\tMinimum sep: %6d at %5d, PWGTS: [%6d %6d], NBND: %6d\n", mincut, mincutorder, pwgts[0], pwgts[1], nbnd));
+      printf("\tMinimum sep: %6d at %5d, PWGTS: [%6" PRIDX " %6" PRIDX "], NBND: %6d\n", mincut, mincutorder, pwgts[0], pwgts[1], nbnd));
 
     graph->mincut = mincut;
     graph->nbnd = nbnd;
@@ -288,7 +288,7 @@ void FM_2WayNodeRefine2(CtrlType *ctrl, GraphType *graph, float ubfactor, int np
   perm = idxwspacemalloc(ctrl, nvtxs);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-    printf("Partitions: [%6d %6d] Nv-Nb[%6d %6d]. ISep: %6d\n", pwgts[0], pwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
+    printf("Partitions: [%6" PRIDX " %6" PRIDX "] Nv-Nb[%6d %6d]. ISep: %6d\n", pwgts[0], pwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
 
   badmaxpwgt = (int)(ubfactor*(pwgts[0]+pwgts[1]+pwgts[2])/2);
 
@@ -420,7 +420,7 @@ void FM_2WayNodeRefine2(CtrlType *ctrl, GraphType *graph, float ubfactor, int np
       mptr[nswaps+1] = nmind;
 
       IFSET(ctrl->dbglvl, DBG_MOVEINFO,
-            printf("Moved %6d to %3d, Gain: %5d [%5d] [%4d %4d] \t[%5d %5d %5d]\n", higain, to, g[to], g[other], vwgt[u[to]], vwgt[u[other]], pwgts[0], pwgts[1], pwgts[2]));
+            printf("Moved %6d to %3d, Gain: %5d [%5d] [%4" PRIDX " %4" PRIDX "] \t[%5" PRIDX " %5" PRIDX " %5" PRIDX "]\n", higain, to, g[to], g[other], vwgt[u[to]], vwgt[u[other]], pwgts[0], pwgts[1], pwgts[2]));
 
     }
 
@@ -467,7 +467,7 @@ void FM_2WayNodeRefine2(CtrlType *ctrl, GraphType *graph, float ubfactor, int np
     ASSERT(mincut == pwgts[2]);
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-      printf("\tMinimum sep: %6d at %5d, PWGTS: [%6d %6d], NBND: %6d\n", mincut, mincutorder, pwgts[0], pwgts[1], nbnd));
+      printf("\tMinimum sep: %6d at %5d, PWGTS: [%6" PRIDX " %6" PRIDX "], NBND: %6d\n", mincut, mincutorder, pwgts[0], pwgts[1], nbnd));
 
     graph->mincut = mincut;
     graph->nbnd = nbnd;
@@ -525,7 +525,7 @@ void FM_2WayNodeRefineEqWgt(CtrlType *ctrl, GraphType *graph, int npasses)
   perm = idxwspacemalloc(ctrl, nvtxs);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-    printf("Partitions: [%6d %6d] Nv-Nb[%6d %6d]. ISep: %6d\n", pwgts[0], pwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
+    printf("Partitions: [%6" PRIDX " %6" PRIDX "] Nv-Nb[%6d %6d]. ISep: %6d\n", pwgts[0], pwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
 
   for (pass=0; pass<npasses; pass++) {
     idxset(nvtxs, -1, moved);
@@ -643,7 +643,7 @@ void FM_2WayNodeRefineEqWgt(CtrlType *ctrl, GraphType *graph, int npasses)
       mptr[nswaps+1] = nmind;
 
       IFSET(ctrl->dbglvl, DBG_MOVEINFO,
-            printf("Moved %6d to %3d, Gain: %5d [%5d] [%4d %4d] \t[%5d %5d %5d]\n", higain, to, g[to], g[other], vwgt[u[to]], vwgt[u[other]], pwgts[0], pwgts[1], pwgts[2]));
+            printf("Moved %6d to %3d, Gain: %5d [%5d] [%4" PRIDX " %4" PRIDX "] \t[%5" PRIDX " %5" PRIDX " %5" PRIDX "]\n", higain, to, g[to], g[other], vwgt[u[to]], vwgt[u[other]], pwgts[0], pwgts[1], pwgts[2]));
 
     }
 
@@ -690,7 +690,7 @@ void FM_2WayNodeRefineEqWgt(CtrlType *ctrl, GraphType *graph, int npasses)
     ASSERT(mincut == pwgts[2]);
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-      printf("\tMinimum sep: %6d at %5d, PWGTS: [%6d %6d], NBND: %6d\n", mincut, mincutorder, pwgts[0], pwgts[1], nbnd));
+      printf("\tMinimum sep: %6d at %5d, PWGTS: [%6" PRIDX " %6" PRIDX "], NBND: %6d\n", mincut, mincutorder, pwgts[0], pwgts[1], nbnd));
 
     graph->mincut = mincut;
     graph->nbnd = nbnd;
@@ -744,7 +744,7 @@ void FM_2WayNodeRefine_OneSided(CtrlType *ctrl, GraphType *graph, float ubfactor
   mind = idxwspacemalloc(ctrl, nvtxs+1);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-    printf("Partitions-N1: [%6d %6d] Nv-Nb[%6d %6d]. ISep: %6d\n", pwgts[0], pwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
+    printf("Partitions-N1: [%6" PRIDX " %6" PRIDX "] Nv-Nb[%6d %6d]. ISep: %6d\n", pwgts[0], pwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
 
   badmaxpwgt = (int)(ubfactor*(pwgts[0]+pwgts[1]+pwgts[2])/2);
 
@@ -846,7 +846,7 @@ void FM_2WayNodeRefine_OneSided(CtrlType *ctrl, GraphType *graph, float ubfactor
 
 
       IFSET(ctrl->dbglvl, DBG_MOVEINFO,
-            printf("Moved %6d to %3d, Gain: %5d [%5d] \t[%5d %5d %5d] [%3d %2d]\n", 
+            printf("Moved %6d to %3d, Gain: %5" PRIDX " [%5" PRIDX "] \t[%5" PRIDX " %5" PRIDX " %5" PRIDX "] [%3d %2d]\n", 
                        higain, to, (vwgt[higain]-rinfo[higain].edegrees[other]), vwgt[higain], pwgts[0], pwgts[1], pwgts[2], nswaps, limit));
 
     }
@@ -893,7 +893,7 @@ void FM_2WayNodeRefine_OneSided(CtrlType *ctrl, GraphType *graph, float ubfactor
     ASSERT(mincut == pwgts[2]);
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-      printf("\tMinimum sep: %6d at %5d, PWGTS: [%6d %6d], NBND: %6d\n", mincut, mincutorder, pwgts[0], pwgts[1], nbnd));
+      printf("\tMinimum sep: %6d at %5d, PWGTS: [%6" PRIDX " %6" PRIDX "], NBND: %6d\n", mincut, mincutorder, pwgts[0], pwgts[1], nbnd));
 
     graph->mincut = mincut;
     graph->nbnd = nbnd;
@@ -950,7 +950,7 @@ void FM_2WayNodeBalance(CtrlType *ctrl, GraphType *graph, float ubfactor)
   moved = idxset(nvtxs, -1, idxwspacemalloc(ctrl, nvtxs));
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-    printf("Partitions: [%6d %6d] Nv-Nb[%6d %6d]. ISep: %6d [B]\n", pwgts[0], pwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
+    printf("Partitions: [%6" PRIDX " %6" PRIDX "] Nv-Nb[%6d %6d]. ISep: %6d [B]\n", pwgts[0], pwgts[1], graph->nvtxs, graph->nbnd, graph->mincut));
 
   nbnd = graph->nbnd;
   RandomPermute(nbnd, perm, 1);
@@ -988,7 +988,7 @@ void FM_2WayNodeBalance(CtrlType *ctrl, GraphType *graph, float ubfactor)
     where[higain] = to;
 
     IFSET(ctrl->dbglvl, DBG_MOVEINFO,
-          printf("Moved %6d to %3d, Gain: %3d, \t[%5d %5d %5d]\n", higain, to, vwgt[higain]-rinfo[higain].edegrees[other], pwgts[0], pwgts[1], pwgts[2]));
+          printf("Moved %6d to %3d, Gain: %3" PRIDX ", \t[%5" PRIDX " %5" PRIDX " %5" PRIDX "]\n", higain, to, vwgt[higain]-rinfo[higain].edegrees[other], pwgts[0], pwgts[1], pwgts[2]));
 
 
     /**********************************************************
@@ -1032,7 +1032,7 @@ void FM_2WayNodeBalance(CtrlType *ctrl, GraphType *graph, float ubfactor)
   }
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-    printf("\tBalanced sep: %6d at %4d, PWGTS: [%6d %6d], NBND: %6d\n", pwgts[2], nswaps, pwgts[0], pwgts[1], nbnd));
+    printf("\tBalanced sep: %6" PRIDX " at %4d, PWGTS: [%6" PRIDX " %6" PRIDX "], NBND: %6d\n", pwgts[2], nswaps, pwgts[0], pwgts[1], nbnd));
 
   graph->mincut = pwgts[2];
   graph->nbnd = nbnd;
@@ -88,20 +88,20 @@ void ComputePartitionInfo(GraphType *graph, int nparts, idxtype *where)
 
   for (i=0; i<nparts; i++)
     kpwgts[i] = idxsum(nparts, padjncy+i*nparts);
-  printf("Min/Max/Avg/Bal # of adjacent     subdomains: %5d %5d %5.2f %7.3f\n",
+  printf("Min/Max/Avg/Bal # of adjacent     subdomains: %5" PRIDX " %5" PRIDX " %5.2f %7.3f\n",
     kpwgts[idxamin(nparts, kpwgts)], kpwgts[idxamax(nparts, kpwgts)], 
     1.0*idxsum(nparts, kpwgts)/(1.0*nparts), 
     1.0*nparts*kpwgts[idxamax(nparts, kpwgts)]/(1.0*idxsum(nparts, kpwgts)));
 
   for (i=0; i<nparts; i++)
     kpwgts[i] = idxsum(nparts, padjcut+i*nparts);
-  printf("Min/Max/Avg/Bal # of adjacent subdomain cuts: %5d %5d %5d %7.3f\n",
+  printf("Min/Max/Avg/Bal # of adjacent subdomain cuts: %5" PRIDX " %5" PRIDX " %5d %7.3f\n",
     kpwgts[idxamin(nparts, kpwgts)], kpwgts[idxamax(nparts, kpwgts)], idxsum(nparts, kpwgts)/nparts, 
     1.0*nparts*kpwgts[idxamax(nparts, kpwgts)]/(1.0*idxsum(nparts, kpwgts)));
 
   for (i=0; i<nparts; i++)
     kpwgts[i] = idxsum(nparts, padjwgt+i*nparts);
-  printf("Min/Max/Avg/Bal/Frac # of interface    nodes: %5d %5d %5d %7.3f %7.3f\n",
+  printf("Min/Max/Avg/Bal/Frac # of interface    nodes: %5" PRIDX " %5" PRIDX " %5d %7.3f %7.3f\n",
     kpwgts[idxamin(nparts, kpwgts)], kpwgts[idxamax(nparts, kpwgts)], idxsum(nparts, kpwgts)/nparts, 
     1.0*nparts*kpwgts[idxamax(nparts, kpwgts)]/(1.0*idxsum(nparts, kpwgts)), 1.0*idxsum(nparts, kpwgts)/(1.0*nvtxs));
 
@@ -112,11 +112,11 @@ void ComputePartitionInfo(GraphType *graph, int nparts, idxtype *where)
   graph->where = tmpptr;
 
   if (mustfree == 1 || mustfree == 3) {
-    free(vwgt);
+    GKdealloc(vwgt);
     graph->vwgt = NULL;
   }
   if (mustfree == 2 || mustfree == 3) {
-    free(adjwgt);
+    GKdealloc(adjwgt);
     graph->adjwgt = NULL;
   }
 
@@ -198,29 +198,29 @@ void ComputePartitionInfoBipartite(GraphType *graph, int nparts, idxtype *where)
 
   for (i=0; i<nparts; i++)
     kpwgts[i] = idxsum(nparts, padjncy+i*nparts);
-  printf("Min/Max/Avg/Bal # of adjacent     subdomains: %5d %5d %5d %7.3f\n",
+  printf("Min/Max/Avg/Bal # of adjacent     subdomains: %5" PRIDX " %5" PRIDX " %5d %7.3f\n",
     kpwgts[idxamin(nparts, kpwgts)], kpwgts[idxamax(nparts, kpwgts)], idxsum(nparts, kpwgts)/nparts, 
     1.0*nparts*kpwgts[idxamax(nparts, kpwgts)]/(1.0*idxsum(nparts, kpwgts)));
 
   for (i=0; i<nparts; i++)
     kpwgts[i] = idxsum(nparts, padjcut+i*nparts);
-  printf("Min/Max/Avg/Bal # of adjacent subdomain cuts: %5d %5d %5d %7.3f\n",
+  printf("Min/Max/Avg/Bal # of adjacent subdomain cuts: %5" PRIDX " %5" PRIDX " %5d %7.3f\n",
     kpwgts[idxamin(nparts, kpwgts)], kpwgts[idxamax(nparts, kpwgts)], idxsum(nparts, kpwgts)/nparts, 
     1.0*nparts*kpwgts[idxamax(nparts, kpwgts)]/(1.0*idxsum(nparts, kpwgts)));
 
   for (i=0; i<nparts; i++)
     kpwgts[i] = idxsum(nparts, padjwgt+i*nparts);
-  printf("Min/Max/Avg/Bal/Frac # of interface    nodes: %5d %5d %5d %7.3f %7.3f\n",
+  printf("Min/Max/Avg/Bal/Frac # of interface    nodes: %5" PRIDX " %5" PRIDX " %5d %7.3f %7.3f\n",
     kpwgts[idxamin(nparts, kpwgts)], kpwgts[idxamax(nparts, kpwgts)], idxsum(nparts, kpwgts)/nparts, 
     1.0*nparts*kpwgts[idxamax(nparts, kpwgts)]/(1.0*idxsum(nparts, kpwgts)), 1.0*idxsum(nparts, kpwgts)/(1.0*nvtxs));
 
 
   if (mustfree == 1 || mustfree == 3) {
-    free(vwgt);
+    GKdealloc(vwgt);
     graph->vwgt = NULL;
   }
   if (mustfree == 2 || mustfree == 3) {
-    free(adjwgt);
+    GKdealloc(adjwgt);
     graph->adjwgt = NULL;
   }
 
@@ -259,7 +259,7 @@ void ComputePartitionBalance(GraphType *graph, int nparts, idxtype *where, float
     }
   }
 
-  free(kpwgts);
+  GKdealloc(kpwgts);
 
 }
 
@@ -280,7 +280,7 @@ float ComputeElementBalance(int ne, int nparts, idxtype *where)
 
   balance = 1.0*nparts*kpwgts[idxamax(nparts, kpwgts)]/(1.0*idxsum(nparts, kpwgts));
 
-  free(kpwgts);
+  GKdealloc(kpwgts);
 
   return balance;
 
@@ -17,14 +17,19 @@
 #define NUMBITS 32
 #endif
 
-/* Indexes are as long as integers for now */
+/* Indexes are as long as integers unless NUMBITS is 64 */
 #if NUMBITS == 64
 typedef long long idxtype;
+#define PRIDX "lld"
 #else
 typedef int idxtype;
+#define PRIDX "d"
 #endif
 
-#define MAXIDX	(1<<8*sizeof(idxtype)-2)
+/* Sums of weights over whole partitions, which may exceed an idxtype */
+typedef long long acctype;
+
+#define MAXIDX	((idxtype)1<<(8*sizeof(idxtype)-2))
 
 /*************************************************************************
 * The following data structure stores local search chain
@@ -146,7 +151,7 @@ typedef struct rinfodef RInfoType;
 **************************************************************************/
 struct vrinfodef {
  int id, ed, nid;            	/* ID/ED of nodes */
- int gv;            		/* IV/EV of nodes */
+ idxtype gv;            	/* IV/EV of nodes */
  int ndegrees;          	/* The number of different ext-degrees */
  VEDegreeType *edegrees;     	/* List of edges */
 };
@@ -173,7 +178,8 @@ struct graphdef {
                                    This is where memory is allocated and used
                                    the rest of the fields in this structure */
 
-  int nvtxs, nedges;		/* The # of vertices and edges in the graph */
+  int nvtxs;			/* The # of vertices in the graph */
+  idxtype nedges;		/* The # of edges in the graph */
   idxtype *xadj;		/* Pointers to the locally stored vertices */
   idxtype *vwgt;		/* Vertex weights */
   idxtype *vsize;		/* Vertex sizes for min-volume formulation */
@@ -217,6 +223,60 @@ typedef struct graphdef GraphType;
 
 
 
+/*************************************************************************
+* The following data type is the body of a thread started by RunThreads
+**************************************************************************/
+typedef void (*ThreadFuncType)(void *, int, int);
+
+
+/*************************************************************************
+* The following data structure stores the statistics of a multilevel 
+* kernel k-means run. Level 0 is the input graph; only the first 
+* MAXSTATLEVELS levels are recorded.
+**************************************************************************/
+struct mlstatsdef {
+  int nlevels;				/* # of levels, including the input graph */
+  int nvtxs[MAXSTATLEVELS];		/* # of vertices of every level */
+  idxtype nedges[MAXSTATLEVELS];	/* # of (undirected) edges of every level */
+  int kkmiters[MAXSTATLEVELS];		/* # of kernel k-means iterations of every level */
+  int totalkkmiters;			/* # of kernel k-means iterations of all levels */
+  double coarsentime;			/* Wall clock seconds of the phases */
+  double initparttime;
+  double refinetime;
+  double totaltime;
+};
+
+typedef struct mlstatsdef MLStatsType;
+
+
+/*************************************************************************
+* The following data structure is the header of the blocks of GKmalloc
+**************************************************************************/
+struct blockdef {
+  size_t magic;			/* POOLMAGIC for the blocks of GKmalloc */
+  struct pooldef *pool;		/* The pool of the block, NULL for system blocks */
+  struct blockdef *next;	/* The next free block of the same size class */
+  int sclass;			/* The size class of pool blocks */
+};
+
+typedef struct blockdef BlockType;
+
+
+/*************************************************************************
+* The following data structure stores a memory pool. The free blocks are
+* kept in one list per power-of-two size class.
+**************************************************************************/
+struct pooldef {
+  BlockType *freelists[NPOOLCLASSES];
+  size_t poolsize;		/* # of bytes obtained from the system */
+  size_t cursize, peaksize;	/* Current and largest # of bytes in use */
+  int nsysallocs;		/* # of blocks obtained from the system */
+  pthread_mutex_t lock;
+};
+
+typedef struct pooldef PoolType;
+
+
 /*************************************************************************
 * The following data type implements a timer
 **************************************************************************/
@@ -239,6 +299,10 @@ struct controldef {
   int pfactor;			/* .1*prunning factor */
   int nseps;			/* The number of separators to be found during multiple bisections */
   int oflags;
+  int nthreads;			/* The # of threads used by the parallel routines */
+  int initpart;			/* The initial partitioning scheme of MLKKM, INITPART_* */
+  idxtype maxpwgt;		/* The maximum vertex weight of a cluster of MLKKM, 0 for no bound */
+  struct mlstatsdef *stats;	/* The statistics of MLKKM, if not NULL */
 
   WorkSpaceType wspace;		/* Work Space Informations */
 
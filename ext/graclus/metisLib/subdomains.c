@@ -63,7 +63,7 @@ void Random_KWayEdgeRefineMConn(CtrlType *ctrl, GraphType *graph, int nparts, fl
   perm = idxwspacemalloc(ctrl, nvtxs);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-     printf("Partitions: [%6d %6d]-[%6d %6d], Balance: %5.3f, Nv-Nb[%6d %6d]. Cut: %6d\n",
+     printf("Partitions: [%6" PRIDX " %6" PRIDX "]-[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nv-Nb[%6d %6d]. Cut: %6d\n",
              pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)], minwgt[0], maxwgt[0], 
              1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nvtxs, graph->nbnd,
              graph->mincut));
@@ -160,7 +160,7 @@ void Random_KWayEdgeRefineMConn(CtrlType *ctrl, GraphType *graph, int nparts, fl
         *======================================================================*/
         graph->mincut -= myedegrees[k].ed-myrinfo->id;
 
-        IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4d. Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
+        IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4" PRIDX ". Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
 
         /* Update pmat to reflect the move of 'i' */
         pmat[from*nparts+to] += (myrinfo->id-myedegrees[k].ed);
@@ -261,14 +261,14 @@ void Random_KWayEdgeRefineMConn(CtrlType *ctrl, GraphType *graph, int nparts, fl
             if (pmat[me*nparts+to] == 0) {
               ndoms[me]++;
               if (ndoms[me] > maxndoms) {
-                printf("You just increased the maxndoms: %d %d\n", ndoms[me], maxndoms);
+                printf("You just increased the maxndoms: %" PRIDX " %d\n", ndoms[me], maxndoms);
                 maxndoms = ndoms[me];
               }
             }
             if (pmat[to*nparts+me] == 0) {
               ndoms[to]++;
               if (ndoms[to] > maxndoms) {
-                printf("You just increased the maxndoms: %d %d\n", ndoms[to], maxndoms);
+                printf("You just increased the maxndoms: %" PRIDX " %d\n", ndoms[to], maxndoms);
                 maxndoms = ndoms[to];
               }
             }
@@ -287,7 +287,7 @@ void Random_KWayEdgeRefineMConn(CtrlType *ctrl, GraphType *graph, int nparts, fl
     graph->nbnd = nbnd;
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-       printf("\t[%6d %6d], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %5d, Vol: %5d, %d\n",
+       printf("\t[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %5d, Vol: %5d, %d\n",
                pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)],
                1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nbnd, nmoves, 
                graph->mincut, ComputeVolume(graph, where), idxsum(nparts, ndoms)));
@@ -357,7 +357,7 @@ void Greedy_KWayEdgeBalanceMConn(CtrlType *ctrl, GraphType *graph, int nparts, f
   PQueueInit(ctrl, &queue, nvtxs, graph->adjwgtsum[idxamax(nvtxs, graph->adjwgtsum)]);
 
   IFSET(ctrl->dbglvl, DBG_REFINE,
-     printf("Partitions: [%6d %6d]-[%6d %6d], Balance: %5.3f, Nv-Nb[%6d %6d]. Cut: %6d [B]\n",
+     printf("Partitions: [%6" PRIDX " %6" PRIDX "]-[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nv-Nb[%6d %6d]. Cut: %6d [B]\n",
              pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)], minwgt[0], maxwgt[0], 
              1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nvtxs, graph->nbnd,
              graph->mincut));
@@ -454,7 +454,7 @@ void Greedy_KWayEdgeBalanceMConn(CtrlType *ctrl, GraphType *graph, int nparts, f
       *======================================================================*/
       graph->mincut -= myedegrees[k].ed-myrinfo->id;
 
-      IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4d. Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
+      IFSET(ctrl->dbglvl, DBG_MOVEINFO, printf("\t\tMoving %6d to %3d. Gain: %4" PRIDX ". Cut: %6d\n", i, to, myedegrees[k].ed-myrinfo->id, graph->mincut));
 
       /* Update pmat to reflect the move of 'i' */
       pmat[from*nparts+to] += (myrinfo->id-myedegrees[k].ed);
@@ -558,14 +558,14 @@ void Greedy_KWayEdgeBalanceMConn(CtrlType *ctrl, GraphType *graph, int nparts, f
           if (pmat[me*nparts+to] == 0) {
             ndoms[me]++;
             if (ndoms[me] > maxndoms) {
-              printf("You just increased the maxndoms: %d %d\n", ndoms[me], maxndoms);
+              printf("You just increased the maxndoms: %" PRIDX " %d\n", ndoms[me], maxndoms);
               maxndoms = ndoms[me];
             }
           }
           if (pmat[to*nparts+me] == 0) {
             ndoms[to]++;
             if (ndoms[to] > maxndoms) {
-              printf("You just increased the maxndoms: %d %d\n", ndoms[to], maxndoms);
+              printf("You just increased the maxndoms: %" PRIDX " %d\n", ndoms[to], maxndoms);
               maxndoms = ndoms[to];
             }
           }
@@ -599,7 +599,7 @@ void Greedy_KWayEdgeBalanceMConn(CtrlType *ctrl, GraphType *graph, int nparts, f
     graph->nbnd = nbnd;
 
     IFSET(ctrl->dbglvl, DBG_REFINE,
-       printf("\t[%6d %6d], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d, %d\n",
+       printf("\t[%6" PRIDX " %6" PRIDX "], Balance: %5.3f, Nb: %6d. Nmoves: %5d, Cut: %6d, %d\n",
                pwgts[idxamin(nparts, pwgts)], pwgts[idxamax(nparts, pwgts)],
                1.0*nparts*pwgts[idxamax(nparts, pwgts)]/tvwgt, graph->nbnd, nmoves, graph->mincut,idxsum(nparts, ndoms)));
   }
@@ -665,7 +665,7 @@ void PrintSubDomainGraph(GraphType *graph, int nparts, idxtype *where)
   }
   printf("Total adjacent subdomains: %d, Max: %d\n", total, max);
 
-  free(pmat);
+  GKdealloc(pmat);
 }
 
 
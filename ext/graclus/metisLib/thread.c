@@ -0,0 +1,125 @@
+/*
+ * thread.c
+ *
+ * This file contains the routines that run a function on a team of
+ * POSIX threads. They are used by the parallel coarsening routines.
+ *
+ */
+
+#include <metis.h>
+#include <pthread.h>
+#include <unistd.h>
+
+
+/*************************************************************************
+* The following data structure is handed to every thread of a team
+**************************************************************************/
+struct threadargdef {
+  ThreadFuncType func;
+  void *arg;
+  int tid, nthreads;
+  PoolType *pool;		/* The memory pool of the calling thread */
+};
+
+typedef struct threadargdef ThreadArgType;
+
+
+/*************************************************************************
+* This function is the entry point of the spawned threads
+**************************************************************************/
+static void *ThreadMain(void *ptr)
+{
+  ThreadArgType *targ = (ThreadArgType *)ptr;
+
+  PoolActivate(targ->pool);
+  targ->func(targ->arg, targ->tid, targ->nthreads);
+
+  return NULL;
+}
+
+
+/*************************************************************************
+* This function returns the number of processors that are online
+**************************************************************************/
+int GetNumProcessors(void)
+{
+  long n;
+
+  n = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return (n > 0 ? (int)n : 1);
+}
+
+
+/*************************************************************************
+* This function runs func(arg, tid, nthreads) on nthreads threads and
+* returns after all of them are done. The calling thread acts as tid 0.
+**************************************************************************/
+void RunThreads(int nthreads, ThreadFuncType func, void *arg)
+{
+  int i;
+  pthread_t *threads;
+  ThreadArgType *targs;
+
+  if (nthreads <= 1) {
+    func(arg, 0, 1);
+    return;
+  }
+
+  threads = (pthread_t *)GKmalloc(sizeof(pthread_t)*nthreads, "RunThreads: threads");
+  targs = (ThreadArgType *)GKmalloc(sizeof(ThreadArgType)*nthreads, "RunThreads: targs");
+
+  for (i=0; i<nthreads; i++) {
+    targs[i].func = func;
+    targs[i].arg = arg;
+    targs[i].tid = i;
+    targs[i].nthreads = nthreads;
+    targs[i].pool = PoolCurrent();
+  }
+
+  for (i=1; i<nthreads; i++) {
+    if (pthread_create(&threads[i], NULL, ThreadMain, (void *)(targs+i)) != 0)
+      errexit("RunThreads: Failed to create thread %d\n", i);
+  }
+
+  ThreadMain((void *)targs);
+
+  for (i=1; i<nthreads; i++)
+    pthread_join(threads[i], NULL);
+
+  GKdealloc(threads);
+  GKdealloc(targs);
+}
+
+
+/*************************************************************************
+* This function computes the [start, end) range of n items that is
+* assigned to thread tid
+**************************************************************************/
+void ThreadRange(int n, int tid, int nthreads, int *start, int *end)
+{
+  int chunk, rem;
+
+  chunk = n/nthreads;
+  rem = n%nthreads;
+
+  *start = tid*chunk + amin(tid, rem);
+  *end = *start + chunk + (tid < rem ? 1 : 0);
+}
+
+
+/*************************************************************************
+* This function returns the number of threads that a parallel routine
+* should use for a problem with n items
+**************************************************************************/
+int ThreadCount(CtrlType *ctrl, int n)
+{
+  int nthreads;
+
+  nthreads = (ctrl->nthreads > 0 ? ctrl->nthreads : GetNumProcessors());
+
+  /* Do not bother the threads with tiny problems */
+  nthreads = amin(nthreads, n/PARALLEL_MINCHUNK);
+
+  return amax(nthreads, 1);
+}
@@ -13,6 +13,7 @@
  */
 
 #include <metis.h>
+#include <sys/time.h>
 
 
 /*************************************************************************
@@ -72,3 +73,17 @@ double seconds(void)
 }
 
 
+/*************************************************************************
+* This function returns the wall clock seconds. Unlike seconds, it is 
+* meaningful when several threads are running.
+**************************************************************************/
+double WallSeconds(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+
+  return((double) tv.tv_sec + 1.0e-6*tv.tv_usec);
+}
+
+
@@ -13,6 +13,16 @@
 
 #include <metis.h>
 
+/*************************************************************************
+* The states of the random number generators. Every thread has its own 
+* states, so that concurrent partitionings do not disturb each other and
+* are reproducible from their seeds.
+**************************************************************************/
+#ifndef __VC__
+static __thread unsigned short drandstate[3];
+static __thread unsigned short randstate[3];
+#endif
+
 /************************************************************************
  when command line fails, print out help info
 ************************************************************************/
@@ -173,7 +183,7 @@ int *imalloc(int n, char *msg)
 /*************************************************************************
 * The following function allocates an array of integers
 **************************************************************************/
-idxtype *idxmalloc(int n, char *msg)
+idxtype *idxmalloc(idxtype n, char *msg)
 {
   if (n == 0)
     return NULL;
@@ -185,7 +195,7 @@ idxtype *idxmalloc(int n, char *msg)
 /*************************************************************************
 * The following function allocates an array of float 
 **************************************************************************/
-float *fmalloc(int n, char *msg)
+float *fmalloc(idxtype n, char *msg)
 {
   if (n == 0)
     return NULL;
@@ -210,7 +220,7 @@ int *ismalloc(int n, int ival, char *msg)
 /*************************************************************************
 * The follwoing function allocates an array of integers
 **************************************************************************/
-idxtype *idxsmalloc(int n, idxtype ival, char *msg)
+idxtype *idxsmalloc(idxtype n, idxtype ival, char *msg)
 {
   if (n == 0)
     return NULL;
@@ -219,23 +229,26 @@ idxtype *idxsmalloc(int n, idxtype ival, char *msg)
 }
 
 
+#endif
+
+
 /*************************************************************************
-* This function is my wrapper around malloc
+* The follwoing function allocates an array of weight accumulators
 **************************************************************************/
-void *GKmalloc(int nbytes, char *msg)
+acctype *accsmalloc(int n, acctype ival, char *msg)
 {
-  void *ptr;
+  int i;
+  acctype *x;
 
-  if (nbytes == 0)
+  if (n == 0)
     return NULL;
 
-  ptr = (void *)malloc(nbytes);
-  if (ptr == NULL) 
-    errexit("***Memory allocation failed for %s. Requested size: %d bytes", msg, nbytes);
+  x = (acctype *)GKmalloc(sizeof(acctype)*n, msg);
+  for (i=0; i<n; i++)
+    x[i] = ival;
 
-  return ptr;
+  return x;
 }
-#endif
 
 /*************************************************************************
 * This function is my wrapper around free, allows multiple pointers    
@@ -246,7 +259,7 @@ void GKfree(void **ptr1,...)
   void **ptr;
 
   if (*ptr1 != NULL)
-    free(*ptr1);
+    GKdealloc(*ptr1);
   *ptr1 = NULL;
 
   va_start(plist, ptr1);
@@ -254,7 +267,7 @@ void GKfree(void **ptr1,...)
   /* while ((int)(ptr = va_arg(plist, void **)) != -1) { */
   while ((ptr = va_arg(plist, void **)) != LTERM) {
     if (*ptr != NULL)
-      free(*ptr);
+      GKdealloc(*ptr);
     *ptr = NULL;
   }
 
@@ -279,9 +292,9 @@ int *iset(int n, int val, int *x)
 /*************************************************************************
 * These functions set the values of a vector
 **************************************************************************/
-idxtype *idxset(int n, idxtype val, idxtype *x)
+idxtype *idxset(idxtype n, idxtype val, idxtype *x)
 {
-  int i;
+  idxtype i;
 
   for (i=0; i<n; i++)
     x[i] = val;
@@ -585,7 +598,7 @@ void RandomPermute(int n, idxtype *p, int flag)
 
   for(i = 1; i < n; i++)
   {
-    j = random() % (i+1);
+    j = GKrand() % (i+1);
     tmp = p[i];
     p[i] = p[j];
     p[j] = tmp;
@@ -645,24 +658,70 @@ int ispow2(int a)
 
 
 /*************************************************************************
-* This function initializes the random number generator
+* This function seeds a 48-bit generator state the way srand48 does
+**************************************************************************/
+#ifndef __VC__
+static void SeedState(unsigned short *state, long seed)
+{
+  state[0] = 0x330E;
+  state[1] = (unsigned short)(seed & 0xFFFF);
+  state[2] = (unsigned short)((seed >> 16) & 0xFFFF);
+}
+#endif
+
+
+/*************************************************************************
+* This function initializes the random number generators of the calling
+* thread
 **************************************************************************/
 void InitRandom(int seed)
 {
   if (seed == -1) {
 #ifndef __VC__
-    srand48(7654321L);  
-#endif
+    SeedState(drandstate, 7654321L);  
+    SeedState(randstate, 4321L);  
+#else
     srand(4321);  
+#endif
   }
   else {
 #ifndef __VC__
-    srand48(seed);  
-#endif
+    SeedState(drandstate, seed);  
+    SeedState(randstate, seed);  
+#else
     srand(seed);  
+#endif
   }
 }
 
+
+/*************************************************************************
+* This function returns a random integer in [0, 2^31) from the generator
+* of the calling thread
+**************************************************************************/
+int GKrand(void)
+{
+#ifndef __VC__
+  return (int)nrand48(randstate);
+#else
+  return rand();
+#endif
+}
+
+
+/*************************************************************************
+* This function returns a random double in [0, 1) from the generator of 
+* the calling thread
+**************************************************************************/
+double GKdrand(void)
+{
+#ifndef __VC__
+  return erand48(drandstate);
+#else
+  return (double)rand()/(RAND_MAX+1.0);
+#endif
+}
+
 /*************************************************************************
 * This function returns the log2(x)
 **************************************************************************/
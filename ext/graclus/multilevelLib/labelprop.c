@@ -0,0 +1,546 @@
+/*
+ * labelprop.c
+ *
+ * This file contains a size-constrained label propagation partitioner. It
+ * is an alternative engine to the multilevel kernel k-means of mlkkm.c
+ * that trades some cut quality for speed on large graphs. The graph is
+ * coarsened by contracting the clusters of parallel label propagation under
+ * a size bound, the coarsest graph is packed into the parts, and the parts
+ * are refined by label propagation on the way back. The threads update the
+ * labels asynchronously, so the result of a multi-threaded run depends on
+ * their timing.
+ *
+ */
+
+#include <metis.h>
+
+
+/*************************************************************************
+* The following data structure holds the state shared by the threads of a
+* label propagation round
+**************************************************************************/
+struct lpdef {
+  GraphType *graph;
+  idxtype *perm;		/* Vertices in increasing order of their degrees */
+  idxtype *label;		/* Label of every vertex, updated in place */
+  idxtype *lwgt;		/* Total vertex weight of every label */
+  idxtype maxlwgt;		/* Upper bound of lwgt */
+  int refine;			/* Only the moves that decrease the cut are taken */
+  int hsize;			/* Size of the connection hash tables, a power of 2 */
+  int next;			/* First vertex of perm that is not handed out yet */
+  int *nmoves;			/* # of moved vertices of every thread */
+};
+
+typedef struct lpdef LPType;
+
+
+/*************************************************************************
+* This function runs one round of label propagation on the vertices that
+* thread tid takes from lp->perm. Every vertex moves to the label it is
+* most connected to among the labels that have room for it.
+**************************************************************************/
+static void LPRound(void *ptr, int tid, int nthreads)
+{
+  LPType *lp = (LPType *)ptr;
+  GraphType *graph = lp->graph;
+  int ii, j, k, h, start, end, nused, nties, nmoves, hmask;
+  idxtype v, from, to, l, vw, w;
+  idxtype *xadj, *adjncy, *vwgt, *adjwgt, *label, *lwgt, *hkeys, *used;
+  acctype *hvals, own, best;
+
+  xadj = graph->xadj;
+  adjncy = graph->adjncy;
+  vwgt = graph->vwgt;
+  adjwgt = graph->adjwgt;
+  label = lp->label;
+  lwgt = lp->lwgt;
+
+  hmask = lp->hsize-1;
+  hkeys = idxsmalloc(lp->hsize, -1, "LPRound: hkeys");
+  hvals = (acctype *)GKmalloc(sizeof(acctype)*lp->hsize, "LPRound: hvals");
+  used = idxmalloc(lp->hsize, "LPRound: used");
+
+  nmoves = 0;
+  for (;;) {
+    start = AtomicFetchAdd(&lp->next, LP_CHUNK);
+    if (start >= graph->nvtxs)
+      break;
+    end = amin(start+LP_CHUNK, graph->nvtxs);
+
+    for (ii=start; ii<end; ii++) {
+      v = lp->perm[ii];
+      from = AtomicLoad(&label[v]);
+      vw = (vwgt ? vwgt[v] : 1);
+
+      /* Sum the weights of the edges of v by the labels of their endpoints */
+      for (nused=0, j=xadj[v]; j<xadj[v+1]; j++) {
+        l = AtomicLoad(&label[adjncy[j]]);
+        for (h=(l*2654435761u)&hmask; hkeys[h]!=-1 && hkeys[h]!=l; h=(h+1)&hmask);
+        if (hkeys[h] == -1) {
+          hkeys[h] = l;
+          hvals[h] = 0;
+          used[nused++] = h;
+        }
+        hvals[h] += (adjwgt ? adjwgt[j] : 1);
+      }
+
+      for (own=0, k=0; k<nused; k++) {
+        if (hkeys[used[k]] == from)
+          own = hvals[used[k]];
+      }
+
+      /* An overweight label gives its vertices away, even at a loss */
+      best = own;
+      if (lp->refine && AtomicLoad(&lwgt[from]) > lp->maxlwgt)
+        best = -1;
+
+      to = from;
+      nties = 0;
+      for (k=0; k<nused; k++) {
+        h = used[k];
+        l = hkeys[h];
+        if (l == from || hvals[h] < best || AtomicLoad(&lwgt[l])+vw > lp->maxlwgt)
+          continue;
+        if (hvals[h] > best) {
+          to = l;
+          best = hvals[h];
+          nties = 1;
+        }
+        else if (to != from && RandomInRangeFast(++nties) == 0) {
+          /* Random tie breaking, the current label wins its ties */
+          to = l;
+        }
+      }
+
+      for (k=0; k<nused; k++)
+        hkeys[used[k]] = -1;
+
+      if (to == from)
+        continue;
+
+      /* Reserve the room in the target label, other threads may fill it meanwhile */
+      w = AtomicLoad(&lwgt[to]);
+      do {
+        if (w+vw > lp->maxlwgt)
+          break;
+      } while (!AtomicCAS(&lwgt[to], &w, w+vw));
+      if (w+vw > lp->maxlwgt)
+        continue;
+
+      AtomicFetchAdd(&lwgt[from], -vw);
+      AtomicStore(&label[v], to);
+      nmoves++;
+    }
+  }
+  lp->nmoves[tid] = nmoves;
+
+  GKfree((void **) &hkeys, (void **) &hvals, (void **) &used, LTERM);
+}
+
+
+/*************************************************************************
+* This function runs rounds of label propagation until fewer than
+* LP_MINMOVES of the vertices move or maxiter rounds are done. It returns
+* the # of rounds.
+**************************************************************************/
+static int LPIterate(CtrlType *ctrl, LPType *lp, int maxiter)
+{
+  int i, iter, nthreads, nmoves;
+
+  nthreads = ThreadCount(ctrl, lp->graph->nvtxs);
+  lp->nmoves = imalloc(nthreads, "LPIterate: nmoves");
+
+  for (iter=0; iter<maxiter; ) {
+    lp->next = 0;
+    RunThreads(nthreads, LPRound, (void *)lp);
+    iter++;
+
+    for (nmoves=0, i=0; i<nthreads; i++)
+      nmoves += lp->nmoves[i];
+    IFSET(ctrl->dbglvl, DBG_REFINE, printf("Label propagation round %d: %d moves\n", iter, nmoves));
+    if (nmoves <= LP_MINMOVES*lp->graph->nvtxs)
+      break;
+  }
+
+  GKdealloc(lp->nmoves);
+
+  return iter;
+}
+
+
+/*************************************************************************
+* This function contracts every label of graph into a vertex of the coarser
+* graph that it returns. graph->cmap receives the coarse vertex of every
+* vertex. The edges inside the labels are dropped.
+**************************************************************************/
+static GraphType *LPContract(GraphType *graph, idxtype *label)
+{
+  int i, j, k, c, nvtxs, cnvtxs;
+  idxtype v, u, cnedges, *xadj, *adjncy, *vwgt, *adjwgt, *cmap, *lmap, *cptr, *cind, *htable;
+  idxtype *cxadj, *cadjncy, *cvwgt, *cadjwgt;
+  GraphType *cgraph;
+
+  nvtxs = graph->nvtxs;
+  xadj = graph->xadj;
+  adjncy = graph->adjncy;
+  vwgt = graph->vwgt;
+  adjwgt = graph->adjwgt;
+  cmap = graph->cmap;
+
+  /* Number the non-empty labels consecutively and bucket their vertices */
+  lmap = idxsmalloc(nvtxs, -1, "LPContract: lmap");
+  for (cnvtxs=0, i=0; i<nvtxs; i++) {
+    if (lmap[label[i]] == -1)
+      lmap[label[i]] = cnvtxs++;
+    cmap[i] = lmap[label[i]];
+  }
+  GKdealloc(lmap);
+
+  cptr = idxsmalloc(cnvtxs+1, 0, "LPContract: cptr");
+  cind = idxmalloc(nvtxs, "LPContract: cind");
+  for (i=0; i<nvtxs; i++)
+    cptr[cmap[i]]++;
+  MAKECSR(c, cnvtxs, cptr);
+  for (i=0; i<nvtxs; i++)
+    cind[cptr[cmap[i]]++] = i;
+  for (c=cnvtxs; c>0; c--)
+    cptr[c] = cptr[c-1];
+  cptr[0] = 0;
+
+  cgraph = SetUpCoarseGraph(graph, cnvtxs, 0);
+  cxadj = cgraph->xadj;
+  cvwgt = cgraph->vwgt;
+  cadjncy = cgraph->adjncy;
+  cadjwgt = cgraph->adjwgt;
+
+  htable = idxsmalloc(cnvtxs, -1, "LPContract: htable");
+  cxadj[0] = cnedges = 0;
+  for (c=0; c<cnvtxs; c++) {
+    cvwgt[c] = 0;
+    for (j=cptr[c]; j<cptr[c+1]; j++) {
+      v = cind[j];
+      cvwgt[c] += (vwgt ? vwgt[v] : 1);
+      for (k=xadj[v]; k<xadj[v+1]; k++) {
+        u = cmap[adjncy[k]];
+        if (u == c)
+          continue;
+        if (htable[u] == -1) {
+          htable[u] = cnedges;
+          cadjncy[cnedges] = u;
+          cadjwgt[cnedges++] = (adjwgt ? adjwgt[k] : 1);
+        }
+        else {
+          cadjwgt[htable[u]] += (adjwgt ? adjwgt[k] : 1);
+        }
+      }
+    }
+    cxadj[c+1] = cnedges;
+
+    cgraph->adjwgtsum[c] = 0;
+    for (k=cxadj[c]; k<cnedges; k++) {
+      htable[cadjncy[k]] = -1;
+      cgraph->adjwgtsum[c] += cadjwgt[k];
+    }
+  }
+  cgraph->nedges = cnedges;
+
+  GKfree((void **) &cptr, (void **) &cind, (void **) &htable, LTERM);
+
+  return cgraph;
+}
+
+
+/*************************************************************************
+* This function restores the min-heap property of the lightest-part heap
+* below position i, after the weight of the part at i has grown
+**************************************************************************/
+static void LPHeapSiftDown(int n, idxtype *heap, idxtype *locator, idxtype *pwgts, int i)
+{
+  int j;
+  idxtype p;
+
+  p = heap[i];
+  while ((j = 2*i+1) < n) {
+    if (j+1 < n && pwgts[heap[j+1]] < pwgts[heap[j]])
+      j++;
+    if (pwgts[heap[j]] >= pwgts[p])
+      break;
+    heap[i] = heap[j];
+    locator[heap[i]] = i;
+    i = j;
+  }
+  heap[i] = p;
+  locator[p] = i;
+}
+
+
+/*************************************************************************
+* This function packs the vertices of the coarsest graph into nparts parts.
+* The vertices are taken from the heaviest down, and every vertex joins the
+* part it is most connected to among the parts that have room for it. A
+* vertex without such a part goes to the lightest part.
+**************************************************************************/
+static void LPPack(GraphType *graph, int nparts, idxtype maxpwgt, idxtype *where)
+{
+  int i, j, k, nvtxs, nused;
+  idxtype v, p, best, *xadj, *adjncy, *vwgt, *adjwgt, *pwgts, *heap, *locator, *conn, *used;
+  acctype bestconn;
+  KeyValueType *cand;
+
+  nvtxs = graph->nvtxs;
+  xadj = graph->xadj;
+  adjncy = graph->adjncy;
+  vwgt = graph->vwgt;
+  adjwgt = graph->adjwgt;
+
+  cand = (KeyValueType *)GKmalloc(sizeof(KeyValueType)*nvtxs, "LPPack: cand");
+  for (i=0; i<nvtxs; i++) {
+    cand[i].key = (vwgt ? vwgt[i] : 1);
+    cand[i].val = i;
+  }
+  ikeysort(nvtxs, cand);
+
+  pwgts = idxsmalloc(nparts, 0, "LPPack: pwgts");
+  heap = idxmalloc(nparts, "LPPack: heap");
+  locator = idxmalloc(nparts, "LPPack: locator");
+  for (p=0; p<nparts; p++) {
+    heap[p] = p;
+    locator[p] = p;
+  }
+  conn = idxsmalloc(nparts, -1, "LPPack: conn");
+  used = idxmalloc(nparts, "LPPack: used");
+  idxset(nvtxs, -1, where);
+
+  for (k=nvtxs-1; k>=0; k--) {
+    v = cand[k].val;
+
+    for (nused=0, j=xadj[v]; j<xadj[v+1]; j++) {
+      p = where[adjncy[j]];
+      if (p == -1)
+        continue;
+      if (conn[p] == -1) {
+        conn[p] = 0;
+        used[nused++] = p;
+      }
+      conn[p] += (adjwgt ? adjwgt[j] : 1);
+    }
+
+    best = heap[0];
+    for (bestconn=0, i=0; i<nused; i++) {
+      p = used[i];
+      if (pwgts[p]+cand[k].key <= maxpwgt && conn[p] > bestconn) {
+        best = p;
+        bestconn = conn[p];
+      }
+      conn[p] = -1;
+    }
+
+    where[v] = best;
+    pwgts[best] += cand[k].key;
+    LPHeapSiftDown(nparts, heap, locator, pwgts, locator[best]);
+  }
+
+  GKfree((void **) &cand, (void **) &pwgts, (void **) &heap, (void **) &locator, (void **) &conn, 
+         (void **) &used, LTERM);
+}
+
+
+/*************************************************************************
+* This function runs the label propagation refinement of the parts where
+* of graph. It returns the # of rounds.
+**************************************************************************/
+static int LPRefine(CtrlType *ctrl, GraphType *graph, int nparts, idxtype maxpwgt, idxtype *where, 
+                    LPType *lp)
+{
+  int i;
+  idxtype *pwgts;
+
+  pwgts = idxsmalloc(nparts, 0, "LPRefine: pwgts");
+  for (i=0; i<graph->nvtxs; i++)
+    pwgts[where[i]] += (graph->vwgt ? graph->vwgt[i] : 1);
+
+  lp->graph = graph;
+  lp->label = where;
+  lp->lwgt = pwgts;
+  lp->maxlwgt = maxpwgt;
+  lp->refine = 1;
+  i = LPIterate(ctrl, lp, LP_NREFINE);
+
+  GKdealloc(pwgts);
+
+  return i;
+}
+
+
+/*************************************************************************
+* This function sets up lp for the label propagation rounds on graph. The
+* vertices are visited from the lowest degree up.
+**************************************************************************/
+static void LPSetUp(GraphType *graph, LPType *lp)
+{
+  int i, nvtxs, maxdeg;
+  idxtype *deg;
+
+  nvtxs = graph->nvtxs;
+  for (maxdeg=0, i=0; i<nvtxs; i++)
+    maxdeg = amax(maxdeg, graph->xadj[i+1]-graph->xadj[i]);
+
+  deg = idxsmalloc(maxdeg+2, 0, "LPSetUp: deg");
+  lp->perm = idxmalloc(nvtxs, "LPSetUp: perm");
+  for (i=0; i<nvtxs; i++)
+    deg[graph->xadj[i+1]-graph->xadj[i]+1]++;
+  for (i=0; i<=maxdeg; i++)
+    deg[i+1] += deg[i];
+  for (i=0; i<nvtxs; i++)
+    lp->perm[deg[graph->xadj[i+1]-graph->xadj[i]]++] = i;
+  GKdealloc(deg);
+
+  for (lp->hsize=1; lp->hsize<2*maxdeg+2; lp->hsize*=2);
+  lp->graph = graph;
+}
+
+
+/*************************************************************************
+* This function computes a k-way partitioning of graph into where by size-
+* constrained label propagation. maxpwgt bounds the weight of the parts,
+* 0 allows LP_UBFACTOR times the average part weight. The graph is coarsened
+* until it has at most ctrl->CoarsenTo vertices or stops shrinking.
+**************************************************************************/
+int LabelPropagation(CtrlType *ctrl, GraphType *graph, int nparts, idxtype maxpwgt, idxtype *where)
+{
+  int i, level, nlevels, niter;
+  idxtype tvwgt, *label, *lwgt, *cwhere, *mycmap = NULL;
+  GraphType *cgraph, *fgraph;
+  LPType lp[MAXSTATLEVELS];
+  MLStatsType *stats = ctrl->stats;
+  double tstart;
+
+  tvwgt = (graph->vwgt ? idxsum(graph->nvtxs, graph->vwgt) : graph->nvtxs);
+  if (maxpwgt <= 0)
+    maxpwgt = (idxtype)ceil(LP_UBFACTOR*tvwgt/nparts);
+  maxpwgt = amax(maxpwgt, (tvwgt+nparts-1)/nparts);
+
+  if (graph->cmap == NULL)
+    graph->cmap = mycmap = idxmalloc(graph->nvtxs, "LabelPropagation: cmap");
+
+  /* Coarsen by clustering under the part bound, every vertex starts in a label of its own */
+  tstart = WallSeconds();
+  cgraph = graph;
+  LPSetUp(cgraph, lp);
+  for (nlevels=1; cgraph->nvtxs > ctrl->CoarsenTo && nlevels < MAXSTATLEVELS; nlevels++) {
+    fgraph = cgraph;
+    label = idxmalloc(fgraph->nvtxs, "LabelPropagation: label");
+    lwgt = idxmalloc(fgraph->nvtxs, "LabelPropagation: lwgt");
+    for (i=0; i<fgraph->nvtxs; i++) {
+      label[i] = i;
+      lwgt[i] = (fgraph->vwgt ? fgraph->vwgt[i] : 1);
+    }
+    lp[nlevels-1].label = label;
+    lp[nlevels-1].lwgt = lwgt;
+    lp[nlevels-1].maxlwgt = maxpwgt;
+    lp[nlevels-1].refine = 0;
+    niter = LPIterate(ctrl, lp+nlevels-1, LP_NITER);
+    if (stats != NULL)
+      stats->kkmiters[nlevels-1] = niter;
+
+    cgraph = LPContract(fgraph, label);
+    GKfree((void **) &label, (void **) &lwgt, LTERM);
+    LPSetUp(cgraph, lp+nlevels);
+    IFSET(ctrl->dbglvl, DBG_COARSEN, printf("%6d %7" PRIDX "\n", cgraph->nvtxs, cgraph->nedges));
+
+    /* Stop when the clustering does not shrink the graph any more */
+    if (cgraph->nvtxs > LP_SHRINKFRACTION*fgraph->nvtxs) {
+      nlevels++;
+      break;
+    }
+  }
+  if (stats != NULL) {
+    stats->coarsentime = WallSeconds() - tstart;
+    stats->nlevels = nlevels;
+    for (i=0, fgraph=graph; fgraph!=NULL && i<MAXSTATLEVELS; fgraph=fgraph->coarser, i++) {
+      stats->nvtxs[i] = fgraph->nvtxs;
+      stats->nedges[i] = fgraph->nedges/2;
+    }
+  }
+
+  tstart = WallSeconds();
+  cwhere = (cgraph == graph ? where : idxmalloc(cgraph->nvtxs, "LabelPropagation: cwhere"));
+  LPPack(cgraph, nparts, maxpwgt, cwhere);
+  if (stats != NULL)
+    stats->initparttime = WallSeconds() - tstart;
+
+  /* Refine the parts level by level, with the parts as the labels */
+  tstart = WallSeconds();
+  for (level=nlevels-1; ; level--) {
+    niter = LPRefine(ctrl, cgraph, nparts, maxpwgt, cwhere, lp+level);
+    if (stats != NULL) {
+      stats->kkmiters[level] += niter;
+      stats->totalkkmiters += stats->kkmiters[level];
+    }
+    GKdealloc(lp[level].perm);
+    if (cgraph == graph)
+      break;
+
+    /* Project the parts to the finer graph */
+    fgraph = cgraph->finer;
+    label = (fgraph == graph ? where : idxmalloc(fgraph->nvtxs, "LabelPropagation: cwhere"));
+    for (i=0; i<fgraph->nvtxs; i++)
+      label[i] = cwhere[fgraph->cmap[i]];
+    GKdealloc(cwhere);
+    cwhere = label;
+    fgraph->coarser = NULL;
+    FreeGraph(cgraph);
+    cgraph = fgraph;
+  }
+  if (stats != NULL)
+    stats->refinetime = WallSeconds() - tstart;
+
+  if (mycmap != NULL) {
+    GKdealloc(mycmap);
+    graph->cmap = NULL;
+  }
+
+  return ComputeCut(graph, where);
+}
+
+
+/*************************************************************************
+* This function is the entry point of the label propagation engine. Its
+* arguments are those of MLKKM_PartGraphKway, chainlength and levels are
+* not used. The label propagation rounds are reported as the kernel
+* k-means iterations of stats.
+**************************************************************************/
+void LP_PartGraphKway(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxtype *vwgt,
+                      idxtype *adjwgt, int *wgtflag, int *numflag, int *nparts, int *chainlength,
+                      int *options, int *edgecut, idxtype *part, int levels, MLStatsType *stats)
+{
+  GraphType graph;
+  CtrlType ctrl;
+  double tstart;
+
+  if (*numflag == 1)
+    Change2CNumbering(*nvtxs, xadj, adjncy);
+
+  SetUpGraph(&graph, OP_KMETIS, *nvtxs, 1, xadj, adjncy, vwgt, adjwgt, *wgtflag);
+
+  ctrl.dbglvl = (options[0] == 0 ? KMETIS_DBGLVL : options[OPTION_DBGLVL]);
+  ctrl.nthreads = (options[0] == 0 ? 1 : options[OPTION_NTHREADS]);
+  ctrl.maxpwgt = (options[0] == 0 ? 0 : options[OPTION_MAXPWGT]);
+  ctrl.optype = OP_KMETIS;
+  ctrl.CoarsenTo = LP_COARSENTO*(*nparts);
+  ctrl.stats = stats;
+  if (stats != NULL)
+    memset(stats, 0, sizeof(MLStatsType));
+  tstart = WallSeconds();
+  InitRandom(options[0] == 0 ? -1 : options[OPTION_SEED]);
+
+  *edgecut = LabelPropagation(&ctrl, &graph, *nparts, ctrl.maxpwgt, part);
+
+  if (stats != NULL)
+    stats->totaltime = WallSeconds() - tstart;
+
+  GKfree((void **) &graph.gdata, LTERM);
+
+  if (*numflag == 1)
+    Change2FNumbering(*nvtxs, xadj, adjncy, part);
+}
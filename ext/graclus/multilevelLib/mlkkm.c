@@ -14,17 +14,44 @@
  */
 
 #include <metis.h>
-//#include <driver.h>
-//#include "../spectralLib/driver.h"
 
-extern int spectral_initialization;
+/*************************************************************************
+* This function sets up ctrl from the options of MLKKM
+**************************************************************************/
+static void SetUpCtrl(CtrlType *ctrl, int *options, MLStatsType *stats)
+{
+  if (options[0] == 0) {  /* Use the default parameters */
+    ctrl->CType = KMETIS_CTYPE; 
+    ctrl->IType = KMETIS_ITYPE;
+    ctrl->RType = KMETIS_RTYPE;
+    ctrl->dbglvl = KMETIS_DBGLVL;
+    ctrl->nthreads = 1;
+    ctrl->initpart = INITPART_METIS;
+    ctrl->maxpwgt = 0;
+    //ctrl->cutType = options[10];
+  }
+  else {
+    ctrl->CType = options[OPTION_CTYPE];
+    ctrl->IType = options[OPTION_ITYPE];
+    ctrl->RType = options[OPTION_RTYPE];
+    ctrl->dbglvl = options[OPTION_DBGLVL];
+    ctrl->nthreads = options[OPTION_NTHREADS];
+    ctrl->initpart = options[OPTION_INITPART];
+    ctrl->maxpwgt = options[OPTION_MAXPWGT];
+    //ctrl->cutType = options[10];
+  }
+  ctrl->optype = OP_KMETIS;
+  ctrl->stats = stats;
+  if (stats != NULL)
+    memset(stats, 0, sizeof(MLStatsType));
+}
 
 /*************************************************************************
 * This function is the entry point for MLKKM
 **************************************************************************/
 void MLKKM_PartGraphKway(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxtype *vwgt, 
                          idxtype *adjwgt, int *wgtflag, int *numflag, int *nparts, int *chainlength, 
-                         int *options, int *edgecut, idxtype *part, int levels)
+                         int *options, int *edgecut, idxtype *part, int levels, MLStatsType *stats)
 {
   int i;
   float *tpwgts;
@@ -34,50 +61,43 @@ void MLKKM_PartGraphKway(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxtype *vw
     tpwgts[i] = 1.0/(1.0*(*nparts));
 
   MLKKM_WPartGraphKway(nvtxs, xadj, adjncy, vwgt, adjwgt, wgtflag, numflag, nparts, chainlength,
-                       tpwgts, options, edgecut, part, levels);
+                       tpwgts, options, edgecut, part, levels, stats);
 
-  free(tpwgts);
+  GKdealloc(tpwgts);
 }
 
 
 /*************************************************************************
-* This function is the entry point for KWMETIS
+* This function is the entry point for KWMETIS. If stats is not NULL, it
+* receives the statistics of the run.
 **************************************************************************/
 void MLKKM_WPartGraphKway(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxtype *vwgt, 
                           idxtype *adjwgt, int *wgtflag, int *numflag, int *nparts, int *chainlength,
-                          float *tpwgts, int *options, int *edgecut, idxtype *part, int levels)
+                          float *tpwgts, int *options, int *edgecut, idxtype *part, int levels,
+                          MLStatsType *stats)
 {
   int i, j;
   GraphType graph;
   CtrlType ctrl;
+  double tstart;
 
   if (*numflag == 1)
     Change2CNumbering(*nvtxs, xadj, adjncy);
 
   SetUpGraph(&graph, OP_KMETIS, *nvtxs, 1, xadj, adjncy, vwgt, adjwgt, *wgtflag);
 
-  if (options[0] == 0) {  /* Use the default parameters */
-    ctrl.CType = KMETIS_CTYPE; 
-    ctrl.IType = KMETIS_ITYPE;
-    ctrl.RType = KMETIS_RTYPE;
-    ctrl.dbglvl = KMETIS_DBGLVL;
-    //ctrl.cutType = options[10];
-  }
-  else {
-    ctrl.CType = options[OPTION_CTYPE];
-    ctrl.IType = options[OPTION_ITYPE];
-    ctrl.RType = options[OPTION_RTYPE];
-    ctrl.dbglvl = options[OPTION_DBGLVL];
-    //ctrl.cutType = options[10];
-  }
-  ctrl.optype = OP_KMETIS;
+  SetUpCtrl(&ctrl, options, stats);
+  tstart = WallSeconds();
   //ctrl.CoarsenTo = amax((*nvtxs)/(40*log2_metis(*nparts)), 5*(*nparts));
   ctrl.CoarsenTo = levels;
   //ctrl.CoarsenTo = amax(40*log2_metis(*nparts), 20*(*nparts));
   //printf("Coarsen To = %d\n", ctrl.CoarsenTo);
   ctrl.maxvwgt = floor(1.5*((graph.vwgt ? idxsum(*nvtxs, graph.vwgt) : (*nvtxs))/ctrl.CoarsenTo));
   ctrl.maxvwgt *= 100;
-  InitRandom(-1);
+  /* Keep the coarse vertices small enough for the clusters to be rebalanced under the bound */
+  if (ctrl.maxpwgt > 0)
+    ctrl.maxvwgt = amax(amin(ctrl.maxvwgt, ctrl.maxpwgt/4), 1);
+  InitRandom(options[0] == 0 ? -1 : options[OPTION_SEED]);
 
   AllocateWorkSpace(&ctrl, &graph, *nparts);
 
@@ -97,82 +117,56 @@ void MLKKM_WPartGraphKway(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxtype *v
   IFSET(ctrl.dbglvl, DBG_TIME, stoptimer(ctrl.TotalTmr));
   IFSET(ctrl.dbglvl, DBG_TIME, PrintTimers(&ctrl));
 
+  if (stats != NULL)
+    stats->totaltime = WallSeconds() - tstart;
+
   FreeWorkSpace(&ctrl, &graph);
 
   if (*numflag == 1)
     Change2FNumbering(*nvtxs, xadj, adjncy, part);
 }
 
-/************************************************************************
-* This function takes a graph and produces a k-way partitioning of it
+/*************************************************************************
+* This function refines the k-way partitioning part of a graph in place by
+* weighted kernel k-means on the graph itself, without coarsening it. It
+* improves the partitionings that were computed by other means.
 **************************************************************************/
-/*void spectralInit(GraphType * graph, int nparts, int *numflag, int* options)
+void MLKKM_RefineKway(int *nvtxs, idxtype *xadj, idxtype *adjncy, idxtype *vwgt, idxtype *adjwgt, 
+                      int *wgtflag, int *nparts, int *chainlength, int *options, idxtype *part, 
+                      MLStatsType *stats)
 {
-  int i, j, nvtxs, nedges;
-  idxtype *adjwgt, *adjncy, *xadj, *where;
-  spectral::Driver* d = new spectral::Driver();
+  int i;
+  GraphType graph;
   CtrlType ctrl;
-  double * dense;
-  idxtype *w;
-  float *m_adjwgt;
-
-  nvtxs = graph->nvtxs;
-  nedges = graph->nedges;
-  xadj = graph->xadj;
-  adjncy = graph->adjncy;
-  adjwgt = graph->adjwgt;
-  where = graph->where;
-
-  if (*numflag == 1)
-    Change2CNumbering(nvtxs, xadj, adjncy);
-
-  if (options[0] == 0) {  // Use the default parameters 
-    ctrl.CType = KMETIS_CTYPE;
-    ctrl.IType = KMETIS_ITYPE;
-    ctrl.RType = KMETIS_RTYPE;
-    ctrl.dbglvl = KMETIS_DBGLVL;
-  }
-  else {
-    ctrl.CType = options[OPTION_CTYPE];
-    ctrl.IType = options[OPTION_ITYPE];
-    ctrl.RType = options[OPTION_RTYPE];
-    ctrl.dbglvl = options[OPTION_DBGLVL];
-  }
-  ctrl.optype = OP_KMETIS;
-  //ctrl.CoarsenTo = amax((nvtxs)/(40*log2_metis(nparts), 20*nparts);
-  ctrl.CoarsenTo = amax((nvtxs)/(40*log2_metis(nparts)), 5*nparts);
-  ctrl.maxvwgt = (int) 1.5*(idxsum(nvtxs, graph->vwgt)/ctrl.CoarsenTo);
-  w = idxsmalloc(nvtxs, 0, "pingpong: weight");
-  Compute_Weights(&ctrl, graph, w);
-  m_adjwgt = fmalloc(nedges, "pingpong: normalized matrix");
-
-  transform_matrix_half(&ctrl, graph, w, m_adjwgt);  
-  dense = new double [nvtxs*nvtxs];
-  sparse2dense(graph, dense, m_adjwgt);
-  //printf("size: %d\n", nvtxs);
-  AllocateWorkSpace(&ctrl, graph, nparts);
+  float *tpwgts;
+  double tstart;
 
-  IFSET(ctrl.dbglvl, DBG_TIME, InitTimers(&ctrl));
-  IFSET(ctrl.dbglvl, DBG_TIME, starttimer(ctrl.TotalTmr));
+  SetUpGraph(&graph, OP_KMETIS, *nvtxs, 1, xadj, adjncy, vwgt, adjwgt, *wgtflag);
+  SetUpCtrl(&ctrl, options, stats);
+  tstart = WallSeconds();
+  InitRandom(options[0] == 0 ? -1 : options[OPTION_SEED]);
 
-  printf("Running spectral over %d nodes and %d clusters....\n", nvtxs, nparts);
+  tpwgts = fmalloc(*nparts, "MLKKM_RefineKway: tpwgts");
+  for (i=0; i<*nparts; i++) 
+    tpwgts[i] = 1.0/(1.0*(*nparts));
 
-  //d->execute2((int*)graph->xadj, (int*)graph->adjncy,(int*) graph->adjwgt, nvtxs, nedges, nparts);
-  d->execute(dense, nvtxs ,nparts);
-  d->copyClusterID(where, nvtxs);
+  AllocateWorkSpace(&ctrl, &graph, *nparts);
+  AllocateKWayPartitionMemory(&ctrl, &graph, *nparts);
+  idxcopy(*nvtxs, part, graph.where);
 
-  IFSET(ctrl.dbglvl, DBG_TIME, stoptimer(ctrl.TotalTmr));
-  IFSET(ctrl.dbglvl, DBG_TIME, PrintTimers(&ctrl));
+  MLKKMRefine(&ctrl, &graph, &graph, *nparts, *chainlength, tpwgts, 1.03);
+  idxcopy(*nvtxs, graph.where, part);
 
-  FreeWorkSpace(&ctrl, graph);
-  //free(dense);
-  free(w);
-  free(m_adjwgt);
+  if (stats != NULL) {
+    stats->nlevels = 1;
+    stats->nvtxs[0] = *nvtxs;
+    stats->nedges[0] = graph.nedges/2;
+    stats->refinetime = stats->totaltime = WallSeconds() - tstart;
+  }
 
-  if (*numflag == 1)
-    Change2FNumbering(nvtxs, xadj, adjncy, where);
+  FreeWorkSpace(&ctrl, &graph);
+  GKfree((void **) &graph.gdata, (void **) &graph.rdata, (void **) &tpwgts, LTERM);
 }
-*/
 
 
 /*************************************************************************
@@ -182,11 +176,14 @@ int MLKKMPartitioning(CtrlType *ctrl, GraphType *graph, int nparts, int chain_le
 {
   int i, j, nvtxs, tvwgt, tpwgts2[2];
   GraphType *cgraph;
-  int wgtflag=3, numflag=0, options[10], edgecut;
+  int wgtflag=3, numflag=0, options[GRACLUS_NOPTIONS], edgecut;
   float ncut;
   idxtype *cptr, *cind;
   int numcomponents;
   char *mlwkkm_fname = "coarse.graph";
+  double tstart;
+  GraphType *ptr;
+  MLStatsType *stats = ctrl->stats;
 
   cptr = idxmalloc(graph->nvtxs, "MLKKMPartitioning: cptr");
   cind = idxmalloc(graph->nvtxs, "MLKKMPartitioning: cind");
@@ -195,8 +192,24 @@ int MLKKMPartitioning(CtrlType *ctrl, GraphType *graph, int nparts, int chain_le
 
   printf("Number of connected components is %d.\n", numcomponents);
   */
+  tstart = WallSeconds();
   cgraph = Coarsen2Way(ctrl, graph);
+  if (stats != NULL) {
+    stats->coarsentime = WallSeconds() - tstart;
+
+    /* Record the sizes of the levels, from the coarsest graph upwards */
+    for (ptr=cgraph, stats->nlevels=1; ptr!=graph; ptr=ptr->finer, stats->nlevels++);
+    for (ptr=cgraph, i=stats->nlevels-1; ptr!=NULL; ptr=ptr->finer, i--) {
+      if (i < MAXSTATLEVELS) {
+        stats->nvtxs[i] = ptr->nvtxs;
+        stats->nedges[i] = ptr->nedges/2;
+      }
+      if (ptr == graph)
+        break;
+    }
+  }
 
+  tstart = WallSeconds();
   IFSET(ctrl->dbglvl, DBG_TIME, starttimer(ctrl->InitPartTmr));
   AllocateKWayPartitionMemory(ctrl, cgraph, nparts);
 
@@ -205,18 +218,20 @@ int MLKKMPartitioning(CtrlType *ctrl, GraphType *graph, int nparts, int chain_le
   options[OPTION_ITYPE] = IPART_GGPKL;
   options[OPTION_RTYPE] = RTYPE_FM;
   options[OPTION_DBGLVL] = 0;
+  options[OPTION_NTHREADS] = ctrl->nthreads;
   
-  if(spectral_initialization == 0)
+  /* The spectral initialization falls back to METIS on graphs that are too small for it */
+  if (ctrl->initpart != INITPART_SPECTRAL || !SpectralInit(ctrl, cgraph, nparts, cgraph->where))
   {
 	  METIS_WPartGraphRecursive(&cgraph->nvtxs, cgraph->xadj, cgraph->adjncy, cgraph->vwgt, 
                             cgraph->adjwgt, &wgtflag, &numflag, &nparts, tpwgts, options, 
                             &edgecut, cgraph->where);
   }
-//  else
-//    spectralInit(cgraph, nparts, &numflag, options);
 
   IFSET(ctrl->dbglvl, DBG_TIME, stoptimer(ctrl->InitPartTmr));
   IFSET(ctrl->dbglvl, DBG_IPART, printf("Initial %d-way partitioning cut: %d\n", nparts, edgecut));
+  if (stats != NULL)
+    stats->initparttime = WallSeconds() - tstart;
 
   IFSET(ctrl->dbglvl, DBG_KWAYPINFO, ComputePartitionInfo(cgraph, nparts, cgraph->where));
   
@@ -250,7 +265,10 @@ int MLKKMPartitioning(CtrlType *ctrl, GraphType *graph, int nparts, int chain_le
   //for random initialization ends here 
   */
   
+  tstart = WallSeconds();
   MLKKMRefine(ctrl, graph, cgraph, nparts, chain_length, tpwgts, ubfactor);
+  if (stats != NULL)
+    stats->refinetime = WallSeconds() - tstart;
   
   /* modification ends */
 
@@ -259,7 +277,7 @@ int MLKKMPartitioning(CtrlType *ctrl, GraphType *graph, int nparts, int chain_le
   //ncut = ComputeNCut(graph, part, nparts);
   //printf("  %d-way Normalized-Cut: %7f\n", nparts, ncut);
   
-  GKfree((void **) &graph->gdata, (void **) &graph->rdata, LTERM);
+  GKfree((void **) &graph->gdata, (void **) &graph->rdata, (void **) &cptr, (void **) &cind, LTERM);
 
   return graph->mincut;
 
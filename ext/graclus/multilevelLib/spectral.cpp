@@ -0,0 +1,278 @@
+/*
+ * spectral.cpp
+ *
+ * This file contains the spectral initial partitioning of the coarsest
+ * graph of MLKKM. The leading eigenvectors of the normalized adjacency
+ * matrix D^-.5*A*D^-.5 are computed by LOBPCG on the sparse matrix, and
+ * the rows of the eigenvectors are clustered by k-means. Only the
+ * nvtxs x O(nparts) blocks of vectors are dense.
+ *
+ */
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+extern "C"
+{
+#include <metis.h>
+}
+
+typedef Eigen::SparseMatrix<double, Eigen::RowMajor> SpMatrix;
+typedef Eigen::MatrixXd Matrix;
+typedef Eigen::VectorXd Vector;
+
+
+/*************************************************************************
+* This function builds the normalized adjacency matrix D^-.5*A*D^-.5 of
+* the graph. Vertices without edges get an empty row.
+**************************************************************************/
+static void NormalizedAdjacency(GraphType *graph, SpMatrix &m)
+{
+  int i, nvtxs;
+  idxtype j, *xadj, *adjncy, *adjwgt;
+  std::vector<Eigen::Triplet<double> > entries;
+  Vector dinv;
+
+  nvtxs = graph->nvtxs;
+  xadj = graph->xadj;
+  adjncy = graph->adjncy;
+  adjwgt = graph->adjwgt;
+
+  dinv = Vector::Zero(nvtxs);
+  for (i=0; i<nvtxs; i++) {
+    for (j=xadj[i]; j<xadj[i+1]; j++)
+      dinv(i) += (adjwgt == NULL ? 1.0 : (double)adjwgt[j]);
+    if (dinv(i) > 0)
+      dinv(i) = 1.0/std::sqrt(dinv(i));
+  }
+
+  entries.reserve(xadj[nvtxs]);
+  for (i=0; i<nvtxs; i++)
+    for (j=xadj[i]; j<xadj[i+1]; j++)
+      entries.push_back(Eigen::Triplet<double>(i, (int)adjncy[j],
+            (adjwgt == NULL ? 1.0 : (double)adjwgt[j])*dinv(i)*dinv(adjncy[j])));
+
+  m.resize(nvtxs, nvtxs);
+  m.setFromTriplets(entries.begin(), entries.end());
+}
+
+
+/*************************************************************************
+* This function replaces the columns of s by an orthonormal basis of
+* their span, in which the first j columns span the first j columns of s.
+* Cholesky QR is applied twice, which is accurate once the columns are
+* not too far from orthogonal; Householder QR is the fallback when the
+* columns are numerically dependent.
+**************************************************************************/
+static void Orthonormalize(Matrix &s)
+{
+  int pass;
+  Matrix g;
+
+  for (pass=0; pass<2; pass++) {
+    g = s.transpose()*s;
+    Eigen::LLT<Matrix> llt(g);
+    if (llt.info() != Eigen::Success)
+      break;
+    llt.matrixU().solveInPlace<Eigen::OnTheRight>(s);
+  }
+
+  if (pass < 2) {
+    Eigen::HouseholderQR<Matrix> qr(s);
+    s = qr.householderQ()*Matrix::Identity(s.rows(), s.cols());
+  }
+}
+
+
+/*************************************************************************
+* This function computes the Rayleigh-Ritz pairs of the matrix m on the
+* orthonormal basis q. The ndim largest Ritz values are stored in lambda
+* in decreasing order and their coefficients on q in c.
+**************************************************************************/
+static void RayleighRitz(const Matrix &q, const Matrix &mq, int ndim, Vector &lambda, Matrix &c)
+{
+  Matrix t;
+
+  t = q.transpose()*mq;
+  t = 0.5*(t + t.transpose());
+
+  Eigen::SelfAdjointEigenSolver<Matrix> es(t);
+  lambda = es.eigenvalues().tail(ndim).reverse();
+  c = es.eigenvectors().rightCols(ndim).rowwise().reverse();
+}
+
+
+/*************************************************************************
+* This function computes the ndim largest eigenpairs of the symmetric
+* matrix m by LOBPCG. x receives the eigenvectors. It returns the # of
+* iterations that were run.
+**************************************************************************/
+static int LOBPCG(const SpMatrix &m, int ndim, Matrix &x, double *resid)
+{
+  int i, j, n, it, nbasis;
+  Vector lambda;
+  Matrix mx, r, p, s, ms, c;
+
+  n = m.rows();
+
+  x.resize(n, ndim);
+  for (j=0; j<ndim; j++)
+    for (i=0; i<n; i++)
+      x(i, j) = GKdrand() - 0.5;
+  Orthonormalize(x);
+
+  mx = m*x;
+  RayleighRitz(x, mx, ndim, lambda, c);
+  x = x*c;
+  mx = mx*c;
+
+  for (it=0; it<SPECTRAL_MAXITER; it++) {
+    r = mx - x*lambda.asDiagonal();
+    *resid = r.colwise().norm().maxCoeff();
+    if (*resid < SPECTRAL_TOL)
+      break;
+
+    /* Scale the directions, so that the tiny residuals of the converged
+       vectors do not make the basis ill-conditioned */
+    for (j=0; j<r.cols(); j++)
+      if (r.col(j).norm() > 0)
+        r.col(j).normalize();
+    for (j=0; j<p.cols(); j++)
+      if (p.col(j).norm() > 0)
+        p.col(j).normalize();
+
+    /* The search space is spanned by the iterates, the residuals and the
+       previous search directions. x comes first, so that the first ndim
+       columns of its orthonormal basis span x. */
+    nbasis = amin(ndim + r.cols() + p.cols(), n);
+    s.resize(n, ndim + r.cols() + p.cols());
+    s << x, r, p;
+    Orthonormalize(s);
+    s.conservativeResize(n, nbasis);
+
+    ms = m*s;
+    RayleighRitz(s, ms, ndim, lambda, c);
+
+    x = s*c;
+    mx = ms*c;
+    p = s.rightCols(nbasis-ndim)*c.bottomRows(nbasis-ndim);
+  }
+
+  return it;
+}
+
+
+/*************************************************************************
+* This function clusters the columns of y into nparts clusters by k-means,
+* starting from the centers that are chosen by k-means++. The distances to
+* the centers are computed by a matrix product, |y-c|^2 = |y|^2-2y.c+|c|^2.
+**************************************************************************/
+static void KMeansColumns(const Matrix &y, int nparts, idxtype *where)
+{
+  int i, k, n, it, nmoves, best, first, nblock;
+  double sum, pick;
+  Matrix centers, sums, dots;
+  Vector mindist, cnorms;
+  std::vector<int> sizes(nparts);
+
+  n = y.cols();
+  centers.resize(y.rows(), nparts);
+  mindist.resize(n);
+
+  /* k-means++ seeding */
+  centers.col(0) = y.col(GKrand()%n);
+  for (i=0; i<n; i++)
+    mindist(i) = (y.col(i) - centers.col(0)).squaredNorm();
+
+  for (k=1; k<nparts; k++) {
+    sum = mindist.sum();
+    pick = GKdrand()*sum;
+    for (i=0; i<n-1 && (pick -= mindist(i)) > 0; i++);
+    if (sum <= 0)
+      i = GKrand()%n;
+
+    centers.col(k) = y.col(i);
+    for (i=0; i<n; i++)
+      mindist(i) = std::min(mindist(i), (y.col(i) - centers.col(k)).squaredNorm());
+  }
+
+  for (i=0; i<n; i++)
+    where[i] = -1;
+
+  /* Lloyd iterations; an empty cluster keeps its center. |y|^2 is the
+     same for all the centers, so it is left out. The products are taken
+     a block of columns at a time to bound their memory. */
+  for (it=0; it<SPECTRAL_KMEANSITER; it++) {
+    cnorms = centers.colwise().squaredNorm().transpose();
+
+    for (nmoves=0, first=0; first<n; first+=nblock) {
+      nblock = amin(SPECTRAL_KMEANSBLOCK, n-first);
+      dots = centers.transpose()*y.middleCols(first, nblock);
+
+      for (i=0; i<nblock; i++) {
+        (cnorms - 2.0*dots.col(i)).minCoeff(&best);
+        if (where[first+i] != best) {
+          where[first+i] = best;
+          nmoves++;
+        }
+      }
+    }
+
+    if (nmoves == 0)
+      break;
+
+    std::fill(sizes.begin(), sizes.end(), 0);
+    sums = Matrix::Zero(y.rows(), nparts);
+    for (i=0; i<n; i++) {
+      sums.col(where[i]) += y.col(i);
+      sizes[where[i]]++;
+    }
+    for (k=0; k<nparts; k++)
+      if (sizes[k] > 0)
+        centers.col(k) = sums.col(k)/sizes[k];
+  }
+}
+
+
+/*************************************************************************
+* This function computes a spectral nparts-way partitioning of the graph
+* into where. The rows of the leading eigenvectors of the normalized
+* adjacency matrix are normalized and clustered by k-means. It returns 0
+* if the graph is too small for it.
+**************************************************************************/
+int SpectralInit(CtrlType *ctrl, GraphType *graph, int nparts, idxtype *where)
+{
+  int i, ndim, nvtxs, niter;
+  double norm, resid;
+  SpMatrix m;
+  Matrix x, y;
+
+  nvtxs = graph->nvtxs;
+
+  /* LOBPCG needs a basis of 3*ndim vectors */
+  ndim = amin(amin(nparts, SPECTRAL_MAXDIM), nvtxs/3);
+  if (ndim < 1 || nvtxs < nparts)
+    return 0;
+
+  NormalizedAdjacency(graph, m);
+
+  resid = 0.0;
+  niter = LOBPCG(m, ndim, x, &resid);
+
+  /* Every vertex is represented by its normalized row of the eigenvectors */
+  y = x.transpose();
+  for (i=0; i<nvtxs; i++) {
+    norm = y.col(i).norm();
+    if (norm > 0)
+      y.col(i) /= norm;
+  }
+
+  KMeansColumns(y, nparts, where);
+
+  IFSET(ctrl->dbglvl, DBG_IPART, printf("Spectral initialization: %d eigenvectors, %d LOBPCG iterations, residual %.2e\n", ndim, niter, resid));
+
+  return 1;
+}
@@ -13,13 +13,133 @@
 
 #include <metis.h>
 #include <float.h>
+#if NUMBITS == 32 && defined(__AVX2__)
+#include <immintrin.h>
+#elif NUMBITS == 32 && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 extern int cutType, memory_saving, boundary_points;
 
+
+/*************************************************************************
+* This function computes the distances 
+*   dist[k] = qterm[k] - scale*linearTerm[k]*inv_sum[k]
+* from a point to all the clusters and returns the first cluster of minimum
+* distance. The AVX2 and SSE2 versions handle 8 and 4 clusters at a time,
+* every lane keeping the first minimum of its clusters.
+**************************************************************************/
+static int ClusterArgmin(int nparts, float *qterm, float *inv_sum, idxtype *linearTerm, float scale, float *dist)
+{
+  int k, l, min_ind;
+  float min_dist;
+
+  k = 0;
+  min_ind = -1;
+  min_dist = FLT_MAX;
+
+#if NUMBITS == 32 && defined(__AVX2__)
+  {
+    __m256 vscale, vmin, d, mask;
+    __m256i vidx, vk, vstep;
+    float lmin[8];
+    int lidx[8];
+
+    vscale = _mm256_set1_ps(scale);
+    vmin = _mm256_set1_ps(FLT_MAX);
+    vidx = _mm256_setzero_si256();
+    vk = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    vstep = _mm256_set1_epi32(8);
+    for (; k+8<=nparts; k+=8) {
+      d = _mm256_cvtepi32_ps(_mm256_loadu_si256((__m256i *)(linearTerm+k)));
+      d = _mm256_mul_ps(_mm256_mul_ps(vscale, d), _mm256_loadu_ps(inv_sum+k));
+      d = _mm256_sub_ps(_mm256_loadu_ps(qterm+k), d);
+      _mm256_storeu_ps(dist+k, d);
+
+      mask = _mm256_cmp_ps(d, vmin, _CMP_LT_OQ);
+      vmin = _mm256_blendv_ps(vmin, d, mask);
+      vidx = _mm256_blendv_epi8(vidx, vk, _mm256_castps_si256(mask));
+      vk = _mm256_add_epi32(vk, vstep);
+    }
+    _mm256_storeu_ps(lmin, vmin);
+    _mm256_storeu_si256((__m256i *)lidx, vidx);
+    for (l=0; l<8; l++) {
+      if (lmin[l] < min_dist || (lmin[l] == min_dist && lidx[l] < min_ind)) {
+        min_dist = lmin[l];
+        min_ind = lidx[l];
+      }
+    }
+  }
+#elif NUMBITS == 32 && defined(__SSE2__)
+  {
+    __m128 vscale, vmin, d, mask;
+    __m128i vidx, vk, vstep, imask;
+    float lmin[4];
+    int lidx[4];
+
+    vscale = _mm_set1_ps(scale);
+    vmin = _mm_set1_ps(FLT_MAX);
+    vidx = _mm_setzero_si128();
+    vk = _mm_setr_epi32(0, 1, 2, 3);
+    vstep = _mm_set1_epi32(4);
+    for (; k+4<=nparts; k+=4) {
+      d = _mm_cvtepi32_ps(_mm_loadu_si128((__m128i *)(linearTerm+k)));
+      d = _mm_mul_ps(_mm_mul_ps(vscale, d), _mm_loadu_ps(inv_sum+k));
+      d = _mm_sub_ps(_mm_loadu_ps(qterm+k), d);
+      _mm_storeu_ps(dist+k, d);
+
+      mask = _mm_cmplt_ps(d, vmin);
+      imask = _mm_castps_si128(mask);
+      vmin = _mm_or_ps(_mm_and_ps(mask, d), _mm_andnot_ps(mask, vmin));
+      vidx = _mm_or_si128(_mm_and_si128(imask, vk), _mm_andnot_si128(imask, vidx));
+      vk = _mm_add_epi32(vk, vstep);
+    }
+    _mm_storeu_ps(lmin, vmin);
+    _mm_storeu_si128((__m128i *)lidx, vidx);
+    for (l=0; l<4; l++) {
+      if (lmin[l] < min_dist || (lmin[l] == min_dist && lidx[l] < min_ind)) {
+        min_dist = lmin[l];
+        min_ind = lidx[l];
+      }
+    }
+  }
+#endif
+
+  for (; k<nparts; k++) {
+    dist[k] = qterm[k] - scale*linearTerm[k]*inv_sum[k];
+    if (dist[k] < min_dist) {
+      min_dist = dist[k];
+      min_ind = k;
+    }
+  }
+
+  return (min_ind == -1 ? 0 : min_ind);
+}
+
+
+/*************************************************************************
+* This function returns the closest cluster, by the distances in dist, to
+* a point of weight vwgt among the clusters that have room for it under
+* maxpwgt. The point stays in its cluster me unless another one is
+* strictly closer.
+**************************************************************************/
+static int BoundedArgmin(int nparts, float *dist, idxtype *pwgts, idxtype vwgt, idxtype maxpwgt, int me)
+{
+  int k, min_ind;
+
+  min_ind = me;
+  for (k=0; k<nparts; k++)
+    if (dist[k] < dist[min_ind] && pwgts[k]+vwgt <= maxpwgt)
+      min_ind = k;
+
+  return min_ind;
+}
+
 void Compute_Weights(CtrlType *ctrl, GraphType *graph, idxtype *w)
      /* compute the weights for WKKM; for the time, only Ncut. w is zero-initialized */
 {
-  int nvtxs, i, j;
+  int nvtxs, i;
+  idxtype j;
   idxtype *xadj, *adjwgt;
 
   nvtxs = graph->nvtxs;
@@ -43,7 +163,8 @@ void Compute_Weights(CtrlType *ctrl, GraphType *graph, idxtype *w)
 void transform_matrix(CtrlType *ctrl, GraphType *graph, idxtype *w, float *m_adjwgt)
      /* normalized the adjacency matrix for Ncut only*/
 {
-  int nvtxs, i, j;
+  int nvtxs, i;
+  idxtype j;
   idxtype *xadj, *adjncy, *adjwgt, *where;
 
   nvtxs = graph->nvtxs;
@@ -90,7 +211,8 @@ void transform_matrix(CtrlType *ctrl, GraphType *graph, idxtype *w, float *m_adj
 void transform_matrix_half(CtrlType *ctrl, GraphType *graph, idxtype *w, float *m_adjwgt)
      /* normalized the adjacency matrix for Ncut only, D^-.5*A*D^-.5*/
 {
-  int nvtxs, i, j;
+  int nvtxs, i;
+  idxtype j;
   idxtype *xadj, *adjncy, *adjwgt, *where;
 
   nvtxs = graph->nvtxs;
@@ -135,11 +257,12 @@ void transform_matrix_half(CtrlType *ctrl, GraphType *graph, idxtype *w, float *
 }
 
 
-void pingpong(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length, float *tpwgts, float ubfactor, int toplevel)
+int pingpong(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length, float *tpwgts, float ubfactor, int toplevel)
      // do batch-local search; chain_length is the search length
+     // return # of kernel k-means iterations
 {
 
-  int nvtxs, nedges, moves, iter;
+  int nvtxs, nedges, moves, iter, kkmiters;
   idxtype *w;
   //float *m_adjwgt;
 
@@ -155,11 +278,12 @@ void pingpong(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length, fl
  
   moves =0;
   iter =0;
+  kkmiters =0;
   
   //printf("Number of boundary points is %d\n", graph->nbnd);
   do{
     //Weighted_kernel_k_means(ctrl, graph, nparts, w, m_adjwgt, tpwgts, ubfactor);
-    Weighted_kernel_k_means(ctrl, graph, nparts, w, tpwgts, ubfactor);
+    kkmiters += Weighted_kernel_k_means(ctrl, graph, nparts, w, tpwgts, ubfactor);
     if (chain_length>0){
       
       //moves = local_search(ctrl, graph, nparts, chain_length, w, m_adjwgt, tpwgts, ubfactor);
@@ -176,19 +300,25 @@ void pingpong(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length, fl
     if(toplevel>0)
       remove_empty_clusters_l2(ctrl, graph, nparts, w, tpwgts, ubfactor);
   }
-  free(w); 
+  if (ctrl->maxpwgt > 0)
+    EnforceSizeBound(ctrl, graph, nparts, w);
+  GKdealloc(w); 
   //free(m_adjwgt); 
+  return kkmiters;
 }
 
-void Weighted_kernel_k_means(CtrlType *ctrl, GraphType *graph, int nparts, idxtype *w, float *tpwgts, float ubfactor){
+int Weighted_kernel_k_means(CtrlType *ctrl, GraphType *graph, int nparts, idxtype *w, float *tpwgts, float ubfactor){
   // w is the weights
+  // return # of iterations
 
 
-  int nvtxs, nbnd, nedges, me, i, j;
-  idxtype *squared_sum, *sum, *xadj, *adjncy, *adjwgt, *where, *new_where, *bndptr, *bndind;
-  float obj, old_obj, epsilon, *inv_sum, *squared_inv_sum;
+  int nvtxs, nbnd, me, i;
+  idxtype j, nedges;
+  acctype *squared_sum, *sum;
+  idxtype *xadj, *adjncy, *adjwgt, *where, *new_where, *bndptr, *bndind;
+  float obj, old_obj, epsilon, *inv_sum, *squared_inv_sum, *qterm, *dist;
   int change;
-  idxtype *linearTerm, ii;
+  idxtype *linearTerm, ii, *vwgt, *pwgts, maxpwgt;
   int loopend, currit=0;
 
   nedges = graph->nedges;
@@ -200,6 +330,8 @@ void Weighted_kernel_k_means(CtrlType *ctrl, GraphType *graph, int nparts, idxty
   where = graph->where;
   bndptr = graph->bndptr;
   bndind = graph->bndind;
+  vwgt = graph->vwgt;
+  maxpwgt = ctrl->maxpwgt;
 
   // we need new_where because in kernel k-means distance is based on cluster label
   // if we change a label, distance to that cluster will change
@@ -207,10 +339,10 @@ void Weighted_kernel_k_means(CtrlType *ctrl, GraphType *graph, int nparts, idxty
   for (i=0; i<nvtxs; i++)
     new_where[i] = where[i];
   
-  sum = idxsmalloc(nparts,0, "Weighted_kernel_k_means: weight sum");
+  sum = accsmalloc(nparts, 0, "Weighted_kernel_k_means: weight sum");
   inv_sum = fmalloc(nparts, "Weighted_kernel_k_means: sum inverse"); 
   squared_inv_sum = fmalloc(nparts, "Weighted_kernel_k_means: squared sum inverse"); 
-  squared_sum = idxsmalloc(nparts,0, "Weighted_kernel_k_means: weight squared sum");
+  squared_sum = accsmalloc(nparts, 0, "Weighted_kernel_k_means: weight squared sum");
   
   //initialization
   
@@ -247,14 +379,23 @@ void Weighted_kernel_k_means(CtrlType *ctrl, GraphType *graph, int nparts, idxty
       obj +=  squared_sum[i]*1.0/sum[i];
   
   epsilon =.00001; 
-  linearTerm = idxmalloc(nparts, "Weighted_kernel_k_means: new_where");
+  linearTerm = idxsmalloc(nparts, 0, "Weighted_kernel_k_means: linear term");
+  qterm = fmalloc(nparts, "Weighted_kernel_k_means: quadratic term");
+  dist = fmalloc(nparts, "Weighted_kernel_k_means: distance");
+  pwgts = (maxpwgt > 0 ? idxmalloc(nparts, "Weighted_kernel_k_means: pwgts") : NULL);
   
   do{
-    float min_dist, dist;
     int min_ind, k;
     change =0;
     old_obj = obj;
     currit++;
+
+    // under a size bound, pwgts follows the moves so that no cluster is filled past maxpwgt
+    if (pwgts != NULL) {
+      idxset(nparts, 0, pwgts);
+      for (i=0; i<nvtxs; i++)
+        pwgts[where[i]] += vwgt[i];
+    }
     /*
     if (adjwgt == NULL) // if graph has uniform edge weights
       for (i=0; i<nvtxs; i++){ // compute linear term in distance from point i to all centers
@@ -296,6 +437,10 @@ void Weighted_kernel_k_means(CtrlType *ctrl, GraphType *graph, int nparts, idxty
       loopend = nbnd;
     else
       loopend = nvtxs;
+    // the quadratic term of the distance does not depend on the point
+    for (k=0; k<nparts; k++)
+      qterm[k] = squared_sum[k]*squared_inv_sum[k];
+
     //for (i=0; i<nvtxs; i++){ // compute linear term in distance from point i to all centers
     for (ii=0; ii<loopend; ii++){
       if(boundary_points == 1)
@@ -304,49 +449,29 @@ void Weighted_kernel_k_means(CtrlType *ctrl, GraphType *graph, int nparts, idxty
 	i = ii;
       if(w[i] >0){
 	float inv_wi=1.0/w[i];
-        for (k=0; k<nparts; k++)
- 	  linearTerm[k] =0;
         for (j=xadj[i]; j<xadj[i+1]; j++)
 	  linearTerm[where[adjncy[j]]] += adjwgt[j]; //only difference between if and else
 	
-	min_ind = me = where[i];
-	min_dist = squared_sum[me]*squared_inv_sum[me] - 2*inv_wi*linearTerm[me]*inv_sum[me];
-	/*if (sum[me] >0)
-	  min_dist = squared_sum[me]*1.0/(1.0*sum[me]*sum[me])-2.0*linearTerm[me]/(sum[me]*w[i]);
-	*/
-	for (k=0; k<me; k++){
-	  dist = squared_sum[k]*squared_inv_sum[k] -2*inv_wi*linearTerm[k]*inv_sum[k]; 
-	  /*
-	    dist = 0;
-	    if (sum[k] >0)
-	    dist = squared_sum[k]*1.0/(1.0*sum[k]*sum[k])-2.0*linearTerm[k]/(sum[k]*w[i]);
-	  */
-	  if(dist < min_dist){
-	    //if(dist < min_dist){
-	    min_dist = dist;
-	    min_ind = k;
-	  }
-	}
-	for (k=me+1; k<nparts; k++){
-	  dist = squared_sum[k]*squared_inv_sum[k] -2*inv_wi*linearTerm[k]*inv_sum[k]; 
-	  /*
-	  dist = 0;
-	  if (sum[k] >0)
-	    dist = squared_sum[k]*1.0/(1.0*sum[k]*sum[k])-2.0*linearTerm[k]/(sum[k]*w[i]);
-	  */
-	  if(dist < min_dist){
-	    //if(dist < min_dist){
-	    min_dist = dist;
-	    min_ind = k;
-	  }
+	me = where[i];
+	min_ind = ClusterArgmin(nparts, qterm, inv_sum, linearTerm, 2*inv_wi, dist);
+	// a point stays in its cluster unless another one is strictly closer
+	if (dist[min_ind] == dist[me])
+	  min_ind = me;
+	if (pwgts != NULL && min_ind != me) {
+	  if (pwgts[min_ind]+vwgt[i] > maxpwgt)
+	    min_ind = BoundedArgmin(nparts, dist, pwgts, vwgt[i], maxpwgt, me);
+	  pwgts[me] -= vwgt[i];
+	  pwgts[min_ind] += vwgt[i];
 	}
+
+	// only the clusters of the neighbors have a nonzero linear term
+        for (j=xadj[i]; j<xadj[i+1]; j++)
+	  linearTerm[where[adjncy[j]]] = 0;
 	
 	if(me != min_ind){
 	  new_where[i] = min_ind; // note here we can not change where; otherwise we change the center
 	  change ++;
 	}
-	//if(i==0)
-	//printf("%d(%d->%d), sum=(%d, %d), linear=(%f, %f), square=(%d, %d), dis=(%f-%f, %f-%f)\n",i, me, min_ind, sum[me], sum[min_ind], linearTerm[me]*1.0/w[i],linearTerm[min_ind]*1.0/w[i],squared_sum[me], squared_sum[min_ind], squared_sum[me]*1.0/(1.0*sum[me]*sum[me]), 2.0*linearTerm[me]/(sum[me]*w[i]), squared_sum[min_ind]*1.0/(1.0*sum[min_ind]*sum[min_ind]), 2.0*linearTerm[min_ind]/(sum[min_ind]*w[i]));
       }
     }
     
@@ -402,17 +527,24 @@ void Weighted_kernel_k_means(CtrlType *ctrl, GraphType *graph, int nparts, idxty
       }
     //printf("Obj: %6.6f, Old_obj: %6.6f, abs(obj-old_obj) = %6.6f\n", obj, old_obj, fabs(obj-old_obj));
   }while((obj - old_obj) > epsilon*obj && currit < MAXITERATIONS);
-  free(sum); free(squared_sum); free(new_where); free(linearTerm); free(inv_sum); free(squared_inv_sum);
+  GKdealloc(sum); GKdealloc(squared_sum); GKdealloc(new_where); GKdealloc(linearTerm); GKdealloc(inv_sum); GKdealloc(squared_inv_sum);
+  GKdealloc(qterm); GKdealloc(dist);
+  if (pwgts != NULL)
+    GKdealloc(pwgts);
+  return currit;
 }
 
 
 int local_search(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length, idxtype *w, float *tpwgts, float ubfactor)
      //return # of points moved
 {
-  int nvtxs, nedges, nbnd, me, i, j, k, s, ii;
-  idxtype *sum, *squared_sum, *xadj, *adjncy, *adjwgt, *where, *bndptr, *bndind;
+  int nvtxs, nbnd, me, i, k, s, ii;
+  idxtype j, nedges;
+  acctype *sum, *squared_sum;
+  idxtype *xadj, *adjncy, *adjwgt, *where, *bndptr, *bndind;
   float change, obj, epsilon, **kDist, *accum_change;
   int moves, actual_length, *mark, fidx, loopend;
+  idxtype *vwgt, *pwgts, maxpwgt;
   Chains *chain;
 
   nedges = graph->nedges;
@@ -424,16 +556,26 @@ int local_search(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length,
   nbnd = graph->nbnd;
   bndind = graph->bndind;
   bndptr = graph->bndptr;
+  vwgt = graph->vwgt;
+  maxpwgt = ctrl->maxpwgt;
   
   if(boundary_points == 1)
     loopend = nbnd;
   else
     loopend = nvtxs;
 
+  // under a size bound, a point is only moved into a cluster with room for it
+  pwgts = NULL;
+  if (maxpwgt > 0) {
+    pwgts = idxsmalloc(nparts, 0, "Local_search: pwgts");
+    for (i=0; i<nvtxs; i++)
+      pwgts[where[i]] += vwgt[i];
+  }
+
   chain = chainmalloc(chain_length, "Local_search: local search chain");
   mark = ismalloc(loopend, 0 , "Local_search: mark");
-  sum = idxsmalloc(nparts,0, "Local_search: weight sum");
-  squared_sum = idxsmalloc(nparts,0,"Local_search: weight squared sum");
+  sum = accsmalloc(nparts, 0, "Local_search: weight sum");
+  squared_sum = accsmalloc(nparts, 0, "Local_search: weight squared sum");
   kDist = f2malloc(loopend, nparts, "Local_search: distance matrix");
   accum_change = fmalloc(chain_length+1,"Local_search: accumulated change");
 
@@ -501,7 +643,7 @@ int local_search(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length,
 	  me = where[j];
 	  if (sum[me] > w[j]) // if this cluster where j belongs is not a singleton
 	    for (k=0; k<nparts; k++)
-	      if (k != me){
+	      if (k != me && (pwgts == NULL || pwgts[k]+vwgt[j] <= maxpwgt)){
 		//tempchange = -kDist[j][me]*sum[me]*w[j]/(sum[me]-w[j]) + kDist[j][k]*sum[k]*w[j]/(sum[k]+w[j]);
 		tempchange = -kDist[ii][me]*sum[me]*w[j]/(sum[me]-w[j]) + kDist[ii][k]*sum[k]*w[j]/(sum[k]+w[j]);
 		if (tempchange < tempMinChange){
@@ -532,6 +674,10 @@ int local_search(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length,
 	where[tempid] = to;
         sum[from] -=  w[tempid];
         sum[to] +=  w[tempid];
+	if (pwgts != NULL) {
+	  pwgts[from] -= vwgt[tempid];
+	  pwgts[to] += vwgt[tempid];
+	}
 	
         for (j=xadj[tempid]; j<xadj[tempid+1]; j++) 
 	  if (where[adjncy[j]] == from)
@@ -594,20 +740,24 @@ int local_search(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length,
     change = 0;
   }
 
-  free(sum); free(squared_sum);free(accum_change); free(chain); free(mark);
+  GKdealloc(sum); GKdealloc(squared_sum);GKdealloc(accum_change); GKdealloc(chain); GKdealloc(mark);
+  if (pwgts != NULL)
+    GKdealloc(pwgts);
   
   //for (i= 0; i<nvtxs; i++)
   for (i= 0; i<loopend; i++)
-    free(kDist[i]);
-  free(kDist);
+    GKdealloc(kDist[i]);
+  GKdealloc(kDist);
   
   return moves;
 }
 
 
-float onePoint_move(GraphType *graph, int nparts, idxtype *sum, idxtype *squared_sum, idxtype *w, idxtype *self_sim, int **linearTerm, int ii){
+float onePoint_move(GraphType *graph, int nparts, acctype *sum, acctype *squared_sum, idxtype *w, idxtype *self_sim, int **linearTerm, int ii){
   
-	int k, j, s, i, nbnd, temp, q1, q2, minchange_id, new_squared_sum1, new_squared_sum2, me, nedges, nvtxs, loopend;
+	int k, s, i, nbnd, temp, minchange_id, me, nvtxs, loopend;
+  idxtype j, nedges;
+  acctype q1, q2, new_squared_sum1, new_squared_sum2;
   float tempchange, minchange, obj, cut;
   idxtype *xadj, *adjncy, *adjwgt, *where, *bndptr, *bndind;
   
@@ -733,8 +883,10 @@ float onePoint_move(GraphType *graph, int nparts, idxtype *sum, idxtype *squared
   return minchange;
 }
 
-void move1Point2EmptyCluster(GraphType *graph, int nparts, idxtype *sum, idxtype *squared_sum, idxtype *w, idxtype *self_sim, int **linearTerm, int k){
-	int j, s, ii, nbnd, q1, q2, minchange_id, new_squared_sum1, new_squared_sum2, me, nvtxs, loopend;
+void move1Point2EmptyCluster(GraphType *graph, int nparts, acctype *sum, acctype *squared_sum, idxtype *w, idxtype *self_sim, int **linearTerm, int k){
+	int s, ii, nbnd, minchange_id, me, nvtxs, loopend;
+  idxtype j;
+  acctype q1, q2, new_squared_sum1, new_squared_sum2;
   float tempchange, minchange;
   idxtype *xadj, *adjncy, *adjwgt, *where, *bndptr, *bndind;
   
@@ -820,8 +972,10 @@ void move1Point2EmptyCluster(GraphType *graph, int nparts, idxtype *sum, idxtype
 int local_search(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length, idxtype *w, float *tpwgts, float ubfactor)
      //return # of points moved
 {
-  int nvtxs, nedges, nbnd, me, i, j, k, s, ii;
-  idxtype *sum, *squared_sum, *xadj, *adjncy, *adjwgt, *where, *bndptr, *bndind, *self_sim;
+  int nvtxs, nbnd, me, i, k, s, ii;
+  idxtype j, nedges;
+  acctype *sum, *squared_sum;
+  idxtype *xadj, *adjncy, *adjwgt, *where, *bndptr, *bndind, *self_sim;
   float change, obj, epsilon, accum_change, minchange;
   int moves, loopTimes, **linearTerm, loopend;
 
@@ -839,8 +993,8 @@ int local_search(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length,
   else
     loopend = nvtxs;
   
-  sum = idxsmalloc(nparts,0, "Local_search: weight sum");
-  squared_sum = idxsmalloc(nparts,0,"Local_search: weight squared sum");
+  sum = accsmalloc(nparts, 0, "Local_search: weight sum");
+  squared_sum = accsmalloc(nparts, 0, "Local_search: weight squared sum");
   self_sim = idxsmalloc(loopend, 0, "Local_search: self similarity");
   linearTerm = i2malloc(loopend, nparts, "Local_search: linear term");
 
@@ -878,7 +1032,6 @@ int local_search(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length,
     if (sum[i] >0)
       obj +=  squared_sum[i]*1.0/sum[i];
 
-  srand(time(NULL));
   //temperature = DEFAULT_TEMP;
   loopTimes = 0;
 
@@ -897,12 +1050,12 @@ int local_search(CtrlType *ctrl, GraphType *graph, int nparts, int chain_length,
     loopTimes ++;
   } 
 
-  free(sum); free(squared_sum); free(self_sim);
+  GKdealloc(sum); GKdealloc(squared_sum); GKdealloc(self_sim);
   
   //for (i= 0; i<nvtxs; i++)
   for (i= 0; i<loopend; i++)
-    free(linearTerm[i]);
-  free(linearTerm);
+    GKdealloc(linearTerm[i]);
+  GKdealloc(linearTerm);
   
   //printf("moves = %d\n", moves);
   return moves;
@@ -923,7 +1076,7 @@ void remove_empty_clusters_l1(CtrlType *ctrl, GraphType *graph, int nparts, idxt
   if(number_of_empty_cluster>0)
     local_search(ctrl, graph, nparts, 1, w, tpwgts, ubfactor);
   
-  free(clustersize);
+  GKdealloc(clustersize);
 }
 
 void remove_empty_clusters_l2(CtrlType *ctrl, GraphType *graph, int nparts, idxtype *w, float *tpwgts, float ubfactor){
@@ -939,8 +1092,10 @@ void remove_empty_clusters_l2(CtrlType *ctrl, GraphType *graph, int nparts, idxt
   //printf("%d empty clusters; ", number_of_empty_cluster);
 
   if(number_of_empty_cluster>0){
-    int nvtxs, me, j, k, ii;
-    idxtype *sum, *squared_sum, *xadj, *adjncy, *adjwgt, *where, *bndptr, *bndind, *self_sim, nbnd;
+    int nvtxs, me, k, ii;
+    idxtype j;
+    acctype *sum, *squared_sum;
+    idxtype *xadj, *adjncy, *adjwgt, *where, *bndptr, *bndind, *self_sim, nbnd;
     int **linearTerm;
     
     nvtxs = graph->nvtxs;
@@ -957,8 +1112,8 @@ void remove_empty_clusters_l2(CtrlType *ctrl, GraphType *graph, int nparts, idxt
     else
       loopend = nvtxs;
 
-    sum = idxsmalloc(nparts,0, "Local_search: weight sum");
-    squared_sum = idxsmalloc(nparts,0,"Local_search: weight squared sum");
+    sum = accsmalloc(nparts, 0, "Local_search: weight sum");
+    squared_sum = accsmalloc(nparts, 0, "Local_search: weight squared sum");
     self_sim = idxsmalloc(loopend, 0, "Local_search: self similarity");
     linearTerm = i2malloc(loopend, nparts, "Local_search: linear term");
     
@@ -989,12 +1144,12 @@ void remove_empty_clusters_l2(CtrlType *ctrl, GraphType *graph, int nparts, idxt
       if(clustersize[k] ==0){
 	move1Point2EmptyCluster(graph, nparts, sum, squared_sum, w, self_sim, linearTerm, k);
       }
-    free(sum); free(squared_sum); free(self_sim);
+    GKdealloc(sum); GKdealloc(squared_sum); GKdealloc(self_sim);
     
     //for (i= 0; i<nvtxs; i++)
     for (i= 0; i<loopend; i++)
-      free(linearTerm[i]);
-    free(linearTerm);
+      GKdealloc(linearTerm[i]);
+    GKdealloc(linearTerm);
   }
   /*
   for(i=0; i<nparts; i++)
@@ -1006,12 +1161,181 @@ void remove_empty_clusters_l2(CtrlType *ctrl, GraphType *graph, int nparts, idxt
       number_of_empty_cluster ++;
   printf("%d empty clusters\n", number_of_empty_cluster);
   */
-  free(clustersize);
+  GKdealloc(clustersize);
+}
+
+/*************************************************************************
+* The following data structure holds a vertex of an overweight cluster and
+* the distance increase of moving it to the closest cluster with room
+**************************************************************************/
+struct boundmovedef {
+  float delta;
+  idxtype vtx, to;
+};
+
+typedef struct boundmovedef BoundMoveType;
+
+static int CompareBoundMoves(const void *v1, const void *v2)
+{
+  const BoundMoveType *m1 = (const BoundMoveType *)v1, *m2 = (const BoundMoveType *)v2;
+
+  if (m1->delta != m2->delta)
+    return (m1->delta < m2->delta ? -1 : 1);
+  return (m1->vtx < m2->vtx ? -1 : (m1->vtx > m2->vtx ? 1 : 0));
+}
+
+
+/*************************************************************************
+* This function computes the kernel k-means distances of vertex i to the
+* clusters into dist and returns the closest cluster other than its own
+* that has room for it under maxpwgt, or -1 if there is none
+**************************************************************************/
+static int ClosestWithRoom(GraphType *graph, int nparts, int i, idxtype *w, idxtype *pwgts, idxtype maxpwgt,
+                           float *qterm, float *inv_sum, idxtype *linearTerm, float *dist)
+{
+  int k, me, to;
+  idxtype j, *xadj, *adjncy, *adjwgt, *where;
+  float scale;
+
+  xadj = graph->xadj;
+  adjncy = graph->adjncy;
+  adjwgt = graph->adjwgt;
+  where = graph->where;
+  me = where[i];
+
+  for (j=xadj[i]; j<xadj[i+1]; j++)
+    linearTerm[where[adjncy[j]]] += adjwgt[j];
+
+  scale = (w[i] > 0 ? 2.0/w[i] : 0);
+  for (to=-1, k=0; k<nparts; k++) {
+    dist[k] = qterm[k] - scale*linearTerm[k]*inv_sum[k];
+    if (k != me && pwgts[k]+graph->vwgt[i] <= maxpwgt && (to == -1 || dist[k] < dist[to]))
+      to = k;
+  }
+
+  for (j=xadj[i]; j<xadj[i+1]; j++)
+    linearTerm[where[adjncy[j]]] = 0;
+
+  return to;
+}
+
+
+/*************************************************************************
+* This function moves vertices out of the clusters whose vertex weight is
+* above ctrl->maxpwgt. Every pass finds, for the vertices of the overweight
+* clusters, the closest cluster with room in the kernel k-means distance,
+* and applies the moves that increase the distance the least first. It
+* returns the # of vertices that were moved.
+**************************************************************************/
+int EnforceSizeBound(CtrlType *ctrl, GraphType *graph, int nparts, idxtype *w)
+{
+  int i, k, me, to, pass, nvtxs, nmoves, tmoves, nover;
+  idxtype j, v, ncand, maxpwgt, *xadj, *adjncy, *adjwgt, *vwgt, *where, *pwgts, *linearTerm;
+  acctype *sum, *squared_sum;
+  float *qterm, *inv_sum, *dist;
+  BoundMoveType *cand;
+
+  nvtxs = graph->nvtxs;
+  xadj = graph->xadj;
+  adjncy = graph->adjncy;
+  adjwgt = graph->adjwgt;
+  vwgt = graph->vwgt;
+  where = graph->where;
+  maxpwgt = ctrl->maxpwgt;
+
+  pwgts = idxsmalloc(nparts, 0, "EnforceSizeBound: pwgts");
+  for (i=0; i<nvtxs; i++)
+    pwgts[where[i]] += vwgt[i];
+
+  for (nover=0, k=0; k<nparts; k++)
+    nover += (pwgts[k] > maxpwgt);
+  if (nover == 0) {
+    GKdealloc(pwgts);
+    return 0;
+  }
+
+  sum = accsmalloc(nparts, 0, "EnforceSizeBound: sum");
+  squared_sum = accsmalloc(nparts, 0, "EnforceSizeBound: squared_sum");
+  for (i=0; i<nvtxs; i++) {
+    me = where[i];
+    sum[me] += w[i];
+    for (j=xadj[i]; j<xadj[i+1]; j++)
+      if (where[adjncy[j]] == me)
+        squared_sum[me] += adjwgt[j];
+  }
+
+  linearTerm = idxsmalloc(nparts, 0, "EnforceSizeBound: linearTerm");
+  qterm = fmalloc(nparts, "EnforceSizeBound: qterm");
+  inv_sum = fmalloc(nparts, "EnforceSizeBound: inv_sum");
+  dist = fmalloc(nparts, "EnforceSizeBound: dist");
+  cand = (BoundMoveType *)GKmalloc(sizeof(BoundMoveType)*nvtxs, "EnforceSizeBound: cand");
+
+  for (tmoves=0, pass=0; pass<SIZEBOUND_NPASSES && nover>0; pass++) {
+    for (k=0; k<nparts; k++) {
+      inv_sum[k] = (sum[k] > 0 ? 1.0/sum[k] : 0);
+      qterm[k] = squared_sum[k]*inv_sum[k]*inv_sum[k];
+    }
+
+    for (ncand=0, i=0; i<nvtxs; i++) {
+      me = where[i];
+      if (pwgts[me] <= maxpwgt)
+        continue;
+
+      if ((to = ClosestWithRoom(graph, nparts, i, w, pwgts, maxpwgt, qterm, inv_sum, linearTerm, dist)) != -1) {
+        cand[ncand].delta = dist[to] - dist[me];
+        cand[ncand].vtx = i;
+        cand[ncand++].to = to;
+      }
+    }
+
+    qsort(cand, ncand, sizeof(BoundMoveType), CompareBoundMoves);
+
+    for (nmoves=0, v=0; v<ncand; v++) {
+      i = cand[v].vtx;
+      to = cand[v].to;
+      me = where[i];
+      if (pwgts[me] <= maxpwgt)
+        continue;
+
+      /* The cluster may have been filled by the previous moves */
+      if (pwgts[to]+vwgt[i] > maxpwgt && (to = ClosestWithRoom(graph, nparts, i, w, pwgts, maxpwgt, qterm, inv_sum, linearTerm, dist)) == -1)
+        continue;
+
+      for (j=xadj[i]; j<xadj[i+1]; j++) {
+        if (adjncy[j] == i) {
+          squared_sum[me] -= adjwgt[j];
+          squared_sum[to] += adjwgt[j];
+        }
+        else if (where[adjncy[j]] == me)
+          squared_sum[me] -= 2*adjwgt[j];
+        else if (where[adjncy[j]] == to)
+          squared_sum[to] += 2*adjwgt[j];
+      }
+      sum[me] -= w[i];
+      sum[to] += w[i];
+      pwgts[me] -= vwgt[i];
+      pwgts[to] += vwgt[i];
+      where[i] = to;
+      nmoves++;
+    }
+    tmoves += nmoves;
+
+    for (nover=0, k=0; k<nparts; k++)
+      nover += (pwgts[k] > maxpwgt);
+    if (nmoves == 0)
+      break;
+  }
+
+  IFSET(ctrl->dbglvl, DBG_REFINE, printf("Size bound %" PRIDX ": %d moves, %d clusters above it\n", maxpwgt, tmoves, nover));
+
+  GKdealloc(pwgts); GKdealloc(sum); GKdealloc(squared_sum); GKdealloc(linearTerm); GKdealloc(qterm); GKdealloc(inv_sum); GKdealloc(dist); GKdealloc(cand);
+
+  return tmoves;
 }
 
 void MLKKMRefine(CtrlType *ctrl, GraphType *orggraph, GraphType *graph, int nparts, int chain_length, float *tpwgts, float ubfactor)
 {
-  int i, nlevels, mustfree=0, temp_cl;
+  int i, nlevels, mustfree=0, temp_cl, kkmiters;
   GraphType *ptr;
 
   IFSET(ctrl->dbglvl, DBG_TIME, starttimer(ctrl->UncoarsenTmr));
@@ -1037,14 +1361,20 @@ void MLKKMRefine(CtrlType *ctrl, GraphType *orggraph, GraphType *graph, int npar
     
     if (graph == orggraph){
       //chain_length = chain_length>0 ? chain_length : 1;
-      pingpong(ctrl, graph, nparts, chain_length, tpwgts, ubfactor, 1);
-      break;
+      kkmiters = pingpong(ctrl, graph, nparts, chain_length, tpwgts, ubfactor, 1);
     }
     else{
       //pingpong(ctrl, graph, nparts, 0, tpwgts, ubfactor, 0);
-      pingpong(ctrl, graph, nparts, chain_length, tpwgts, ubfactor, 0);
+      kkmiters = pingpong(ctrl, graph, nparts, chain_length, tpwgts, ubfactor, 0);
       //chain_length /= 2;
     }
+    if (ctrl->stats != NULL) {
+      if (nlevels-i < MAXSTATLEVELS)
+        ctrl->stats->kkmiters[nlevels-i] = kkmiters;
+      ctrl->stats->totalkkmiters += kkmiters;
+    }
+    if (graph == orggraph)
+      break;
     
     
     //pingpong(ctrl, graph, nparts, chain_length, tpwgts, ubfactor);
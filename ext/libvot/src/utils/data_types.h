@@ -128,6 +128,35 @@ public:
 		return true;
 	}
 
+	///
+	/// \brief ReadSiftHeader: read the header of a sift file only (the number of features and the dimensions),
+	///                        the descriptors are not loaded
+	/// \param szFileName: the name of the sift file
+	/// \return
+	///
+	bool ReadSiftHeader(std::string const &szFileName)
+	{
+		FILE *fd;
+		if ((fd = fopen(szFileName.c_str(), "rb")) == nullptr) {
+			std::cerr << "[ReadSiftHeader] Can't read sift file " << szFileName << '\n';
+			return false;
+		}
+		int header[5];
+		int f = fread(header, sizeof(int), 5, fd);
+		fclose(fd);
+		if (f != 5 || header[0] != ('S'+ ('I'<<8)+('F'<<16)+('T'<<24)) || header[2] < 0) {
+			std::cerr << "[ReadSiftHeader] Reading error\n";
+			return false;
+		}
+
+		name_ = header[0];
+		version_ = header[1];
+		npoint_ = header[2];
+		nLocDim_ = header[3];
+		nDesDim_ = header[4];
+		return true;
+	}
+
 	///
 	/// \brief ConvertChar2Float: Read a char sift file and convert it to DTYPE(float/double) sift.
 	///                           The descriptors are L1 normalized and then square-rooted (RootSift)
@@ -0,0 +1,121 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef BISECTION_TREE_HPP
+#define BISECTION_TREE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "ImageGraph.hpp"
+
+namespace bluefish {
+
+// a node of the bisection tree, the images order[begin, end) of the tree
+struct BisectionNode
+{
+  uint32_t begin = 0;
+  uint32_t end = 0;
+  int32_t left = -1;          // children in the tree, -1 for a leaf
+  int32_t right = -1;
+  float cut = 0;              // similarity score of the edges between the two children
+  float ncut = 0;             // normalized cut of the bisection
+  int64_t weight = 0;         // total node weight of the images
+
+  uint32_t Size() const { return end - begin; }
+};
+
+/**
+ * @brief Recursive bisection hierarchy of an image graph. The images of every
+ *        tree node are a contiguous range of order, so the tree is stored as
+ *        the permutation and the ranges of the nodes. Any cluster size bound
+ *        is answered by cutting the tree at the largest nodes within it.
+ */
+class BisectionTree
+{
+public:
+  std::vector<uint32_t> order;        // image indices, the children of a node are consecutive
+  std::vector<BisectionNode> nodes;   // nodes[0] is the root
+  uint64_t signature = 0;             // signature of the image graph the tree is built on
+  uint32_t leafSize = 0;              // the leaves have at most leafSize images
+
+/**
+ * @brief  Signature of an image graph, independent of the order of its edges
+ * @note   Node weights and edge scores are included, so that a tree of
+ *         another graph is not reused
+ * @param  imageGraph: image graph
+ * @retval 64-bit signature
+ */
+static uint64_t Signature(const ImageGraph& imageGraph);
+
+/**
+ * @brief  Save the tree into a binary file
+ * @note
+ * @param  filename: path of the file
+ * @retval True if the file is written
+ */
+bool Save(std::string filename) const;
+
+/**
+ * @brief  Load a tree from a binary file
+ * @note
+ * @param  filename: path of the file (produced by Save function)
+ * @retval True if a valid tree is read
+ */
+bool Load(std::string filename);
+
+/**
+ * @brief  Cut the tree into the largest nodes that satisfy the bounds
+ * @note   A leaf is returned as it is, even if it exceeds the bounds
+ * @param  upper: upper bound of the number of images of a cluster
+ * @param  weightUpper: upper bound of the total weight of a cluster, 0 for no bound
+ * @retval Indices of the cut tree nodes
+ */
+std::vector<int> Cut(size_t upper, size_t weightUpper = 0) const;
+
+/**
+ * @brief  Similarity score of the edges that are cut off by the bisections above a cut
+ * @note
+ * @param  cut: tree nodes produced by Cut function
+ * @retval Sum of the cut scores of the ancestors of the cut nodes
+ */
+double CutScore(const std::vector<int>& cut) const;
+
+/**
+ * @brief  Cluster ID of every image after cutting the tree
+ * @note
+ * @param  cut: tree nodes produced by Cut function
+ * @retval Cluster results that represents the cluster ID (return[i] = k means
+ *         image i belongs to the node cut[k])
+ */
+std::vector<size_t> Labels(const std::vector<int>& cut) const;
+};
+
+}   // namespace bluefish
+
+#endif
@@ -0,0 +1,172 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLUSTER_API_HPP
+#define CLUSTER_API_HPP
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <utility>
+#include <cstdint>
+
+#include "ImageGraph.hpp"
+#include "LocalityOrder.hpp"
+
+namespace bluefish {
+
+// parameters of ClusterImages, the same as the arguments and options of GraphCluster
+struct ClusterOptions
+{
+  std::string clusterOption = "expansion";  // 'naive', 'expansion' or 'vertexcut'
+  size_t upper = 100;                       // max_img_num
+  float completeRatio = 0.7;                // completeness_ratio
+  std::string partition = "kway";           // 'kway', 'bounded' or 'community', and 'tree' or 'stream' 
+                                            // for ClusterImageFiles
+  bool labelPropagation = false;            // label propagation engine instead of kernel k-means
+  bool parallelCoarsen = false;             // parallel matching in the normalized-cut coarsening
+  OrderMethod order = ORDER_NONE;           // renumbering of the images for the partitioners
+  double resolution = 1.0;                  // resolution of the communities
+  size_t threadNum = 1;                     // threads of the partitioners, 0 for all the processors
+  size_t restartNum = 1;                    // normalized-cut restarts, the best one is kept
+  bool spectralInit = false;                // spectral initial partition of the normalized cut
+  size_t edgeBudget = 0;                    // matches kept for the normalized cut, 0 for all of them
+  bool refine = false;                      // refine the 'stream' and 'community' clusters by kernel k-means
+  bool verbose = false;                     // print the statistics of the partitioners and the expansion to cout
+  std::string outputDir;                    // directory of the image_part folders, graph.txt, clusters.txt 
+                                            // and cluster_tree.txt, empty to write nothing
+  std::string workDir;                      // directory of the normalized-cut files, the expansion checkpoints, 
+                                            // the bisection tree and the shards, empty to keep them in memory
+  double checkpointInterval = 0;            // minimum seconds between two expansion checkpoints in workDir
+  bool resume = false;                      // continue the expansion from the checkpoint in workDir
+};
+
+// files of a clustering, and the runs of ClusterImageFiles other than a plain one
+struct ClusterFiles
+{
+  std::string imageList;                    // paths of the images, one per line
+  std::string matchFile;                    // 'src dst score' lines, '-' for the standard input of a stream
+  std::string siftList;                     // sift files in the order of imageList that weight the images, 
+                                            // may be empty
+  std::string newMatches;                   // matches of new images, which are added to the clusters of a 
+                                            // previous run in outputDir
+  std::vector<std::pair<size_t, float>> sweep;  // upper and completeRatio pairs, each one is clustered from 
+                                                // the bisection tree into outputDir/sweep_<upper>_<ratio>
+  size_t shardSize = 0;                     // shards of at most this many images are clustered by worker 
+                                            // processes, 0 for none
+  size_t processNum = 2;                    // number of worker processes of the shards
+  std::vector<std::string> workerArgs;      // command line of a worker, which calls ClusterShards with the 
+                                            // shard directory that is appended to it
+};
+
+// image graph given in memory, either as an edge array or in CSR format
+struct ClusterInput
+{
+  size_t nodeNum = 0;                   // number of images
+  std::vector<uint32_t> edgeSrc;        // edge array: the i-th match is edgeSrc[i] - edgeDst[i]
+  std::vector<uint32_t> edgeDst;
+  std::vector<size_t> offsets;          // CSR: the matches of image i are neighbors[offsets[i]..offsets[i+1]), 
+  std::vector<uint32_t> neighbors;      // used when offsets is not empty
+  std::vector<float> scores;            // similarity of every match of the edge array or of the CSR
+  std::vector<std::string> imageNames;  // paths of the images, only needed by outputDir
+  std::vector<int> weights;             // weights of the images, e.g. their numbers of features, may be empty
+};
+
+// progress of ClusterImages: the stage ('partition', 'expansion', ...) and its finished share
+typedef std::function<void(const std::string&, double)> ClusterProgress;
+
+/**
+ * @brief  Build the image graph of an input
+ * @note   A match may be given once or in both directions, the matches of an image to 
+ *         itself are skipped. The node indices are the image numbers.
+ * @param  input: images and matches
+ * @param  imageGraph: image graph
+ * @param  error: reason of a failure
+ * @retval True if the input is consistent
+ */
+bool BuildClusterGraph(const ClusterInput& input, ImageGraph& imageGraph, std::string& error);
+
+/**
+ * @brief  Cluster the images of a graph in memory
+ * @note   Nothing is written to the disk unless options.outputDir or options.workDir is 
+ *         set. The clusters are lists of the node indices of the graph. A graph of at most 
+ *         options.upper images is one cluster.
+ * @param  imageGraph: image graph, the node indices are the positions of the nodes
+ * @param  options: parameters of the clusters
+ * @param  clusters: images of every cluster
+ * @param  error: reason of a failure
+ * @param  progress: called at the stages of the clustering, may be empty
+ * @retval True if the graph is clustered
+ */
+bool ClusterImages(const ImageGraph& imageGraph, const ClusterOptions& options, 
+                   std::vector<std::vector<size_t>>& clusters, std::string& error, 
+                   ClusterProgress progress = ClusterProgress());
+
+/**
+ * @brief  Cluster the images of an edge array or CSR graph in memory
+ * @note   See BuildClusterGraph and ClusterImages
+ * @param  input: images and matches
+ * @param  options: parameters of the clusters
+ * @param  clusters: image numbers of every cluster
+ * @param  error: reason of a failure
+ * @param  progress: called at the stages of the clustering, may be empty
+ * @retval True if the images are clustered
+ */
+bool ClusterImages(const ClusterInput& input, const ClusterOptions& options, 
+                   std::vector<std::vector<size_t>>& clusters, std::string& error, 
+                   ClusterProgress progress = ClusterProgress());
+
+/**
+ * @brief  Cluster the images of an image list and a match file
+ * @note   The runs of GraphCluster. A plain 'kway', 'bounded' or 'community' partition 
+ *         is the one of ClusterImages. The other runs start from the streamed clusters, 
+ *         the cut of the bisection tree in workDir or the expansion checkpoint, add new 
+ *         images, sweep the parameters or split the graph into shards, as given by files.
+ *         A sweep returns the clusters of its last pair, and incremental runs return none.
+ * @param  files: input files and runs
+ * @param  options: parameters of the clusters
+ * @param  clusters: image numbers of every cluster
+ * @param  error: reason of a failure
+ * @param  progress: called at the stages of the clustering, may be empty
+ * @retval True if the images are clustered
+ */
+bool ClusterImageFiles(const ClusterFiles& files, const ClusterOptions& options, 
+                       std::vector<std::vector<size_t>>& clusters, std::string& error, 
+                       ClusterProgress progress = ClusterProgress());
+
+/**
+ * @brief  Cluster the shards of ClusterImageFiles, in a worker process
+ * @note   Every shard is clustered by ClusterImages with the options
+ * @param  shardDir: directory of the shard files
+ * @param  options: parameters of the clusters
+ * @retval False if a shard claimed by this worker is not clustered
+ */
+bool ClusterShards(const std::string& shardDir, const ClusterOptions& options);
+
+}   // namespace bluefish
+
+#endif
@@ -0,0 +1,87 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLUSTER_EXPANSION_HPP
+#define CLUSTER_EXPANSION_HPP
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#include "ImageGraph.hpp"
+
+namespace bluefish {
+
+/**
+ * @brief Greedy expansion of the clusters over the matches that the partition 
+ *        discarded. Every cluster of either image of a discarded match is a 
+ *        candidate to take a copy of the other image. Its key is the similarity of 
+ *        the match times the share of the completeness budget that the cluster has 
+ *        left: a cluster of n images may share at most completeRatio * n images with 
+ *        the other clusters. The candidates are taken from a heap, largest key first. 
+ *        The budgets shrink as the copies are made, so a popped candidate is rescored, 
+ *        and pushed back if its key went down. A match whose images have come together 
+ *        in a cluster meanwhile is added to it. Ties are broken by the indices of the 
+ *        images and the clusters, so the result doesn't depend on the thread number. 
+ *        The candidates are taken one at a time, since every copy changes the budgets 
+ *        that the next one is scored with; the discarded matches are collected and 
+ *        the copies are added to the clusters on all the threads, a cluster per thread.
+ */
+class ClusterExpansion
+{
+public:
+  float completeRatio;        // completeness ratio
+  size_t threadNum;           // number of threads, 0 for all the processors
+
+  // statistics of the last Expand call
+  size_t discardedEdges = 0;  // number of matches whose images shared no cluster
+  size_t restoredEdges = 0;   // number of them added to a cluster
+  size_t copiedImages = 0;    // number of images copied into a cluster
+  double totalTime = 0;       // wall clock seconds
+
+/**
+ * @brief  Create an expansion
+ * @note
+ * @param  completeRatio: completeness ratio
+ * @param  threadNum: number of threads, 0 for all the processors
+ */
+ClusterExpansion(float completeRatio, size_t threadNum = 0);
+
+/**
+ * @brief  Expand the clusters with the discarded matches of the image graph
+ * @note   The images of the clusters are found in the image graph by their idx. The 
+ *         clusters are not bisected, they may grow past the size bound.
+ * @param  imageGraph: original image graph
+ * @param  clusters: clusters of the images, expanded in place
+ * @retval None
+ */
+void Expand(const ImageGraph& imageGraph, std::vector<std::shared_ptr<ImageGraph>>& clusters);
+};
+
+}   // namespace bluefish
+
+#endif
@@ -0,0 +1,146 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLUSTER_SERVER_HPP
+#define CLUSTER_SERVER_HPP
+
+#include <string>
+#include <vector>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <utility>
+
+#include "ImageGraph.hpp"
+
+namespace bluefish {
+
+// parameters of a cluster request, the defaults come from the command line of the server
+struct ClusterRequest
+{
+  std::string clusterOption = "naive";  // 'naive', 'expansion' or 'vertexcut'
+  size_t upper = 100;                   // max_img_num
+  float completeRatio = 0.7;            // completeness_ratio
+  std::string partition = "kway";       // 'kway', 'bounded' or 'community'
+  std::string engine = "graclus";       // 'graclus' or 'lp'
+  std::string order = "none";           // 'none', 'rcm' or 'bfs'
+  double resolution = 1.0;              // resolution of the communities
+  size_t threadNum = 1;                 // threads of the normalized cut of the request
+  size_t edgeBudget = 0;                // matches kept for the normalized cut, 0 for all of them
+  std::vector<size_t> images;           // subset of the images, empty for all of them
+  std::string output;                   // directory of the image_part folders, empty to only stream the clusters
+};
+
+/**
+ * @brief Resident clustering service. The image graph is loaded once and shared 
+ *        by all the requests, which come over a Unix domain socket. The connections 
+ *        are watched by poll and their cluster requests run on a pool of worker 
+ *        threads, so that an idle connection doesn't hold a worker. A request is one line:
+ *          cluster [key=value ...]   keys: option, upper, ratio, partition, engine, 
+ *                                    order, resolution, threads, budget, images, output
+ *          info                      number of images and matches of the graph
+ *          shutdown                  stop the server after the queued requests
+ *        images is a list of indices and ranges, e.g. 0-499,700,702. A cluster 
+ *        request is answered by "ok <clusters>", one line "<k> <size>: <images>" per 
+ *        cluster with the indices of the image list, and "end". A failed request is 
+ *        answered by "error <message>".
+ */
+class ClusterServer
+{
+public:
+  ClusterRequest defaults;    // parameters of the requests that don't set them
+
+/**
+ * @brief  Create a server of an image graph
+ * @note   The requests are clustered in memory by ClusterImages, only the output 
+ *         directory of a request is written
+ * @param  imageGraph: image graph, the node indices are the indices of the image list
+ * @param  workerNum: number of requests that run at the same time, 0 for all the processors
+ */
+ClusterServer(const ImageGraph& imageGraph, size_t workerNum = 0);
+
+/**
+ * @brief  Serve the requests on a Unix domain socket until a shutdown request
+ * @note   An existing socket file is replaced. The file is removed at the end. 
+ *         The requests of a connection are answered in order.
+ * @param  socketPath: path of the socket
+ * @retval False if the socket cannot be opened
+ */
+bool Serve(std::string socketPath);
+
+/**
+ * @brief  Parse a cluster request
+ * @note
+ * @param  line: request line without the leading "cluster"
+ * @param  request: parsed request, starting from the defaults
+ * @param  error: message of a parsing error
+ * @retval True if the request is valid
+ */
+bool ParseRequest(const std::string& line, ClusterRequest& request, std::string& error) const;
+
+/**
+ * @brief  Run a cluster request
+ * @note   Thread safe, the shared image graph is only read
+ * @param  request: parameters of the request
+ * @param  clusters: images of every cluster, as indices of the image list
+ * @param  error: message of a failure
+ * @retval True if the clusters are made
+ */
+bool Run(const ClusterRequest& request, std::vector<std::vector<size_t>>& clusters, std::string& error) const;
+
+private:
+/**
+ * @brief  Answer a request
+ * @note   
+ * @param  fd: socket of the connection
+ * @param  line: request line
+ * @retval False if the reply cannot be sent
+ */
+bool Handle(int fd, const std::string& line);
+
+/**
+ * @brief  Take cluster requests from the queue until the server stops
+ * @note   The socket of an answered request is given back to Serve through wakeFds
+ */
+void Work();
+
+  const ImageGraph& imageGraph;   // graph shared by the requests
+  size_t workerNum;               // number of worker threads
+  std::queue<std::pair<int, std::string>> jobs;   // cluster requests that wait for a worker, with their sockets
+  std::vector<std::pair<int, bool>> finished;     // sockets of the answered requests, false if they are broken
+  std::mutex mutex;               // guards jobs and finished
+  std::condition_variable ready;  // signals a new request or the stop
+  std::atomic<bool> stopping;     // set by a shutdown request
+  std::atomic<size_t> requestNum; // number of the cluster requests so far
+  int listenFd;                   // listening socket
+  int wakeFds[2];                 // pipe through which the workers wake the poll of Serve
+};
+
+}   // namespace bluefish
+
+#endif
@@ -0,0 +1,111 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CLUSTER_TREE_HPP
+#define CLUSTER_TREE_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "ImageGraph.hpp"
+
+namespace bluefish {
+
+// connectivity between two clusters, or two merged groups of clusters
+struct ClusterLink
+{
+  int left = -1;
+  int right = -1;
+  size_t common = 0;        // number of images in both
+  size_t matches = 0;       // number of matches with one image in each
+  double similarity = 0;    // similarity score of those matches
+};
+
+// a merge of two nodes of the tree, the leaves 0..leafNum-1 are the clusters
+struct ClusterMerge
+{
+  int node = -1;            // tree node made by the merge
+  int left = -1;
+  int right = -1;
+  int round = 0;            // the merges of a round are independent of each other
+  size_t images = 0;        // number of images of the node, with their copies
+  double similarity = 0;    // similarity between the two children
+};
+
+/**
+ * @brief Merge tree of the clusters for hierarchical reconstruction. The links 
+ *        between the clusters are collected in one pass over the matches on all 
+ *        the threads. The tree is built round by round: every round merges the 
+ *        linked pairs of nodes in the order of their average similarity, and a node 
+ *        merges at most once per round, so the merges of a round can run in parallel 
+ *        and the tree stays balanced. Nodes without links to each other stay apart, 
+ *        as the roots of a forest.
+ */
+class ClusterTree
+{
+public:
+  size_t leafNum = 0;                 // number of clusters
+  std::vector<size_t> leafSizes;      // number of images of every cluster
+  std::vector<ClusterLink> links;     // links between the clusters
+  std::vector<ClusterMerge> merges;   // merges in the order of their rounds
+
+/**
+ * @brief  Build the tree of the clusters of an image graph
+ * @note
+ * @param  imageGraph: image graph, the node indices are the positions of the nodes
+ * @param  clusters: clusters of its images, which may share images
+ * @param  threadNum: number of threads of the pass over the matches, 0 for all the processors
+ * @retval None
+ */
+void Build(const ImageGraph& imageGraph, const std::vector<std::shared_ptr<ImageGraph>>& clusters, 
+           size_t threadNum = 0);
+
+/**
+ * @brief  Number of merge rounds
+ * @note
+ * @retval Depth of the tree
+ */
+int Rounds() const { return merges.empty() ? 0 : merges.back().round + 1; }
+
+/**
+ * @brief  Save the tree into a text file
+ * @note   The first line is the number of clusters, links and merges. Then every link 
+ *         is a line "link <cluster> <cluster> <common images> <matches> <similarity>", 
+ *         and every merge a line "merge <node> <left> <right> <round> <images> <similarity>".
+ *         The clusters are numbered as in clusters.txt, the merged nodes from the 
+ *         number of clusters on.
+ * @param  filename: path of the file
+ * @retval True if the file is written
+ */
+bool Save(std::string filename) const;
+};
+
+}   // namespace bluefish
+
+#endif
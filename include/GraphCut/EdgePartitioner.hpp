@@ -0,0 +1,92 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef EDGE_PARTITIONER_HPP
+#define EDGE_PARTITIONER_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "ImageGraph.hpp"
+
+namespace bluefish {
+
+/**
+ * @brief Vertex-cut partitioner of the image graph. The matches are assigned to the 
+ *        clusters instead of the images, and an image is copied into every cluster 
+ *        that holds one of its matches, so the clusters overlap in one pass. As in 2PS, 
+ *        the images may start in the home clusters of a disjoint partition. A match 
+ *        goes to the cluster that already holds its images, preferring the copies of
+ *        the image of lower degree (HDRF), and to the emptier clusters. The clusters
+ *        have at most upper images, and at most replicaBudget images are copied 
+ *        beyond their first copy. A match that would exceed them is dropped.
+ */
+class EdgePartitioner
+{
+public:
+  size_t upper;           // upper bound of the number of images of a cluster
+  size_t replicaBudget;   // number of copies allowed beyond the first copy of every image
+  float lambda;           // weight of the balance term against the replication term
+  std::vector<int> edgeClusters;                // cluster of every match, -1 for a dropped one
+  std::vector<std::vector<uint32_t>> clusters;  // images of every cluster
+
+/**
+ * @brief  Create a partitioner
+ * @note
+ * @param  upper: upper bound of the number of images of a cluster
+ * @param  replicaBudget: number of copies allowed beyond the first copy of every image
+ * @param  lambda: weight of the balance term, 1 in HDRF
+ */
+EdgePartitioner(size_t upper, size_t replicaBudget, float lambda = 1.0);
+
+/**
+ * @brief  Assign the matches to the clusters
+ * @note   The threads take the matches in chunks, in their order. A match that finds 
+ *         no cluster with room is dropped. The images without kept matches join the 
+ *         emptiest clusters at the end, new ones are opened if they are full.
+ * @param  nodeNum: number of images, the image indices are below it
+ * @param  edges: matches between the images
+ * @param  homes: home cluster of every image, -1 or empty for none
+ * @param  clusterNum: number of clusters, including the home clusters
+ * @param  threadNum: number of threads, the result depends on the thread timing for more than one
+ * @retval None
+ */
+void Partition(size_t nodeNum, const std::vector<LinkEdge>& edges, const std::vector<int>& homes, 
+               size_t clusterNum, size_t threadNum = 1);
+
+/**
+ * @brief  Total number of image copies in the clusters
+ * @note
+ * @retval Number of images of all the clusters
+ */
+size_t Replicas() const;
+};
+
+}   // namespace bluefish
+
+#endif
@@ -30,23 +30,66 @@
 
 #include <string>
 #include <fstream>
+#include <cmath>
+#include <algorithm>
 #include <cstring>
+#include <climits>
 #include <memory>
 #include <queue>
 #include <utility>
+#include <set>
+#include <unordered_map>
+#include <functional>
 
 #include "ImageGraph.hpp"
+#include "BisectionTree.hpp"
+#include "LocalityOrder.hpp"
 
 using namespace std;
 using namespace bluefish;
 
+struct pooldef;  // memory pool of Graclus
+
 
 namespace bluefish {
+
+// statistics of the normalized-cut calls, accumulated over a run
+struct NCReport
+{
+  size_t calls = 0;           // number of normalized-cut calls
+  size_t levels = 0;          // number of multilevel levels of all calls
+  size_t kkmIterations = 0;   // number of kernel k-means iterations of all calls
+  double readTime = 0;        // wall clock seconds of the phases of all calls
+  double coarsenTime = 0;
+  double initPartTime = 0;
+  double refineTime = 0;
+  double totalTime = 0;
+  float maxNCut = 0;          // largest normalized cut of a call
+  float maxBalance = 0;       // largest cluster size over average cluster size of a call
+};
+
 class GraphCluster 
 {
 public:
   size_t graphUpper;    // upper bound of cluster size
+  size_t weightUpper;   // upper bound of the total node weight of a cluster, 0 for no bound
   float completeRatio;  // completeness ratio
+  bool parallelCoarsen; // coarsen the normalized-cut graph with the parallel matching
+  size_t threadNum;     // number of threads used by Graclus, 0 means all the processors
+  size_t restartNum;    // number of concurrent normalized-cut restarts, the best one is kept
+  bool spectralInit;    // initial partition of the coarsest graph by spectral clustering instead of METIS
+  bool labelPropagation; // partition by size-constrained label propagation instead of kernel k-means
+  NCReport ncReport;    // statistics of the NormalizedCut calls
+  double checkpointInterval;  // minimum seconds between two checkpoints of ExpanGraphCluster, 0 disables them
+  double resolution;    // resolution of the modularity of CommunityCluster
+  OrderMethod nodeOrder; // renumbering of the images in the inputs of the partitioners
+  size_t edgeBudget;    // number of matches kept for the first normalized cut by GraphSparsifier, 0 keeps all
+  std::function<void(const string&, double)> progress;  // called by ClusterGraph with a stage and its finished share, may be empty
+  bool verbose;         // print the statistics of the partitioners, the sparsifier and the expansion rounds to cout
+
+private:
+  shared_ptr<pooldef> ncPool;  // workspace of Graclus kept between normalized-cut calls
+  unordered_map<string, LocalityOrder> ncOrders;  // order of the images of every normalized-cut file
 
 public:
 
@@ -54,16 +97,38 @@ GraphCluster(size_t upper = 100, float cr = 0.7);
 
 /** 
  * @brief  Build a graph according to image list and vocabulary file(*.out)
- * @note   
+ * @note   The nodes are weighted by their numbers of features when siftList is given
  * @param  imageList: a file that stores the paths of images
- * @param  vocFile: vocabulary tree search file that store the similarity scores
+ * @param  vocFile: vocabulary tree search file that store the similarity scores, 
+ *         may be empty for a graph without edges
+ * @param  siftList: a file that stores the paths of the sift files in the order of imageList, may be empty
  * @retval ImageGraph
  */
-ImageGraph BuildGraph(string imageList, string vocFile);
+ImageGraph BuildGraph(string imageList, string vocFile, string siftList = "");
+
+/** 
+ * @brief  Add the similarity scores of a vocabulary file(*.out) to the graph as undirected edges
+ * @note   The matches of the images that are not in the graph are skipped
+ * @param  imageGraph: image graph
+ * @param  vocFile: vocabulary tree search file that store the similarity scores
+ * @retval True if the file is read
+ */
+bool ReadMatches(ImageGraph& imageGraph, string vocFile);
+
+/** 
+ * @brief  Weight the image nodes by the numbers of features in their sift files
+ * @note   Only the sift headers are read. The nodes stay unweighted if the list 
+ *         doesn't match the images.
+ * @param  imageGraph: image graph without edges
+ * @param  siftList: a file that stores the paths of the sift files in the order of the images
+ * @retval Image graph with the weighted nodes
+ */
+ImageGraph WeightNodes(ImageGraph imageGraph, string siftList);
 
 /** 
  * @brief  Generate a file that stores the result of Normalized-Cut
- * @note   
+ * @note   The images are written in the order of nodeOrder. NormalizedCut and RefineCut 
+ *         map the clusters of the file back to the images.
  * @param  imageGraph: ImageGraph that represents the similarity information of images
  * @param  dir: directory that store the normalized-cut files
  * @retval The path of the file that stores the result of Normalized-Cut
@@ -72,13 +137,129 @@ string GenerateNCGraph(ImageGraph imageGraph, string dir);
 
 /** 
  * @brief  Normalized-Cut interface that encapusulates the original algorithm of Graclus library
- * @note   
+ * @note   restartNum partitionings with different seeds are computed and the one 
+ *         with the lowest normalized cut is returned. labelPropagation selects the faster engine.
  * @param  filename: normalized-cut file (produced by GenerateNCGraph function)
  * @param  clusterNum: the number of clusters that we want to divide into.
+ * @param  maxClusterSize: hard upper bound of the cluster size (the total node weight 
+ *         for a weighted graph), 0 for no bound. It should leave some slack over the 
+ *         average cluster size.
+ * @retval Cluster results that represents the cluster ID (For example, return[0] = 1 
+ *         suggests that image 0 belongs to 1-st cluster), empty if clusterNum < 2 or 
+ *         the graph is empty
+ */
+vector<size_t> NormalizedCut(string filename, size_t clusterNum, size_t maxClusterSize = 0);  
+
+/** 
+ * @brief  Normalized-Cut of an image graph in memory, without a normalized-cut file
+ * @note   The images are passed to Graclus in the order of nodeOrder
+ * @param  imageGraph: image graph
+ * @param  clusterNum: the number of clusters that we want to divide into.
+ * @param  maxClusterSize: hard upper bound of the cluster size, 0 for no bound
+ * @retval Cluster results that represents the cluster ID (For example, return[0] = 1 
+ *         suggests that image 0 belongs to 1-st cluster), empty if clusterNum < 2 or 
+ *         the graph is empty
+ */
+vector<size_t> NormalizedCut(const ImageGraph& imageGraph, size_t clusterNum, size_t maxClusterSize = 0);
+
+/** 
+ * @brief  Partition the images in one pass over the vocabulary file, as they arrive
+ * @note   The matches must be grouped by their source images, e.g. in capture order.
+ *         Every image joins a cluster of at most graphUpper images when its matches 
+ *         are read (StreamPartitioner), the graph is never built.
+ * @param  imageList: a file that stores the paths of images
+ * @param  vocFile: vocabulary tree search file that store the similarity scores, 
+ *         "-" for the standard input
+ * @param  clusterNum: the number of clusters that are made
  * @retval Cluster results that represents the cluster ID (For example, return[0] = 1 
  *         suggests that image 0 belongs to 1-st cluster)
  */
-vector<size_t> NormalizedCut(string filename, size_t clusterNum);  
+vector<size_t> StreamCluster(string imageList, string vocFile, size_t& clusterNum);
+
+/** 
+ * @brief  Partition the images into the communities of the graph by the Leiden algorithm
+ * @note   The communities have at most graphUpper images. Their number follows from 
+ *         the graph and the resolution.
+ * @param  imageGraph: image graph
+ * @param  clusterNum: the number of communities
+ * @retval Cluster results that represents the cluster ID (For example, return[0] = 1 
+ *         suggests that image 0 belongs to 1-st cluster)
+ */
+vector<size_t> CommunityCluster(const ImageGraph& imageGraph, size_t& clusterNum);
+
+/** 
+ * @brief  Refine a partitioning by the kernel k-means of Graclus on the graph itself
+ * @note   The graph is not coarsened, so only the images at the cluster borders move
+ * @param  filename: normalized-cut file (produced by GenerateNCGraph function)
+ * @param  clusters: cluster ID of every image
+ * @param  clusterNum: the number of clusters
+ * @param  maxClusterSize: hard upper bound of the cluster size, 0 for no bound
+ * @retval Refined cluster results
+ */
+vector<size_t> RefineCut(string filename, const vector<size_t>& clusters, 
+                         size_t clusterNum, size_t maxClusterSize = 0);
+
+/** 
+ * @brief  Peak memory used by the normalized-cut workspace
+ * @note   The workspace is kept between the NormalizedCut calls
+ * @retval The largest number of bytes of the workspace in use at the same time
+ */
+size_t NCWorkspacePeak() const;
+
+/** 
+ * @brief  Print the statistics of the NormalizedCut calls
+ * @note   
+ * @retval None
+ */
+void PrintNCReport() const;
+
+/** 
+ * @brief  Sparsify the graph of the first normalized cut down to edgeBudget matches
+ * @note   The connected components are kept. The graph is returned as it is when 
+ *         edgeBudget is 0 or not smaller than its number of matches.
+ * @param  imageGraph: image graph
+ * @retval Image graph with the same nodes and the kept matches
+ */
+ImageGraph SparsifyGraph(const ImageGraph& imageGraph) const;
+
+/** 
+ * @brief  Normalized cut of a partitioning, measured on the similarity scores of a graph
+ * @note   The sum over the clusters of their cut over their association, so that the 
+ *         clusters of a sparsified graph can be compared on the whole graph
+ * @param  imageGraph: image graph
+ * @param  clusters: cluster ID of every image
+ * @retval Normalized cut
+ */
+double NCutValue(const ImageGraph& imageGraph, const vector<size_t>& clusters) const;
+
+/** 
+ * @brief  Print the number of images and the total weight of every cluster
+ * @note   The weight of a cluster is its number of features when the nodes are weighted
+ * @param  imageGraphs: clusters in the order of their image_part folders
+ * @retval None
+ */
+void PrintClusterWeights(const vector<shared_ptr<ImageGraph>>& imageGraphs) const;
+
+/** 
+ * @brief  Print the overlap of the clusters
+ * @note   The replication factor is the number of copies of an image on average, the 
+ *         kept similarity is the share of the similarity of the matches whose images 
+ *         are together in a cluster
+ * @param  imageGraph: original image graph
+ * @param  imageGraphs: clusters of its images
+ * @retval None
+ */
+void PrintOverlap(const ImageGraph& imageGraph, const vector<shared_ptr<ImageGraph>>& imageGraphs) const;
+
+/** 
+ * @brief  Save the merge tree of the clusters into cluster_tree.txt
+ * @note   See ClusterTree for the file format
+ * @param  imageGraph: original image graph
+ * @param  imageGraphs: clusters in the order of their image_part folders
+ * @param  dir: output directory
+ * @retval None
+ */
+void SaveClusterTree(const ImageGraph& imageGraph, const vector<shared_ptr<ImageGraph>>& imageGraphs, string dir) const;
 
 /** 
  * @brief  Move images into different clusters
@@ -107,6 +288,44 @@ void MoveImages(vector<shared_ptr<ImageGraph>> imageGraphs, string dir);
  */
 pair<shared_ptr<ImageGraph>, shared_ptr<ImageGraph>> BiPartition(ImageGraph imageGraph, string dir); 
 
+/** 
+ * @brief  Judge if a cluster must be divided again
+ * @note   
+ * @param  imageGraph: image graph of the cluster
+ * @retval True if it has more than graphUpper nodes or more than weightUpper weight
+ */
+bool Oversized(const ImageGraph& imageGraph) const;
+
+/** 
+ * @brief  Bisect the image graph recursively into a bisection tree
+ * @note   Every bisection is a normalized cut (BiPartition function)
+ * @param  imageGraph: image graph
+ * @param  dir: directory that stores the normalized-cut files
+ * @param  leafSize: the graphs of at most leafSize images are not bisected
+ * @retval Bisection tree of the image graph
+ */
+BisectionTree BuildBisectionTree(ImageGraph imageGraph, string dir, size_t leafSize);
+
+/** 
+ * @brief  Load the bisection tree of the image graph from dir/bisection_tree.bin
+ * @note   The tree is built and saved if the file doesn't exist, belongs to another
+ *         graph or has leaves larger than leafSize
+ * @param  imageGraph: image graph
+ * @param  dir: directory of the tree file and the normalized-cut files
+ * @param  leafSize: the largest leaf size that is accepted
+ * @retval Bisection tree of the image graph
+ */
+BisectionTree LoadBisectionTree(ImageGraph imageGraph, string dir, size_t leafSize);
+
+/** 
+ * @brief  Cut the bisection tree into clusters within graphUpper (and weightUpper)
+ * @note   
+ * @param  imageGraph: image graph the tree is built on
+ * @param  tree: bisection tree
+ * @retval A list of sub-imageGraphs
+ */
+queue<shared_ptr<ImageGraph>> CutBisectionTree(ImageGraph imageGraph, const BisectionTree& tree);
+
 /** 
  * @brief  Judge if graphs has "edge"
  * @note   
@@ -126,50 +345,80 @@ bool HasEdge(vector<shared_ptr<ImageGraph>> graphs, LinkEdge edge);
 bool HasEdge(queue<shared_ptr<ImageGraph>> graphs, LinkEdge edge);
 
 /** 
- * @brief  Collect discarded edges in graph division
- * @note   
- * @param  imageGraph: the complete image graph before graph cluster
- * @param  insizeGraphs: graphs that node size less than graphUpper
- * @param  candidateGraphs: candidate graphs that node size may less than graphUpper
- * @retval An priority_queue that store all the discarded edges in graph division
- */
-priority_queue<LinkEdge> DiscardedEdges(ImageGraph imageGraph, 
-                                        vector<shared_ptr<ImageGraph>> insizeGraphs, 
-                                        queue<shared_ptr<ImageGraph>> candidateGraphs);
-
-/** 
- * @brief  Select a image graph randomly which satisfy the completeness ratio
- * @note   
- * @param  imageGraph: image graph
- * @param  graphs: a list of image graphs
- * @param  edge: edge between nodes
- * @retval Unselected node and the image graph that the selected node belongs to
+ * @brief  Save the state of ExpanGraphCluster at the beginning of a round
+ * @note   The file is written to a temporary file first and renamed, so that a crash 
+ *         while writing leaves the previous checkpoint
+ * @param  filename: path of the checkpoint file
+ * @param  imageGraph: original image graph
+ * @param  insizeGraphs: clusters that satisfy the size constraint
+ * @param  candidateGraphs: clusters that are still to be bisected
+ * @param  round: the number of finished rounds
+ * @retval True if the checkpoint is written
  */
-pair<ImageNode, shared_ptr<ImageGraph>> SelectCRGraph(ImageGraph imageGraph, 
-                                                      vector<shared_ptr<ImageGraph>> graphs, 
-                                                      LinkEdge edge); 
+bool SaveCheckpoint(string filename, const ImageGraph& imageGraph, 
+                    const vector<shared_ptr<ImageGraph>>& insizeGraphs, 
+                    queue<shared_ptr<ImageGraph>> candidateGraphs, size_t round);
 
 /** 
- * @brief  Count the number of common images between two clusters
- * @note   
- * @param  imageGraphL: left image graph
- * @param  imageGraphR: right image graph
- * @retval The number of common images between two clusters
+ * @brief  Load the state of ExpanGraphCluster saved by SaveCheckpoint
+ * @note   The checkpoint must belong to the same image graph, graphUpper and completeRatio
+ * @param  filename: path of the checkpoint file
+ * @param  imageGraph: original image graph
+ * @param  insizeGraphs: clusters that satisfy the size constraint
+ * @param  candidateGraphs: clusters that are still to be bisected
+ * @param  round: the number of finished rounds
+ * @retval True if a valid checkpoint is read
  */
-int RepeatedNodeNum(const ImageGraph imageGraphL, const ImageGraph imageGraphR); 
+bool LoadCheckpoint(string filename, const ImageGraph& imageGraph, 
+                    vector<shared_ptr<ImageGraph>>& insizeGraphs, 
+                    queue<shared_ptr<ImageGraph>>& candidateGraphs, size_t& round);
 
 /** 
  * @brief  Graph Cluster that uses the graph expansion algorithm
- * @note   
+ * @note   The discarded matches are restored by ClusterExpansion on threadNum threads, 
+ *         the result doesn't depend on the time or the threads. The state is saved into 
+ *         dir/expansion_checkpoint.bin at the round boundaries, at most every 
+ *         checkpointInterval seconds. The file is removed at the end.
  * @param  imageGraph: original image graph
  * @param  imageGraphs: initial image graphs that divided with no common images
  * @param  dir: directory to store normalized-cut files
  * @param  clusterNum: the number of clusters that divided into
+ * @param  resume: continue from the checkpoint in dir instead of imageGraphs
  * @retval A list of image graphs after expansion-graph-cluster algorithm
  */
 vector<shared_ptr<ImageGraph>> ExpanGraphCluster(ImageGraph imageGraph, 
                                                 queue<shared_ptr<ImageGraph>> imageGraphs, 
-                                                string dir, size_t clusterNum); 
+                                                string dir, size_t clusterNum, bool resume = false); 
+
+/** 
+ * @brief  Add the new images of the image graph to the clusters of a previous run
+ * @note   The previous clusters are read from dir/graph.txt, the images that are in none of 
+ *         them are new. Every new image joins its best connected cluster by the new matches, 
+ *         the new images without a match to the collection make clusters of at most 
+ *         graphUpper images. Only the previous matches between the images of the touched 
+ *         clusters are kept from vocFile. These images are bisected and expanded again, 
+ *         and only the folders of the changed clusters are written again. graph.txt and 
+ *         clusters.txt are updated.
+ * @param  imageGraph: images of the previous run and the new ones, with the new matches only
+ * @param  vocFile: matches of the previous run
+ * @param  dir: directory of the previous cluster result
+ * @retval True if the clusters are updated
+ */
+bool IncrementalGraphCluster(const ImageGraph& imageGraph, string vocFile, string dir);
+
+/** 
+ * @brief  Graph cluster that assigns the matches to the clusters instead of the images
+ * @note   The images start in their initial clusters and are copied into the clusters 
+ *         of their matches (EdgePartitioner), which replaces the expansion. At most 
+ *         completeRatio times the number of images are copied.
+ * @param  imageGraph: original image graph
+ * @param  imageGraphs: initial image graphs that divided with no common images
+ * @param  clusterNum: the number of clusters, some of them may start empty
+ * @retval A list of image graphs of at most graphUpper images
+ */
+vector<shared_ptr<ImageGraph>> VertexCutCluster(const ImageGraph& imageGraph, 
+                                                queue<shared_ptr<ImageGraph>> imageGraphs, 
+                                                size_t clusterNum);
 
 /** 
  * @brief  Naive graph cluster algorithm (all the clusters have no common images)
@@ -194,6 +443,43 @@ vector<shared_ptr<ImageGraph>> NaiveGraphCluster(queue<shared_ptr<ImageGraph>> i
 queue<shared_ptr<ImageGraph>> ConstructSubGraphs(ImageGraph imageGraph, 
                                                 vector<size_t> clusters, 
                                                 size_t clusterNum); 
+
+/** 
+ * @brief  Set weightUpper to the weight of graphUpper images of average weight
+ * @note   weightUpper is 0 for an unweighted graph
+ * @param  imageGraph: image graph
+ */
+void SetWeightUpper(const ImageGraph& imageGraph);
+
+/** 
+ * @brief  Choose the number of clusters and the cluster bound of the first partition
+ * @note   The vertex cut leaves room for the copied images and the bounded partition 
+ *         leaves some slack over the average cluster size. A weighted graph is bounded 
+ *         by weight and weightUpper is set.
+ * @param  imageGraph: image graph
+ * @param  clusterOption: 'naive', 'expansion' or 'vertexcut'
+ * @param  partition: 'kway', 'bounded' or 'community'
+ * @param  maxClusterSize: bound of the cluster size (or weight) for NormalizedCut, 0 for no bound
+ * @retval Number of clusters, at least 2 if the graph has more than graphUpper images. 
+ *         It is 1 for the communities, whose number is found by CommunityCluster.
+ */
+size_t ClusterNumber(const ImageGraph& imageGraph, string clusterOption, string partition, 
+                     size_t& maxClusterSize);
+
+/** 
+ * @brief  Cluster an image graph from the first partition to the final clusters
+ * @note   The number and the bounds of the clusters are chosen by ClusterNumber, 
+ *         weightUpper is set for a weighted graph. No image is moved. The stages 
+ *         are reported to progress.
+ * @param  imageGraph: image graph, the node indices are the positions of the nodes
+ * @param  clusterOption: 'naive', 'expansion' or 'vertexcut'
+ * @param  partition: 'kway', 'bounded' or 'community'
+ * @param  dir: directory that stores the normalized-cut files, empty to cut the 
+ *         graph in memory and write no file
+ * @retval A list of image graphs, the empty clusters are left out
+ */
+vector<shared_ptr<ImageGraph>> ClusterGraph(const ImageGraph& imageGraph, string clusterOption, 
+                                            string partition, string dir);
 };
 
 }   // namespace bluefish
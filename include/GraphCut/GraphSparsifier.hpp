@@ -0,0 +1,85 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef GRAPH_SPARSIFIER_HPP
+#define GRAPH_SPARSIFIER_HPP
+
+#include <vector>
+#include <cstddef>
+
+#include "ImageGraph.hpp"
+
+namespace bluefish {
+
+/**
+ * @brief Edge sparsification of an image graph before the normalized cut. Dense 
+ *        match files hold many redundant matches that hardly change the cut but 
+ *        dominate the coarsening time and memory of Graclus. Every image ranks its 
+ *        matches by similarity and keeps its best ceil(degree^alpha) of them (local 
+ *        degree sparsification). A match is kept from the smallest alpha at which 
+ *        one of its images keeps it, so the matches are sorted by that alpha and 
+ *        the edge budget takes them in order. The maximum spanning forest by 
+ *        similarity is always kept, so the connected components don't change and 
+ *        stay linked by their strongest matches. The ranking and the sorts run on 
+ *        all the threads, the forest (Kruskal) and the graph that is returned are 
+ *        built on one thread.
+ */
+class GraphSparsifier
+{
+public:
+  size_t edgeBudget;          // number of matches to keep
+  size_t threadNum;           // number of threads, 0 for all the processors
+
+  // statistics of the last Sparsify call
+  size_t inputEdges = 0;      // number of matches of the graph
+  size_t keptEdges = 0;       // number of matches kept
+  size_t forestEdges = 0;     // number of matches of the spanning forest
+  size_t components = 0;      // number of connected components
+  double keptSimilarity = 0;  // share of the similarity of the kept matches
+  double totalTime = 0;       // wall clock seconds
+
+/**
+ * @brief  Create a sparsifier
+ * @note
+ * @param  edgeBudget: number of matches to keep, the spanning forest is kept even 
+ *         if it is larger
+ * @param  threadNum: number of threads, 0 for all the processors
+ */
+GraphSparsifier(size_t edgeBudget, size_t threadNum = 0);
+
+/**
+ * @brief  Sparsify an image graph
+ * @note   A graph that has at most edgeBudget matches is returned as it is
+ * @param  imageGraph: image graph
+ * @retval Image graph with the same nodes and the kept matches
+ */
+ImageGraph Sparsify(const ImageGraph& imageGraph);
+};
+
+}   // namespace bluefish
+
+#endif
@@ -0,0 +1,141 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef LOCALITY_ORDER_HPP
+#define LOCALITY_ORDER_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "ImageGraph.hpp"
+
+namespace bluefish {
+
+// renumbering of the images before partitioning
+enum OrderMethod
+{
+  ORDER_NONE = 0,   // the order of the image list
+  ORDER_RCM,        // reverse Cuthill-McKee
+  ORDER_BFS         // breadth-first from the images of highest degree
+};
+
+/**
+ * @brief Locality-improving order of the images of a graph. The images of the 
+ *        image list are usually in the order of their file names, so the matched 
+ *        images are scattered over the arrays of the partitioners. Numbered by 
+ *        this order, the matches of an image point to nearby positions, and the 
+ *        passes over the nodes and edges hit the cache more often. The labels 
+ *        that are computed on the renumbered graph are mapped back by image.
+ */
+class LocalityOrder
+{
+public:
+  std::vector<uint32_t> order;   // order[k] is the image at position k, empty for the identity
+  std::vector<uint32_t> rank;    // rank[i] is the position of image i
+
+/**
+ * @brief  Compute the order of the images of a graph
+ * @note   Reverse Cuthill-McKee starts every connected component at a pseudo-peripheral 
+ *         image and visits the neighbors by increasing degree, then reverses the whole 
+ *         order. The BFS order starts at the image of highest degree and visits the 
+ *         neighbors by decreasing degree.
+ * @param  imageGraph: image graph
+ * @param  method: ordering method, ORDER_NONE leaves the order empty
+ */
+LocalityOrder(const ImageGraph& imageGraph, OrderMethod method);
+
+/**
+ * @brief  Compute the order of the images of a graph given by its edge maps
+ * @note
+ * @param  edgeMaps: edges of every image, as returned by ImageGraph::GetEdgeMap
+ * @param  method: ordering method, ORDER_NONE leaves the order empty
+ */
+LocalityOrder(const std::vector<EdgeMap>& edgeMaps, OrderMethod method);
+
+/**
+ * @brief  Judge if the order is the identity
+ * @note
+ * @retval True if no order is computed
+ */
+bool Empty() const { return order.empty(); }
+
+/**
+ * @brief  Average distance between the positions of the images of a match
+ * @note   The smaller it is, the closer the matched images are in memory
+ * @param  edgeMaps: edges of every image, as returned by ImageGraph::GetEdgeMap
+ * @param  rank: position of every image, empty for the order of the image list
+ * @retval Average distance over the edges
+ */
+static double EdgeSpan(const std::vector<EdgeMap>& edgeMaps, const std::vector<uint32_t>& rank);
+
+/**
+ * @brief  Map the labels of the positions back to the images
+ * @note
+ * @param  labels: labels[k] belongs to the image at position k
+ * @retval Labels of the images in the order of the image list
+ */
+template <typename T>
+std::vector<T> ToImages(const std::vector<T>& labels) const
+{
+  if(order.empty()) return labels;
+  std::vector<T> mapped(labels.size());
+  for(size_t k = 0; k < labels.size() && k < order.size(); k++) {
+    mapped[order[k]] = labels[k];
+  }
+  return mapped;
+}
+
+/**
+ * @brief  Map the labels of the images to their positions
+ * @note
+ * @param  labels: labels[i] belongs to image i
+ * @retval Labels in the order of the positions
+ */
+template <typename T>
+std::vector<T> ToPositions(const std::vector<T>& labels) const
+{
+  if(order.empty()) return labels;
+  std::vector<T> mapped(labels.size());
+  for(size_t k = 0; k < labels.size() && k < order.size(); k++) {
+    mapped[k] = labels[order[k]];
+  }
+  return mapped;
+}
+};
+
+/**
+ * @brief  Name of an ordering method
+ * @note
+ * @param  method: ordering method
+ * @retval "none", "rcm" or "bfs"
+ */
+const char* OrderName(OrderMethod method);
+
+}   // namespace bluefish
+
+#endif
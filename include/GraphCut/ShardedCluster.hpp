@@ -0,0 +1,121 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SHARDED_CLUSTER_HPP
+#define SHARDED_CLUSTER_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "ImageGraph.hpp"
+
+namespace bluefish {
+
+struct ClusterOptions;
+
+/**
+ * @brief Clustering of a graph that doesn't fit into one process. The images are 
+ *        split into shards of at most shardSize images by one streaming pass over 
+ *        the matches (StreamPartitioner), and the matches inside every shard are 
+ *        written into a binary shard file by a second pass, without building the 
+ *        image graph. Worker processes claim the shards from the shard directory by 
+ *        creating their lock files, cluster them and write their clusters next to 
+ *        them. The clusters of all the shards are merged at the end. The matches 
+ *        between the shards are lost, the streaming pass keeps them few.
+ */
+class ShardedCluster
+{
+public:
+  std::string shardDir;   // directory of the shard files, the job queue
+  size_t shardSize;       // upper bound of the number of images of a shard
+  size_t processNum;      // number of worker processes
+
+/**
+ * @brief  Create a sharded clustering
+ * @note
+ * @param  shardDir: directory of the shard files, it is created if needed
+ * @param  shardSize: upper bound of the number of images of a shard
+ * @param  processNum: number of worker processes
+ */
+ShardedCluster(std::string shardDir, size_t shardSize, size_t processNum);
+
+/**
+ * @brief  Split the images into shards and write the shard files
+ * @note   The vocabulary file is read twice. The files of a previous split are removed.
+ * @param  imageList: a file that stores the paths of images
+ * @param  vocFile: vocabulary tree search file that store the similarity scores
+ * @param  siftList: sift files in the order of imageList to weight the images, may be empty
+ * @retval Number of shards, 0 if the files cannot be read or written
+ */
+size_t Split(std::string imageList, std::string vocFile, std::string siftList = "");
+
+/**
+ * @brief  Run worker processes until every shard is clustered
+ * @note   Every worker runs the program with workerArgs. The shards whose worker died, 
+ *         or exited without writing their clusters, are unlocked and given to a second 
+ *         round of workers.
+ * @param  workerArgs: command line of a worker, workerArgs[0] is the program
+ * @retval True if the clusters of all the shards are written
+ */
+bool RunWorkers(const std::vector<std::string>& workerArgs);
+
+/**
+ * @brief  Merge the clusters of the shards
+ * @note   The nodes of the merged clusters are numbered by the image list, they have no edges
+ * @retval Clusters of all the shards, in the order of the shards
+ */
+std::vector<std::shared_ptr<ImageGraph>> Merge() const;
+
+/**
+ * @brief  Claim and cluster shards until none is left
+ * @note   Called by the worker processes. A shard that cannot be clustered keeps its lock.
+ * @param  shardDir: directory of the shard files
+ * @param  options: parameters of the clusters of ClusterImages, without the output
+ * @retval False if a shard claimed by this worker is not clustered
+ */
+static bool Work(std::string shardDir, const ClusterOptions& options);
+
+/**
+ * @brief  Load a shard file
+ * @note   The nodes are numbered from 0 in the shard graph
+ * @param  filename: path of the shard file
+ * @param  imageGraph: graph of the images of the shard and their matches
+ * @param  images: index of every node in the image list
+ * @retval True if a valid shard is read
+ */
+static bool LoadShard(std::string filename, ImageGraph& imageGraph, std::vector<uint32_t>& images);
+
+private:
+  size_t shardNum = 0;                // number of shards of the last split
+  std::vector<ImageNode> imageNodes;  // images of the image list, for the merge
+};
+
+}   // namespace bluefish
+
+#endif
@@ -0,0 +1,119 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef STREAM_PARTITIONER_HPP
+#define STREAM_PARTITIONER_HPP
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <set>
+#include <unordered_map>
+
+namespace bluefish {
+
+/**
+ * @brief One-pass partitioner of images that arrive with their matches, e.g. in
+ *        capture order while the similarity search is still running. Every image
+ *        joins a cluster when it arrives, by a Fennel objective: the similarity 
+ *        to the images of the cluster minus a penalty that grows with the cluster 
+ *        size. No cluster grows past the size bound. Only the cluster of every 
+ *        image and the matches to the images that have not arrived yet are kept.
+ */
+class StreamPartitioner
+{
+public:
+  size_t upper;         // upper bound of the cluster size
+  float gamma;          // exponent of the size penalty of Fennel
+
+/**
+ * @brief  Create a partitioner for at most nodeNum images
+ * @note
+ * @param  nodeNum: number of images, the image indices are below it
+ * @param  upper: upper bound of the cluster size
+ * @param  gamma: exponent of the size penalty, 1.5 in Fennel
+ */
+StreamPartitioner(size_t nodeNum, size_t upper, float gamma = 1.5);
+
+/**
+ * @brief  Assign an arriving image to a cluster
+ * @note   The matches to the images that have not arrived are kept until they 
+ *         arrive. An image that has arrived before only leaves its new matches.
+ * @param  node: index of the image
+ * @param  edges: matches of the image as (image index, similarity score)
+ * @retval Cluster ID of the image
+ */
+int Add(size_t node, const std::vector<std::pair<size_t, float>>& edges);
+
+/**
+ * @brief  Assign the images that have not arrived at the end of the stream
+ * @note   They arrive in the order of their indices, with the matches kept for them
+ * @retval Number of the images that are assigned
+ */
+size_t Finish();
+
+/**
+ * @brief  Cluster ID of every image
+ * @note
+ * @retval Cluster IDs, -1 for the images that have not arrived before Finish
+ */
+const std::vector<int>& Labels() const { return labels; }
+
+/**
+ * @brief  Number of clusters
+ * @note
+ * @retval Number of clusters
+ */
+size_t ClusterNum() const { return sizes.size(); }
+
+/**
+ * @brief  Number of the matches that are kept for the images that have not arrived
+ * @note
+ * @retval Size of the frontier
+ */
+size_t FrontierSize() const { return frontierSize; }
+
+private:
+/**
+ * @brief  Put an image into a cluster and update the clusters that have room
+ * @note   cluster == ClusterNum() opens a new cluster
+ */
+void Assign(size_t node, int cluster);
+
+  size_t nodeNum;             // number of images
+  std::vector<int> labels;    // cluster ID of every image, -1 before it arrives
+  std::vector<size_t> sizes;  // number of images of every cluster
+  std::unordered_map<size_t, std::vector<std::pair<size_t, float>>> frontier;  // matches of the images that have not arrived
+  size_t frontierSize = 0;    // number of matches in frontier
+  size_t arrived = 0;         // number of images that have arrived
+  double weightSum = 0;       // total similarity of the matches of the arrived images
+  std::set<std::pair<size_t, int>> open;   // (size, cluster ID) of the clusters that have room
+};
+
+}   // namespace bluefish
+
+#endif
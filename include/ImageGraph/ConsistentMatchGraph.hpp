@@ -45,6 +45,8 @@ private:
     MatchGraph _tripletGraph;   // a match graph after triplet expansion
     MatchGraph _finalGraph;     // final match graph after component merging
     size_t** _generalGraph;     // a general adjacent matrix
+    std::vector<int> _communities;  // community of every node of the triplet graph
+    size_t _communityNum = 0;       // number of communities
 
     /**
      * @brief Construct nodes of match graph from other image graph
@@ -57,14 +59,13 @@ private:
      * @return a priority queue ordered by edge weight
      */
     priority_queue<LinkEdge> OrderEdge(const ImageGraph g) const;
-    /** TODO
-     * @brief
-     * 
+    /**
+     * @brief Split the triplet graph into communities by the Leiden algorithm
      */
     void ComputeCommunityStructure();
-    /** TODO
-     * @brief
-     * 
+    /**
+     * @brief Collect the matches of the triplet graph between different communities
+     * @return a priority queue of the matches ordered by edge weight
      */
     priority_queue<LinkEdge> CreateCandidateMatchSet(); 
     /** TODO
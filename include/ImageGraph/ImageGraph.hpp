@@ -78,7 +78,9 @@ namespace bluefish
 		int idx;                    //!< the optional original index (maybe in the image_list)
 		std::string image_name;     //!< the image name
 		std::string sift_name;      //!< the sift name
-		ImageNode(int idx_ = -1, const std::string &iname = "", const std::string &sname = ""): idx(idx_), image_name(iname), sift_name(sname) {}
+		int weight;                 //!< the weight of the node in partition balancing (e.g. its number of features)
+		ImageNode(int idx_ = -1, const std::string &iname = "", const std::string &sname = "", int weight_ = 1): 
+			idx(idx_), image_name(iname), sift_name(sname), weight(weight_) {}
 
 		//! Copy constructor
 		ImageNode(const ImageNode & node)
@@ -86,6 +88,7 @@ namespace bluefish
 			idx = node.idx;
 			image_name = node.image_name;
 			sift_name = node.sift_name;
+			weight = node.weight;
 		}
 	};
 
@@ -138,9 +141,17 @@ namespace bluefish
 		int NodeNum();
 		int GetEdgeSize() const;
 		int GetNodeSize() const;
+		//! Brief the sum of the node weights
+		long long GetWeight() const;
+		//! Brief true if some node weight is not 1
+		bool IsWeighted() const;
 		ImageNode GetNode(int idx) const;
 		std::vector<ImageNode> GetImageNode() const;
 		std::vector<EdgeMap> GetEdgeMap() const;
+		//! Brief the adjacency maps without a copy, valid while the graph is not changed
+		const std::vector<EdgeMap>& EdgeMaps() const;
+		//! Brief the nodes without a copy, valid while the graph is not changed
+		const std::vector<ImageNode>& ImageNodes() const;
 		std::vector<size_t> ShortestPath(size_t src, size_t dst) const;
 		int Map2CurrentIdx(int idx);
 
@@ -0,0 +1,93 @@
+/** 
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification, 
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, 
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice, 
+  this list of conditions and the following disclaimer 
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may 
+  be used to endorse or promote products derived from this software without specific 
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, 
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef LEIDEN_H
+#define LEIDEN_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "ImageGraph.hpp"
+
+namespace bluefish{
+
+// Algorithm used in this class comes from
+// "Traag V A, Waltman L, van Eck N J. From Louvain to Leiden: guaranteeing well-connected 
+// communities[J]. Scientific Reports, 2019, 9(1): 5233."
+// The local moving runs on all the threads at once, as in the parallel Louvain of
+// "Lu H, Halappanavar M, Kalyanaraman A. Parallel heuristics for scalable community 
+// detection[J]. Parallel Computing, 2015, 47: 19-37."
+class LeidenCommunity
+{
+private:
+    size_t _communityNum;   // number of communities of the last Compute
+    double _modularity;     // modularity of the last Compute
+    size_t _levels;         // number of aggregation levels of the last Compute
+
+public:
+    double resolution;      // resolution of the modularity, the communities get smaller as it grows
+    size_t maxSize;         // upper bound of the number of nodes of a community, 0 for no bound
+    size_t threadNum;       // number of threads, 0 for all the processors
+    unsigned int seed;      // seed of the node orders
+
+    LeidenCommunity(double resolution = 1.0, size_t maxSize = 0, size_t threadNum = 0, unsigned int seed = 0);
+    /**
+     * @brief Detect the communities of an image graph by weighted modularity
+     * @param g: image graph, the edge scores are the weights
+     * @param order: the nodes are numbered order[0], order[1], ... inside, so that 
+     *        matched nodes are close in memory. Empty for the order of the graph.
+     * @return community ID of every node, from 0 to CommunityNum() - 1
+     */
+    std::vector<int> Compute(const ImageGraph& g, const std::vector<uint32_t>& order = std::vector<uint32_t>());
+    /**
+     * @brief Detect the communities of a graph in CSR format
+     * @param nodeNum: number of nodes
+     * @param xadj: the edges of node i are adjncy[xadj[i]] to adjncy[xadj[i + 1] - 1]
+     * @param adjncy: adjacent nodes, every edge is stored in both directions
+     * @param adjwgt: edge weights
+     * @return community ID of every node, from 0 to CommunityNum() - 1
+     */
+    std::vector<int> Compute(size_t nodeNum, const std::vector<size_t>& xadj, 
+                             const std::vector<uint32_t>& adjncy, const std::vector<float>& adjwgt);
+    /**
+     * @brief Get the number of communities of the last Compute
+     */
+    size_t CommunityNum() const { return _communityNum; }
+    /**
+     * @brief Get the modularity of the last Compute, with the resolution
+     */
+    double Modularity() const { return _modularity; }
+    /**
+     * @brief Get the number of aggregation levels of the last Compute
+     */
+    size_t Levels() const { return _levels; }
+};
+
+}   // namespace bluefish
+
+#endif
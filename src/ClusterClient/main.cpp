@@ -0,0 +1,272 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Test client of the cluster server of GraphCluster (-S). Every thread opens its own 
+// connection and sends all the requests, starting at a different one, so that the 
+// requests overlap on the server. The replies are checked and the latencies printed.
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+// connection to the server with a line reader
+class Connection
+{
+public:
+    Connection(const string& socketPath)
+    {
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd >= 0 && connect(fd, (sockaddr *)&address, sizeof(address)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    ~Connection()
+    {
+        if(fd >= 0) close(fd);
+    }
+    bool IsOpen() const { return fd >= 0; }
+
+    bool Send(const string& line)
+    {
+        string buffer = line + "\n";
+        size_t sent = 0;
+        while(sent < buffer.size()) {
+            ssize_t n = send(fd, buffer.data() + sent, buffer.size() - sent, MSG_NOSIGNAL);
+            if(n <= 0) return false;
+            sent += n;
+        }
+        return true;
+    }
+
+    bool ReadLine(string& line)
+    {
+        size_t newline;
+        char chunk[4096];
+        while((newline = buffer.find('\n')) == string::npos) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if(n <= 0) return false;
+            buffer.append(chunk, n);
+        }
+        line = buffer.substr(0, newline);
+        buffer.erase(0, newline + 1);
+        return true;
+    }
+
+private:
+    int fd;
+    string buffer;
+};
+
+// result of one cluster request
+struct Reply
+{
+    bool ok = false;
+    string message;                   // error or check failure
+    vector<vector<size_t>> clusters;
+    double seconds = 0;
+};
+
+// images of the images= parameter of a request, all the images if there is none
+static set<size_t> RequestedImages(const string& request, size_t nodeNum)
+{
+    set<size_t> images;
+    size_t pos = request.find("images=");
+    if(pos == string::npos) {
+        for(size_t i = 0; i < nodeNum; i++) images.insert(i);
+        return images;
+    }
+    string list = request.substr(pos + 7);
+    list = list.substr(0, list.find(' '));
+    stringstream list_in(list);
+    string item;
+    while(getline(list_in, item, ',')) {
+        size_t first = strtoul(item.c_str(), NULL, 10), last = first;
+        if(item.find('-') != string::npos) last = strtoul(item.c_str() + item.find('-') + 1, NULL, 10);
+        for(size_t i = first; i <= last; i++) images.insert(i);
+    }
+    return images;
+}
+
+static Reply SendRequest(Connection& connection, const string& request, size_t nodeNum)
+{
+    Reply reply;
+    auto start = chrono::steady_clock::now();
+    string line;
+    if(!connection.Send(request) || !connection.ReadLine(line)) {
+        reply.message = "connection lost";
+        return reply;
+    }
+    if(line.compare(0, 3, "ok ") != 0) {
+        reply.message = line;
+        return reply;
+    }
+    size_t cluster_num = strtoul(line.c_str() + 3, NULL, 10);
+    for(size_t k = 0; k < cluster_num; k++) {
+        if(!connection.ReadLine(line)) {
+            reply.message = "connection lost";
+            return reply;
+        }
+        stringstream line_in(line.substr(line.find(':') + 1));
+        vector<size_t> cluster;
+        size_t image;
+        while(line_in >> image) cluster.push_back(image);
+        reply.clusters.push_back(cluster);
+    }
+    if(!connection.ReadLine(line) || line != "end") {
+        reply.message = "missing end of the reply";
+        return reply;
+    }
+    reply.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Every requested image is in a cluster, and no other image
+    set<size_t> requested = RequestedImages(request, nodeNum), covered;
+    for(auto& cluster : reply.clusters) {
+        for(size_t image : cluster) {
+            if(!requested.count(image)) {
+                reply.message = "image " + to_string(image) + " was not requested";
+                return reply;
+            }
+            covered.insert(image);
+        }
+    }
+    if(covered.size() != requested.size()) {
+        reply.message = to_string(requested.size() - covered.size()) + " images are in no cluster";
+        return reply;
+    }
+    reply.ok = true;
+    return reply;
+}
+
+int main(int argc, char ** argv)
+{
+    if(argc < 4) {
+        cout << "Usage: " << argv[0] << " socket_path concurrency request [request ...]\n" <<
+                "  e.g. " << argv[0] << " /tmp/gc.sock 8 \"cluster\" \"cluster option=expansion upper=50\" " <<
+                "\"cluster images=0-499 output=/tmp/part\" shutdown\n" <<
+                "  A 'shutdown' request is sent once after all the others.\n";
+        return 0;
+    }
+    string socket_path(argv[1]);
+    int concurrency = max(atoi(argv[2]), 1);
+    vector<string> requests;
+    bool stop_server = false;
+    for(int i = 3; i < argc; i++) {
+        if(string(argv[i]) == "shutdown") stop_server = true;
+        else requests.push_back(argv[i]);
+    }
+
+    size_t node_num = 0;
+    {
+        Connection connection(socket_path);
+        string line;
+        if(!connection.IsOpen() || !connection.Send("info") || !connection.ReadLine(line) || 
+           line.compare(0, 3, "ok ") != 0) {
+            cerr << "Server " << socket_path << " cannot be reached!" << endl;
+            return 1;
+        }
+        node_num = strtoul(line.c_str() + 3, NULL, 10);
+        cout << "server: " << line.substr(3) << " (images matches)" << endl;
+    }
+
+    mutex result_mutex;
+    vector<vector<Reply>> replies(requests.size());
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for(int t = 0; t < concurrency; t++) {
+        threads.push_back(thread([&, t]() {
+            Connection connection(socket_path);
+            for(size_t r = 0; r < requests.size(); r++) {
+                size_t q = (r + t) % requests.size();
+                Reply reply;
+                if(!connection.IsOpen()) reply.message = "cannot connect";
+                else reply = SendRequest(connection, requests[q], node_num);
+                lock_guard<mutex> lock(result_mutex);
+                replies[q].push_back(reply);
+            }
+        }));
+    }
+    for(auto& thread : threads) thread.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    int failures = 0;
+    for(size_t q = 0; q < requests.size(); q++) {
+        double total = 0, worst = 0;
+        size_t ok = 0, max_size = 0;
+        set<vector<vector<size_t>>> distinct;
+        for(auto& reply : replies[q]) {
+            if(!reply.ok) {
+                cerr << "  \"" << requests[q] << "\": " << reply.message << endl;
+                failures++;
+                continue;
+            }
+            ok++;
+            total += reply.seconds;
+            worst = max(worst, reply.seconds);
+            for(auto& cluster : reply.clusters) max_size = max(max_size, cluster.size());
+            distinct.insert(reply.clusters);
+        }
+        cout << "\"" << requests[q] << "\": " << ok << "/" << replies[q].size() << " ok";
+        if(ok > 0) {
+            cout << ", " << replies[q][0].clusters.size() << " clusters, largest " << max_size 
+                 << ", " << distinct.size() << " distinct results, latency " << total / ok 
+                 << "s average, " << worst << "s worst";
+        }
+        cout << endl;
+    }
+    cout << requests.size() * concurrency << " requests on " << concurrency << " connections in " 
+         << seconds << "s, " << failures << " failed" << endl;
+
+    if(stop_server) {
+        Connection connection(socket_path);
+        string line;
+        if(!connection.IsOpen() || !connection.Send("shutdown") || !connection.ReadLine(line)) {
+            cerr << "Server cannot be stopped!" << endl;
+            return 1;
+        }
+    }
+    return failures > 0 ? 1 : 0;
+}
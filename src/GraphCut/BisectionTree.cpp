@@ -0,0 +1,199 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "BisectionTree.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace bluefish {
+
+// "GCBT" and the version of the file layout
+static const uint32_t kTreeMagic = 0x54424347;
+static const uint32_t kTreeVersion = 1;
+
+static uint64_t Mix(uint64_t x)
+{
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t BisectionTree::Signature(const ImageGraph& imageGraph)
+{
+    std::vector<ImageNode> nodes = imageGraph.GetImageNode();
+    std::vector<EdgeMap> edge_maps = imageGraph.GetEdgeMap();
+    uint64_t signature = Mix(nodes.size());
+
+    // The terms are summed, so that the order of the hash maps doesn't matter
+    for(size_t i = 0; i < nodes.size(); i++) {
+        signature += Mix((i << 32) ^ (uint32_t)nodes[i].weight);
+        for(EdgeMap::const_iterator it = edge_maps[i].begin(); it != edge_maps[i].end(); it++) {
+            uint32_t score;
+            memcpy(&score, &it->second.score, sizeof(score));
+            signature += Mix(Mix(((uint64_t)i << 32) | (uint32_t)it->first) ^ score);
+        }
+    }
+    return signature;
+}
+
+bool BisectionTree::Save(std::string filename) const
+{
+    FILE *fd = fopen(filename.c_str(), "wb");
+    if(fd == NULL) {
+        std::cerr << "Bisection tree " << filename << " cannot be created!" << std::endl;
+        return false;
+    }
+
+    uint32_t header[5] = {kTreeMagic, kTreeVersion, (uint32_t)order.size(), (uint32_t)nodes.size(), leafSize};
+    bool ok = fwrite(header, sizeof(uint32_t), 5, fd) == 5 &&
+              fwrite(&signature, sizeof(uint64_t), 1, fd) == 1 &&
+              fwrite(order.data(), sizeof(uint32_t), order.size(), fd) == order.size();
+    for(size_t i = 0; ok && i < nodes.size(); i++) {
+        const BisectionNode& n = nodes[i];
+        ok = fwrite(&n.begin, sizeof(n.begin), 1, fd) == 1 && fwrite(&n.end, sizeof(n.end), 1, fd) == 1 &&
+             fwrite(&n.left, sizeof(n.left), 1, fd) == 1 && fwrite(&n.right, sizeof(n.right), 1, fd) == 1 &&
+             fwrite(&n.cut, sizeof(n.cut), 1, fd) == 1 && fwrite(&n.ncut, sizeof(n.ncut), 1, fd) == 1 &&
+             fwrite(&n.weight, sizeof(n.weight), 1, fd) == 1;
+    }
+    fclose(fd);
+
+    if(!ok) {
+        std::cerr << "Bisection tree " << filename << " cannot be written!" << std::endl;
+    }
+    return ok;
+}
+
+bool BisectionTree::Load(std::string filename)
+{
+    FILE *fd = fopen(filename.c_str(), "rb");
+    if(fd == NULL) {
+        return false;
+    }
+
+    uint32_t header[5];
+    bool ok = fread(header, sizeof(uint32_t), 5, fd) == 5 && header[0] == kTreeMagic &&
+              header[1] == kTreeVersion && fread(&signature, sizeof(uint64_t), 1, fd) == 1;
+    if(ok) {
+        order.resize(header[2]);
+        nodes.resize(header[3]);
+        leafSize = header[4];
+        ok = fread(order.data(), sizeof(uint32_t), order.size(), fd) == order.size();
+        for(size_t i = 0; ok && i < order.size(); i++) {
+            ok = order[i] < order.size();
+        }
+    }
+    for(size_t i = 0; ok && i < nodes.size(); i++) {
+        BisectionNode& n = nodes[i];
+        ok = fread(&n.begin, sizeof(n.begin), 1, fd) == 1 && fread(&n.end, sizeof(n.end), 1, fd) == 1 &&
+             fread(&n.left, sizeof(n.left), 1, fd) == 1 && fread(&n.right, sizeof(n.right), 1, fd) == 1 &&
+             fread(&n.cut, sizeof(n.cut), 1, fd) == 1 && fread(&n.ncut, sizeof(n.ncut), 1, fd) == 1 &&
+             fread(&n.weight, sizeof(n.weight), 1, fd) == 1;
+        // A corrupted file must not send Cut out of the arrays
+        ok = ok && n.begin <= n.end && n.end <= order.size() &&
+             n.left < (int32_t)nodes.size() && n.right < (int32_t)nodes.size() &&
+             (n.left == -1) == (n.right == -1) && (n.left == -1 || (n.left > (int32_t)i && n.right > (int32_t)i));
+    }
+    fclose(fd);
+
+    if(!ok || nodes.empty()) {
+        std::cerr << "Bisection tree " << filename << " is not valid, it is rebuilt" << std::endl;
+        order.clear();
+        nodes.clear();
+        return false;
+    }
+    return true;
+}
+
+std::vector<int> BisectionTree::Cut(size_t upper, size_t weightUpper) const
+{
+    std::vector<int> cut, stack;
+
+    if(!nodes.empty()) {
+        stack.push_back(0);
+    }
+    while(!stack.empty()) {
+        int k = stack.back();
+        stack.pop_back();
+        const BisectionNode& n = nodes[k];
+        bool oversized = n.Size() > upper || (weightUpper > 0 && n.weight > (int64_t)weightUpper);
+        if(oversized && n.left != -1) {
+            // right first, so that the clusters come out in the order of the images
+            stack.push_back(n.right);
+            stack.push_back(n.left);
+        }
+        else {
+            cut.push_back(k);
+        }
+    }
+    return cut;
+}
+
+double BisectionTree::CutScore(const std::vector<int>& cut) const
+{
+    // The ancestors of the cut nodes are the nodes whose range is split by the cut
+    std::vector<bool> is_cut(nodes.size(), false);
+    for(size_t k = 0; k < cut.size(); k++) {
+        is_cut[cut[k]] = true;
+    }
+
+    double score = 0;
+    std::vector<int> stack;
+    if(!nodes.empty()) {
+        stack.push_back(0);
+    }
+    while(!stack.empty()) {
+        const BisectionNode& n = nodes[stack.back()];
+        bool leaf = is_cut[stack.back()] || n.left == -1;
+        stack.pop_back();
+        if(!leaf) {
+            score += n.cut;
+            stack.push_back(n.left);
+            stack.push_back(n.right);
+        }
+    }
+    return score;
+}
+
+std::vector<size_t> BisectionTree::Labels(const std::vector<int>& cut) const
+{
+    std::vector<size_t> labels(order.size(), 0);
+    for(size_t k = 0; k < cut.size(); k++) {
+        const BisectionNode& n = nodes[cut[k]];
+        for(uint32_t i = n.begin; i < n.end; i++) {
+            labels[order[i]] = k;
+        }
+    }
+    return labels;
+}
+
+}   // namespace bluefish
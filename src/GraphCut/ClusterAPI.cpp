@@ -0,0 +1,507 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ClusterAPI.hpp"
+#include "GraphCluster.hpp"
+#include "ShardedCluster.hpp"
+
+#include "stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <sstream>
+
+namespace bluefish {
+
+bool BuildClusterGraph(const ClusterInput& input, ImageGraph& imageGraph, std::string& error)
+{
+    size_t node_num = input.nodeNum;
+    bool csr = !input.offsets.empty();
+    size_t edge_num = csr ? input.neighbors.size() : input.edgeSrc.size();
+    if(node_num > (size_t)INT_MAX) {
+        error = "too many images";
+        return false;
+    }
+    if(!input.imageNames.empty() && input.imageNames.size() != node_num) {
+        error = "the number of image names is not the number of images";
+        return false;
+    }
+    if(!input.weights.empty() && input.weights.size() != node_num) {
+        error = "the number of weights is not the number of images";
+        return false;
+    }
+    if(csr && (input.offsets.size() != node_num + 1 || input.offsets.back() != edge_num)) {
+        error = "the offsets don't match the neighbors";
+        return false;
+    }
+    if(!csr && input.edgeDst.size() != edge_num) {
+        error = "the edge array has more sources than destinations";
+        return false;
+    }
+    if(!input.scores.empty() && input.scores.size() != edge_num) {
+        error = "the number of scores is not the number of matches";
+        return false;
+    }
+
+    imageGraph = ImageGraph();
+    for(size_t i = 0; i < node_num; i++) {
+        imageGraph.AddNode(ImageNode(i, input.imageNames.empty() ? "" : input.imageNames[i], "", 
+                                     input.weights.empty() ? 1 : input.weights[i]));
+    }
+    size_t src = 0;
+    for(size_t e = 0; e < edge_num; e++) {
+        if(csr) {
+            while(input.offsets[src + 1] <= e) {
+                src++;
+            }
+        }
+        else {
+            src = input.edgeSrc[e];
+        }
+        size_t dst = csr ? input.neighbors[e] : input.edgeDst[e];
+        if(src >= node_num || dst >= node_num) {
+            error = "match " + std::to_string(e) + " refers to an image that doesn't exist";
+            return false;
+        }
+        if(src != dst) {
+            imageGraph.AddEdgeu(src, dst, input.scores.empty() ? 1.0 : input.scores[e]);
+        }
+    }
+    return true;
+}
+
+// GraphCluster with the parameters of the options
+static void ConfigureCluster(GraphCluster& graphCluster, const ClusterOptions& options, ClusterProgress progress)
+{
+    graphCluster.threadNum = options.threadNum;
+    graphCluster.restartNum = options.restartNum;
+    graphCluster.parallelCoarsen = options.parallelCoarsen;
+    graphCluster.spectralInit = options.spectralInit;
+    graphCluster.labelPropagation = options.labelPropagation;
+    graphCluster.nodeOrder = options.order;
+    graphCluster.resolution = options.resolution;
+    graphCluster.edgeBudget = options.edgeBudget;
+    graphCluster.checkpointInterval = options.workDir.empty() ? 0 : options.checkpointInterval;
+    graphCluster.verbose = options.verbose;
+    graphCluster.progress = progress;
+}
+
+// The options that every clustering checks, 'tree' and 'stream' are only read from files
+static bool CheckOptions(const ClusterOptions& options, bool files, std::string& error)
+{
+    if(options.clusterOption != "naive" && options.clusterOption != "expansion" && 
+       options.clusterOption != "vertexcut") {
+        error = "unknown cluster option " + options.clusterOption;
+        return false;
+    }
+    if(options.partition != "kway" && options.partition != "bounded" && options.partition != "community" && 
+       (!files || (options.partition != "tree" && options.partition != "stream"))) {
+        error = "unknown partition " + options.partition;
+        return false;
+    }
+    if(options.upper == 0) {
+        error = "the cluster size must be positive";
+        return false;
+    }
+    if(options.resume && options.clusterOption != "expansion") {
+        error = "only the expansion can be resumed";
+        return false;
+    }
+    if(options.clusterOption == "vertexcut" && options.partition != "kway" && options.partition != "bounded") {
+        error = "the vertex cut starts from the 'kway' or 'bounded' normalized cut";
+        return false;
+    }
+    if(options.partition == "stream" && options.resume) {
+        error = "the stream partition cannot be resumed";
+        return false;
+    }
+    if((options.resume || options.partition == "tree" || 
+        (options.refine && (options.partition == "stream" || options.partition == "community"))) && 
+       options.workDir.empty()) {
+        error = "the checkpoint, the bisection tree and the refinement need a work directory";
+        return false;
+    }
+    return true;
+}
+
+// Clusters of the graph. A plain partition is the one of ClusterGraph, the others start 
+// from the checkpoint, the bisection tree, the stream labels or the refined communities.
+static bool RunClusters(GraphCluster& graphCluster, const ImageGraph& imageGraph, const ClusterOptions& options, 
+                        const std::vector<size_t>& streamLabels, size_t streamNum, 
+                        std::vector<std::shared_ptr<ImageGraph>>& result, std::string& error)
+{
+    size_t node_num = imageGraph.GetNodeSize();
+    bool stream = (options.partition == "stream");
+    if(options.verbose) {
+        std::cout << "nodes: " << node_num << std::endl;
+        std::cout << "graphUpper: " << graphCluster.graphUpper << std::endl;
+    }
+    result.clear();
+    if(node_num == 0) {
+        return true;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if(node_num <= graphCluster.graphUpper && !options.resume) {
+        if(options.verbose) {
+            std::cout << "size of graphs less than cluster size, camera cluster is the origin one\n";
+        }
+        result.push_back(std::make_shared<ImageGraph>(imageGraph));
+        return true;
+    }
+
+    bool plain = !options.resume && (options.partition == "kway" || options.partition == "bounded" || 
+                                     (options.partition == "community" && !options.refine));
+    if(plain) {
+        result = graphCluster.ClusterGraph(imageGraph, options.clusterOption, options.partition, options.workDir);
+    }
+    else {
+        size_t clust_num = streamNum, max_clust_size = 0;
+        if(!stream) {
+            clust_num = graphCluster.ClusterNumber(imageGraph, options.clusterOption, options.partition, max_clust_size);
+        }
+        std::queue<std::shared_ptr<ImageGraph>> sub_image_graphs;
+        if(options.resume) {
+            // The initial clusters are in the checkpoint
+        }
+        else if(options.partition == "tree") {
+            BisectionTree tree = graphCluster.LoadBisectionTree(imageGraph, options.workDir, graphCluster.graphUpper);
+            sub_image_graphs = graphCluster.CutBisectionTree(imageGraph, tree);
+            clust_num = sub_image_graphs.size();
+        }
+        else {
+            std::vector<size_t> labels = stream ? streamLabels : graphCluster.CommunityCluster(imageGraph, clust_num);
+            if(options.refine) {
+                // Like the normalized cut, the refinement doesn't bound the cluster size
+                std::string nc_graph = graphCluster.GenerateNCGraph(imageGraph, options.workDir);
+                labels = graphCluster.RefineCut(nc_graph, labels, clust_num, max_clust_size);
+            }
+            if(labels.size() != node_num) {
+                error = "the graph cannot be partitioned";
+                return false;
+            }
+            sub_image_graphs = graphCluster.ConstructSubGraphs(imageGraph, labels, clust_num);
+        }
+
+        if(options.clusterOption == "expansion") {
+            result = graphCluster.ExpanGraphCluster(imageGraph, sub_image_graphs, options.workDir, clust_num, 
+                                                    options.resume);
+        }
+        else if(options.clusterOption == "vertexcut") {
+            result = graphCluster.VertexCutCluster(imageGraph, sub_image_graphs, clust_num);
+        }
+        else {
+            for(; !sub_image_graphs.empty(); sub_image_graphs.pop()) {
+                if(sub_image_graphs.front()->GetNodeSize() > 0) {
+                    result.push_back(sub_image_graphs.front());
+                }
+            }
+        }
+    }
+    if(result.empty()) {
+        error = "the graph cannot be partitioned";
+        return false;
+    }
+    if(options.verbose) {
+        std::cout << options.clusterOption << " clusters in " 
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s" << std::endl;
+    }
+    return true;
+}
+
+// The image numbers of the clusters, printed and written as the options say
+static bool FinishClusters(GraphCluster& graphCluster, const ImageGraph& imageGraph, 
+                           const std::vector<std::shared_ptr<ImageGraph>>& result, const ClusterOptions& options, 
+                           std::vector<std::vector<size_t>>& clusters, std::string& error)
+{
+    clusters.clear();
+    for(auto cluster : result) {
+        std::vector<size_t> members;
+        for(const ImageNode& node : cluster->ImageNodes()) {
+            members.push_back(node.idx);
+        }
+        clusters.push_back(members);
+    }
+    if(options.verbose && options.clusterOption != "naive" && result.size() > 1) {
+        graphCluster.PrintOverlap(imageGraph, result);
+    }
+    if(!options.outputDir.empty()) {
+        if(!stlplus::folder_exists(options.outputDir) && !stlplus::folder_create(options.outputDir)) {
+            error = options.outputDir + " cannot be created";
+            return false;
+        }
+        graphCluster.MoveImages(result, options.outputDir);
+        graphCluster.SaveClusterTree(imageGraph, result, options.outputDir);
+    }
+    if(options.verbose && result.size() > 1) {
+        graphCluster.PrintNCReport();
+    }
+    return true;
+}
+
+bool ClusterImages(const ImageGraph& imageGraph, const ClusterOptions& options, 
+                   std::vector<std::vector<size_t>>& clusters, std::string& error, 
+                   ClusterProgress progress)
+{
+    if(!CheckOptions(options, false, error)) {
+        return false;
+    }
+    if(options.partition == "community" && imageGraph.IsWeighted()) {
+        error = "the communities are bounded by their numbers of images, they cannot be weighted";
+        return false;
+    }
+
+    GraphCluster graph_cluster(options.upper, options.completeRatio);
+    ConfigureCluster(graph_cluster, options, progress);
+    std::vector<std::shared_ptr<ImageGraph>> result;
+    if(!RunClusters(graph_cluster, imageGraph, options, std::vector<size_t>(), 0, result, error) || 
+       !FinishClusters(graph_cluster, imageGraph, result, options, clusters, error)) {
+        return false;
+    }
+    if(progress) {
+        progress("done", 1.0);
+    }
+    return true;
+}
+
+bool ClusterImages(const ClusterInput& input, const ClusterOptions& options, 
+                   std::vector<std::vector<size_t>>& clusters, std::string& error, 
+                   ClusterProgress progress)
+{
+    ImageGraph image_graph;
+    if(!BuildClusterGraph(input, image_graph, error)) {
+        return false;
+    }
+    return ClusterImages(image_graph, options, clusters, error, progress);
+}
+
+// The runs of ClusterImageFiles that the options and the files don't support together
+static bool CheckFiles(const ClusterFiles& files, const ClusterOptions& options, std::string& error)
+{
+    bool stream = (options.partition == "stream");
+    if(!files.newMatches.empty() && options.clusterOption != "expansion") {
+        error = "only the expansion can be run incrementally";
+    }
+    else if(options.clusterOption == "vertexcut" && !files.sweep.empty()) {
+        error = "the vertex cut starts from the normalized cut, it cannot be swept";
+    }
+    else if(options.partition == "community" && !files.siftList.empty()) {
+        error = "the communities are bounded by their numbers of images, they cannot be weighted";
+    }
+    else if(stream && (!files.newMatches.empty() || !files.sweep.empty() || !files.siftList.empty())) {
+        error = "the stream partition cannot be swept, weighted or run incrementally";
+    }
+    else if(stream && files.matchFile == "-" && (options.refine || options.clusterOption == "expansion")) {
+        error = "the refinement and the expansion read the matches again, they cannot come from the standard input";
+    }
+    else if(files.shardSize > 0 && 
+            (stream || options.resume || !files.newMatches.empty() || !files.sweep.empty() || 
+             options.partition == "tree" || options.refine || files.matchFile == "-")) {
+        error = "the shards are clustered by 'kway', 'bounded' or 'community' partitions, they cannot be "
+                "streamed, resumed, swept, refined, cut from a tree, run incrementally or read from the standard input";
+    }
+    else if((files.shardSize > 0 || !files.sweep.empty()) && options.workDir.empty()) {
+        error = "the shards and the sweep need a work directory";
+    }
+    else if((!files.newMatches.empty() || !files.sweep.empty() || files.shardSize > 0) && options.outputDir.empty()) {
+        error = "the incremental run, the sweep and the shards need an output directory";
+    }
+    return error.empty();
+}
+
+// Every pair of the sweep is cut from the same bisection tree, only the expansion is run again
+static bool SweepClusters(GraphCluster& graphCluster, const ImageGraph& imageGraph, const ClusterFiles& files, 
+                          const ClusterOptions& options, std::vector<std::vector<size_t>>& clusters, std::string& error)
+{
+    size_t leaf_size = files.sweep[0].first;
+    for(auto param : files.sweep) {
+        leaf_size = std::min(leaf_size, param.first);
+    }
+    BisectionTree tree = graphCluster.LoadBisectionTree(imageGraph, options.workDir, leaf_size);
+
+    std::vector<std::string> reports;
+    for(auto param : files.sweep) {
+        graphCluster.graphUpper = param.first;
+        graphCluster.completeRatio = param.second;
+        graphCluster.SetWeightUpper(imageGraph);
+        std::stringstream name;
+        name << "sweep_" << param.first << "_" << param.second;
+        std::string sweep_dir = options.outputDir + "/" + name.str();
+        if(!stlplus::folder_exists(sweep_dir) && !stlplus::folder_create(sweep_dir)) {
+            error = sweep_dir + " cannot be created";
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::queue<std::shared_ptr<ImageGraph>> sub_image_graphs = graphCluster.CutBisectionTree(imageGraph, tree);
+        std::vector<std::shared_ptr<ImageGraph>> result;
+        if(options.clusterOption == "expansion") {
+            result = graphCluster.ExpanGraphCluster(imageGraph, sub_image_graphs, sweep_dir, sub_image_graphs.size());
+        }
+        else {
+            for(; !sub_image_graphs.empty(); sub_image_graphs.pop()) {
+                result.push_back(sub_image_graphs.front());
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        graphCluster.MoveImages(result, sweep_dir);
+        graphCluster.SaveClusterTree(imageGraph, result, sweep_dir);
+
+        size_t images = 0, max_size = 0;
+        clusters.clear();
+        for(auto cluster : result) {
+            images += cluster->GetNodeSize();
+            max_size = std::max(max_size, (size_t)cluster->GetNodeSize());
+            std::vector<size_t> members;
+            for(const ImageNode& node : cluster->ImageNodes()) {
+                members.push_back(node.idx);
+            }
+            clusters.push_back(members);
+        }
+        std::stringstream report;
+        report << "  " << name.str() << ": " << result.size() << " clusters, largest " << max_size 
+               << " images, " << images << " images with the repeated ones, " << seconds << "s";
+        reports.push_back(report.str());
+    }
+
+    if(options.verbose) {
+        std::cout << "sweep:\n";
+        for(auto report : reports) {
+            std::cout << report << "\n";
+        }
+        graphCluster.PrintNCReport();
+    }
+    return true;
+}
+
+// The shards are clustered by worker processes, which call ClusterShards
+static bool ShardClusters(GraphCluster& graphCluster, const ClusterFiles& files, const ClusterOptions& options, 
+                          std::vector<std::vector<size_t>>& clusters, std::string& error)
+{
+    auto start = std::chrono::steady_clock::now();
+    ShardedCluster sharded(options.workDir + "/shards", files.shardSize, files.processNum);
+    if(sharded.Split(files.imageList, files.matchFile, files.siftList) == 0) {
+        error = "the images cannot be split into shards";
+        return false;
+    }
+    std::vector<std::string> worker_args = files.workerArgs;
+    worker_args.push_back(sharded.shardDir);
+    if(files.workerArgs.empty() || !sharded.RunWorkers(worker_args)) {
+        error = "the shards are not all clustered";
+        return false;
+    }
+    std::vector<std::shared_ptr<ImageGraph>> result = sharded.Merge();
+    if(options.verbose) {
+        std::cout << "sharded clusters in " 
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s" << std::endl;
+    }
+    clusters.clear();
+    for(auto cluster : result) {
+        std::vector<size_t> members;
+        for(const ImageNode& node : cluster->ImageNodes()) {
+            members.push_back(node.idx);
+        }
+        clusters.push_back(members);
+    }
+    graphCluster.MoveImages(result, options.outputDir);
+    return true;
+}
+
+bool ClusterImageFiles(const ClusterFiles& files, const ClusterOptions& options, 
+                       std::vector<std::vector<size_t>>& clusters, std::string& error, 
+                       ClusterProgress progress)
+{
+    if(!CheckOptions(options, true, error) || !CheckFiles(files, options, error)) {
+        return false;
+    }
+    if(!options.outputDir.empty() && !stlplus::folder_exists(options.outputDir) && 
+       !stlplus::folder_create(options.outputDir)) {
+        error = options.outputDir + " cannot be created";
+        return false;
+    }
+    GraphCluster graph_cluster(options.upper, options.completeRatio);
+    ConfigureCluster(graph_cluster, options, progress);
+    clusters.clear();
+    if(files.shardSize > 0) {
+        return ShardClusters(graph_cluster, files, options, clusters, error);
+    }
+
+    bool stream = (options.partition == "stream");
+    size_t stream_num = 0;
+    std::vector<size_t> stream_labels;
+    if(stream) {
+        // The image graph is not needed by the naive clusters, they are kept from the stream
+        stream_labels = graph_cluster.StreamCluster(files.imageList, files.matchFile, stream_num);
+        if(stream_labels.empty()) {
+            error = "the images cannot be streamed";
+            return false;
+        }
+    }
+    if(!files.newMatches.empty()) {
+        // Only the new matches are read into the graph, the previous ones of the touched 
+        // clusters are read from the match file
+        ImageGraph new_graph = graph_cluster.BuildGraph(files.imageList, "", files.siftList);
+        graph_cluster.SetWeightUpper(new_graph);
+        bool updated = graph_cluster.ReadMatches(new_graph, files.newMatches) && 
+                       graph_cluster.IncrementalGraphCluster(new_graph, files.matchFile, options.outputDir);
+        if(options.verbose) {
+            graph_cluster.PrintNCReport();
+        }
+        if(!updated) {
+            error = "the clusters of " + options.outputDir + " cannot be updated";
+        }
+        return updated;
+    }
+
+    bool need_edges = !stream || options.refine || options.clusterOption == "expansion";
+    ImageGraph image_graph = graph_cluster.BuildGraph(files.imageList, need_edges ? files.matchFile : "", 
+                                                      files.siftList);
+    if(image_graph.GetNodeSize() == 0) {
+        error = "the image list has no images";
+        return false;
+    }
+    if(!files.sweep.empty()) {
+        return SweepClusters(graph_cluster, image_graph, files, options, clusters, error);
+    }
+
+    std::vector<std::shared_ptr<ImageGraph>> result;
+    if(!RunClusters(graph_cluster, image_graph, options, stream_labels, stream_num, result, error) || 
+       !FinishClusters(graph_cluster, image_graph, result, options, clusters, error)) {
+        return false;
+    }
+    if(progress) {
+        progress("done", 1.0);
+    }
+    return true;
+}
+
+bool ClusterShards(const std::string& shardDir, const ClusterOptions& options)
+{
+    return ShardedCluster::Work(shardDir, options);
+}
+
+}   // namespace bluefish
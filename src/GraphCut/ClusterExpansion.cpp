@@ -0,0 +1,279 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ClusterExpansion.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+
+namespace bluefish {
+
+// The pass over the matches gives every thread blocks of this many images
+static const size_t kNodeBlock = 4096;
+
+// A match between the images at the positions src and dst, or between the 
+// local indices src and dst of a cluster
+struct ExpansionEdge
+{
+    float score;
+    uint32_t src;
+    uint32_t dst;
+};
+
+// A cluster that may take a copy of an image of a discarded match. The key is the 
+// similarity of the match times the share of the completeness budget that the 
+// cluster had left when the key was computed.
+struct ExpansionCandidate
+{
+    float key;
+    uint32_t edge;      // index of the match in the discarded matches
+    uint32_t cluster;   // cluster that takes the copy
+    uint32_t side;      // 0 if the cluster holds src and dst is copied, 1 for the opposite
+};
+
+// A cluster that holds an image, with the local index of the image in the cluster
+struct Membership
+{
+    uint32_t cluster;
+    uint32_t local;
+};
+
+// Run body(t) for t in [0, threadNum) on threadNum threads
+static void ParallelRun(size_t threadNum, const std::function<void(size_t)>& body)
+{
+    std::vector<std::thread> threads;
+    for(size_t t = 1; t < threadNum; t++) {
+        threads.push_back(std::thread(body, t));
+    }
+    body(0);
+    for(auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Share of the completeness budget of a cluster that is left, negative if the cluster
+// shares more than completeRatio times its size with the other clusters
+static double BudgetShare(float completeRatio, size_t size, size_t shared)
+{
+    double budget = completeRatio * size;
+    if(budget <= 0) {
+        return shared == 0 ? 1.0 : -1.0;
+    }
+    return (budget - (double)shared) / budget;
+}
+
+// The first cluster that holds both images, -1 if there is none
+static int CommonCluster(const std::vector<Membership>& srcClusters, const std::vector<Membership>& dstClusters, 
+                         const Membership** srcMember, const Membership** dstMember)
+{
+    for(const Membership& a : srcClusters) {
+        for(const Membership& b : dstClusters) {
+            if(a.cluster == b.cluster) {
+                *srcMember = &a;
+                *dstMember = &b;
+                return a.cluster;
+            }
+        }
+    }
+    return -1;
+}
+
+ClusterExpansion::ClusterExpansion(float completeRatio, size_t threadNum)
+{
+    this->completeRatio = completeRatio;
+    this->threadNum = threadNum;
+}
+
+void ClusterExpansion::Expand(const ImageGraph& imageGraph, std::vector<std::shared_ptr<ImageGraph>>& clusters)
+{
+    auto start = std::chrono::steady_clock::now();
+    discardedEdges = 0;
+    restoredEdges = 0;
+    copiedImages = 0;
+
+    const std::vector<EdgeMap>& edge_maps = imageGraph.EdgeMaps();
+    std::vector<ImageNode> nodes = imageGraph.GetImageNode();
+    size_t node_num = nodes.size();
+    size_t cluster_num = clusters.size();
+    size_t thread_num = threadNum > 0 ? threadNum : std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::unordered_map<int, uint32_t> position;
+    for(uint32_t i = 0; i < node_num; i++) {
+        position[nodes[i].idx] = i;
+    }
+
+    // The clusters of every image, and the number of images every cluster shares 
+    // with the other clusters, counted once for every other cluster
+    std::vector<std::vector<Membership>> member_of(node_num);
+    std::vector<size_t> sizes(cluster_num);
+    for(uint32_t c = 0; c < cluster_num; c++) {
+        std::vector<ImageNode> cluster_nodes = clusters[c]->GetImageNode();
+        sizes[c] = cluster_nodes.size();
+        for(uint32_t l = 0; l < cluster_nodes.size(); l++) {
+            auto it = position.find(cluster_nodes[l].idx);
+            if(it != position.end()) {
+                member_of[it->second].push_back(Membership{c, l});
+            }
+        }
+    }
+    std::vector<size_t> shared(cluster_num, 0);
+    for(size_t u = 0; u < node_num; u++) {
+        for(const Membership& m : member_of[u]) {
+            shared[m.cluster] += member_of[u].size() - 1;
+        }
+    }
+
+    // The matches of images that share no cluster are discarded, the blocks of 
+    // images are collected on all the threads and joined in their order
+    size_t block_num = (node_num + kNodeBlock - 1) / kNodeBlock;
+    std::vector<std::vector<ExpansionEdge>> block_edges(block_num);
+    std::atomic<size_t> next_block(0);
+    ParallelRun(std::max((size_t)1, std::min(thread_num, block_num)), [&](size_t) {
+        const Membership *src_member, *dst_member;
+        for(size_t b; (b = next_block++) < block_num; ) {
+            for(size_t u = b * kNodeBlock; u < std::min((b + 1) * kNodeBlock, node_num); u++) {
+                for(EdgeMap::const_iterator it = edge_maps[u].begin(); it != edge_maps[u].end(); it++) {
+                    size_t v = it->first;
+                    if(v > u && CommonCluster(member_of[u], member_of[v], &src_member, &dst_member) == -1) {
+                        block_edges[b].push_back(ExpansionEdge{it->second.score, (uint32_t)u, (uint32_t)v});
+                    }
+                }
+            }
+        }
+    });
+    std::vector<ExpansionEdge> discarded;
+    for(auto& edges : block_edges) {
+        discarded.insert(discarded.end(), edges.begin(), edges.end());
+        std::vector<ExpansionEdge>().swap(edges);
+    }
+    discardedEdges = discarded.size();
+
+    // Every cluster of either image of a discarded match is a candidate to take a copy 
+    // of the other image. The heap pops the largest key, then the strongest match, the 
+    // lowest images and the lowest cluster, so that the order is unique.
+    auto pops_after = [&discarded](const ExpansionCandidate& a, const ExpansionCandidate& b) {
+        if(a.key != b.key) return a.key < b.key;
+        const ExpansionEdge& x = discarded[a.edge];
+        const ExpansionEdge& y = discarded[b.edge];
+        if(x.score != y.score) return x.score < y.score;
+        if(x.src != y.src) return x.src > y.src;
+        if(x.dst != y.dst) return x.dst > y.dst;
+        return a.cluster > b.cluster;
+    };
+    std::vector<ExpansionCandidate> candidates;
+    for(uint32_t e = 0; e < discarded.size(); e++) {
+        for(uint32_t side = 0; side < 2; side++) {
+            uint32_t holder = side == 0 ? discarded[e].src : discarded[e].dst;
+            for(const Membership& m : member_of[holder]) {
+                double share = BudgetShare(completeRatio, sizes[m.cluster], shared[m.cluster]);
+                if(share >= 0) {
+                    candidates.push_back(ExpansionCandidate{(float)(discarded[e].score * share), e, m.cluster, side});
+                }
+            }
+        }
+    }
+    std::priority_queue<ExpansionCandidate, std::vector<ExpansionCandidate>, decltype(pops_after)> 
+        heap(pops_after, std::move(candidates));
+
+    // The budgets only shrink as the copies are made (for completeRatio <= 1), so the 
+    // key of a candidate is rescored when it is popped, and the candidate is pushed 
+    // back if its key went down. A candidate whose key holds is the best one left.
+    std::vector<std::vector<uint32_t>> added_nodes(cluster_num);
+    std::vector<std::vector<ExpansionEdge>> added_edges(cluster_num);
+    std::vector<bool> restored(discarded.size(), false);
+    while(!heap.empty()) {
+        ExpansionCandidate candidate = heap.top();
+        heap.pop();
+        if(restored[candidate.edge]) {
+            continue;
+        }
+        const ExpansionEdge& edge = discarded[candidate.edge];
+        const Membership *src_member, *dst_member;
+        int common = CommonCluster(member_of[edge.src], member_of[edge.dst], &src_member, &dst_member);
+        if(common != -1) {
+            // The images have come together in a cluster meanwhile
+            added_edges[common].push_back(ExpansionEdge{edge.score, src_member->local, dst_member->local});
+            restored[candidate.edge] = true;
+            restoredEdges++;
+            continue;
+        }
+
+        uint32_t best = candidate.cluster;
+        double share = BudgetShare(completeRatio, sizes[best], shared[best]);
+        if(share < 0) {
+            continue;
+        }
+        float key = (float)(edge.score * share);
+        if(key < candidate.key) {
+            candidate.key = key;
+            heap.push(candidate);
+            continue;
+        }
+
+        uint32_t holder = candidate.side == 0 ? edge.src : edge.dst;
+        uint32_t copy = candidate.side == 0 ? edge.dst : edge.src;
+        uint32_t other_local = 0;
+        for(const Membership& m : member_of[holder]) {
+            if(m.cluster == best) {
+                other_local = m.local;
+            }
+        }
+        uint32_t local = sizes[best]++;
+        for(const Membership& m : member_of[copy]) {
+            shared[m.cluster]++;
+        }
+        shared[best] += member_of[copy].size();
+        member_of[copy].push_back(Membership{best, local});
+        added_nodes[best].push_back(copy);
+        added_edges[best].push_back(ExpansionEdge{edge.score, other_local, local});
+        restored[candidate.edge] = true;
+        copiedImages++;
+        restoredEdges++;
+    }
+
+    // The clusters are independent, every thread adds the images and the matches of
+    // one cluster at a time
+    std::atomic<size_t> next_cluster(0);
+    ParallelRun(std::max((size_t)1, std::min(thread_num, cluster_num)), [&](size_t) {
+        for(size_t c; (c = next_cluster++) < cluster_num; ) {
+            for(uint32_t u : added_nodes[c]) {
+                clusters[c]->AddNode(nodes[u]);
+            }
+            for(const ExpansionEdge& edge : added_edges[c]) {
+                clusters[c]->AddEdgeu(edge.src, edge.dst, edge.score);
+            }
+        }
+    });
+    totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}   // namespace bluefish
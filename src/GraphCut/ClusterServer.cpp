@@ -0,0 +1,513 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ClusterServer.hpp"
+#include "ClusterAPI.hpp"
+#include "GraphCluster.hpp"
+
+#include "stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace bluefish {
+
+// Write a whole buffer into a socket
+static bool SendAll(int fd, const string& buffer)
+{
+    size_t sent = 0;
+    while(sent < buffer.size()) {
+        ssize_t n = send(fd, buffer.data() + sent, buffer.size() - sent, MSG_NOSIGNAL);
+        if(n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+// Parse a non-negative number, a sign or a trailing character is an error
+static bool ParseCount(const string& value, size_t& count)
+{
+    char *end;
+    if(value.empty() || !isdigit((unsigned char)value[0])) {
+        return false;
+    }
+    count = strtoull(value.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+// Parse a list of indices and ranges such as 0-499,700,702
+static bool ParseImages(const string& list, size_t nodeNum, vector<size_t>& images)
+{
+    stringstream list_in(list);
+    string item;
+    vector<bool> taken(nodeNum, false);
+    while(getline(list_in, item, ',')) {
+        size_t dash = item.find('-');
+        char *end;
+        unsigned long first = strtoul(item.c_str(), &end, 10);
+        unsigned long last = first;
+        if(end == item.c_str() || (dash == string::npos && *end != '\0')) {
+            return false;
+        }
+        if(dash != string::npos) {
+            last = strtoul(item.c_str() + dash + 1, &end, 10);
+            if(*end != '\0' || last < first) {
+                return false;
+            }
+        }
+        if(last >= nodeNum) {
+            return false;
+        }
+        for(size_t i = first; i <= last; i++) {
+            if(!taken[i]) {
+                taken[i] = true;
+                images.push_back(i);
+            }
+        }
+    }
+    return !images.empty();
+}
+
+ClusterServer::ClusterServer(const ImageGraph& imageGraph, size_t workerNum)
+    : imageGraph(imageGraph), stopping(false), requestNum(0), listenFd(-1)
+{
+    this->workerNum = workerNum > 0 ? workerNum : max(thread::hardware_concurrency(), 1u);
+}
+
+bool ClusterServer::ParseRequest(const string& line, ClusterRequest& request, string& error) const
+{
+    request = defaults;
+    stringstream line_in(line);
+    string param;
+    while(line_in >> param) {
+        size_t equal = param.find('=');
+        string key = param.substr(0, equal);
+        string value = equal == string::npos ? "" : param.substr(equal + 1);
+        if(key == "option") {
+            request.clusterOption = value;
+        }
+        else if(key == "upper") {
+            if(!ParseCount(value, request.upper)) {
+                error = "upper must be a number of images";
+                return false;
+            }
+        }
+        else if(key == "ratio") {
+            request.completeRatio = atof(value.c_str());
+        }
+        else if(key == "partition") {
+            request.partition = value;
+        }
+        else if(key == "engine") {
+            request.engine = value;
+        }
+        else if(key == "order") {
+            request.order = value;
+        }
+        else if(key == "resolution") {
+            request.resolution = atof(value.c_str());
+        }
+        else if(key == "threads") {
+            if(!ParseCount(value, request.threadNum)) {
+                error = "threads must be a number of threads, 0 for all the processors";
+                return false;
+            }
+        }
+        else if(key == "budget") {
+            if(!ParseCount(value, request.edgeBudget)) {
+                error = "budget must be a number of matches";
+                return false;
+            }
+        }
+        else if(key == "images") {
+            request.images.clear();
+            if(!ParseImages(value, imageGraph.GetNodeSize(), request.images)) {
+                error = "images must be indices and ranges of the image list, e.g. 0-499,700";
+                return false;
+            }
+        }
+        else if(key == "output") {
+            request.output = value;
+        }
+        else {
+            error = "unknown parameter " + key;
+            return false;
+        }
+    }
+
+    if(request.clusterOption != "naive" && request.clusterOption != "expansion" && 
+       request.clusterOption != "vertexcut") {
+        error = "option must be 'naive', 'expansion' or 'vertexcut'";
+    }
+    else if(request.upper == 0) {
+        error = "upper must be positive";
+    }
+    else if(request.partition != "kway" && request.partition != "bounded" && request.partition != "community") {
+        error = "partition must be 'kway', 'bounded' or 'community'";
+    }
+    else if(request.engine != "graclus" && request.engine != "lp") {
+        error = "engine must be 'graclus' or 'lp'";
+    }
+    else if(request.order != "none" && request.order != "rcm" && request.order != "bfs") {
+        error = "order must be 'none', 'rcm' or 'bfs'";
+    }
+    // The combinations of the options are checked by ClusterImages, like the ones of the command line
+    return error.empty();
+}
+
+bool ClusterServer::Run(const ClusterRequest& request, vector<vector<size_t>>& clusters, string& error) const
+{
+    // The whole graph is cut in place. The images of a subset are numbered from 0 
+    // in a graph of their own, images maps them back.
+    vector<size_t> images = request.images;
+    ImageGraph subgraph;
+    if(images.empty()) {
+        for(size_t i = 0; i < (size_t)imageGraph.GetNodeSize(); i++) {
+            images.push_back(i);
+        }
+    }
+    else {
+        const vector<ImageNode>& nodes = imageGraph.ImageNodes();
+        const vector<EdgeMap>& edge_maps = imageGraph.EdgeMaps();
+        vector<int> local(nodes.size(), -1);
+        for(size_t l = 0; l < images.size(); l++) {
+            const ImageNode& node = nodes[images[l]];
+            local[images[l]] = l;
+            subgraph.AddNode(ImageNode(l, node.image_name, node.sift_name, node.weight));
+        }
+        for(size_t l = 0; l < images.size(); l++) {
+            for(EdgeMap::const_iterator it = edge_maps[images[l]].begin(); it != edge_maps[images[l]].end(); it++) {
+                if(local[it->first] > (int)l) {
+                    subgraph.AddEdgeu(l, local[it->first], it->second.score);
+                }
+            }
+        }
+    }
+    const ImageGraph& graph = request.images.empty() ? imageGraph : subgraph;
+
+    // Graclus needs two clusters at least and no more clusters than images, the 
+    // request is answered with an error before anything is cut
+    size_t node_num = graph.GetNodeSize();
+    if(node_num == 0) {
+        error = "the graph of the request has no images";
+        return false;
+    }
+    if(node_num > request.upper && request.partition != "community") {
+        GraphCluster graph_cluster(request.upper, request.completeRatio);
+        graph_cluster.verbose = false;
+        size_t max_clust_size = 0;
+        size_t clust_num = graph_cluster.ClusterNumber(graph, request.clusterOption, request.partition, max_clust_size);
+        if(clust_num < 2 || clust_num > node_num) {
+            error = to_string(node_num) + " images cannot be cut into " + to_string(clust_num) + " clusters";
+            return false;
+        }
+    }
+
+    ClusterOptions options;
+    options.clusterOption = request.clusterOption;
+    options.upper = request.upper;
+    options.completeRatio = request.completeRatio;
+    options.partition = request.partition;
+    options.labelPropagation = (request.engine == "lp");
+    options.order = request.order == "rcm" ? ORDER_RCM : (request.order == "bfs" ? ORDER_BFS : ORDER_NONE);
+    options.resolution = request.resolution;
+    options.edgeBudget = request.edgeBudget;
+    options.threadNum = request.threadNum;
+
+    vector<vector<size_t>> local;
+    if(!ClusterImages(graph, options, local, error)) {
+        return false;
+    }
+
+    clusters.clear();
+    vector<shared_ptr<ImageGraph>> moved;
+    const vector<ImageNode>& nodes = graph.ImageNodes();
+    for(auto& cluster : local) {
+        vector<size_t> members;
+        shared_ptr<ImageGraph> renumbered(new ImageGraph());
+        for(size_t l : cluster) {
+            const ImageNode& node = nodes[l];
+            members.push_back(images[l]);
+            renumbered->AddNode(ImageNode(images[l], node.image_name, node.sift_name, node.weight));
+        }
+        clusters.push_back(members);
+        moved.push_back(renumbered);
+    }
+    if(!request.output.empty()) {
+        if(!stlplus::folder_exists(request.output) && !stlplus::folder_create(request.output)) {
+            error = request.output + " cannot be created";
+            return false;
+        }
+        // graph.txt lists the indices of the image list
+        GraphCluster graph_cluster(request.upper, request.completeRatio);
+        graph_cluster.MoveImages(moved, request.output);
+    }
+    return true;
+}
+
+bool ClusterServer::Handle(int fd, const string& line)
+{
+    stringstream line_in(line);
+    string command;
+    line_in >> command;
+    if(command == "info") {
+        stringstream reply;
+        reply << "ok " << imageGraph.GetNodeSize() << " " << imageGraph.GetEdgeSize() / 2 << "\n";
+        return SendAll(fd, reply.str());
+    }
+    else if(command == "shutdown") {
+        stopping = true;
+        return SendAll(fd, "ok\n");
+    }
+    else if(command == "cluster") {
+        ClusterRequest request;
+        string error, params;
+        getline(line_in, params);
+        vector<vector<size_t>> clusters;
+        if(ParseRequest(params, request, error)) {
+            requestNum++;
+            auto start = chrono::steady_clock::now();
+            Run(request, clusters, error);
+            cout << "request " << line << ": " << clusters.size() << " clusters, " 
+                 << chrono::duration<double>(chrono::steady_clock::now() - start).count() << "s" << endl;
+        }
+        if(!error.empty()) {
+            return SendAll(fd, "error " + error + "\n");
+        }
+
+        // One line per cluster, so that the client can read them as they come
+        bool open = SendAll(fd, "ok " + to_string(clusters.size()) + "\n");
+        for(size_t k = 0; open && k < clusters.size(); k++) {
+            stringstream reply;
+            reply << k << " " << clusters[k].size() << ":";
+            for(size_t image : clusters[k]) {
+                reply << " " << image;
+            }
+            reply << "\n";
+            open = SendAll(fd, reply.str());
+        }
+        return open && SendAll(fd, "end\n");
+    }
+    else if(!command.empty()) {
+        return SendAll(fd, "error unknown request " + command + "\n");
+    }
+    return true;
+}
+
+void ClusterServer::Work()
+{
+    while(true) {
+        pair<int, string> job;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this] { return !jobs.empty() || stopping; });
+            if(jobs.empty()) {
+                return;
+            }
+            job = jobs.front();
+            jobs.pop();
+        }
+        bool open = Handle(job.first, job.second);
+        {
+            lock_guard<std::mutex> lock(mutex);
+            finished.push_back(make_pair(job.first, open));
+        }
+        // Wakes the poll of Serve, which watches the connection again
+        char wake = 0;
+        while(write(wakeFds[1], &wake, 1) < 0 && errno == EINTR);
+    }
+}
+
+bool ClusterServer::Serve(string socketPath)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "Socket path " << socketPath << " is too long!" << endl;
+        return false;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath.c_str());
+    if(listenFd < 0 || bind(listenFd, (sockaddr *)&address, sizeof(address)) != 0 || listen(listenFd, 64) != 0) {
+        cerr << "Socket " << socketPath << " cannot be opened!" << endl;
+        if(listenFd >= 0) {
+            close(listenFd);
+        }
+        return false;
+    }
+    if(pipe(wakeFds) != 0) {
+        cerr << "The pipe of the workers cannot be opened!" << endl;
+        close(listenFd);
+        return false;
+    }
+    cout << "serving " << imageGraph.GetNodeSize() << " images on " << socketPath 
+         << " with " << workerNum << " workers" << endl;
+
+    vector<thread> workers;
+    for(size_t i = 0; i < workerNum; i++) {
+        workers.push_back(thread(&ClusterServer::Work, this));
+    }
+
+    // The connections are watched here and only their cluster requests go to the 
+    // workers, so that the idle connections don't hold a worker. A connection is 
+    // not watched while a worker answers it, its requests are answered in order.
+    struct Connection
+    {
+      string buffer;        // received bytes that are not answered yet
+      bool busy = false;    // a worker answers a request of the connection
+      bool closed = false;  // the client closed the connection, the received requests are still answered
+    };
+    map<int, Connection> open_fds;
+    size_t busy_num = 0;
+    char chunk[4096];
+    while(!stopping || busy_num > 0) {
+        vector<pollfd> fds;
+        fds.push_back({wakeFds[0], POLLIN, 0});
+        if(!stopping) {
+            fds.push_back({listenFd, POLLIN, 0});
+        }
+        for(auto& conn : open_fds) {
+            if(!conn.second.busy && !conn.second.closed) {
+                fds.push_back({conn.first, POLLIN, 0});
+            }
+        }
+        if(poll(fds.data(), fds.size(), -1) < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            cerr << "poll failed: " << strerror(errno) << endl;
+            stopping = true;
+            break;
+        }
+
+        for(auto& p : fds) {
+            if(p.revents == 0) {
+                continue;
+            }
+            if(p.fd == wakeFds[0]) {
+                if(read(wakeFds[0], chunk, sizeof(chunk)) < 0 && errno != EINTR) {
+                    continue;
+                }
+                lock_guard<std::mutex> lock(mutex);
+                for(auto& done : finished) {
+                    Connection& conn = open_fds[done.first];
+                    conn.busy = false;
+                    conn.closed = conn.closed || !done.second;
+                    busy_num--;
+                }
+                finished.clear();
+            }
+            else if(p.fd == listenFd) {
+                int fd = accept(listenFd, NULL, NULL);
+                if(fd >= 0) {
+                    open_fds[fd] = Connection();
+                }
+            }
+            else {
+                ssize_t n = recv(p.fd, chunk, sizeof(chunk), 0);
+                if(n <= 0) {
+                    open_fds[p.fd].closed = true;
+                }
+                else {
+                    open_fds[p.fd].buffer.append(chunk, n);
+                }
+            }
+        }
+
+        // Answer the received requests. The cluster requests are queued for the workers, 
+        // the others are short and answered here.
+        for(auto it = open_fds.begin(); it != open_fds.end();) {
+            Connection& conn = it->second;
+            size_t newline;
+            while(!conn.busy && !stopping && (newline = conn.buffer.find('\n')) != string::npos) {
+                string line = conn.buffer.substr(0, newline);
+                conn.buffer.erase(0, newline + 1);
+                if(!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                stringstream line_in(line);
+                string command;
+                line_in >> command;
+                if(command == "cluster") {
+                    lock_guard<std::mutex> lock(mutex);
+                    jobs.push(make_pair(it->first, line));
+                    conn.busy = true;
+                    busy_num++;
+                    ready.notify_one();
+                }
+                else if(!Handle(it->first, line)) {
+                    conn.closed = true;
+                    conn.buffer.clear();
+                }
+            }
+            if(!conn.busy && conn.closed && conn.buffer.find('\n') == string::npos) {
+                close(it->first);
+                it = open_fds.erase(it);
+            }
+            else {
+                it++;
+            }
+        }
+    }
+
+    // The workers have answered the queued requests, the requests that came after the 
+    // shutdown are not answered
+    {
+        lock_guard<std::mutex> lock(mutex);
+        ready.notify_all();
+    }
+    for(auto& worker : workers) {
+        worker.join();
+    }
+    for(auto& conn : open_fds) {
+        close(conn.first);
+    }
+    close(wakeFds[0]);
+    close(wakeFds[1]);
+    close(listenFd);
+    unlink(socketPath.c_str());
+    cout << "server stopped after " << requestNum << " cluster requests" << endl;
+    return true;
+}
+
+}   // namespace bluefish
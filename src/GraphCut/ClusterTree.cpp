@@ -0,0 +1,223 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ClusterTree.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <thread>
+#include <unordered_map>
+
+namespace bluefish {
+
+// The pass over the matches gives every thread chunks of this many images
+static const size_t kImageChunk = 1024;
+
+static uint64_t PairKey(uint32_t a, uint32_t b)
+{
+    return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+void ClusterTree::Build(const ImageGraph& imageGraph, const std::vector<std::shared_ptr<ImageGraph>>& clusters, 
+                        size_t threadNum)
+{
+    size_t node_num = imageGraph.GetNodeSize();
+    leafNum = clusters.size();
+    leafSizes.assign(leafNum, 0);
+    links.clear();
+    merges.clear();
+
+    // Clusters of every image, as CSR
+    std::vector<size_t> offsets(node_num + 1, 0);
+    for(size_t k = 0; k < leafNum; k++) {
+        const std::vector<ImageNode>& nodes = clusters[k]->ImageNodes();
+        leafSizes[k] = nodes.size();
+        for(auto& node : nodes) {
+            if(node.idx >= 0 && (size_t)node.idx < node_num) offsets[node.idx + 1]++;
+        }
+    }
+    for(size_t i = 0; i < node_num; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<uint32_t> member(offsets[node_num]);
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    for(size_t k = 0; k < leafNum; k++) {
+        const std::vector<ImageNode>& nodes = clusters[k]->ImageNodes();
+        for(auto& node : nodes) {
+            if(node.idx >= 0 && (size_t)node.idx < node_num) member[fill[node.idx]++] = k;
+        }
+    }
+
+    // One pass over the images and their matches, every thread sums its own links
+    const std::vector<EdgeMap>& edge_maps = imageGraph.EdgeMaps();
+    size_t thread_num = threadNum > 0 ? threadNum : std::max(std::thread::hardware_concurrency(), 1u);
+    thread_num = std::max((size_t)1, std::min(thread_num, (node_num + kImageChunk - 1) / kImageChunk));
+    std::vector<std::unordered_map<uint64_t, ClusterLink>> partial(thread_num);
+    auto pass = [&](size_t t) {
+        std::unordered_map<uint64_t, ClusterLink>& acc = partial[t];
+        for(size_t begin = t * kImageChunk; begin < node_num; begin += thread_num * kImageChunk) {
+            for(size_t u = begin; u < std::min(begin + kImageChunk, node_num); u++) {
+                for(size_t a = offsets[u]; a < offsets[u + 1]; a++) {
+                    for(size_t b = a + 1; b < offsets[u + 1]; b++) {
+                        acc[PairKey(member[a], member[b])].common++;
+                    }
+                }
+                for(EdgeMap::const_iterator it = edge_maps[u].begin(); it != edge_maps[u].end(); it++) {
+                    size_t v = it->first;
+                    // Every match is seen from its smaller image
+                    if(v >= node_num || v <= u) continue;
+                    for(size_t a = offsets[u]; a < offsets[u + 1]; a++) {
+                        for(size_t b = offsets[v]; b < offsets[v + 1]; b++) {
+                            if(member[a] == member[b]) continue;
+                            ClusterLink& link = acc[PairKey(member[a], member[b])];
+                            link.matches++;
+                            link.similarity += it->second.score;
+                        }
+                    }
+                }
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for(size_t t = 1; t < thread_num; t++) {
+        threads.push_back(std::thread(pass, t));
+    }
+    pass(0);
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    // Sorted by the cluster pair, so that the file doesn't depend on the threads
+    std::map<uint64_t, ClusterLink> merged;
+    for(auto& acc : partial) {
+        for(auto& entry : acc) {
+            ClusterLink& link = merged[entry.first];
+            link.common += entry.second.common;
+            link.matches += entry.second.matches;
+            link.similarity += entry.second.similarity;
+        }
+        std::unordered_map<uint64_t, ClusterLink>().swap(acc);
+    }
+    for(auto& entry : merged) {
+        ClusterLink link = entry.second;
+        link.left = entry.first >> 32;
+        link.right = entry.first & 0xffffffff;
+        links.push_back(link);
+    }
+
+    // Links of every live node of the tree
+    std::vector<std::map<int, ClusterLink>> adjacent(leafNum);
+    std::vector<size_t> sizes(leafSizes);
+    std::vector<bool> alive(leafNum, true);
+    for(auto& link : links) {
+        if(link.matches > 0 || link.common > 0) {
+            adjacent[link.left][link.right] = link;
+            adjacent[link.right][link.left] = link;
+        }
+    }
+
+    for(int round = 0; ; round++) {
+        // Pairs by average similarity, ties by the node numbers
+        std::vector<std::pair<double, std::pair<int, int>>> candidates;
+        for(size_t a = 0; a < adjacent.size(); a++) {
+            if(!alive[a]) continue;
+            for(auto& entry : adjacent[a]) {
+                if(entry.first > (int)a) {
+                    double score = entry.second.similarity / std::max((double)sizes[a] * sizes[entry.first], 1.0);
+                    candidates.push_back(std::make_pair(-score, std::make_pair((int)a, entry.first)));
+                }
+            }
+        }
+        if(candidates.empty()) {
+            break;
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        std::vector<bool> merged_now(adjacent.size(), false);
+        for(auto& candidate : candidates) {
+            int a = candidate.second.first, b = candidate.second.second;
+            if(merged_now[a] || merged_now[b]) continue;
+            merged_now[a] = merged_now[b] = true;
+
+            ClusterMerge merge;
+            merge.node = adjacent.size();
+            merge.left = a;
+            merge.right = b;
+            merge.round = round;
+            merge.images = sizes[a] + sizes[b];
+            merge.similarity = adjacent[a][b].similarity;
+            merges.push_back(merge);
+
+            // The links of the new node are the sums of the links of its children
+            std::map<int, ClusterLink> links_c;
+            for(int child : {a, b}) {
+                for(auto& entry : adjacent[child]) {
+                    if(entry.first == a || entry.first == b) continue;
+                    ClusterLink& link = links_c[entry.first];
+                    link.common += entry.second.common;
+                    link.matches += entry.second.matches;
+                    link.similarity += entry.second.similarity;
+                    adjacent[entry.first].erase(child);
+                }
+                std::map<int, ClusterLink>().swap(adjacent[child]);
+                alive[child] = false;
+            }
+            for(auto& entry : links_c) {
+                adjacent[entry.first][merge.node] = entry.second;
+            }
+            adjacent.push_back(links_c);
+            sizes.push_back(merge.images);
+            alive.push_back(true);
+            merged_now.push_back(true);
+        }
+    }
+}
+
+bool ClusterTree::Save(std::string filename) const
+{
+    std::ofstream tree_out(filename);
+    if(!tree_out.is_open()) {
+        std::cerr << "Cluster tree " << filename << " cannot be created!" << std::endl;
+        return false;
+    }
+    tree_out << leafNum << " " << links.size() << " " << merges.size() << "\n";
+    tree_out << std::setprecision(8);
+    for(auto& link : links) {
+        tree_out << "link " << link.left << " " << link.right << " " << link.common << " " 
+                 << link.matches << " " << link.similarity << "\n";
+    }
+    for(auto& merge : merges) {
+        tree_out << "merge " << merge.node << " " << merge.left << " " << merge.right << " " 
+                 << merge.round << " " << merge.images << " " << merge.similarity << "\n";
+    }
+    tree_out.close();
+    return (bool)tree_out;
+}
+
+}   // namespace bluefish
@@ -0,0 +1,251 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "EdgePartitioner.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+
+namespace bluefish {
+
+// matches taken by a thread at a time
+static const size_t kEdgeChunk = 1024;
+// the copies of an image are guarded by the lock of image % kLockStripes
+static const size_t kLockStripes = 4096;
+
+// shared state of the threads of Partition
+struct EdgePartitionState
+{
+  const std::vector<LinkEdge>* edges;
+  std::vector<double> degrees;                  // similarity of the matches of every image
+  std::vector<std::vector<int>> replicas;       // clusters of every image
+  std::vector<std::atomic<size_t>> sizes;       // number of images of every cluster
+  std::vector<std::mutex> locks;
+  std::atomic<size_t> next;                     // first match that no thread has taken
+  std::atomic<size_t> cursor;                   // where the search of an empty cluster starts
+  std::atomic<size_t> extra;                    // copies beyond the first copy of every image
+
+  EdgePartitionState(size_t nodeNum, size_t clusterNum)
+      : degrees(nodeNum, 0), replicas(nodeNum), sizes(clusterNum), locks(kLockStripes)
+  {
+      for(size_t i = 0; i < clusterNum; i++) {
+          sizes[i].store(0);
+      }
+      next.store(0);
+      cursor.store(0);
+      extra.store(0);
+  }
+};
+
+EdgePartitioner::EdgePartitioner(size_t upper, size_t replicaBudget, float lambda)
+    : upper(std::max<size_t>(upper, 2)), replicaBudget(replicaBudget), lambda(lambda)
+{
+}
+
+// Reserve room for need images in cluster p and extraNeed copies of the budget
+static bool Reserve(EdgePartitionState& state, size_t p, size_t need, size_t extraNeed, 
+                    size_t upper, size_t budget)
+{
+    if(need == 0) {
+        return true;
+    }
+    size_t size = state.sizes[p].load(std::memory_order_relaxed);
+    do {
+        if(size + need > upper) {
+            return false;
+        }
+    } while(!state.sizes[p].compare_exchange_weak(size, size + need, std::memory_order_relaxed));
+
+    if(extraNeed > 0 && state.extra.fetch_add(extraNeed, std::memory_order_relaxed) + extraNeed > budget) {
+        state.extra.fetch_sub(extraNeed, std::memory_order_relaxed);
+        state.sizes[p].fetch_sub(need, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+// Assign the match e, with the locks of its images held
+static void AssignEdge(EdgePartitionState& state, size_t e, const EdgePartitioner& ep, 
+                       std::vector<int>& edgeClusters)
+{
+    const LinkEdge& edge = (*state.edges)[e];
+    std::vector<int>& au = state.replicas[edge.src];
+    std::vector<int>& av = state.replicas[edge.dst];
+    size_t k = state.sizes.size();
+
+    // HDRF: a copy of the image of lower degree is worth more, since the image of 
+    // higher degree is the one to be cut
+    double du = state.degrees[edge.src], dv = state.degrees[edge.dst];
+    double theta_u = (du + dv > 0) ? du / (du + dv) : 0.5;
+    double theta_v = 1.0 - theta_u;
+
+    std::vector<std::pair<double, int>> candidates;
+    for(int pass = 0; pass < 2; pass++) {
+        const std::vector<int>& a = (pass == 0 ? au : av);
+        for(size_t i = 0; i < a.size(); i++) {
+            int p = a[i];
+            bool in_u = std::find(au.begin(), au.end(), p) != au.end();
+            bool in_v = std::find(av.begin(), av.end(), p) != av.end();
+            if(pass == 1 && in_u) {
+                continue;   // already a candidate
+            }
+            double score = (in_u ? 2.0 - theta_u : 0.0) + (in_v ? 2.0 - theta_v : 0.0) + 
+                           ep.lambda * (1.0 - (double)state.sizes[p].load(std::memory_order_relaxed) / ep.upper);
+            candidates.push_back(std::make_pair(score, p));
+        }
+    }
+
+    // The next cluster with room for both images, in turn, so that the empty 
+    // clusters are seeded evenly
+    size_t start = state.cursor.load(std::memory_order_relaxed);
+    for(size_t i = 0; i < k; i++) {
+        size_t p = (start + i) % k;
+        size_t size = state.sizes[p].load(std::memory_order_relaxed);
+        if(size + 2 <= ep.upper) {
+            state.cursor.store(p + 1, std::memory_order_relaxed);
+            candidates.push_back(std::make_pair(ep.lambda * (1.0 - (double)size / ep.upper), (int)p));
+            break;
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), 
+              [](const std::pair<double, int>& a, const std::pair<double, int>& b) { 
+                  return a.first > b.first || (a.first == b.first && a.second < b.second); });
+
+    for(size_t i = 0; i < candidates.size(); i++) {
+        int p = candidates[i].second;
+        bool in_u = std::find(au.begin(), au.end(), p) != au.end();
+        bool in_v = std::find(av.begin(), av.end(), p) != av.end();
+        size_t need = !in_u + !in_v;
+        size_t extra_need = (!in_u && !au.empty()) + (!in_v && !av.empty());
+        if(Reserve(state, p, need, extra_need, ep.upper, ep.replicaBudget)) {
+            if(!in_u) {
+                au.push_back(p);
+            }
+            if(!in_v) {
+                av.push_back(p);
+            }
+            edgeClusters[e] = p;
+            return;
+        }
+    }
+    edgeClusters[e] = -1;
+}
+
+static void PartitionThread(EdgePartitionState& state, const EdgePartitioner& ep, std::vector<int>& edgeClusters)
+{
+    const std::vector<LinkEdge>& edges = *state.edges;
+    while(true) {
+        size_t begin = state.next.fetch_add(kEdgeChunk);
+        if(begin >= edges.size()) {
+            break;
+        }
+        size_t end = std::min(begin + kEdgeChunk, edges.size());
+        for(size_t e = begin; e < end; e++) {
+            size_t lu = edges[e].src % kLockStripes, lv = edges[e].dst % kLockStripes;
+            if(lu > lv) {
+                std::swap(lu, lv);
+            }
+            std::lock_guard<std::mutex> lock_u(state.locks[lu]);
+            if(lu != lv) {
+                std::lock_guard<std::mutex> lock_v(state.locks[lv]);
+                AssignEdge(state, e, ep, edgeClusters);
+            }
+            else {
+                AssignEdge(state, e, ep, edgeClusters);
+            }
+        }
+    }
+}
+
+void EdgePartitioner::Partition(size_t nodeNum, const std::vector<LinkEdge>& edges, const std::vector<int>& homes, 
+                                size_t clusterNum, size_t threadNum)
+{
+    clusterNum = std::max<size_t>(clusterNum, 1);
+    threadNum = std::max<size_t>(threadNum, 1);
+    EdgePartitionState state(nodeNum, clusterNum);
+    state.edges = &edges;
+    edgeClusters.assign(edges.size(), -1);
+
+    // The degrees are known before the matches are assigned, as in 2PS
+    for(size_t e = 0; e < edges.size(); e++) {
+        state.degrees[edges[e].src] += edges[e].score;
+        state.degrees[edges[e].dst] += edges[e].score;
+    }
+
+    // Every image starts in its home cluster, the matches across the clusters copy images
+    for(size_t i = 0; i < nodeNum && i < homes.size(); i++) {
+        if(homes[i] >= 0 && homes[i] < (int)clusterNum) {
+            state.replicas[i].push_back(homes[i]);
+            state.sizes[homes[i]].fetch_add(1);
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for(size_t t = 1; t < threadNum; t++) {
+        threads.push_back(std::thread(PartitionThread, std::ref(state), std::cref(*this), std::ref(edgeClusters)));
+    }
+    PartitionThread(state, *this, edgeClusters);
+    for(size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    clusters.assign(clusterNum, std::vector<uint32_t>());
+    std::vector<size_t> sizes(clusterNum);
+    for(size_t p = 0; p < clusterNum; p++) {
+        sizes[p] = state.sizes[p].load();
+    }
+    for(size_t i = 0; i < nodeNum; i++) {
+        const std::vector<int>& a = state.replicas[i];
+        if(a.empty()) {
+            // An image without kept matches joins the emptiest cluster
+            size_t p = std::min_element(sizes.begin(), sizes.end()) - sizes.begin();
+            if(sizes[p] >= upper) {
+                p = sizes.size();
+                sizes.push_back(0);
+                clusters.push_back(std::vector<uint32_t>());
+            }
+            sizes[p]++;
+            clusters[p].push_back((uint32_t)i);
+        }
+        for(size_t j = 0; j < a.size(); j++) {
+            clusters[a[j]].push_back((uint32_t)i);
+        }
+    }
+}
+
+size_t EdgePartitioner::Replicas() const
+{
+    size_t replicas = 0;
+    for(size_t p = 0; p < clusters.size(); p++) {
+        replicas += clusters[p].size();
+    }
+    return replicas;
+}
+
+}   // namespace bluefish
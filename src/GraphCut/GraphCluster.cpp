@@ -26,9 +26,21 @@
 */
 
 #include "GraphCluster.hpp"
+#include "StreamPartitioner.hpp"
+#include "EdgePartitioner.hpp"
+#include "Leiden.hpp"
+#include "ClusterTree.hpp"
+#include "GraphSparsifier.hpp"
+#include "ClusterExpansion.hpp"
 
 // #include "third_party/cmdLine/cmdLine.h"
 #include "stlplus3/filesystemSimplified/file_system.hpp"
+#include "libvot/src/utils/data_types.h"
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <thread>
 
 extern "C"
 {
@@ -39,14 +51,25 @@ namespace bluefish {
 GraphCluster::GraphCluster(size_t upper, float cr)
 {
     graphUpper = upper;
+    weightUpper = 0;
     completeRatio = cr;
+    parallelCoarsen = false;
+    threadNum = 1;
+    restartNum = 1;
+    spectralInit = false;
+    labelPropagation = false;
+    checkpointInterval = 60;
+    resolution = 1.0;
+    nodeOrder = ORDER_NONE;
+    edgeBudget = 0;
+    verbose = true;
+    ncPool = shared_ptr<pooldef>(GraclusPoolCreate(), GraclusPoolDestroy);
 }
 
-ImageGraph GraphCluster::BuildGraph(string imageList, string vocFile)
+ImageGraph GraphCluster::BuildGraph(string imageList, string vocFile, string siftList)
 {
     ImageGraph image_graph;
     ifstream img_in(imageList);
-    ifstream voc_in(vocFile);
     string img;
     int idx = 0;
     
@@ -61,22 +84,141 @@ ImageGraph GraphCluster::BuildGraph(string imageList, string vocFile)
     }
     img_in.close();
 
+    if(!siftList.empty()) {
+        image_graph = WeightNodes(image_graph, siftList);
+    }
+
+    if(!vocFile.empty()) {
+        ReadMatches(image_graph, vocFile);
+    }
+    return image_graph;
+}
+
+bool GraphCluster::ReadMatches(ImageGraph& imageGraph, string vocFile)
+{
+    ifstream voc_in(vocFile);
     if(!voc_in.is_open()) {
         cerr << "File of vocabulary tree cannot be opened!" << endl;
-        return image_graph;
+        return false;
     }
     size_t src, dst;
     float score;
-    int k = 0;
+    size_t skipped = 0;
     while(voc_in >> src >> dst >> score) {
         // an undirect weight graph is required
-         if(src != dst) {
-             image_graph.AddEdgeu(src, dst, score);
-         }
+        if(src >= imageGraph.GetNodeSize() || dst >= imageGraph.GetNodeSize()) {
+            skipped++;
+        }
+        else if(src != dst) {
+            imageGraph.AddEdgeu(src, dst, score);
+        }
     }
     voc_in.close();
 
-    return image_graph;
+    if(skipped > 0) {
+        cerr << skipped << " matches of " << vocFile << " refer to images that are not in the image list" << endl;
+    }
+    return true;
+}
+
+ImageGraph GraphCluster::WeightNodes(ImageGraph imageGraph, string siftList)
+{
+    ifstream sift_in(siftList);
+    vector<string> sift_files;
+    string sift;
+
+    if(!sift_in.is_open()) {
+        cerr << "File of sift list cannot be opened, the images are not weighted!" << endl;
+        return imageGraph;
+    }
+    while(sift_in >> sift) {
+        sift_files.push_back(sift);
+    }
+    sift_in.close();
+    if(sift_files.size() != imageGraph.GetNodeSize()) {
+        cerr << "The sift list has " << sift_files.size() << " files for " << imageGraph.GetNodeSize() 
+             << " images, the images are not weighted!" << endl;
+        return imageGraph;
+    }
+
+    // Only the headers are read, the feature counts are in the first bytes of the files
+    ImageGraph weighted_graph;
+    vector<ImageNode> nodes = imageGraph.GetImageNode();
+    vot::SiftData sift_data;
+    for(int i = 0; i < nodes.size(); i++) {
+        int weight = 1;
+        if(sift_data.ReadSiftHeader(sift_files[i])) {
+            weight = std::max(sift_data.getFeatureNum(), 1);
+        }
+        weighted_graph.AddNode(ImageNode(nodes[i].idx, nodes[i].image_name, sift_files[i], weight));
+    }
+
+    if(weighted_graph.GetWeight() > INT_MAX / 2) {
+        cerr << "Total image weight " << weighted_graph.GetWeight() 
+             << " may overflow the 32-bit Graclus, build it with GRACLUS_IDX64" << endl;
+    }
+    return weighted_graph;
+}
+
+// Adjacency of the normalized-cut graph in the CSR format of Graclus, the k-th node is 
+// the image order[k] and the edge weights are integers
+struct NCAdjacency
+{
+    vector<idxtype> xadj;
+    vector<idxtype> adjncy;
+    vector<idxtype> adjwgt;
+    vector<idxtype> vwgt;   // empty for an unweighted graph
+};
+
+static void BuildNCAdjacency(const ImageGraph& imageGraph, const LocalityOrder& order, NCAdjacency& adjacency)
+{
+    std::vector<ImageNode> img_nodes = imageGraph.GetImageNode();
+    const std::vector<EdgeMap>& edge_maps = imageGraph.EdgeMaps();
+    adjacency.xadj.assign(1, 0);
+    adjacency.adjncy.clear();
+    adjacency.adjwgt.clear();
+    adjacency.vwgt.clear();
+
+    bool weighted = imageGraph.IsWeighted();
+    vector<pair<size_t, long long>> edges;
+    for (size_t k = 0; k < img_nodes.size(); k++) {
+        size_t i = order.Empty() ? k : order.order[k];
+        if(weighted) {
+            adjacency.vwgt.push_back(img_nodes[i].weight);
+        }
+        edges.clear();
+        for (EdgeMap::const_iterator it = edge_maps[i].begin(); it != edge_maps[i].end(); it++) {
+            // Graclus reads integer edge weights, zero weights would leave nodes without degree
+            long long weight = std::max(1LL, std::llround(it->second.score * 1e4));
+            edges.push_back(make_pair(order.Empty() ? it->second.dst : order.rank[it->second.dst], weight));
+        }
+        if(!order.Empty()) {
+            sort(edges.begin(), edges.end());
+        }
+        for(auto edge : edges) {
+            adjacency.adjncy.push_back(edge.first);
+            adjacency.adjwgt.push_back(edge.second);
+        }
+        adjacency.xadj.push_back(adjacency.adjncy.size());
+    }
+}
+
+// The k-th node of the normalized-cut graph is the image order[k]
+static LocalityOrder NCOrder(const ImageGraph& imageGraph, OrderMethod method, bool verbose)
+{
+    if(method == ORDER_NONE) {
+        return LocalityOrder(imageGraph, method);
+    }
+    std::vector<EdgeMap> edge_maps = imageGraph.GetEdgeMap();
+    auto start = chrono::steady_clock::now();
+    LocalityOrder order(edge_maps, method);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if(verbose && !order.Empty()) {
+        cout << "order " << OrderName(method) << ": " << edge_maps.size() << " nodes, edge span " 
+             << LocalityOrder::EdgeSpan(edge_maps, vector<uint32_t>()) << " -> " 
+             << LocalityOrder::EdgeSpan(edge_maps, order.rank) << ", " << seconds << "s" << endl;
+    }
+    return order;
 }
 
 string GraphCluster::GenerateNCGraph(ImageGraph imageGraph, string dir)
@@ -94,42 +236,417 @@ string GraphCluster::GenerateNCGraph(ImageGraph imageGraph, string dir)
         cerr << "Normalized-Cut Graph cannot be opened!" << endl;
         return filename;
     }
-    nc_out << imageGraph.GetNodeSize() << " " << imageGraph.GetEdgeSize() / 2 << " 1\n";
+    // fmt 11 when the vertex weights are written before the adjacency lists
+    bool weighted = imageGraph.IsWeighted();
+    nc_out << imageGraph.GetNodeSize() << " " << imageGraph.GetEdgeSize() / 2 << (weighted ? " 11\n" : " 1\n");
 
-    std::vector<ImageNode> img_nodes = imageGraph.GetImageNode();
-    std::vector<EdgeMap> edge_maps = imageGraph.GetEdgeMap();
+    // The k-th line of the file is the image order[k], the clusters are mapped back by ncOrders
+    LocalityOrder order = NCOrder(imageGraph, nodeOrder, verbose);
+    ncOrders.erase(filename);
+    if(!order.Empty()) {
+        ncOrders.insert(make_pair(filename, order));
+    }
 
-    for (int i = 0; i < img_nodes.size(); i++) {
-		for (EdgeMap::iterator it = edge_maps[i].begin(); it != edge_maps[i].end(); it++) {
-			nc_out << it->second.dst + 1 << " " << it->second.score * 1e4 << " ";
-		}
+    NCAdjacency adjacency;
+    BuildNCAdjacency(imageGraph, order, adjacency);
+    for (size_t k = 0; k + 1 < adjacency.xadj.size(); k++) {
+        if(weighted) {
+            nc_out << adjacency.vwgt[k] << " ";
+        }
+        for(idxtype j = adjacency.xadj[k]; j < adjacency.xadj[k + 1]; j++) {
+            nc_out << adjacency.adjncy[j] + 1 << " " << adjacency.adjwgt[j] << " ";
+        }
         nc_out << endl;
-	}
+    }
     nc_out.close();
     return filename;
 }
 
-vector<size_t> GraphCluster::NormalizedCut(string filename, size_t clusterNum)
+// Add the statistics of a Graclus call to the report, and print them if verbose
+static void ReportNC(const Graclus& graclus, size_t clusterNum, const char *name, NCReport& report, bool verbose)
+{
+    const MLStatsType& stats = graclus.stats;
+    if(verbose) {
+        cout << name << ": " << graclus.clusterNum << " nodes, " << clusterNum 
+             << " clusters, ncut " << graclus.ncut << ", balance " << graclus.balance << endl;
+        cout << "  levels (nodes/edges/kkm iterations):";
+        for(int i = 0; i < stats.nlevels && i < MAXSTATLEVELS; i++) {
+            cout << " " << stats.nvtxs[i] << "/" << stats.nedges[i] << "/" << stats.kkmiters[i];
+        }
+        cout << endl;
+        cout << "  time: read " << graclus.readTime << "s, coarsen " << stats.coarsentime 
+             << "s, initial partition " << stats.initparttime << "s, refine " << stats.refinetime 
+             << "s, total " << stats.totaltime << "s" << endl;
+    }
+
+    report.calls++;
+    report.levels += stats.nlevels;
+    report.kkmIterations += stats.totalkkmiters;
+    report.readTime += graclus.readTime;
+    report.coarsenTime += stats.coarsentime;
+    report.initPartTime += stats.initparttime;
+    report.refineTime += stats.refinetime;
+    report.totalTime += stats.totaltime;
+    report.maxNCut = max(report.maxNCut, graclus.ncut);
+    report.maxBalance = max(report.maxBalance, graclus.balance);
+
+    if(verbose && graclus.nrestarts > 1) {
+        for(int i = 0; i < graclus.nrestarts; i++) {
+            cout << "restart " << i << ": ncut " << graclus.restartNCut[i] 
+                 << ", time " << graclus.restartTime[i] << "s" << endl;
+        }
+        cout << "best restart: " << graclus.bestRestart << endl;
+    }
+}
+
+// Options of the Graclus calls of NormalizedCut
+static void NCOptions(const GraphCluster& graphCluster, size_t maxClusterSize, int *options)
+{
+    GraclusSetDefaultOptions(options);
+    if(graphCluster.parallelCoarsen) {
+        options[OPTION_CTYPE] = MATCH_PSHEMN;
+    }
+    options[OPTION_NTHREADS] = graphCluster.threadNum;
+    options[OPTION_NRESTARTS] = graphCluster.restartNum;
+    if(graphCluster.spectralInit) {
+        options[OPTION_INITPART] = INITPART_SPECTRAL;
+    }
+    options[OPTION_MAXPWGT] = (int)maxClusterSize;
+    if(graphCluster.labelPropagation) {
+        options[OPTION_ENGINE] = ENGINE_LABELPROP;
+    }
+}
+
+vector<size_t> GraphCluster::NormalizedCut(string filename, size_t clusterNum, size_t maxClusterSize)
 {
     vector<size_t> clusters;
-    char path[256];
-    strcpy(path, filename.c_str());
+    vector<char> path(filename.c_str(), filename.c_str() + filename.size() + 1);
 
-    Graclus graclus = normalizedCut(path, clusterNum);
+    int options[GRACLUS_NOPTIONS];
+    NCOptions(*this, maxClusterSize, options);
+
+    GraclusUsePool(ncPool.get());
+    Graclus graclus = normalizedCut(path.data(), clusterNum, options);
+    if(graclus.part == NULL) {
+        // Graclus reported the reason, the caller sees no labels
+        GraclusUsePool(NULL);
+        return clusters;
+    }
     
     for(int i = 0; i < graclus.clusterNum; i++) {
         clusters.push_back((size_t)graclus.part[i]);
     }
+    unordered_map<string, LocalityOrder>::const_iterator order = ncOrders.find(filename);
+    if(order != ncOrders.end()) {
+        clusters = order->second.ToImages(clusters);
+    }
+
+    ReportNC(graclus, clusterNum, labelPropagation ? "label propagation" : "normalized cut", ncReport, verbose);
+    GraclusFree(&graclus);
+    GraclusUsePool(NULL);
     
     return clusters;
 }
 
+vector<size_t> GraphCluster::NormalizedCut(const ImageGraph& imageGraph, size_t clusterNum, size_t maxClusterSize)
+{
+    vector<size_t> clusters;
+    if(imageGraph.GetNodeSize() == 0) {
+        return clusters;
+    }
+    LocalityOrder order = NCOrder(imageGraph, nodeOrder, verbose);
+    NCAdjacency adjacency;
+    BuildNCAdjacency(imageGraph, order, adjacency);
+
+    int options[GRACLUS_NOPTIONS];
+    NCOptions(*this, maxClusterSize, options);
+
+    GraclusUsePool(ncPool.get());
+    Graclus graclus = normalizedCutGraph(imageGraph.GetNodeSize(), adjacency.xadj.data(), adjacency.adjncy.data(), 
+                                         adjacency.vwgt.empty() ? NULL : adjacency.vwgt.data(), 
+                                         adjacency.adjwgt.data(), clusterNum, options);
+    if(graclus.part == NULL) {
+        GraclusUsePool(NULL);
+        return clusters;
+    }
+    for(int i = 0; i < graclus.clusterNum; i++) {
+        clusters.push_back((size_t)graclus.part[i]);
+    }
+    if(!order.Empty()) {
+        clusters = order.ToImages(clusters);
+    }
+
+    ReportNC(graclus, clusterNum, labelPropagation ? "label propagation" : "normalized cut", ncReport, verbose);
+    GraclusFree(&graclus);
+    GraclusUsePool(NULL);
+
+    return clusters;
+}
+
+vector<size_t> GraphCluster::StreamCluster(string imageList, string vocFile, size_t& clusterNum)
+{
+    vector<size_t> clusters;
+    clusterNum = 0;
+
+    ifstream img_in(imageList);
+    if(!img_in.is_open()) {
+        cerr << "File of image list cannot be opened!" << endl;
+        return clusters;
+    }
+    size_t node_num = 0;
+    string img;
+    while(img_in >> img) {
+        node_num++;
+    }
+    img_in.close();
+
+    ifstream voc_file;
+    if(vocFile != "-") {
+        voc_file.open(vocFile);
+        if(!voc_file.is_open()) {
+            cerr << "File of vocabulary tree cannot be opened!" << endl;
+            return clusters;
+        }
+    }
+    istream& voc_in = (vocFile == "-" ? cin : voc_file);
+
+    auto start = chrono::steady_clock::now();
+    StreamPartitioner partitioner(node_num, graphUpper);
+    vector<pair<size_t, float>> edges;
+    size_t src, dst, last = SIZE_MAX;
+    size_t max_frontier = 0, skipped = 0;
+    float score;
+    while(voc_in >> src >> dst >> score) {
+        if(src >= node_num || dst >= node_num) {
+            skipped++;
+            continue;
+        }
+        if(src != last && last != SIZE_MAX) {
+            partitioner.Add(last, edges);
+            max_frontier = max(max_frontier, partitioner.FrontierSize());
+            edges.clear();
+        }
+        last = src;
+        if(src != dst) {
+            edges.push_back(make_pair(dst, score));
+        }
+    }
+    if(last != SIZE_MAX) {
+        partitioner.Add(last, edges);
+    }
+    size_t unmatched = partitioner.Finish();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if(skipped > 0) {
+        cerr << skipped << " matches of " << vocFile << " refer to images that are not in the image list" << endl;
+    }
+    const vector<int>& labels = partitioner.Labels();
+    clusters.assign(labels.begin(), labels.end());
+    clusterNum = partitioner.ClusterNum();
+    cout << "stream: " << node_num << " nodes, " << clusterNum << " clusters, " << unmatched 
+         << " nodes arrived at the end, largest frontier " << max_frontier << " matches, " 
+         << seconds << "s" << endl;
+    return clusters;
+}
+
+vector<size_t> GraphCluster::CommunityCluster(const ImageGraph& imageGraph, size_t& clusterNum)
+{
+    auto start = chrono::steady_clock::now();
+    LeidenCommunity leiden(resolution, graphUpper, threadNum);
+    LocalityOrder order(imageGraph, nodeOrder);
+    vector<int> communities = leiden.Compute(imageGraph, order.order);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    clusterNum = leiden.CommunityNum();
+    if(verbose) {
+        cout << "leiden: " << communities.size() << " nodes, " << clusterNum << " communities, modularity " 
+             << leiden.Modularity() << ", " << leiden.Levels() << " levels, " << seconds << "s" << endl;
+    }
+    return vector<size_t>(communities.begin(), communities.end());
+}
+
+vector<size_t> GraphCluster::RefineCut(string filename, const vector<size_t>& clusters, 
+                                       size_t clusterNum, size_t maxClusterSize)
+{
+    vector<size_t> refined;
+    vector<char> path(filename.c_str(), filename.c_str() + filename.size() + 1);
+
+    int options[GRACLUS_NOPTIONS];
+    GraclusSetDefaultOptions(options);
+    options[OPTION_NTHREADS] = threadNum;
+    options[OPTION_MAXPWGT] = (int)maxClusterSize;
+
+    // The clusters are given and returned by image, the file lists the images in its order
+    unordered_map<string, LocalityOrder>::const_iterator order = ncOrders.find(filename);
+    vector<idxtype> part(clusters.begin(), clusters.end());
+    if(order != ncOrders.end()) {
+        part = order->second.ToPositions(part);
+    }
+    GraclusUsePool(ncPool.get());
+    Graclus graclus = refineNormalizedCut(path.data(), clusterNum, part.data(), options);
+    if(graclus.part == NULL) {
+        GraclusUsePool(NULL);
+        return refined;
+    }
+    for(int i = 0; i < graclus.clusterNum; i++) {
+        refined.push_back((size_t)graclus.part[i]);
+    }
+    if(order != ncOrders.end()) {
+        refined = order->second.ToImages(refined);
+    }
+    ReportNC(graclus, clusterNum, "refinement", ncReport, verbose);
+    GraclusFree(&graclus);
+    GraclusUsePool(NULL);
+    
+    return refined;
+}
+
+size_t GraphCluster::NCWorkspacePeak() const
+{
+    return GraclusPoolPeakSize(ncPool.get());
+}
+
+ImageGraph GraphCluster::SparsifyGraph(const ImageGraph& imageGraph) const
+{
+    if(edgeBudget == 0) {
+        return imageGraph;
+    }
+    GraphSparsifier sparsifier(edgeBudget, threadNum);
+    ImageGraph sparse_graph = sparsifier.Sparsify(imageGraph);
+    if(!verbose) {
+        return sparse_graph;
+    }
+    if(sparsifier.keptEdges == sparsifier.inputEdges) {
+        cout << "sparsify: " << sparsifier.inputEdges << " matches are within the budget" << endl;
+        return sparse_graph;
+    }
+    cout << "sparsify: " << sparsifier.inputEdges << " -> " << sparsifier.keptEdges << " matches (budget " 
+         << edgeBudget << ", forest " << sparsifier.forestEdges << ", " << sparsifier.components 
+         << " components), kept similarity " << sparsifier.keptSimilarity << ", " << sparsifier.totalTime << "s" << endl;
+    return sparse_graph;
+}
+
+double GraphCluster::NCutValue(const ImageGraph& imageGraph, const vector<size_t>& clusters) const
+{
+    size_t node_num = imageGraph.GetNodeSize();
+    if(clusters.size() != node_num) {
+        return 0;
+    }
+    size_t cluster_num = 0;
+    for(size_t c : clusters) {
+        cluster_num = max(cluster_num, c + 1);
+    }
+    vector<double> cut(cluster_num, 0), assoc(cluster_num, 0);
+    const vector<EdgeMap>& edge_maps = imageGraph.EdgeMaps();
+    for(size_t u = 0; u < node_num; u++) {
+        for(EdgeMap::const_iterator it = edge_maps[u].begin(); it != edge_maps[u].end(); it++) {
+            assoc[clusters[u]] += it->second.score;
+            if(clusters[it->first] != clusters[u]) {
+                cut[clusters[u]] += it->second.score;
+            }
+        }
+    }
+    double ncut = 0;
+    for(size_t k = 0; k < cluster_num; k++) {
+        if(assoc[k] > 0) {
+            ncut += cut[k] / assoc[k];
+        }
+    }
+    return ncut;
+}
+
+void GraphCluster::PrintNCReport() const
+{
+    cout << "normalized-cut report:\n"
+         << "  calls: " << ncReport.calls << "\n"
+         << "  levels: " << ncReport.levels << "\n"
+         << "  kernel k-means iterations: " << ncReport.kkmIterations << "\n"
+         << "  time: read " << ncReport.readTime << "s, coarsen " << ncReport.coarsenTime 
+         << "s, initial partition " << ncReport.initPartTime << "s, refine " << ncReport.refineTime
+         << "s, total " << ncReport.totalTime + ncReport.readTime << "s\n"
+         << "  worst ncut: " << ncReport.maxNCut << ", worst balance: " << ncReport.maxBalance << "\n"
+         << "  workspace peak: " << NCWorkspacePeak() / (1024.0 * 1024.0) << " MB" << endl;
+}
+
+void GraphCluster::PrintClusterWeights(const vector<shared_ptr<ImageGraph>>& imageGraphs) const
+{
+    if(imageGraphs.empty()) {
+        return;
+    }
+
+    long long total = 0, max_weight = 0;
+    cout << "cluster weights:\n";
+    for(int i = 0; i < imageGraphs.size(); i++) {
+        long long weight = imageGraphs[i]->GetWeight();
+        cout << "  image_part_" << i << ": " << imageGraphs[i]->GetNodeSize() 
+             << " images, weight " << weight << "\n";
+        total += weight;
+        max_weight = max(max_weight, weight);
+    }
+    cout << "  total weight " << total << ", largest weight over average " 
+         << (double)max_weight * imageGraphs.size() / max(total, 1LL) << endl;
+}
+
+void GraphCluster::PrintOverlap(const ImageGraph& imageGraph, const vector<shared_ptr<ImageGraph>>& imageGraphs) const
+{
+    size_t node_num = imageGraph.GetNodeSize();
+    vector<vector<int>> node_clusters(node_num);
+    size_t replicas = 0, max_size = 0;
+    for(int k = 0; k < imageGraphs.size(); k++) {
+        vector<ImageNode> nodes = imageGraphs[k]->GetImageNode();
+        for(auto node : nodes) {
+            if(node.idx >= 0 && node.idx < node_num) {
+                node_clusters[node.idx].push_back(k);
+            }
+        }
+        replicas += nodes.size();
+        max_size = max(max_size, nodes.size());
+    }
+
+    double total = 0, kept = 0;
+    vector<EdgeMap> edge_maps = imageGraph.GetEdgeMap();
+    for(size_t i = 0; i < node_num; i++) {
+        for(EdgeMap::const_iterator it = edge_maps[i].begin(); it != edge_maps[i].end(); it++) {
+            if(it->first <= (int)i) {
+                continue;
+            }
+            const vector<int>& a = node_clusters[i];
+            const vector<int>& b = node_clusters[it->first];
+            total += it->second.score;
+            for(size_t j = 0; j < a.size(); j++) {
+                if(find(b.begin(), b.end(), a[j]) != b.end()) {
+                    kept += it->second.score;
+                    break;
+                }
+            }
+        }
+    }
+    cout << "overlap: " << imageGraphs.size() << " clusters, largest " << max_size 
+         << " images, replication factor " << (double)replicas / max(node_num, (size_t)1) 
+         << ", kept similarity " << (total > 0 ? kept / total : 1.0) << endl;
+}
+
+void GraphCluster::SaveClusterTree(const ImageGraph& imageGraph, const vector<shared_ptr<ImageGraph>>& imageGraphs, 
+                                   string dir) const
+{
+    auto start = chrono::steady_clock::now();
+    ClusterTree tree;
+    tree.Build(imageGraph, imageGraphs, threadNum);
+    if(tree.Save(dir + "/cluster_tree.txt")) {
+        cout << "cluster tree: " << tree.leafNum << " clusters, " << tree.links.size() << " links, " 
+             << tree.merges.size() << " merges in " << tree.Rounds() << " rounds, " 
+             << chrono::duration<double>(chrono::steady_clock::now() - start).count() << "s" << endl;
+    }
+}
+
 void GraphCluster::MoveImages(queue<shared_ptr<ImageGraph>> imageGraphs, string dir)
 {
     int i = 0;
+    vector<shared_ptr<ImageGraph>> moved_graphs;
     while(!imageGraphs.empty()) {
         shared_ptr<ImageGraph> ig = imageGraphs.front();
         imageGraphs.pop();
+        moved_graphs.push_back(ig);
         std::vector<ImageNode> img_nodes = ig->GetImageNode();
 
         if(!stlplus::folder_create(dir + "/image_part_" + std::to_string(i))) {
@@ -145,6 +662,9 @@ void GraphCluster::MoveImages(queue<shared_ptr<ImageGraph>> imageGraphs, string
         }
         i++;
     }
+    if(verbose) {
+        PrintClusterWeights(moved_graphs);
+    }
 }
 
 void GraphCluster::MoveImages(vector<shared_ptr<ImageGraph>> imageGraphs, string dir)
@@ -182,14 +702,22 @@ void GraphCluster::MoveImages(vector<shared_ptr<ImageGraph>> imageGraphs, string
     }
     out_graph.close();
     out_cluster.close();
+    if(verbose) {
+        PrintClusterWeights(imageGraphs);
+    }
 }
 
 pair<shared_ptr<ImageGraph>, shared_ptr<ImageGraph>> GraphCluster::BiPartition(ImageGraph imageGraph, string dir)
 {
     pair<shared_ptr<ImageGraph>, shared_ptr<ImageGraph>> graph_pair;
 
-    string nc_file = GenerateNCGraph(imageGraph, dir);
-    vector<size_t> clusters = NormalizedCut(nc_file, 2);
+    // The halves of a weighted graph are kept balanced by weight
+    size_t max_weight = 0;
+    if(imageGraph.IsWeighted()) {
+        max_weight = (size_t)ceil(imageGraph.GetWeight() * 0.55);
+    }
+    vector<size_t> clusters = dir.empty() ? NormalizedCut(imageGraph, 2, max_weight) : 
+                                            NormalizedCut(GenerateNCGraph(imageGraph, dir), 2, max_weight);
     queue<shared_ptr<ImageGraph>> graphs = ConstructSubGraphs(imageGraph, clusters, 2);
     if(graphs.size() != 2) {
         cout << "Error occured when bi-partition image graph\n";
@@ -202,6 +730,122 @@ pair<shared_ptr<ImageGraph>, shared_ptr<ImageGraph>> GraphCluster::BiPartition(I
     return graph_pair;
 }
 
+BisectionTree GraphCluster::BuildBisectionTree(ImageGraph imageGraph, string dir, size_t leafSize)
+{
+    BisectionTree tree;
+    std::vector<ImageNode> nodes = imageGraph.GetImageNode();
+    std::unordered_map<int, uint32_t> position;
+
+    tree.signature = BisectionTree::Signature(imageGraph);
+    tree.leafSize = leafSize;
+    for(uint32_t i = 0; i < nodes.size(); i++) {
+        position[nodes[i].idx] = i;
+        tree.order.push_back(i);
+    }
+    BisectionNode root;
+    root.end = nodes.size();
+    root.weight = imageGraph.GetWeight();
+    tree.nodes.push_back(root);
+
+    queue<pair<int, shared_ptr<ImageGraph>>> pending;
+    pending.push(make_pair(0, make_shared<ImageGraph>(imageGraph)));
+    while(!pending.empty()) {
+        int k = pending.front().first;
+        shared_ptr<ImageGraph> ig = pending.front().second;
+        pending.pop();
+        if(ig->GetNodeSize() <= leafSize) {
+            continue;
+        }
+
+        pair<shared_ptr<ImageGraph>, shared_ptr<ImageGraph>> halves = BiPartition(*ig, dir);
+        if(!halves.first || !halves.second || 
+           halves.first->GetNodeSize() == 0 || halves.second->GetNodeSize() == 0) {
+            // The graph cannot be divided, it stays a leaf
+            continue;
+        }
+
+        // Cut and association scores of the bisection
+        std::vector<ImageNode> ig_nodes = ig->GetImageNode();
+        std::vector<EdgeMap> edge_maps = ig->GetEdgeMap();
+        std::unordered_map<int, int> side;
+        for(auto node : ig_nodes) {
+            side[node.idx] = 1;
+        }
+        for(auto node : halves.first->GetImageNode()) {
+            side[node.idx] = 0;
+        }
+        double cut = 0, assoc[2] = {0, 0};
+        for(int i = 0; i < ig_nodes.size(); i++) {
+            int s = side[ig_nodes[i].idx];
+            for(EdgeMap::iterator it = edge_maps[i].begin(); it != edge_maps[i].end(); it++) {
+                assoc[s] += it->second.score;
+                if(side[ig_nodes[it->first].idx] != s) {
+                    cut += it->second.score;
+                }
+            }
+        }
+        cut /= 2;  // every edge is stored in both directions
+
+        // The images of the first half are put before the ones of the second half
+        BisectionNode left, right;
+        left.begin = tree.nodes[k].begin;
+        left.end = right.begin = left.begin;
+        for(auto node : halves.first->GetImageNode()) {
+            tree.order[left.end++] = position[node.idx];
+        }
+        right.begin = right.end = left.end;
+        for(auto node : halves.second->GetImageNode()) {
+            tree.order[right.end++] = position[node.idx];
+        }
+        left.weight = halves.first->GetWeight();
+        right.weight = halves.second->GetWeight();
+
+        tree.nodes[k].cut = cut;
+        tree.nodes[k].ncut = (assoc[0] > 0 ? cut / assoc[0] : 0) + (assoc[1] > 0 ? cut / assoc[1] : 0);
+        tree.nodes[k].left = tree.nodes.size();
+        tree.nodes[k].right = tree.nodes.size() + 1;
+        pending.push(make_pair(tree.nodes[k].left, halves.first));
+        pending.push(make_pair(tree.nodes[k].right, halves.second));
+        tree.nodes.push_back(left);
+        tree.nodes.push_back(right);
+    }
+
+    cout << "bisection tree: " << tree.nodes.size() << " nodes, leaves of at most " << leafSize << " images" << endl;
+    return tree;
+}
+
+BisectionTree GraphCluster::LoadBisectionTree(ImageGraph imageGraph, string dir, size_t leafSize)
+{
+    string filename = dir + "/bisection_tree.bin";
+    BisectionTree tree;
+
+    if(tree.Load(filename)) {
+        if(tree.signature == BisectionTree::Signature(imageGraph) && 
+           tree.order.size() == imageGraph.GetNodeSize() && tree.leafSize <= leafSize) {
+            cout << "bisection tree loaded from " << filename << endl;
+            return tree;
+        }
+        cout << "bisection tree of " << filename << " doesn't match the graph or the cluster size, it is rebuilt" << endl;
+    }
+
+    tree = BuildBisectionTree(imageGraph, dir, leafSize);
+    tree.Save(filename);
+    return tree;
+}
+
+queue<shared_ptr<ImageGraph>> GraphCluster::CutBisectionTree(ImageGraph imageGraph, const BisectionTree& tree)
+{
+    std::vector<int> cut = tree.Cut(graphUpper, weightUpper);
+    cout << "bisection tree cut: " << cut.size() << " clusters, cut score " << tree.CutScore(cut) << endl;
+    return ConstructSubGraphs(imageGraph, tree.Labels(cut), cut.size());
+}
+
+bool GraphCluster::Oversized(const ImageGraph& imageGraph) const
+{
+    return imageGraph.GetNodeSize() > graphUpper || 
+           (weightUpper > 0 && imageGraph.GetWeight() > weightUpper);
+}
+
 bool GraphCluster::HasEdge(vector<shared_ptr<ImageGraph>> graphs, LinkEdge edge)
 {
     for(auto graph : graphs) {
@@ -231,81 +875,224 @@ bool GraphCluster::HasEdge(queue<shared_ptr<ImageGraph>> graphs, LinkEdge edge)
     return hasEdge;
 }
 
-priority_queue<LinkEdge> GraphCluster::DiscardedEdges(ImageGraph imageGraph, 
-                                        vector<shared_ptr<ImageGraph>> insizeGraphs, 
-                                        queue<shared_ptr<ImageGraph>> candidateGraphs)
+// "GCCK" and the version of the checkpoint layout
+static const uint32_t kCheckpointMagic = 0x4b434347;
+static const uint32_t kCheckpointVersion = 2;
+
+template <typename T>
+static void AppendValue(string& buffer, T value)
 {
-    priority_queue<LinkEdge> discarded_edges;
-    std::vector<EdgeMap> edge_maps = imageGraph.GetEdgeMap();
-    std::vector<ImageNode> nodes = imageGraph.GetImageNode();
+    buffer.append((const char*)&value, sizeof(T));
+}
 
+template <typename T>
+static bool ReadValue(const string& buffer, size_t& pos, T& value)
+{
+    if(pos + sizeof(T) > buffer.size()) {
+        return false;
+    }
+    memcpy(&value, buffer.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+// A graph is stored as the positions of its nodes in the original image graph 
+// and its edges (src < dst) in local indices
+static void AppendGraph(string& buffer, const ImageGraph& graph, 
+                        const unordered_map<int, uint32_t>& position)
+{
+    std::vector<ImageNode> nodes = graph.GetImageNode();
+    std::vector<EdgeMap> edge_maps = graph.GetEdgeMap();
+
+    AppendValue<uint32_t>(buffer, nodes.size());
+    for(auto node : nodes) {
+        AppendValue<uint32_t>(buffer, position.at(node.idx));
+    }
+    uint32_t nedges = 0;
     for(int i = 0; i < nodes.size(); i++) {
-        for(int j = i + 1; j < nodes.size(); j++) {
-            EdgeMap::iterator it = edge_maps[i].find(j);
-            if(it != edge_maps[i].end()) {
-                LinkEdge edge = it->second;
-                // if(!HasEdge(insizeGraphs, edge) && !HasEdge(candidateGraphs, edge)) {
-                if(!HasEdge(insizeGraphs, edge)) {
-                    discarded_edges.push(edge);
-                }
+        for(EdgeMap::iterator it = edge_maps[i].begin(); it != edge_maps[i].end(); it++) {
+            nedges += (it->first > i);
+        }
+    }
+    AppendValue<uint32_t>(buffer, nedges);
+    for(int i = 0; i < nodes.size(); i++) {
+        for(EdgeMap::iterator it = edge_maps[i].begin(); it != edge_maps[i].end(); it++) {
+            if(it->first > i) {
+                AppendValue<uint32_t>(buffer, i);
+                AppendValue<uint32_t>(buffer, it->first);
+                AppendValue<float>(buffer, it->second.score);
             }
         }
     }
-    return discarded_edges;
 }
 
-int GraphCluster::RepeatedNodeNum(const ImageGraph imageGraphL, const ImageGraph imageGraphR)
+static shared_ptr<ImageGraph> ReadGraph(const string& buffer, size_t& pos, 
+                                        const std::vector<ImageNode>& imageNodes)
 {
-    int num = 0;
-    std::vector<ImageNode> l_nodes = imageGraphL.GetImageNode();
-    std::vector<ImageNode> r_nodes = imageGraphR.GetImageNode();
-    for(auto lnode : l_nodes) {
-        for(auto rnode : r_nodes) {
-            if(lnode.idx == rnode.idx) num++;
+    uint32_t nnodes, nedges, src, dst, position;
+    float score;
+
+    if(!ReadValue(buffer, pos, nnodes) || nnodes > imageNodes.size()) {
+        return nullptr;
+    }
+    shared_ptr<ImageGraph> graph(new ImageGraph());
+    for(uint32_t i = 0; i < nnodes; i++) {
+        if(!ReadValue(buffer, pos, position) || position >= imageNodes.size()) {
+            return nullptr;
+        }
+        graph->AddNode(imageNodes[position]);
+    }
+    if(!ReadValue(buffer, pos, nedges)) {
+        return nullptr;
+    }
+    for(uint32_t e = 0; e < nedges; e++) {
+        if(!ReadValue(buffer, pos, src) || !ReadValue(buffer, pos, dst) || 
+           !ReadValue(buffer, pos, score) || src >= nnodes || dst >= nnodes) {
+            return nullptr;
         }
+        graph->AddEdgeu(src, dst, score);
     }
-    return num;
+    return graph;
 }
 
-pair<ImageNode, shared_ptr<ImageGraph>> GraphCluster::SelectCRGraph(ImageGraph imageGraph, vector<shared_ptr<ImageGraph>> graphs, LinkEdge edge)
+bool GraphCluster::SaveCheckpoint(string filename, const ImageGraph& imageGraph, 
+                                  const vector<shared_ptr<ImageGraph>>& insizeGraphs, 
+                                  queue<shared_ptr<ImageGraph>> candidateGraphs, size_t round)
 {
-    ImageNode unselected_node, selected_node;
-    bool find = true;
-    srand((unsigned)time(NULL));
-    int ran = rand() % 2;
+    std::vector<ImageNode> nodes = imageGraph.GetImageNode();
+    unordered_map<int, uint32_t> position;
+    for(uint32_t i = 0; i < nodes.size(); i++) {
+        position[nodes[i].idx] = i;
+    }
 
-    for(int i = 0; i < graphs.size(); i++) {
-        unselected_node = (ran == 0) ? imageGraph.GetNode(edge.dst) : imageGraph.GetNode(edge.src);
-        selected_node = (ran == 0) ? graphs[i]->GetNode(edge.src) : graphs[i]->GetNode(edge.dst);
-        int repeatedNodeNum = 0;
-        if(selected_node.idx != -1) {
-            for(int j = 0; j < graphs.size(); j++) {
-                if(i != j) {
-                    repeatedNodeNum += RepeatedNodeNum(*graphs[i], *graphs[j]);
-                    // if((float)repeatedNodeNum / (float)graphs[i].GetNodeSize() > completeRatio) {
-                    //     break;
-                    // }
-                }
-            }
-            if((float)repeatedNodeNum / (float)graphs[i]->GetNodeSize() <= completeRatio) {
-                return make_pair(unselected_node, graphs[i]);
-            }
-        }
+    string buffer;
+    AppendValue<uint32_t>(buffer, kCheckpointMagic);
+    AppendValue<uint32_t>(buffer, kCheckpointVersion);
+    AppendValue<uint64_t>(buffer, BisectionTree::Signature(imageGraph));
+    AppendValue<uint64_t>(buffer, graphUpper);
+    AppendValue<uint64_t>(buffer, weightUpper);
+    AppendValue<float>(buffer, completeRatio);
+    AppendValue<uint64_t>(buffer, round);
+
+    AppendValue<uint32_t>(buffer, insizeGraphs.size());
+    for(auto graph : insizeGraphs) {
+        AppendGraph(buffer, *graph, position);
+    }
+    AppendValue<uint32_t>(buffer, candidateGraphs.size());
+    for(; !candidateGraphs.empty(); candidateGraphs.pop()) {
+        AppendGraph(buffer, *candidateGraphs.front(), position);
+    }
+
+    string tmp_file = filename + ".tmp";
+    FILE *fd = fopen(tmp_file.c_str(), "wb");
+    if(fd == NULL) {
+        cerr << "Checkpoint " << tmp_file << " cannot be created!" << endl;
+        return false;
+    }
+    bool ok = fwrite(buffer.data(), 1, buffer.size(), fd) == buffer.size();
+    ok = (fclose(fd) == 0) && ok;
+    if(!ok || rename(tmp_file.c_str(), filename.c_str()) != 0) {
+        cerr << "Checkpoint " << filename << " cannot be written!" << endl;
+        remove(tmp_file.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool GraphCluster::LoadCheckpoint(string filename, const ImageGraph& imageGraph, 
+                                  vector<shared_ptr<ImageGraph>>& insizeGraphs, 
+                                  queue<shared_ptr<ImageGraph>>& candidateGraphs, size_t& round)
+{
+    ifstream in(filename, ios::binary);
+    if(!in.is_open()) {
+        cerr << "Checkpoint " << filename << " cannot be opened!" << endl;
+        return false;
+    }
+    string buffer((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+
+    size_t pos = 0;
+    uint32_t magic, version, ngraphs;
+    uint64_t signature, upper, weight_upper, rounds;
+    float ratio;
+    if(!ReadValue(buffer, pos, magic) || !ReadValue(buffer, pos, version) || 
+       magic != kCheckpointMagic || version != kCheckpointVersion ||
+       !ReadValue(buffer, pos, signature) || !ReadValue(buffer, pos, upper) || 
+       !ReadValue(buffer, pos, weight_upper) || !ReadValue(buffer, pos, ratio) || 
+       !ReadValue(buffer, pos, rounds)) {
+        cerr << "Checkpoint " << filename << " is not valid!" << endl;
+        return false;
+    }
+    if(signature != BisectionTree::Signature(imageGraph) || upper != graphUpper || 
+       weight_upper != weightUpper || ratio != completeRatio) {
+        cerr << "Checkpoint " << filename << " belongs to another graph or other parameters!" << endl;
+        return false;
     }
-    shared_ptr<ImageGraph> rep(new ImageGraph());
-    return make_pair(ImageNode(), rep);
+
+    std::vector<ImageNode> nodes = imageGraph.GetImageNode();
+    vector<shared_ptr<ImageGraph>> insize_graphs;
+    queue<shared_ptr<ImageGraph>> candidate_graphs;
+    bool ok = ReadValue(buffer, pos, ngraphs);
+    for(uint32_t i = 0; ok && i < ngraphs; i++) {
+        shared_ptr<ImageGraph> graph = ReadGraph(buffer, pos, nodes);
+        ok = (graph != nullptr);
+        insize_graphs.push_back(graph);
+    }
+    ok = ok && ReadValue(buffer, pos, ngraphs);
+    for(uint32_t i = 0; ok && i < ngraphs; i++) {
+        shared_ptr<ImageGraph> graph = ReadGraph(buffer, pos, nodes);
+        ok = (graph != nullptr);
+        candidate_graphs.push(graph);
+    }
+    if(!ok || pos != buffer.size()) {
+        cerr << "Checkpoint " << filename << " is not valid!" << endl;
+        return false;
+    }
+
+    insizeGraphs = insize_graphs;
+    candidateGraphs = candidate_graphs;
+    round = rounds;
+    return true;
 }
 
-vector<shared_ptr<ImageGraph>> GraphCluster::ExpanGraphCluster(ImageGraph imageGraph, queue<shared_ptr<ImageGraph>> imageGraphs, string dir, size_t clusterNum)
+vector<shared_ptr<ImageGraph>> GraphCluster::ExpanGraphCluster(ImageGraph imageGraph, queue<shared_ptr<ImageGraph>> imageGraphs, string dir, size_t clusterNum, bool resume)
 {
     vector<shared_ptr<ImageGraph>> insize_graphs;
     queue<shared_ptr<ImageGraph>>& candidate_graphs = imageGraphs;
+    string checkpoint_file = dir + "/expansion_checkpoint.bin";
+    size_t round = 0;
+
+    if(resume) {
+        if(!LoadCheckpoint(checkpoint_file, imageGraph, insize_graphs, candidate_graphs, round)) {
+            return insize_graphs;
+        }
+        cout << "resumed from round " << round << ": " << insize_graphs.size() << " clusters, " 
+             << candidate_graphs.size() << " candidates" << endl;
+    }
+
+    // The initial clusters are saved, then a checkpoint is written when the rounds since
+    // the last one took at least checkpointInterval seconds and 50 times the last 
+    // checkpoint, so that the checkpoints take at most 2% of the run time
+    auto last_checkpoint = chrono::steady_clock::now();
+    double checkpoint_seconds = 0;
 
     while(!candidate_graphs.empty()) {
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - last_checkpoint).count();
+        if(checkpointInterval > 0 && !dir.empty() && ((round == 0 && !resume) || elapsed >= max(checkpointInterval, 50 * checkpoint_seconds))) {
+            auto start = chrono::steady_clock::now();
+            bool saved = SaveCheckpoint(checkpoint_file, imageGraph, insize_graphs, candidate_graphs, round);
+            last_checkpoint = chrono::steady_clock::now();
+            checkpoint_seconds = chrono::duration<double>(last_checkpoint - start).count();
+            if(saved) {
+                cout << "checkpoint of round " << round << " saved in " << checkpoint_seconds << "s" << endl;
+            }
+        }
+        round++;
+
         while(!candidate_graphs.empty()) {
             shared_ptr<ImageGraph> ig = candidate_graphs.front();
             candidate_graphs.pop();
-            if(ig->GetNodeSize() <= graphUpper) {
+            if(!Oversized(*ig)) {
                 insize_graphs.push_back(ig);
             }
             else {
@@ -316,45 +1103,382 @@ vector<shared_ptr<ImageGraph>> GraphCluster::ExpanGraphCluster(ImageGraph imageG
         }
 
         // Graph expansion
-        priority_queue<LinkEdge> discarded_edges = 
-            DiscardedEdges(imageGraph, insize_graphs, candidate_graphs);
-        while(!discarded_edges.empty()) {
-            LinkEdge edge = discarded_edges.top();
-            discarded_edges.pop();
-            cout << "discarded_edges: " << edge.src << ", " << edge.dst << endl; 
-
-            pair<ImageNode, shared_ptr<ImageGraph>> crp_graph = 
-                SelectCRGraph(imageGraph, insize_graphs, edge);
-            ImageNode unselected_node = crp_graph.first;
-            shared_ptr<ImageGraph> selected_graph = crp_graph.second;
-            if(unselected_node.idx != -1) {
-                if(selected_graph->GetNode(unselected_node.idx).idx == -1) {
-                    selected_graph->AddNode(unselected_node);
-                }
-                selected_graph->AddEdgeu(selected_graph->Map2CurrentIdx(edge.src), 
-                                        selected_graph->Map2CurrentIdx(edge.dst), 
-                                        edge.score);
-            }
+        ClusterExpansion expansion(completeRatio, threadNum);
+        expansion.Expand(imageGraph, insize_graphs);
+        if(verbose) {
+            cout << "expansion round " << round << ": " << expansion.discardedEdges << " discarded matches, " 
+                 << expansion.restoredEdges << " restored by " << expansion.copiedImages << " copied images, " 
+                 << expansion.totalTime << "s" << endl;
         }
         // After graph expansion, there may be some image graph that doesn't
         // satisfy the size constraint, check this condition
         std::vector<shared_ptr<ImageGraph>>::iterator igIte;
         for(igIte = insize_graphs.begin(); igIte != insize_graphs.end();) {
             // Make a little relax of original constraint condition
-            if((*igIte)->GetNodeSize() > graphUpper) {
+            if(Oversized(**igIte)) {
                 candidate_graphs.push(*igIte);
                 igIte = insize_graphs.erase(igIte);
             }
             else igIte++;
         }
+        if(progress) {
+            progress("expansion", (double)insize_graphs.size() / (insize_graphs.size() + candidate_graphs.size()));
+        }
+    }
+    if(!dir.empty() && stlplus::file_exists(checkpoint_file)) {
+        stlplus::file_delete(checkpoint_file);
+    }
+    if(verbose) {
+        cout << "end ExpanGraphCluster\n";
     }
-    cout << "end ExpanGraphCluster\n";
     return insize_graphs;
 }
 
+bool GraphCluster::IncrementalGraphCluster(const ImageGraph& imageGraph, string vocFile, string dir)
+{
+    auto start = chrono::steady_clock::now();
+    const std::vector<ImageNode>& nodes = imageGraph.ImageNodes();
+    const std::vector<EdgeMap>& new_edges = imageGraph.EdgeMaps();
+    size_t n = nodes.size();
+
+    // Previous clusters, an image may belong to several of them after the expansion
+    ifstream graph_in(dir + "/graph.txt");
+    if(!graph_in.is_open()) {
+        cerr << "graph.txt of the previous clusters cannot be opened!" << endl;
+        return false;
+    }
+    vector<vector<int>> members;
+    vector<vector<int>> member_of(n);
+    string line;
+    while(getline(graph_in, line)) {
+        stringstream line_in(line);
+        vector<int> cluster;
+        int idx;
+        while(line_in >> idx) {
+            if(idx < 0 || idx >= n) {
+                cerr << "graph.txt refers to image " << idx << " that is not in the image list!" << endl;
+                return false;
+            }
+            cluster.push_back(idx);
+            member_of[idx].push_back(members.size());
+        }
+        if(!cluster.empty()) {
+            members.push_back(cluster);
+        }
+    }
+    graph_in.close();
+
+    // The similarity score of image i to every cluster of its neighbors in a graph
+    unordered_map<int, double> scores;
+    auto cluster_scores = [&](const EdgeMap& edges, const vector<int>& globalIdx) {
+        scores.clear();
+        for(EdgeMap::const_iterator it = edges.begin(); it != edges.end(); it++) {
+            for(int c : member_of[globalIdx.empty() ? it->first : globalIdx[it->first]]) {
+                scores[c] += it->second.score;
+            }
+        }
+    };
+
+    // New images join their best connected cluster by their new matches. An image that 
+    // is only connected to other new images waits until one of them is assigned.
+    vector<int> new_images;
+    for(int i = 0; i < n; i++) {
+        if(member_of[i].empty()) {
+            new_images.push_back(i);
+        }
+    }
+    size_t new_num = new_images.size();
+    set<int> touched;
+    for(bool assigned = true; assigned && !new_images.empty(); ) {
+        assigned = false;
+        vector<int> waiting;
+        for(int i : new_images) {
+            cluster_scores(new_edges[i], vector<int>());
+            if(scores.empty()) {
+                waiting.push_back(i);
+                continue;
+            }
+            int best = max_element(scores.begin(), scores.end(), 
+                [](const pair<const int, double>& a, const pair<const int, double>& b) {
+                    return a.second < b.second || (a.second == b.second && a.first > b.first);
+                })->first;
+            members[best].push_back(i);
+            member_of[i].push_back(best);
+            touched.insert(best);
+            assigned = true;
+        }
+        new_images.swap(waiting);
+    }
+    // Images that are not connected to the collection start clusters of their own, of 
+    // at most graphUpper images, so that none of them is cut without matches
+    for(size_t first = 0; first < new_images.size(); first += graphUpper) {
+        vector<int> cluster(new_images.begin() + first, 
+                            new_images.begin() + min(first + graphUpper, new_images.size()));
+        for(int i : cluster) {
+            member_of[i].push_back(members.size());
+        }
+        touched.insert(members.size());
+        members.push_back(cluster);
+    }
+    cout << new_num << " new images, " << touched.size() << " of " << members.size() << " clusters touched" << endl;
+    if(touched.empty()) {
+        return true;
+    }
+
+    // The images of the touched clusters are clustered again in a local graph, with 
+    // their new matches and the previous matches between them. Only these matches 
+    // are kept from the previous match file.
+    vector<int> touched_list(touched.begin(), touched.end());
+    unordered_map<int, int> local_cluster;
+    for(int k = 0; k < touched_list.size(); k++) {
+        local_cluster[touched_list[k]] = k;
+    }
+    vector<int> local_to_global;
+    vector<int> global_to_local(n, -1);
+    for(int c : touched_list) {
+        for(int i : members[c]) {
+            if(global_to_local[i] == -1) {
+                global_to_local[i] = local_to_global.size();
+                local_to_global.push_back(i);
+            }
+        }
+    }
+
+    ImageGraph local_graph;
+    for(int l = 0; l < local_to_global.size(); l++) {
+        const ImageNode& node = nodes[local_to_global[l]];
+        local_graph.AddNode(ImageNode(l, node.image_name, node.sift_name, node.weight));
+    }
+    for(int l = 0; l < local_to_global.size(); l++) {
+        const EdgeMap& edges = new_edges[local_to_global[l]];
+        for(EdgeMap::const_iterator it = edges.begin(); it != edges.end(); it++) {
+            if(global_to_local[it->first] != -1) {
+                local_graph.AddEdge(l, global_to_local[it->first], it->second.score);
+            }
+        }
+    }
+    ifstream voc_in(vocFile);
+    if(!voc_in.is_open()) {
+        cerr << "File of vocabulary tree cannot be opened!" << endl;
+        return false;
+    }
+    size_t src, dst;
+    float score;
+    while(voc_in >> src >> dst >> score) {
+        if(src < n && dst < n && src != dst && global_to_local[src] != -1 && global_to_local[dst] != -1) {
+            local_graph.AddEdgeu(global_to_local[src], global_to_local[dst], score);
+        }
+    }
+    voc_in.close();
+
+    // Each image starts in the touched cluster it is best connected to, the expansion 
+    // adds the copies
+    vector<size_t> labels;
+    const std::vector<EdgeMap>& local_edges = local_graph.EdgeMaps();
+    for(int l = 0; l < local_to_global.size(); l++) {
+        int i = local_to_global[l];
+        int best = -1;
+        double best_score = 0;
+        if(member_of[i].size() > 1) {
+            cluster_scores(local_edges[l], local_to_global);
+        }
+        for(int m : member_of[i]) {
+            if(!local_cluster.count(m)) {
+                continue;
+            }
+            double m_score = member_of[i].size() > 1 ? scores[m] : 0;
+            if(best == -1 || m_score > best_score) {
+                best = m;
+                best_score = m_score;
+            }
+        }
+        labels.push_back(local_cluster[best]);
+    }
+
+    // A touched cluster whose images are all better connected elsewhere is left empty
+    queue<shared_ptr<ImageGraph>> local_graphs;
+    queue<shared_ptr<ImageGraph>> sub_graphs = ConstructSubGraphs(local_graph, labels, touched_list.size());
+    for(; !sub_graphs.empty(); sub_graphs.pop()) {
+        if(sub_graphs.front()->GetNodeSize() > 0) {
+            local_graphs.push(sub_graphs.front());
+        }
+    }
+    vector<shared_ptr<ImageGraph>> local_clusters = 
+        ExpanGraphCluster(local_graph, local_graphs, dir, touched_list.size());
+
+    // The new clusters take the places of the touched ones, the others are appended
+    vector<int> slots = touched_list;
+    for(size_t k = touched_list.size(); k < local_clusters.size(); k++) {
+        slots.push_back(members.size() + k - touched_list.size());
+    }
+    members.resize(max(members.size(), (size_t)*max_element(slots.begin(), slots.end()) + 1));
+    for(size_t k = 0; k < slots.size(); k++) {
+        members[slots[k]].clear();
+        if(k < local_clusters.size()) {
+            for(auto node : local_clusters[k]->GetImageNode()) {
+                members[slots[k]].push_back(local_to_global[node.idx]);
+            }
+        }
+    }
+    // Touched clusters without a replacement are dropped, the later ones are renumbered
+    vector<int> renumber(members.size(), -1);
+    vector<vector<int>> kept;
+    for(size_t c = 0; c < members.size(); c++) {
+        if(!members[c].empty()) {
+            renumber[c] = kept.size();
+            kept.push_back(members[c]);
+        }
+    }
+    set<int> changed;
+    for(size_t k = 0; k < slots.size(); k++) {
+        if(renumber[slots[k]] != -1) {
+            changed.insert(renumber[slots[k]]);
+        }
+    }
+    for(size_t c = 0; c < renumber.size(); c++) {
+        if(renumber[c] != -1 && renumber[c] != c) {
+            changed.insert(renumber[c]);
+        }
+    }
+
+    // Only the folders of the changed clusters are written again
+    ofstream out_graph(dir + "/graph.txt");
+    ofstream out_cluster(dir + "/clusters.txt");
+    if(!out_graph.is_open() || !out_cluster.is_open()) {
+        cerr << "graph.txt or clusters.txt cannot be created!" << endl;
+        return false;
+    }
+    for(size_t c = 0; c < kept.size(); c++) {
+        string sub_folder = dir + "/image_part_" + std::to_string(c);
+        out_cluster << sub_folder << "\n";
+        for(int i : kept[c]) {
+            out_graph << i << " ";
+        }
+        out_graph << "\n";
+
+        if(!changed.count(c)) {
+            continue;
+        }
+        if(stlplus::folder_exists(sub_folder)) {
+            stlplus::folder_delete(sub_folder, true);
+        }
+        if(!stlplus::folder_create(sub_folder)) {
+            cerr << "image part " << c << " cannot be created!" << endl;
+        }
+        for(int i : kept[c]) {
+            string new_file = sub_folder + "/" + stlplus::filename_part(nodes[i].image_name);
+            if(!stlplus::file_copy(nodes[i].image_name, new_file)) {
+                cout << "cannot copy " << nodes[i].image_name << " to " << new_file << endl;
+            }
+        }
+    }
+    for(size_t c = kept.size(); c < members.size(); c++) {
+        string sub_folder = dir + "/image_part_" + std::to_string(c);
+        if(stlplus::folder_exists(sub_folder)) {
+            stlplus::folder_delete(sub_folder, true);
+        }
+    }
+    out_graph.close();
+    out_cluster.close();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "incremental clustering: " << local_to_global.size() << " images clustered again, " 
+         << changed.size() << " of " << kept.size() << " clusters written, " << seconds << "s" << endl;
+    return true;
+}
+
+vector<shared_ptr<ImageGraph>> GraphCluster::VertexCutCluster(const ImageGraph& imageGraph, 
+                                                              queue<shared_ptr<ImageGraph>> imageGraphs, 
+                                                              size_t clusterNum)
+{
+    vector<ImageNode> nodes = imageGraph.GetImageNode();
+    vector<int> homes(nodes.size(), -1);
+    for(int k = 0; !imageGraphs.empty(); imageGraphs.pop(), k++) {
+        vector<ImageNode> ig_nodes = imageGraphs.front()->GetImageNode();
+        for(auto node : ig_nodes) {
+            if(node.idx >= 0 && node.idx < nodes.size()) {
+                homes[node.idx] = k;
+            }
+        }
+        clusterNum = max(clusterNum, (size_t)k + 1);
+    }
+
+    // The partitioner sees the images by their positions in nodeOrder, the matches of 
+    // neighboring images come one after the other
+    vector<EdgeMap> edge_maps = imageGraph.GetEdgeMap();
+    LocalityOrder order(edge_maps, nodeOrder);
+    vector<LinkEdge> edges;
+    for(size_t k = 0; k < nodes.size(); k++) {
+        size_t i = order.Empty() ? k : order.order[k];
+        for(EdgeMap::const_iterator it = edge_maps[i].begin(); it != edge_maps[i].end(); it++) {
+            size_t l = order.Empty() ? it->first : order.rank[it->first];
+            if(l > k) {
+                edges.push_back(LinkEdge(k, l, it->second.score));
+            }
+        }
+    }
+    homes = order.ToPositions(homes);
+
+    auto start = chrono::steady_clock::now();
+    size_t thread_num = threadNum > 0 ? threadNum : max(thread::hardware_concurrency(), 1u);
+    EdgePartitioner partitioner(graphUpper, (size_t)(completeRatio * nodes.size()));
+    partitioner.Partition(nodes.size(), edges, homes, clusterNum, thread_num);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if(!order.Empty()) {
+        for(auto& cluster : partitioner.clusters) {
+            for(auto& node : cluster) {
+                node = order.order[node];
+            }
+        }
+    }
+
+    size_t dropped = 0;
+    for(size_t e = 0; e < edges.size(); e++) {
+        dropped += (partitioner.edgeClusters[e] == -1);
+    }
+    if(verbose) {
+        cout << "vertex cut: " << nodes.size() << " nodes, " << edges.size() << " edges, " 
+             << partitioner.clusters.size() << " clusters, " << partitioner.Replicas() << " replicas, " 
+             << dropped << " edges dropped, " << seconds << "s" << endl;
+    }
+
+    // The clusters keep all the matches between their images
+    vector<shared_ptr<ImageGraph>> clusters;
+    vector<int> local(nodes.size(), -1);
+    for(size_t k = 0; k < partitioner.clusters.size(); k++) {
+        const vector<uint32_t>& cluster = partitioner.clusters[k];
+        if(cluster.empty()) {
+            continue;
+        }
+        shared_ptr<ImageGraph> ig(new ImageGraph());
+        for(size_t l = 0; l < cluster.size(); l++) {
+            local[cluster[l]] = l;
+            ig->AddNode(nodes[cluster[l]]);
+        }
+        for(size_t l = 0; l < cluster.size(); l++) {
+            for(EdgeMap::const_iterator it = edge_maps[cluster[l]].begin(); it != edge_maps[cluster[l]].end(); it++) {
+                if(local[it->first] > (int)l) {
+                    ig->AddEdgeu(l, local[it->first], it->second.score);
+                }
+            }
+        }
+        for(size_t l = 0; l < cluster.size(); l++) {
+            local[cluster[l]] = -1;
+        }
+        clusters.push_back(ig);
+    }
+    return clusters;
+}
+
 vector<shared_ptr<ImageGraph>> GraphCluster::NaiveGraphCluster(queue<shared_ptr<ImageGraph>> imageGraphs, string dir, size_t clusterNum)
 {
     MoveImages(imageGraphs, dir);
+
+    vector<shared_ptr<ImageGraph>> clusters;
+    for(; !imageGraphs.empty(); imageGraphs.pop()) {
+        clusters.push_back(imageGraphs.front());
+    }
+    return clusters;
 }
 
 queue<shared_ptr<ImageGraph>> GraphCluster::ConstructSubGraphs(ImageGraph imageGraph, vector<size_t> clusters, size_t clusterNum)
@@ -389,4 +1513,110 @@ queue<shared_ptr<ImageGraph>> GraphCluster::ConstructSubGraphs(ImageGraph imageG
     return imageGraphs;
 }
 
+void GraphCluster::SetWeightUpper(const ImageGraph& imageGraph)
+{
+    weightUpper = 0;
+    if(imageGraph.IsWeighted() && imageGraph.GetNodeSize() > 0) {
+        // The weight of graphUpper images of average weight
+        weightUpper = (size_t)ceil((double)imageGraph.GetWeight() * graphUpper / imageGraph.GetNodeSize());
+    }
+}
+
+size_t GraphCluster::ClusterNumber(const ImageGraph& imageGraph, string clusterOption, string partition, 
+                                   size_t& maxClusterSize)
+{
+    size_t node_num = imageGraph.GetNodeSize();
+    size_t clust_num = 1;
+    maxClusterSize = 0;
+    if(node_num <= graphUpper || partition == "community") {
+        // The number of communities is found by CommunityCluster
+    }
+    else if(clusterOption == "vertexcut") {
+        // The images of the normalized-cut clusters are copied into the clusters of their 
+        // matches, leave room for completeRatio copies in addition
+        maxClusterSize = max((size_t)1, (size_t)(graphUpper / (1.0 + completeRatio)));
+        clust_num = (size_t)ceil(node_num / (0.9 * maxClusterSize));
+    }
+    else if(partition == "bounded") {
+        // The bound is hard, leave some slack over the average cluster size
+        clust_num = (size_t)ceil(node_num / (0.9 * graphUpper));
+        maxClusterSize = graphUpper;
+    }
+    else {
+        // Between graphUpper and 2 * graphUpper images still need two clusters
+        clust_num = max((size_t)2, node_num / graphUpper);
+    }
+
+    SetWeightUpper(imageGraph);
+    if(imageGraph.IsWeighted() && clust_num > 1) {
+        // Kernel k-means doesn't balance the clusters by itself, bound their weights
+        maxClusterSize = (size_t)ceil(imageGraph.GetWeight() / (0.9 * clust_num));
+        if(verbose) {
+            cout << "weight: " << imageGraph.GetWeight() << ", cluster weight bound: " << maxClusterSize 
+                 << ", after expansion: " << weightUpper << endl;
+        }
+    }
+    return clust_num;
+}
+
+vector<shared_ptr<ImageGraph>> GraphCluster::ClusterGraph(const ImageGraph& imageGraph, string clusterOption, 
+                                                          string partition, string dir)
+{
+    size_t node_num = imageGraph.GetNodeSize();
+    vector<shared_ptr<ImageGraph>> clusters;
+    if(node_num == 0) {
+        return clusters;
+    }
+    if(node_num <= graphUpper) {
+        clusters.push_back(make_shared<ImageGraph>(imageGraph));
+        return clusters;
+    }
+    size_t max_clust_size = 0;
+    size_t clust_num = ClusterNumber(imageGraph, clusterOption, partition, max_clust_size);
+
+    vector<size_t> labels;
+    if(progress) {
+        progress("partition", 0.0);
+    }
+    if(partition == "community") {
+        labels = CommunityCluster(imageGraph, clust_num);
+    }
+    else if(dir.empty()) {
+        labels = NormalizedCut(SparsifyGraph(imageGraph), clust_num, max_clust_size);
+    }
+    else {
+        string nc_graph = GenerateNCGraph(SparsifyGraph(imageGraph), dir);
+        labels = NormalizedCut(nc_graph, clust_num, max_clust_size);
+    }
+    if(labels.size() != node_num) {
+        return clusters;
+    }
+    if(verbose && edgeBudget > 0 && partition != "community") {
+        cout << "ncut on all the " << imageGraph.GetEdgeSize() / 2 << " matches: " 
+             << NCutValue(imageGraph, labels) << endl;
+    }
+    queue<shared_ptr<ImageGraph>> sub_image_graphs = ConstructSubGraphs(imageGraph, labels, clust_num);
+    if(progress) {
+        progress("partition", 1.0);
+    }
+
+    if(clusterOption == "expansion") {
+        clusters = ExpanGraphCluster(imageGraph, sub_image_graphs, dir, clust_num);
+    }
+    else if(clusterOption == "vertexcut") {
+        clusters = VertexCutCluster(imageGraph, sub_image_graphs, clust_num);
+    }
+    else {
+        for(; !sub_image_graphs.empty(); sub_image_graphs.pop()) {
+            if(sub_image_graphs.front()->GetNodeSize() > 0) {
+                clusters.push_back(sub_image_graphs.front());
+            }
+        }
+    }
+    if(progress) {
+        progress(clusterOption, 1.0);
+    }
+    return clusters;
+}
+
 }   // namespace bluefish
\ No newline at end of file
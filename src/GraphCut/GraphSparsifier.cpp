@@ -0,0 +1,244 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "GraphSparsifier.hpp"
+#include "UnionFind.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <thread>
+
+namespace bluefish {
+
+// The passes over the nodes give every thread blocks of this many nodes
+static const size_t kNodeBlock = 4096;
+
+// A match with the smallest alpha at which one of its images keeps it
+struct SparseEdge
+{
+    float alpha;
+    float score;
+    uint32_t src;
+    uint32_t dst;
+
+    // by alpha, then by similarity, then by the images, so that the order is unique
+    bool operator<(const SparseEdge& e) const
+    {
+        if(alpha != e.alpha) return alpha < e.alpha;
+        if(score != e.score) return score > e.score;
+        return src != e.src ? src < e.src : dst < e.dst;
+    }
+};
+
+// Run body(begin, end) over the blocks of [0, n) on threadNum threads
+static void ParallelBlocks(size_t threadNum, size_t n, const std::function<void(size_t, size_t)>& body)
+{
+    auto work = [&](size_t t) {
+        for(size_t begin = t * kNodeBlock; begin < n; begin += threadNum * kNodeBlock) {
+            body(begin, std::min(begin + kNodeBlock, n));
+        }
+    };
+    std::vector<std::thread> threads;
+    for(size_t t = 1; t < threadNum; t++) {
+        threads.push_back(std::thread(work, t));
+    }
+    work(0);
+    for(auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Sort the chunks of items on their own threads, then merge them pairwise
+template<typename T, typename Less>
+static void ParallelSort(std::vector<T>& items, size_t threadNum, Less less)
+{
+    size_t parts = std::max((size_t)1, std::min(threadNum, items.size() / kNodeBlock));
+    std::vector<size_t> bounds(parts + 1);
+    for(size_t i = 0; i <= parts; i++) {
+        bounds[i] = items.size() * i / parts;
+    }
+    for(size_t width = 0; width < parts; width = (width == 0 ? 1 : 2 * width)) {
+        std::vector<std::thread> threads;
+        for(size_t i = 0; i < parts; i += (width == 0 ? 1 : 2 * width)) {
+            if(width == 0) {
+                threads.push_back(std::thread([&, i]() {
+                    std::sort(items.begin() + bounds[i], items.begin() + bounds[i + 1], less);
+                }));
+            }
+            else if(i + width < parts) {
+                size_t end = bounds[std::min(i + 2 * width, parts)];
+                threads.push_back(std::thread([&, i, width, end]() {
+                    std::inplace_merge(items.begin() + bounds[i], items.begin() + bounds[i + width], 
+                                       items.begin() + end, less);
+                }));
+            }
+        }
+        for(auto& thread : threads) {
+            thread.join();
+        }
+    }
+}
+
+GraphSparsifier::GraphSparsifier(size_t edgeBudget, size_t threadNum)
+{
+    this->edgeBudget = edgeBudget;
+    this->threadNum = threadNum;
+}
+
+ImageGraph GraphSparsifier::Sparsify(const ImageGraph& imageGraph)
+{
+    auto start = std::chrono::steady_clock::now();
+    size_t node_num = imageGraph.GetNodeSize();
+    inputEdges = imageGraph.GetEdgeSize() / 2;
+    keptEdges = inputEdges;
+    forestEdges = 0;
+    components = 0;
+    keptSimilarity = 1.0;
+    totalTime = 0;
+    if(inputEdges <= edgeBudget) {
+        return imageGraph;
+    }
+
+    const std::vector<EdgeMap>& edge_maps = imageGraph.EdgeMaps();
+    size_t thread_num = threadNum > 0 ? threadNum : std::max(std::thread::hardware_concurrency(), 1u);
+    thread_num = std::max((size_t)1, std::min(thread_num, (node_num + kNodeBlock - 1) / kNodeBlock));
+
+    // The matches of every image sorted by the other image, with the alpha from which 
+    // the image keeps them: the match of rank r is kept by ceil(degree^alpha) > r
+    std::vector<size_t> offsets(node_num + 1, 0);
+    for(size_t u = 0; u < node_num; u++) {
+        offsets[u + 1] = offsets[u] + edge_maps[u].size();
+    }
+    std::vector<uint32_t> neighbors(offsets[node_num]);
+    std::vector<float> alphas(offsets[node_num]);
+    std::vector<float> scores(offsets[node_num]);
+    std::vector<size_t> upper(node_num + 1, 0);
+    ParallelBlocks(thread_num, node_num, [&](size_t begin, size_t end) {
+        std::vector<std::pair<float, uint32_t>> ranked;
+        std::vector<std::pair<uint32_t, std::pair<float, float>>> sorted;
+        for(size_t u = begin; u < end; u++) {
+            ranked.clear();
+            for(EdgeMap::const_iterator it = edge_maps[u].begin(); it != edge_maps[u].end(); it++) {
+                ranked.push_back(std::make_pair(-(float)it->second.score, (uint32_t)it->first));
+            }
+            std::sort(ranked.begin(), ranked.end());
+            double log_degree = ranked.size() > 1 ? std::log((double)ranked.size()) : 1.0;
+            sorted.clear();
+            for(size_t r = 0; r < ranked.size(); r++) {
+                float alpha = (float)(std::log((double)r + 1.0) / log_degree);
+                sorted.push_back(std::make_pair(ranked[r].second, std::make_pair(alpha, -ranked[r].first)));
+            }
+            std::sort(sorted.begin(), sorted.end());
+            for(size_t j = 0; j < sorted.size(); j++) {
+                neighbors[offsets[u] + j] = sorted[j].first;
+                alphas[offsets[u] + j] = sorted[j].second.first;
+                scores[offsets[u] + j] = sorted[j].second.second;
+                if(sorted[j].first > u) {
+                    upper[u + 1]++;
+                }
+            }
+        }
+    });
+
+    // Every match once, from its smaller image
+    for(size_t u = 0; u < node_num; u++) {
+        upper[u + 1] += upper[u];
+    }
+    std::vector<SparseEdge> edges(upper[node_num]);
+    ParallelBlocks(thread_num, node_num, [&](size_t begin, size_t end) {
+        for(size_t u = begin; u < end; u++) {
+            size_t k = upper[u];
+            for(size_t j = offsets[u]; j < offsets[u + 1]; j++) {
+                uint32_t v = neighbors[j];
+                if(v <= u) continue;
+                std::vector<uint32_t>::const_iterator back = 
+                    std::lower_bound(neighbors.begin() + offsets[v], neighbors.begin() + offsets[v + 1], (uint32_t)u);
+                float alpha = alphas[j];
+                if(back != neighbors.begin() + offsets[v + 1] && *back == u) {
+                    alpha = std::min(alpha, alphas[back - neighbors.begin()]);
+                }
+                SparseEdge edge = {alpha, scores[j], (uint32_t)u, v};
+                edges[k++] = edge;
+            }
+        }
+    });
+    std::vector<uint32_t>().swap(neighbors);
+    std::vector<float>().swap(alphas);
+    std::vector<float>().swap(scores);
+    ParallelSort(edges, thread_num, std::less<SparseEdge>());
+
+    // The maximum spanning forest by similarity keeps the components connected through 
+    // their strongest matches. Kruskal takes the matches by decreasing similarity, the 
+    // order is unique.
+    std::vector<size_t> by_score(edges.size());
+    for(size_t e = 0; e < edges.size(); e++) {
+        by_score[e] = e;
+    }
+    ParallelSort(by_score, thread_num, [&edges](size_t a, size_t b) {
+        const SparseEdge& x = edges[a];
+        const SparseEdge& y = edges[b];
+        if(x.score != y.score) return x.score > y.score;
+        return x.src != y.src ? x.src < y.src : x.dst < y.dst;
+    });
+    UnionFind forest(node_num);
+    std::vector<bool> in_forest(edges.size(), false);
+    for(size_t e : by_score) {
+        if(forest.UnionSet(edges[e].src, edges[e].dst)) {
+            in_forest[e] = true;
+            forestEdges++;
+        }
+    }
+    std::vector<size_t>().swap(by_score);
+    components = forest.set_num;
+
+    ImageGraph sparse_graph;
+    std::vector<ImageNode> nodes = imageGraph.GetImageNode();
+    for(auto& node : nodes) {
+        sparse_graph.AddNode(node);
+    }
+    size_t others = edgeBudget > forestEdges ? edgeBudget - forestEdges : 0;
+    double total = 0, kept = 0;
+    keptEdges = 0;
+    for(size_t e = 0; e < edges.size(); e++) {
+        total += edges[e].score;
+        if(in_forest[e] || others > 0) {
+            if(!in_forest[e]) {
+                others--;
+            }
+            sparse_graph.AddEdgeu(edges[e].src, edges[e].dst, edges[e].score);
+            kept += edges[e].score;
+            keptEdges++;
+        }
+    }
+    keptSimilarity = total > 0 ? kept / total : 1.0;
+    totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return sparse_graph;
+}
+
+}   // namespace bluefish
@@ -0,0 +1,194 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "LocalityOrder.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace bluefish {
+
+// The pseudo-peripheral search stops after this number of BFS sweeps
+static const int kPeripheralSweeps = 4;
+
+// Breadth-first levels from start over the images that are not placed yet, 
+// the visited images are appended to queue
+static void Levels(const std::vector<size_t>& xadj, const std::vector<uint32_t>& adjncy, 
+                   uint32_t start, std::vector<int>& level, std::vector<uint32_t>& queue)
+{
+    size_t head = queue.size();
+    level[start] = 0;
+    queue.push_back(start);
+    for(size_t q = head; q < queue.size(); q++) {
+        uint32_t v = queue[q];
+        for(size_t e = xadj[v]; e < xadj[v + 1]; e++) {
+            if(level[adjncy[e]] == -1) {
+                level[adjncy[e]] = level[v] + 1;
+                queue.push_back(adjncy[e]);
+            }
+        }
+    }
+}
+
+LocalityOrder::LocalityOrder(const ImageGraph& imageGraph, OrderMethod method)
+{
+    if(method != ORDER_NONE) {
+        *this = LocalityOrder(imageGraph.GetEdgeMap(), method);
+    }
+}
+
+LocalityOrder::LocalityOrder(const std::vector<EdgeMap>& edgeMaps, OrderMethod method)
+{
+    size_t n = edgeMaps.size();
+    if(method == ORDER_NONE || n == 0) {
+        return;
+    }
+
+    // Symmetric adjacency lists without duplicates, whether the graph stores one 
+    // or both directions of its edges
+    std::vector<size_t> xadj(n + 1, 0);
+    for(size_t i = 0; i < n; i++) {
+        for(EdgeMap::const_iterator it = edgeMaps[i].begin(); it != edgeMaps[i].end(); it++) {
+            if(it->first >= 0 && (size_t)it->first < n && (size_t)it->first != i) {
+                xadj[i + 1]++;
+                xadj[it->first + 1]++;
+            }
+        }
+    }
+    for(size_t i = 0; i < n; i++) {
+        xadj[i + 1] += xadj[i];
+    }
+    std::vector<uint32_t> adjncy(xadj[n]);
+    std::vector<size_t> fill(xadj.begin(), xadj.end() - 1);
+    for(size_t i = 0; i < n; i++) {
+        for(EdgeMap::const_iterator it = edgeMaps[i].begin(); it != edgeMaps[i].end(); it++) {
+            if(it->first >= 0 && (size_t)it->first < n && (size_t)it->first != i) {
+                adjncy[fill[i]++] = it->first;
+                adjncy[fill[it->first]++] = i;
+            }
+        }
+    }
+    size_t m = 0;
+    for(size_t i = 0; i < n; i++) {
+        std::vector<uint32_t>::iterator begin = adjncy.begin() + xadj[i];
+        std::sort(begin, adjncy.begin() + xadj[i + 1]);
+        size_t len = std::unique(begin, adjncy.begin() + xadj[i + 1]) - begin;
+        std::copy(begin, begin + len, adjncy.begin() + m);
+        xadj[i] = m;
+        m += len;
+    }
+    xadj[n] = m;
+    adjncy.resize(m);
+
+    // Neighbors by increasing degree for Cuthill-McKee, by decreasing degree for the BFS
+    bool ascending = (method == ORDER_RCM);
+    auto degree = [&](uint32_t v) { return xadj[v + 1] - xadj[v]; };
+    auto before = [&](uint32_t a, uint32_t b) {
+        if(degree(a) != degree(b)) return ascending ? degree(a) < degree(b) : degree(a) > degree(b);
+        return a < b;
+    };
+    for(size_t i = 0; i < n; i++) {
+        std::sort(adjncy.begin() + xadj[i], adjncy.begin() + xadj[i + 1], before);
+    }
+
+    // Roots of the components are tried in the same order as the neighbors
+    std::vector<uint32_t> roots(n);
+    for(size_t i = 0; i < n; i++) {
+        roots[i] = i;
+    }
+    std::sort(roots.begin(), roots.end(), before);
+
+    std::vector<int> placed(n, -1), level(n, -1);
+    std::vector<uint32_t> sweep;
+    order.reserve(n);
+    for(size_t r = 0; r < n; r++) {
+        uint32_t start = roots[r];
+        if(placed[start] != -1) {
+            continue;
+        }
+        if(method == ORDER_RCM) {
+            // George-Liu: restart from the image of lowest degree in the last level 
+            // as long as the eccentricity grows
+            int eccentricity = -1;
+            for(int s = 0; s < kPeripheralSweeps; s++) {
+                sweep.clear();
+                Levels(xadj, adjncy, start, level, sweep);
+                int depth = level[sweep.back()];
+                uint32_t next = sweep.back();
+                for(size_t q = sweep.size(); q-- > 0 && level[sweep[q]] == depth; ) {
+                    if(degree(sweep[q]) <= degree(next)) next = sweep[q];
+                }
+                for(uint32_t v : sweep) {
+                    level[v] = -1;
+                }
+                if(depth <= eccentricity) {
+                    break;
+                }
+                eccentricity = depth;
+                start = next;
+            }
+        }
+        // placed[] marks the visited images, adjncy is sorted so that the 
+        // neighbors are appended in the order of the method
+        Levels(xadj, adjncy, start, placed, order);
+    }
+    if(method == ORDER_RCM) {
+        std::reverse(order.begin(), order.end());
+    }
+
+    rank.resize(n);
+    for(size_t k = 0; k < n; k++) {
+        rank[order[k]] = k;
+    }
+}
+
+double LocalityOrder::EdgeSpan(const std::vector<EdgeMap>& edgeMaps, const std::vector<uint32_t>& rank)
+{
+    size_t n = edgeMaps.size();
+    double span = 0;
+    size_t edges = 0;
+    for(size_t i = 0; i < n; i++) {
+        for(EdgeMap::const_iterator it = edgeMaps[i].begin(); it != edgeMaps[i].end(); it++) {
+            size_t j = it->first;
+            if(j >= n || j == i) continue;
+            span += rank.empty() ? std::abs((double)i - (double)j) : std::abs((double)rank[i] - (double)rank[j]);
+            edges++;
+        }
+    }
+    return edges > 0 ? span / edges : 0;
+}
+
+const char* OrderName(OrderMethod method)
+{
+    switch(method) {
+        case ORDER_RCM: return "rcm";
+        case ORDER_BFS: return "bfs";
+        default: return "none";
+    }
+}
+
+}   // namespace bluefish
@@ -0,0 +1,367 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ShardedCluster.hpp"
+#include "GraphCluster.hpp"
+#include "ClusterAPI.hpp"
+
+#include "stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace bluefish {
+
+// "GCSH" and the version of the shard file layout
+static const uint32_t kShardMagic = 0x48534347;
+static const uint32_t kShardVersion = 1;
+
+static string ShardFile(const string& dir, size_t k)
+{
+    return dir + "/shard_" + to_string(k) + ".bin";
+}
+
+static string ClusterFile(const string& dir, size_t k)
+{
+    return dir + "/shard_" + to_string(k) + ".clusters";
+}
+
+static string LockFile(const string& dir, size_t k)
+{
+    return dir + "/shard_" + to_string(k) + ".lock";
+}
+
+// Process that claimed a shard, written into its lock file, or 0 if there is none
+static pid_t LockOwner(const string& lockFile)
+{
+    ifstream lock_in(lockFile);
+    long pid = 0;
+    if(!(lock_in >> pid)) {
+        return 0;
+    }
+    return (pid_t)pid;
+}
+
+// match between two images of a shard, by their indices in the shard
+struct ShardEdge
+{
+    uint32_t src;
+    uint32_t dst;
+    float score;
+};
+
+ShardedCluster::ShardedCluster(string shardDir, size_t shardSize, size_t processNum)
+{
+    this->shardDir = shardDir;
+    this->shardSize = shardSize;
+    this->processNum = processNum > 0 ? processNum : 1;
+}
+
+size_t ShardedCluster::Split(string imageList, string vocFile, string siftList)
+{
+    // The first level: one pass of the stream partitioner, bounded by the shard size
+    GraphCluster splitter(shardSize, 0);
+    vector<size_t> labels = splitter.StreamCluster(imageList, vocFile, shardNum);
+    if(labels.empty()) {
+        return shardNum = 0;
+    }
+    ImageGraph node_graph = splitter.BuildGraph(imageList, "", siftList);
+    imageNodes = node_graph.GetImageNode();
+    if(imageNodes.size() != labels.size()) {
+        cerr << "Image list " << imageList << " cannot be read again!" << endl;
+        return shardNum = 0;
+    }
+
+    if(stlplus::folder_exists(shardDir)) {
+        stlplus::folder_delete(shardDir, true);
+    }
+    if(!stlplus::folder_create(shardDir)) {
+        cerr << "Shard directory " << shardDir << " cannot be created!" << endl;
+        return shardNum = 0;
+    }
+
+    // Every shard file starts with its images: index in the image list, weight and name
+    vector<uint32_t> local(labels.size());
+    vector<uint32_t> sizes(shardNum, 0);
+    for(size_t i = 0; i < labels.size(); i++) {
+        local[i] = sizes[labels[i]]++;
+    }
+    vector<FILE *> files(shardNum, NULL);
+    bool ok = true;
+    for(size_t k = 0; k < shardNum && ok; k++) {
+        files[k] = fopen(ShardFile(shardDir, k).c_str(), "wb");
+        uint32_t header[3] = {kShardMagic, kShardVersion, sizes[k]};
+        ok = files[k] != NULL && fwrite(header, sizeof(uint32_t), 3, files[k]) == 3;
+    }
+    for(size_t i = 0; i < labels.size() && ok; i++) {
+        FILE *fd = files[labels[i]];
+        uint32_t idx = i, length = imageNodes[i].image_name.size();
+        int32_t weight = imageNodes[i].weight;
+        ok = fwrite(&idx, sizeof(idx), 1, fd) == 1 && fwrite(&weight, sizeof(weight), 1, fd) == 1 &&
+             fwrite(&length, sizeof(length), 1, fd) == 1 && 
+             fwrite(imageNodes[i].image_name.data(), 1, length, fd) == length;
+    }
+
+    // The second pass appends the matches inside the shards
+    ifstream voc_in(vocFile);
+    size_t src, dst, inside = 0, between = 0;
+    float score;
+    double inside_score = 0, total_score = 0;
+    ok = ok && voc_in.is_open();
+    while(ok && voc_in >> src >> dst >> score) {
+        if(src >= labels.size() || dst >= labels.size() || src == dst) {
+            continue;
+        }
+        total_score += score;
+        if(labels[src] != labels[dst]) {
+            between++;
+            continue;
+        }
+        ShardEdge edge = {local[src], local[dst], score};
+        ok = fwrite(&edge.src, sizeof(edge.src), 1, files[labels[src]]) == 1 &&
+             fwrite(&edge.dst, sizeof(edge.dst), 1, files[labels[src]]) == 1 &&
+             fwrite(&edge.score, sizeof(edge.score), 1, files[labels[src]]) == 1;
+        inside++;
+        inside_score += score;
+    }
+    for(size_t k = 0; k < shardNum; k++) {
+        if(files[k] != NULL && fclose(files[k]) != 0) {
+            ok = false;
+        }
+    }
+    if(!ok) {
+        cerr << "Shard files cannot be written into " << shardDir << "!" << endl;
+        return shardNum = 0;
+    }
+
+    uint32_t largest = 0;
+    for(auto size : sizes) {
+        largest = max(largest, size);
+    }
+    cout << "shards: " << shardNum << " shards, largest " << largest << " images, " << inside 
+         << " matches inside, " << between << " matches between the shards, " 
+         << (total_score > 0 ? inside_score / total_score : 1.0) << " of the similarity kept" << endl;
+    return shardNum;
+}
+
+bool ShardedCluster::LoadShard(string filename, ImageGraph& imageGraph, vector<uint32_t>& images)
+{
+    FILE *fd = fopen(filename.c_str(), "rb");
+    if(fd == NULL) {
+        return false;
+    }
+    uint32_t header[3];
+    bool ok = fread(header, sizeof(uint32_t), 3, fd) == 3 && header[0] == kShardMagic && header[1] == kShardVersion;
+    imageGraph = ImageGraph();
+    images.clear();
+    for(uint32_t l = 0; ok && l < header[2]; l++) {
+        uint32_t idx, length;
+        int32_t weight;
+        ok = fread(&idx, sizeof(idx), 1, fd) == 1 && fread(&weight, sizeof(weight), 1, fd) == 1 &&
+             fread(&length, sizeof(length), 1, fd) == 1 && length < (1u << 16);
+        string name(ok ? length : 0, '\0');
+        ok = ok && fread(&name[0], 1, length, fd) == length;
+        if(ok) {
+            imageGraph.AddNode(ImageNode(l, name, "", weight));
+            images.push_back(idx);
+        }
+    }
+    ShardEdge edge;
+    while(ok && fread(&edge.src, sizeof(edge.src), 1, fd) == 1) {
+        ok = fread(&edge.dst, sizeof(edge.dst), 1, fd) == 1 && fread(&edge.score, sizeof(edge.score), 1, fd) == 1 &&
+             edge.src < images.size() && edge.dst < images.size();
+        if(ok) {
+            imageGraph.AddEdgeu(edge.src, edge.dst, edge.score);
+        }
+    }
+    fclose(fd);
+    return ok;
+}
+
+bool ShardedCluster::Work(string shardDir, const ClusterOptions& options)
+{
+    // A claimed shard that cannot be clustered keeps its lock, so that RunWorkers 
+    // knows who left it
+    bool ok = true;
+    for(size_t k = 0; stlplus::file_exists(ShardFile(shardDir, k)); k++) {
+        if(stlplus::file_exists(ClusterFile(shardDir, k))) {
+            continue;
+        }
+        // The lock file is the claim of the shard, only one process can create it
+        int lock = open(LockFile(shardDir, k).c_str(), O_CREAT | O_EXCL | O_WRONLY, 0644);
+        if(lock < 0) {
+            continue;
+        }
+        string pid = to_string(getpid()) + "\n";
+        if(write(lock, pid.data(), pid.size()) != (ssize_t)pid.size()) {
+            cerr << "Lock of shard " << k << " cannot be written!" << endl;
+        }
+        close(lock);
+
+        auto start = chrono::steady_clock::now();
+        ImageGraph shard_graph;
+        vector<uint32_t> images;
+        if(!LoadShard(ShardFile(shardDir, k), shard_graph, images)) {
+            cerr << "Shard " << ShardFile(shardDir, k) << " is not valid!" << endl;
+            ok = false;
+            continue;
+        }
+        // The normalized cuts of the shard stay in memory, and its clusters are written below
+        ClusterOptions shard_options = options;
+        shard_options.outputDir.clear();
+        shard_options.workDir.clear();
+        shard_options.resume = false;
+        shard_options.verbose = false;
+        vector<vector<size_t>> clusters;
+        string error;
+        if(!ClusterImages(shard_graph, shard_options, clusters, error)) {
+            cerr << "Shard " << k << " cannot be partitioned: " << error << endl;
+            ok = false;
+            continue;
+        }
+
+        // The clusters appear under their final name only when they are complete
+        string cluster_file = ClusterFile(shardDir, k);
+        ofstream cluster_out(cluster_file + ".tmp");
+        for(auto& cluster : clusters) {
+            for(size_t l = 0; l < cluster.size(); l++) {
+                cluster_out << (l > 0 ? " " : "") << images[cluster[l]];
+            }
+            cluster_out << "\n";
+        }
+        cluster_out.close();
+        if(!cluster_out || rename((cluster_file + ".tmp").c_str(), cluster_file.c_str()) != 0) {
+            cerr << "Clusters of shard " << k << " cannot be written!" << endl;
+            ok = false;
+            continue;
+        }
+        remove(LockFile(shardDir, k).c_str());
+        cout << "worker " << getpid() << ": shard " << k << ", " << images.size() << " images, " 
+             << clusters.size() << " clusters, " 
+             << chrono::duration<double>(chrono::steady_clock::now() - start).count() << "s" << endl;
+    }
+    return ok;
+}
+
+bool ShardedCluster::RunWorkers(const vector<string>& workerArgs)
+{
+    vector<char *> args;
+    for(auto& arg : workerArgs) {
+        args.push_back(const_cast<char *>(arg.c_str()));
+    }
+    args.push_back(NULL);
+
+    // A second round takes the shards of the workers that died
+    for(int round = 0; round < 2; round++) {
+        vector<size_t> missing;
+        for(size_t k = 0; k < shardNum; k++) {
+            if(!stlplus::file_exists(ClusterFile(shardDir, k))) {
+                missing.push_back(k);
+                // No worker is running, so the locks are left by dead workers
+                remove(LockFile(shardDir, k).c_str());
+            }
+        }
+        if(missing.empty()) {
+            return true;
+        }
+        if(round > 0) {
+            cerr << missing.size() << " shards were left by failed workers, they are run again" << endl;
+        }
+
+        vector<pid_t> workers;
+        size_t worker_num = min(processNum, missing.size());
+        for(size_t i = 0; i < worker_num; i++) {
+            pid_t pid = fork();
+            if(pid == 0) {
+                execvp(args[0], args.data());
+                _exit(127);
+            }
+            if(pid < 0) {
+                cerr << "Worker process cannot be started: " << strerror(errno) << endl;
+                break;
+            }
+            workers.push_back(pid);
+        }
+        for(pid_t pid : workers) {
+            int status;
+            waitpid(pid, &status, 0);
+            if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                cerr << "Worker " << pid << " failed" << endl;
+            }
+        }
+        // A worker that exits without the clusters of a shard it claimed failed as well, 
+        // whatever its exit status
+        for(size_t k : missing) {
+            pid_t owner = LockOwner(LockFile(shardDir, k));
+            if(owner > 0 && !stlplus::file_exists(ClusterFile(shardDir, k))) {
+                cerr << "Worker " << owner << " exited without the clusters of shard " << k << endl;
+            }
+        }
+        if(workers.empty()) {
+            return false;
+        }
+    }
+    for(size_t k = 0; k < shardNum; k++) {
+        if(!stlplus::file_exists(ClusterFile(shardDir, k))) {
+            cerr << "Shard " << k << " cannot be clustered!" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+vector<shared_ptr<ImageGraph>> ShardedCluster::Merge() const
+{
+    vector<shared_ptr<ImageGraph>> clusters;
+    for(size_t k = 0; k < shardNum; k++) {
+        ifstream cluster_in(ClusterFile(shardDir, k));
+        string line;
+        while(getline(cluster_in, line)) {
+            stringstream line_in(line);
+            shared_ptr<ImageGraph> cluster(new ImageGraph());
+            size_t idx;
+            while(line_in >> idx) {
+                if(idx < imageNodes.size()) {
+                    cluster->AddNode(imageNodes[idx]);
+                }
+            }
+            if(cluster->GetNodeSize() > 0) {
+                clusters.push_back(cluster);
+            }
+        }
+    }
+    return clusters;
+}
+
+}   // namespace bluefish
@@ -0,0 +1,155 @@
+/**
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification,
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may
+  be used to endorse or promote products derived from this software without specific
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "StreamPartitioner.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace bluefish {
+
+StreamPartitioner::StreamPartitioner(size_t nodeNum, size_t upper, float gamma)
+    : upper(std::max<size_t>(upper, 1)), gamma(gamma), nodeNum(nodeNum), labels(nodeNum, -1)
+{
+}
+
+void StreamPartitioner::Assign(size_t node, int cluster)
+{
+    if(cluster == (int)sizes.size()) {
+        sizes.push_back(0);
+    }
+    else {
+        open.erase(std::make_pair(sizes[cluster], cluster));
+    }
+    sizes[cluster]++;
+    if(sizes[cluster] < upper) {
+        open.insert(std::make_pair(sizes[cluster], cluster));
+    }
+    labels[node] = cluster;
+    arrived++;
+}
+
+int StreamPartitioner::Add(size_t node, const std::vector<std::pair<size_t, float>>& edges)
+{
+    if(node >= nodeNum) {
+        return -1;
+    }
+
+    // The matches to the images that have not arrived wait for them in the frontier
+    for(size_t i = 0; i < edges.size(); i++) {
+        size_t dst = edges[i].first;
+        if(dst < nodeNum && dst != node && labels[dst] == -1) {
+            frontier[dst].push_back(std::make_pair(node, edges[i].second));
+            frontierSize++;
+        }
+    }
+    if(labels[node] != -1) {
+        return labels[node];
+    }
+
+    std::vector<std::pair<size_t, float>> waiting;
+    std::unordered_map<size_t, std::vector<std::pair<size_t, float>>>::iterator it = frontier.find(node);
+    if(it != frontier.end()) {
+        waiting.swap(it->second);
+        frontier.erase(it);
+        frontierSize -= waiting.size();
+    }
+
+    // Similarity of the image to every cluster of the arrived images
+    std::unordered_map<int, double> conn;
+    for(size_t i = 0; i < edges.size(); i++) {
+        weightSum += edges[i].second;
+        if(edges[i].first < nodeNum && labels[edges[i].first] != -1) {
+            conn[labels[edges[i].first]] += edges[i].second;
+        }
+    }
+    for(size_t i = 0; i < waiting.size(); i++) {
+        conn[labels[waiting[i].first]] += waiting[i].second;
+    }
+
+    // Fennel: alpha = m * k^(gamma - 1) / n^gamma, the total similarity m is 
+    // extrapolated from the matches listed by the arrived images
+    size_t k = (nodeNum + upper - 1) / upper;
+    double n = (double)nodeNum;
+    double m = weightSum / (arrived + 1) * n / 2.0;
+    double alpha = m * std::pow((double)k, gamma - 1.0) / std::pow(n, gamma);
+
+    int best = -1;
+    double best_score = 0;
+    for(std::unordered_map<int, double>::const_iterator c = conn.begin(); c != conn.end(); c++) {
+        double s = (double)sizes[c->first];
+        if(sizes[c->first] >= upper) {
+            continue;
+        }
+        double score = c->second - alpha * (std::pow(s + 1.0, gamma) - std::pow(s, gamma));
+        if(best == -1 || score > best_score || (score == best_score && c->first < best)) {
+            best = c->first;
+            best_score = score;
+        }
+    }
+
+    // The clusters without similar images only differ by their size penalty, 
+    // so the smallest one is the candidate among them, or a new cluster while
+    // there are fewer than k
+    int lightest = -1;
+    double lightest_size = 0;
+    if(sizes.size() < k) {
+        lightest = (int)sizes.size();
+    }
+    else if(!open.empty()) {
+        lightest = open.begin()->second;
+        lightest_size = (double)open.begin()->first;
+    }
+    if(lightest != -1) {
+        double score = conn.count(lightest) ? conn[lightest] : 0.0;
+        score -= alpha * (std::pow(lightest_size + 1.0, gamma) - std::pow(lightest_size, gamma));
+        if(best == -1 || score > best_score) {
+            best = lightest;
+        }
+    }
+
+    // All clusters are full
+    if(best == -1) {
+        best = (int)sizes.size();
+    }
+    Assign(node, best);
+    return best;
+}
+
+size_t StreamPartitioner::Finish()
+{
+    size_t rest = 0;
+    for(size_t i = 0; i < nodeNum; i++) {
+        if(labels[i] == -1) {
+            Add(i, std::vector<std::pair<size_t, float>>());
+            rest++;
+        }
+    }
+    return rest;
+}
+
+}   // namespace bluefish
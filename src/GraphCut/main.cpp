@@ -26,65 +26,224 @@
 */
 
 #include "GraphCluster.hpp"
+#include "ClusterAPI.hpp"
+#include "ClusterServer.hpp"
 
+#include <sstream>
+
+#include "cmdLine/cmdLine.h"
 #include "stlplus3/filesystemSimplified/file_system.hpp"
 
 // #define __DEBUG__
 
 int main(int argc, char ** argv)
 {
+    string coarsen_option = "serial";
+    int thread_num = 1;
+    int restart_num = 1;
+    string init_option = "metis";
+    string engine_option = "graclus";
+    string partition_option = "kway";
+    string sift_list = "";
+    string sweep_option = "";
+    double checkpoint_interval = 60;
+    string new_matches = "";
+    double resolution = 1.0;
+    string order_option = "none";
+    string socket_path = "";
+    int shard_size = 0;
+    int process_num = 2;
+    string worker_dir = "";
+    int edge_budget = 0;
+
+    CmdLine cmd;
+    cmd.add(make_option('c', coarsen_option, "coarsen"));
+    cmd.add(make_option('t', thread_num, "threads"));
+    cmd.add(make_option('r', restart_num, "restarts"));
+    cmd.add(make_option('i', init_option, "init"));
+    cmd.add(make_option('e', engine_option, "engine"));
+    cmd.add(make_option('p', partition_option, "partition"));
+    cmd.add(make_option('w', sift_list, "weights"));
+    cmd.add(make_option('s', sweep_option, "sweep"));
+    cmd.add(make_option('k', checkpoint_interval, "checkpoint"));
+    cmd.add(make_switch('R', "resume"));
+    cmd.add(make_option('n', new_matches, "incremental"));
+    cmd.add(make_switch('f', "refine"));
+    cmd.add(make_option('m', resolution, "resolution"));
+    cmd.add(make_option('o', order_option, "order"));
+    cmd.add(make_option('S', socket_path, "serve"));
+    cmd.add(make_option('P', shard_size, "shards"));
+    cmd.add(make_option('j', process_num, "processes"));
+    cmd.add(make_option('W', worker_dir, "worker"));
+    cmd.add(make_option('b', edge_budget, "budget"));
+
+    try {
+        cmd.process(argc, argv);
+    } catch(const string& s) {
+        cerr << s << endl;
+        return 0;
+    }
+
     if(argc < 6) {
         cout << "Please input file path of the vocabulary tree\n" << endl;
         cout << "Usage: \n" << 
             "i23dSFM_GraphCluster absolut_img_path absolut_voc_path " << 
-            "cluster_option max_img_size completeness_ratio\n";
-        cout << "Notice: cluster_option must be 'naive' or 'expansion'\n";
+            "cluster_option max_img_size completeness_ratio [options]\n";
+        cout << "Notice: cluster_option must be 'naive', 'expansion' or 'vertexcut'\n";
+        cout << "Options:\n" <<
+            "  -c, --coarsen  'serial' or 'parallel' matching in normalized-cut coarsening (default serial)\n" <<
+            "  -t, --threads  number of threads of the normalized cut, 0 for all processors (default 1). The\n" <<
+            "                 expansion chooses its copies on one thread, only the discarded matches are\n" <<
+            "                 collected and the expanded clusters built on the threads\n" <<
+            "  -r, --restarts number of concurrent normalized-cut restarts, the best one is kept (default 1)\n" <<
+            "  -i, --init     'metis' or 'spectral' initial partition of the coarsest normalized-cut graph (default metis)\n" <<
+            "  -e, --engine   'graclus' or 'lp': multilevel kernel k-means of Graclus, or the faster\n" <<
+            "                 size-constrained label propagation (default graclus)\n" <<
+            "  -p, --partition 'kway', 'bounded', 'tree', 'stream' or 'community': 'bounded' keeps the normalized-cut\n" <<
+            "                 clusters within max_img_size, so that few of them need to be bisected again. 'tree' cuts\n" <<
+            "                 the bisection tree that is cached in bisection_tree.bin. 'stream' clusters the images in\n" <<
+            "                 one pass as their matches are read, absolut_voc_path may be '-'. 'community' takes the\n" <<
+            "                 Leiden communities of at most max_img_size images (default kway)\n" <<
+            "  -f, --refine   refine the clusters of '-p stream' or '-p community' by kernel k-means on the whole graph\n" <<
+            "  -m, --resolution resolution of the modularity of '-p community', larger for smaller communities (default 1)\n" <<
+            "  -o, --order    'none', 'rcm' or 'bfs': renumber the images for locality before they are partitioned, by\n" <<
+            "                 reverse Cuthill-McKee or by a degree-sorted BFS. The clusters are mapped back (default none)\n" <<
+            "  -b, --budget   sparsify the graph of the first normalized cut to this many matches, keeping the\n" <<
+            "                 best matches of every image and the connectivity (default 0, all the matches)\n" <<
+            "  -w, --weights  sift list in the order of the image list, the clusters are balanced by their\n" <<
+            "                 numbers of features instead of their numbers of images\n" <<
+            "  -s, --sweep    list of max_img_size:completeness_ratio, e.g. '50:0.7,100:0.5'. Every pair is\n" <<
+            "                 clustered from the bisection tree into sweep_<size>_<ratio>\n" <<
+            "  -k, --checkpoint minimum seconds between two checkpoints of the expansion, 0 for none (default 60)\n" <<
+            "  -R, --resume   continue the expansion from expansion_checkpoint.bin, the parameters must be the same\n" <<
+            "  -n, --incremental matches of the new images: the images of the image list that are not in the\n" <<
+            "                 graph.txt of the previous run are added to its clusters\n" <<
+            "  -S, --serve    keep the graph in memory and answer cluster requests on this Unix domain socket.\n" <<
+            "                 The arguments and options are the defaults of the requests, -t is the number of\n" <<
+            "                 requests that run at the same time\n" <<
+            "  -P, --shards   split the images into shards of at most this many images by a streaming pass, and\n" <<
+            "                 cluster the shards in worker processes without building the whole graph\n" <<
+            "  -j, --processes number of worker processes of -P (default 2)\n";
         return 0;
     }
 
-    // It's best to put them on image root path
     string img_list(argv[1]);
     string voc_file(argv[2]); 
     string cluster_option(argv[3]);
     int max_image_num = atoi(argv[4]);
     float completeness_ratio = atof(argv[5]);
 
-    GraphCluster graph_cluster(max_image_num, completeness_ratio);
-    
-    string dir = stlplus::folder_part(voc_file);
-    ImageGraph img_graph = graph_cluster.BuildGraph(img_list, voc_file);
-
-#ifdef __DEBUG__
-    img_graph.ShowInfo();
-#endif
-
-    size_t clustNum = 1;
-    cout << "nodes: " << img_graph.GetNodeSize() << endl;
-    cout << "graphUpper: " << graph_cluster.graphUpper << endl;
-    if(img_graph.GetNodeSize() < graph_cluster.graphUpper) {
-        cout << "size of graphs less than cluster size, camera cluster is the origin one\n";
+    ClusterOptions options;
+    options.clusterOption = cluster_option;
+    options.upper = max_image_num < 0 ? 0 : max_image_num;
+    options.completeRatio = completeness_ratio;
+    options.partition = partition_option;
+    if(coarsen_option == "parallel") {
+        options.parallelCoarsen = true;
+    }
+    else if(coarsen_option != "serial") {
+        cout << "coarsen option must be 'serial' or 'parallel'\n";
         return 0;
     }
-    else {
-        clustNum = img_graph.GetNodeSize() / graph_cluster.graphUpper;
+    if(init_option == "spectral") {
+        options.spectralInit = true;
     }
-
-    string nc_graph = graph_cluster.GenerateNCGraph(img_graph, dir);
-    vector<size_t> clusters = graph_cluster.NormalizedCut(nc_graph, clustNum);
-    queue<shared_ptr<ImageGraph>> sub_image_graphs = 
-        graph_cluster.ConstructSubGraphs(img_graph, clusters, clustNum);
-
-    if(cluster_option == "naive") {
-        graph_cluster.NaiveGraphCluster(sub_image_graphs, dir, clustNum);
+    else if(init_option != "metis") {
+        cout << "init option must be 'metis' or 'spectral'\n";
+        return 0;
     }
-    else if(cluster_option == "expansion") {
-        vector<shared_ptr<ImageGraph>> insize_graphs = 
-            graph_cluster.ExpanGraphCluster(img_graph, sub_image_graphs, dir, clustNum);
-        graph_cluster.MoveImages(insize_graphs, dir);
+    if(engine_option == "lp") {
+        options.labelPropagation = true;
     }
-    else {
-        cout << "cluster_option must be 'naive' or 'expansion'\n";
+    else if(engine_option != "graclus") {
+        cout << "engine option must be 'graclus' or 'lp'\n";
         return 0;
     }
+    if(order_option == "rcm") {
+        options.order = ORDER_RCM;
+    }
+    else if(order_option == "bfs") {
+        options.order = ORDER_BFS;
+    }
+    else if(order_option != "none") {
+        cout << "order option must be 'none', 'rcm' or 'bfs'\n";
+        return 0;
+    }
+    options.threadNum = thread_num < 0 ? 0 : thread_num;
+    options.restartNum = restart_num < 1 ? 1 : restart_num;
+    options.resolution = resolution;
+    options.edgeBudget = edge_budget < 0 ? 0 : edge_budget;
+    options.refine = cmd.used('f');
+    options.resume = cmd.used('R');
+    options.checkpointInterval = checkpoint_interval;
+    options.verbose = true;
+    // It's best to put them on image root path
+    string dir = stlplus::folder_part(voc_file == "-" ? img_list : voc_file);
+    options.workDir = dir;
+    options.outputDir = dir;
+
+    ClusterFiles files;
+    files.imageList = img_list;
+    files.matchFile = voc_file;
+    files.siftList = sift_list;
+    files.newMatches = new_matches;
+    files.shardSize = shard_size < 0 ? 0 : shard_size;
+    files.processNum = process_num < 1 ? 1 : process_num;
+    if(!sweep_option.empty()) {
+        stringstream sweep_in(sweep_option);
+        string param;
+        while(getline(sweep_in, param, ',')) {
+            size_t colon = param.find(':');
+            int upper = atoi(param.substr(0, colon).c_str());
+            if(upper <= 0) {
+                cout << "sweep parameters must be max_img_size:completeness_ratio\n";
+                return 0;
+            }
+            files.sweep.push_back(make_pair((size_t)upper, colon == string::npos ? 
+                                  completeness_ratio : (float)atof(param.substr(colon + 1).c_str())));
+        }
+    }
+
+    if(!worker_dir.empty()) {
+        // A worker process of -P, started by ClusterImageFiles with the arguments below
+        return ClusterShards(worker_dir, options) ? 0 : 1;
+    }
+
+    if(!socket_path.empty()) {
+        if(options.partition == "stream" || options.resume || !files.newMatches.empty() || !files.sweep.empty() || 
+           options.partition == "tree" || options.refine || files.shardSize > 0) {
+            cout << "the server answers 'kway', 'bounded' and 'community' requests on the whole graph, it cannot\n" <<
+                    "stream, resume, sweep, refine, shard, cut a tree or run incrementally\n";
+            return 0;
+        }
+        GraphCluster graph_cluster(options.upper, options.completeRatio);
+        ImageGraph img_graph = graph_cluster.BuildGraph(img_list, voc_file, sift_list);
 
-}
\ No newline at end of file
+#ifdef __DEBUG__
+        img_graph.ShowInfo();
+#endif
+
+        ClusterServer server(img_graph, options.threadNum);
+        server.defaults.clusterOption = cluster_option;
+        server.defaults.upper = options.upper;
+        server.defaults.completeRatio = completeness_ratio;
+        server.defaults.partition = partition_option;
+        server.defaults.engine = engine_option;
+        server.defaults.order = order_option;
+        server.defaults.resolution = resolution;
+        server.defaults.edgeBudget = options.edgeBudget;
+        return server.Serve(socket_path) ? 0 : 1;
+    }
+
+    // The workers of the shards run this program again with the same arguments
+    files.workerArgs.assign(argv, argv + argc);
+    files.workerArgs.push_back("-W");
+
+    vector<vector<size_t>> clusters;
+    string error;
+    if(!ClusterImageFiles(files, options, clusters, error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -29,6 +29,7 @@
 
 #include "ConsistentMatchGraph.hpp"
 #include "UnionFind.hpp"
+#include "Leiden.hpp"
 
 using namespace std;
 
@@ -158,7 +159,7 @@ namespace bluefish
         // Create the candidate matching set
         priority_queue<LinkEdge> matchSet = this->CreateCandidateMatchSet();
 
-        size_t m;   // TODO, community number
+        size_t m = _communityNum;
         size_t searchTime = communityScale * m * (m - 1) / 2;
         while(!matchSet.empty() && searchTime--)
         {
@@ -180,12 +181,28 @@ namespace bluefish
 
     void ConsistentMatchGraph::ComputeCommunityStructure()
     {
-        // TODO
+        LeidenCommunity leiden;
+        _communities = leiden.Compute(_tripletGraph);
+        _communityNum = leiden.CommunityNum();
     }
 
     priority_queue<LinkEdge> ConsistentMatchGraph::CreateCandidateMatchSet()
     {
-        // TODO
+        // The matches between two communities, strongest first. A match stored 
+        // in both directions is taken once.
+        priority_queue<LinkEdge> matchSet;
+        const std::vector<EdgeMap>& edgeMaps = _tripletGraph.EdgeMaps();
+        for(size_t i = 0; i < edgeMaps.size(); i++)
+        {
+            for(const auto& item : edgeMaps[i])
+            {
+                const LinkEdge& edge = item.second;
+                if(_communities[edge.src] == _communities[edge.dst]) continue;
+                if(edge.src > edge.dst && edgeMaps[edge.dst].count(edge.src)) continue;
+                matchSet.push(edge);
+            }
+        }
+        return matchSet;
     }
 
     // vector<size_T> ConsistentMatchGraph::FindShortestPath(size_t src, size_t dst)
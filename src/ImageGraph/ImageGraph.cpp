@@ -343,17 +343,32 @@ int ImageGraph::NodeNum() {return size_;}
 int ImageGraph::GetEdgeSize() const 
 { 
 	int edge_num = 0;
-	for (int i = 0; i < size_; i++) {
-		EdgeMap edgeMap = adj_maps_[i];
-		for (EdgeMap::iterator it = edgeMap.begin(); it != edgeMap.end(); it++) {
-			edge_num++;
-		}
-	}
+	for (int i = 0; i < size_; i++)
+		edge_num += adj_maps_[i].size();
 	return edge_num; 
 }
 int ImageGraph::GetNodeSize() const { return size_; }
 std::vector<ImageNode> ImageGraph::GetImageNode() const { return nodes_; }
 std::vector<EdgeMap> ImageGraph::GetEdgeMap() const { return adj_maps_; }
+const std::vector<EdgeMap>& ImageGraph::EdgeMaps() const { return adj_maps_; }
+const std::vector<ImageNode>& ImageGraph::ImageNodes() const { return nodes_; }
+
+long long ImageGraph::GetWeight() const
+{
+	long long weight = 0;
+	for (int i = 0; i < size_; i++)
+		weight += nodes_[i].weight;
+	return weight;
+}
+
+bool ImageGraph::IsWeighted() const
+{
+	for (int i = 0; i < size_; i++) {
+		if (nodes_[i].weight != 1)
+			return true;
+	}
+	return false;
+}
 
 int ImageGraph::Map2CurrentIdx(int idx)
 {
@@ -0,0 +1,499 @@
+/** 
+  Copyright (c) 2018 Yu Chen
+
+  Redistribution and use in source and binary forms, with or without modification, 
+  are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, 
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice, 
+  this list of conditions and the following disclaimer 
+  in the documentation and/or other materials provided with the distribution.
+
+  3. Neither the name of the GraphCluster nor the names of its contributors may 
+  be used to endorse or promote products derived from this software without specific 
+  prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY 
+  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+  BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, 
+  OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <atomic>
+#include <thread>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+#include "Leiden.hpp"
+
+using namespace std;
+
+namespace bluefish
+{
+    // nodes taken by a thread at a time
+    static const size_t kNodeChunk = 256;
+    // the local moving stops after this number of rounds over the nodes
+    static const size_t kMaxRounds = 64;
+    static const size_t kMaxLevels = 64;
+
+    // graph of an aggregation level, the nodes of a level are communities of the one below
+    struct LeidenLevel
+    {
+        size_t n = 0;
+        vector<size_t> xadj;
+        vector<uint32_t> adjncy;
+        vector<float> adjwgt;
+        vector<double> degree;      // weighted degree, including the edges inside the node
+        vector<size_t> size;        // number of nodes of the input graph
+    };
+
+    // weights of the edges to every community, with an open addressing hash table
+    class NeighborWeights
+    {
+    private:
+        vector<int> _keys;
+        vector<double> _values;
+        vector<size_t> _used;
+        size_t _mask = 0;
+
+    public:
+        vector<int> communities;    // communities in the order they are met
+
+        void Reset(size_t degree)
+        {
+            if(_keys.size() < 2 * degree + 2) {
+                size_t size = 16;
+                while(size < 2 * degree + 2) size <<= 1;
+                _keys.assign(size, -1);
+                _values.assign(size, 0.0);
+                _mask = size - 1;
+                _used.clear();
+            }
+            for(size_t slot : _used) {
+                _keys[slot] = -1;
+                _values[slot] = 0.0;
+            }
+            _used.clear();
+            communities.clear();
+        }
+        void Add(int key, double value)
+        {
+            size_t slot = ((size_t)key * 0x9E3779B1u) & _mask;
+            while(_keys[slot] != -1 && _keys[slot] != key) slot = (slot + 1) & _mask;
+            if(_keys[slot] == -1) {
+                _keys[slot] = key;
+                _used.push_back(slot);
+                communities.push_back(key);
+            }
+            _values[slot] += value;
+        }
+        double Get(int key) const
+        {
+            size_t slot = ((size_t)key * 0x9E3779B1u) & _mask;
+            while(_keys[slot] != -1) {
+                if(_keys[slot] == key) return _values[slot];
+                slot = (slot + 1) & _mask;
+            }
+            return 0.0;
+        }
+    };
+
+    template<typename Function>
+    static void RunThreads(size_t threadNum, Function function)
+    {
+        vector<thread> threads;
+        for(size_t t = 1; t < threadNum; t++) {
+            threads.push_back(thread(function, t));
+        }
+        function(0);
+        for(size_t t = 0; t < threads.size(); t++) {
+            threads[t].join();
+        }
+    }
+
+    static void AtomicAdd(atomic<double>& a, double value)
+    {
+        double old = a.load(memory_order_relaxed);
+        while(!a.compare_exchange_weak(old, old + value, memory_order_relaxed));
+    }
+
+    // Move the nodes to the neighbor communities of the largest modularity gain on all
+    // the threads, until no node moves. label[v] is a node id of the level.
+    static void LocalMoving(const LeidenLevel& g, vector<atomic<int>>& label, double scale, 
+                            size_t maxSize, const vector<uint32_t>& order, size_t threadNum)
+    {
+        size_t n = g.n;
+        vector<atomic<double>> sigma(n);
+        vector<atomic<size_t>> csize(n);
+        vector<atomic<int>> members(n);
+        vector<atomic<char>> active(n);
+        for(size_t v = 0; v < n; v++) {
+            sigma[v].store(0.0);
+            csize[v].store(0);
+            members[v].store(0);
+            active[v].store(1);
+        }
+        for(size_t v = 0; v < n; v++) {
+            int c = label[v].load();
+            sigma[c].store(sigma[c].load() + g.degree[v]);
+            csize[c].store(csize[c].load() + g.size[v]);
+            members[c].store(members[c].load() + 1);
+        }
+
+        for(size_t round = 0; round < kMaxRounds; round++) {
+            atomic<size_t> next(0), moves(0);
+            RunThreads(threadNum, [&](size_t) {
+                NeighborWeights weights;
+                size_t local_moves = 0;
+                for(size_t begin = next.fetch_add(kNodeChunk); begin < n; begin = next.fetch_add(kNodeChunk)) {
+                    size_t end = min(begin + kNodeChunk, n);
+                    for(size_t i = begin; i < end; i++) {
+                        uint32_t v = order[i];
+                        if(!active[v].exchange(0, memory_order_relaxed)) continue;
+
+                        weights.Reset(g.xadj[v + 1] - g.xadj[v]);
+                        for(size_t e = g.xadj[v]; e < g.xadj[v + 1]; e++) {
+                            weights.Add(label[g.adjncy[e]].load(memory_order_relaxed), g.adjwgt[e]);
+                        }
+                        int own = label[v].load(memory_order_relaxed);
+                        double kv = g.degree[v];
+                        size_t sv = g.size[v];
+                        // Gain of the modularity against the node alone
+                        double best_gain = weights.Get(own) - kv * (sigma[own].load(memory_order_relaxed) - kv) * scale;
+                        int best = own;
+                        for(int c : weights.communities) {
+                            if(c == own) continue;
+                            if(maxSize > 0 && csize[c].load(memory_order_relaxed) + sv > maxSize) continue;
+                            double gain = weights.Get(c) - kv * sigma[c].load(memory_order_relaxed) * scale;
+                            if(gain > best_gain || (gain == best_gain && best != own && c < best)) {
+                                best_gain = gain;
+                                best = c;
+                            }
+                        }
+                        if(best == own) continue;
+                        // Two nodes alone would swap their communities forever
+                        if(members[own].load(memory_order_relaxed) == 1 && 
+                           members[best].load(memory_order_relaxed) == 1 && best > own) continue;
+
+                        size_t size = csize[best].load(memory_order_relaxed);
+                        bool reserved = true;
+                        do {
+                            if(maxSize > 0 && size + sv > maxSize) {
+                                reserved = false;
+                                break;
+                            }
+                        } while(!csize[best].compare_exchange_weak(size, size + sv, memory_order_relaxed));
+                        if(!reserved) continue;
+
+                        csize[own].fetch_sub(sv, memory_order_relaxed);
+                        members[best].fetch_add(1, memory_order_relaxed);
+                        members[own].fetch_sub(1, memory_order_relaxed);
+                        AtomicAdd(sigma[best], kv);
+                        AtomicAdd(sigma[own], -kv);
+                        label[v].store(best, memory_order_relaxed);
+                        local_moves++;
+                        for(size_t e = g.xadj[v]; e < g.xadj[v + 1]; e++) {
+                            uint32_t u = g.adjncy[e];
+                            if(label[u].load(memory_order_relaxed) != best) {
+                                active[u].store(1, memory_order_relaxed);
+                            }
+                        }
+                    }
+                }
+                moves.fetch_add(local_moves);
+            });
+            if(moves.load() == 0) break;
+        }
+    }
+
+    // Split every community into well-connected sub-communities: the nodes start alone, 
+    // and a well-connected node alone joins the well-connected sub-community of its 
+    // community of the largest modularity gain. The communities are shared among the threads.
+    static vector<int> Refine(const LeidenLevel& g, const vector<int>& label, double scale, 
+                              unsigned int seed, size_t threadNum)
+    {
+        size_t n = g.n;
+        // nodes of every community, by counting sort
+        vector<size_t> start(n + 1, 0);
+        for(size_t v = 0; v < n; v++) start[label[v] + 1]++;
+        for(size_t c = 0; c < n; c++) start[c + 1] += start[c];
+        vector<uint32_t> nodes(n);
+        {
+            vector<size_t> fill(start.begin(), start.end() - 1);
+            for(size_t v = 0; v < n; v++) nodes[fill[label[v]]++] = v;
+        }
+
+        vector<int> rlabel(n);
+        vector<double> rsigma(n), rext(n);
+        vector<int> rcount(n, 1);
+        iota(rlabel.begin(), rlabel.end(), 0);
+
+        atomic<size_t> next(0);
+        RunThreads(threadNum, [&](size_t) {
+            NeighborWeights weights;
+            for(size_t c = next.fetch_add(1); c < n; c = next.fetch_add(1)) {
+                if(start[c + 1] - start[c] < 2) continue;
+                vector<uint32_t> members(nodes.begin() + start[c], nodes.begin() + start[c + 1]);
+                double sigma_c = 0;
+                for(uint32_t v : members) {
+                    sigma_c += g.degree[v];
+                    rsigma[v] = g.degree[v];
+                    double ext = 0;
+                    for(size_t e = g.xadj[v]; e < g.xadj[v + 1]; e++) {
+                        if(label[g.adjncy[e]] == (int)c) ext += g.adjwgt[e];
+                    }
+                    rext[v] = ext;
+                }
+                mt19937 rng(seed + (unsigned int)c);
+                shuffle(members.begin(), members.end(), rng);
+
+                for(uint32_t v : members) {
+                    double kv = g.degree[v];
+                    if(rcount[rlabel[v]] != 1 || rext[v] < kv * (sigma_c - kv) * scale) continue;
+
+                    weights.Reset(g.xadj[v + 1] - g.xadj[v]);
+                    for(size_t e = g.xadj[v]; e < g.xadj[v + 1]; e++) {
+                        uint32_t u = g.adjncy[e];
+                        if(label[u] == (int)c) weights.Add(rlabel[u], g.adjwgt[e]);
+                    }
+                    int best = -1;
+                    double best_gain = 0;
+                    for(int r : weights.communities) {
+                        if(r == rlabel[v] || rext[r] < rsigma[r] * (sigma_c - rsigma[r]) * scale) continue;
+                        double gain = weights.Get(r) - kv * rsigma[r] * scale;
+                        if(gain > best_gain || (best == -1 && gain == 0)) {
+                            best_gain = gain;
+                            best = r;
+                        }
+                    }
+                    if(best == -1) continue;
+
+                    int own = rlabel[v];
+                    rext[best] += rext[own] - 2.0 * weights.Get(best);
+                    rsigma[best] += rsigma[own];
+                    rcount[best] += rcount[own];
+                    rcount[own] = 0;
+                    rlabel[v] = best;
+                }
+            }
+        });
+        return rlabel;
+    }
+
+    // Graph of the sub-communities, group[v] is the node of v in it
+    static LeidenLevel Aggregate(const LeidenLevel& g, const vector<int>& group, size_t groupNum, size_t threadNum)
+    {
+        size_t n = g.n;
+        LeidenLevel cg;
+        cg.n = groupNum;
+        cg.degree.assign(groupNum, 0.0);
+        cg.size.assign(groupNum, 0);
+
+        vector<size_t> start(groupNum + 1, 0);
+        for(size_t v = 0; v < n; v++) start[group[v] + 1]++;
+        for(size_t c = 0; c < groupNum; c++) start[c + 1] += start[c];
+        vector<uint32_t> nodes(n);
+        {
+            vector<size_t> fill(start.begin(), start.end() - 1);
+            for(size_t v = 0; v < n; v++) nodes[fill[group[v]]++] = v;
+        }
+
+        // The threads build the rows of contiguous ranges of nodes, which are copied 
+        // into place after the offsets are known
+        size_t chunk_num = (groupNum + kNodeChunk - 1) / kNodeChunk;
+        vector<vector<uint32_t>> chunk_adjncy(chunk_num);
+        vector<vector<float>> chunk_adjwgt(chunk_num);
+        vector<size_t> degree_num(groupNum, 0);
+        atomic<size_t> next(0);
+        RunThreads(threadNum, [&](size_t) {
+            NeighborWeights weights;
+            for(size_t k = next.fetch_add(1); k < chunk_num; k = next.fetch_add(1)) {
+                size_t end = min((k + 1) * kNodeChunk, groupNum);
+                for(size_t c = k * kNodeChunk; c < end; c++) {
+                    size_t edge_num = 0;
+                    for(size_t i = start[c]; i < start[c + 1]; i++) {
+                        edge_num += g.xadj[nodes[i] + 1] - g.xadj[nodes[i]];
+                    }
+                    weights.Reset(edge_num);
+                    for(size_t i = start[c]; i < start[c + 1]; i++) {
+                        uint32_t v = nodes[i];
+                        cg.degree[c] += g.degree[v];
+                        cg.size[c] += g.size[v];
+                        for(size_t e = g.xadj[v]; e < g.xadj[v + 1]; e++) {
+                            int d = group[g.adjncy[e]];
+                            if(d != (int)c) weights.Add(d, g.adjwgt[e]);
+                        }
+                    }
+                    degree_num[c] = weights.communities.size();
+                    for(int d : weights.communities) {
+                        chunk_adjncy[k].push_back(d);
+                        chunk_adjwgt[k].push_back((float)weights.Get(d));
+                    }
+                }
+            }
+        });
+
+        cg.xadj.assign(groupNum + 1, 0);
+        for(size_t c = 0; c < groupNum; c++) cg.xadj[c + 1] = cg.xadj[c] + degree_num[c];
+        cg.adjncy.resize(cg.xadj[groupNum]);
+        cg.adjwgt.resize(cg.xadj[groupNum]);
+        next.store(0);
+        RunThreads(threadNum, [&](size_t) {
+            for(size_t k = next.fetch_add(1); k < chunk_num; k = next.fetch_add(1)) {
+                size_t offset = cg.xadj[k * kNodeChunk];
+                copy(chunk_adjncy[k].begin(), chunk_adjncy[k].end(), cg.adjncy.begin() + offset);
+                copy(chunk_adjwgt[k].begin(), chunk_adjwgt[k].end(), cg.adjwgt.begin() + offset);
+                vector<uint32_t>().swap(chunk_adjncy[k]);
+                vector<float>().swap(chunk_adjwgt[k]);
+            }
+        });
+        return cg;
+    }
+
+    // Renumber the labels from 0, returns the number of labels
+    static size_t Renumber(vector<int>& label, size_t n)
+    {
+        vector<int> id(n, -1);
+        size_t num = 0;
+        for(size_t v = 0; v < label.size(); v++) {
+            if(id[label[v]] == -1) id[label[v]] = num++;
+            label[v] = id[label[v]];
+        }
+        return num;
+    }
+
+    LeidenCommunity::LeidenCommunity(double resolution, size_t maxSize, size_t threadNum, unsigned int seed)
+        : _communityNum(0), _modularity(0), _levels(0), 
+          resolution(resolution), maxSize(maxSize), threadNum(threadNum), seed(seed)
+    {
+    }
+
+    std::vector<int> LeidenCommunity::Compute(const ImageGraph& g, const std::vector<uint32_t>& order)
+    {
+        size_t n = g.GetNodeSize();
+        std::vector<EdgeMap> edgeMaps = g.GetEdgeMap();
+        std::vector<size_t> xadj(n + 1, 0);
+        std::vector<uint32_t> adjncy;
+        std::vector<float> adjwgt;
+
+        // rank[i] is the inner index of node i
+        bool ordered = (order.size() == n);
+        std::vector<uint32_t> rank;
+        if(ordered) {
+            rank.resize(n);
+            for(size_t k = 0; k < n; k++) rank[order[k]] = k;
+        }
+
+        // The edges are stored in both directions, whether the image graph has one or both
+        std::vector<std::vector<std::pair<uint32_t, float> > > adj(n);
+        for(size_t i = 0; i < n; i++) {
+            for(EdgeMap::const_iterator it = edgeMaps[i].begin(); it != edgeMaps[i].end(); it++) {
+                size_t j = it->first;
+                if(j >= n || j == i) continue;
+                if(edgeMaps[j].find(i) == edgeMaps[j].end() || i < j) {
+                    uint32_t u = ordered ? rank[i] : i, v = ordered ? rank[j] : j;
+                    adj[u].push_back(make_pair(v, it->second.score));
+                    adj[v].push_back(make_pair(u, it->second.score));
+                }
+            }
+        }
+        for(size_t i = 0; i < n; i++) {
+            if(ordered) std::sort(adj[i].begin(), adj[i].end());
+            xadj[i + 1] = xadj[i] + adj[i].size();
+            for(auto edge : adj[i]) {
+                adjncy.push_back(edge.first);
+                adjwgt.push_back(edge.second);
+            }
+            std::vector<std::pair<uint32_t, float> >().swap(adj[i]);
+        }
+        std::vector<int> communities = Compute(n, xadj, adjncy, adjwgt);
+        if(!ordered) {
+            return communities;
+        }
+        std::vector<int> mapped(n);
+        for(size_t k = 0; k < n; k++) mapped[order[k]] = communities[k];
+        return mapped;
+    }
+
+    std::vector<int> LeidenCommunity::Compute(size_t nodeNum, const std::vector<size_t>& xadj, 
+                                              const std::vector<uint32_t>& adjncy, const std::vector<float>& adjwgt)
+    {
+        size_t nthreads = threadNum > 0 ? threadNum : max(thread::hardware_concurrency(), 1u);
+        LeidenLevel g;
+        g.n = nodeNum;
+        g.xadj = xadj;
+        g.adjncy = adjncy;
+        g.adjwgt = adjwgt;
+        g.degree.assign(nodeNum, 0.0);
+        g.size.assign(nodeNum, 1);
+        double total = 0;
+        for(size_t v = 0; v < nodeNum; v++) {
+            for(size_t e = xadj[v]; e < xadj[v + 1]; e++) g.degree[v] += adjwgt[e];
+            total += g.degree[v];
+        }
+        // modularity gain of a node of degree kv joining a community of degree sigma is
+        // w(v, community) - kv * sigma * scale
+        double scale = total > 0 ? resolution / total : 0.0;
+
+        vector<int> node(nodeNum);          // node of every input node in the current level
+        iota(node.begin(), node.end(), 0);
+        vector<int> label(nodeNum);
+        iota(label.begin(), label.end(), 0);
+        mt19937 rng(seed);
+        _levels = 0;
+
+        while(_levels < kMaxLevels) {
+            _levels++;
+            vector<uint32_t> order(g.n);
+            iota(order.begin(), order.end(), 0);
+            shuffle(order.begin(), order.end(), rng);
+
+            vector<atomic<int>> atomic_label(g.n);
+            for(size_t v = 0; v < g.n; v++) atomic_label[v].store(label[v]);
+            LocalMoving(g, atomic_label, scale, maxSize, order, nthreads);
+            for(size_t v = 0; v < g.n; v++) label[v] = atomic_label[v].load();
+            size_t community_num = Renumber(label, g.n);
+            if(community_num == g.n) break;
+
+            vector<int> group = Refine(g, label, scale, rng(), nthreads);
+            size_t group_num = Renumber(group, g.n);
+            if(group_num == g.n) {
+                // No sub-community has two nodes, aggregate the communities themselves
+                group = label;
+                group_num = community_num;
+            }
+
+            vector<int> coarse_label(group_num);
+            for(size_t v = 0; v < g.n; v++) coarse_label[group[v]] = label[v];
+            for(size_t i = 0; i < nodeNum; i++) node[i] = group[node[i]];
+            g = Aggregate(g, group, group_num, nthreads);
+            label.swap(coarse_label);
+        }
+
+        vector<int> communities(nodeNum);
+        for(size_t i = 0; i < nodeNum; i++) communities[i] = label[node[i]];
+        _communityNum = Renumber(communities, nodeNum);
+
+        // Q = sum over the communities of in / 2m - resolution * (sigma / 2m)^2
+        vector<double> in(_communityNum, 0.0), sigma(_communityNum, 0.0);
+        for(size_t v = 0; v < nodeNum; v++) {
+            for(size_t e = xadj[v]; e < xadj[v + 1]; e++) {
+                sigma[communities[v]] += adjwgt[e];
+                if(communities[adjncy[e]] == communities[v]) in[communities[v]] += adjwgt[e];
+            }
+        }
+        _modularity = 0;
+        for(size_t c = 0; total > 0 && c < _communityNum; c++) {
+            _modularity += in[c] / total - resolution * (sigma[c] / total) * (sigma[c] / total);
+        }
+        return communities;
+    }
+
+}   // namespace bluefish
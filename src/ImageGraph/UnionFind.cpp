@@ -50,9 +50,16 @@ namespace bluefish
 
     size_t UnionFind::Find(size_t x)
     {
-        if(x != father[x])
-            father[x] = Find(father[x]);	// path compression
-        return father[x];
+        // Iterative, the chains of UnionSet may be as long as the number of elements
+        size_t root = x;
+        while(root != father[root])
+            root = father[root];
+        while(x != root) {
+            size_t next = father[x];
+            father[x] = root;	// path compression
+            x = next;
+        }
+        return root;
     }
 
     bool UnionFind::UnionSet(size_t x, size_t y)